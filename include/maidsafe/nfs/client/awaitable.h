@@ -0,0 +1,283 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_CLIENT_AWAITABLE_H_
+#define MAIDSAFE_NFS_CLIENT_AWAITABLE_H_
+
+// Coroutine support needs a compiler in C++20 mode; otherwise this header declares nothing, and
+// MAIDSAFE_NFS_COROUTINES is left undefined.  Configure with NFS_CXX20_TESTS=ON to build the tests
+// and benchmarks which cover it.  The co_await-able client operations are free functions here
+// rather than members, so that MaidNodeNfs and DataGetter are defined identically in every build.
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+#define MAIDSAFE_NFS_COROUTINES
+#endif
+#endif
+
+#ifdef MAIDSAFE_NFS_COROUTINES
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "boost/asio/io_service.hpp"
+#include "boost/optional/optional.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/data_types/structured_data_versions.h"
+
+#include "maidsafe/nfs/client/cancellation_token.h"
+#include "maidsafe/nfs/client/client_utils.h"
+#include "maidsafe/nfs/client/data_getter.h"
+#include "maidsafe/nfs/client/maid_node_nfs.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace detail {
+
+template <typename T>
+struct AwaitedValue {
+  template <typename U>
+  void Set(U&& value_in) {
+    value = std::forward<U>(value_in);
+  }
+  T Take() { return std::move(*value); }
+
+  boost::optional<T> value;
+};
+
+template <>
+struct AwaitedValue<void> {
+  void Set() {}
+  void Take() {}
+};
+
+}  // namespace detail
+
+// Awaits an operation which reports its outcome to a completion handler (see
+// GetCompletionHandler).  'initiate' is called with the handler as the awaiting coroutine suspends,
+// and the coroutine is resumed on 'io_service' once the handler has been called, so no thread is
+// held while the operation is outstanding.  If 'initiate' itself calls the handler (e.g. for cached
+// data) the coroutine carries on without suspending.  co_await yields the operation's result of
+// type 'T', or throws maidsafe_error holding its error.
+template <typename T, typename Initiate>
+class Awaitable {
+ public:
+  Awaitable(boost::asio::io_service& io_service, Initiate initiate)
+      : io_service_(io_service),
+        initiate_(std::move(initiate)),
+        coroutine_(),
+        initiating_thread_(),
+        state_(kInitiating),
+        error_(),
+        value_() {}
+
+  bool await_ready() const noexcept { return false; }
+
+  bool await_suspend(std::coroutine_handle<> coroutine) {
+    coroutine_ = coroutine;
+    initiating_thread_ = std::this_thread::get_id();
+    initiate_([this](std::error_code error, auto&&... value) {
+      error_ = error;
+      if (!error)
+        value_.Set(std::forward<decltype(value)>(value)...);
+      if (std::this_thread::get_id() == initiating_thread_) {
+        int state(kInitiating);
+        if (state_.compare_exchange_strong(state, kCompletedInline))
+          return;
+      }
+      // If 'initiate' hasn't returned yet, await_suspend resumes the coroutine instead, since this
+      // awaitable is destroyed once it has been resumed.
+      if (state_.exchange(kCompleted) == kSuspended)
+        Resume();
+    });
+    int state(kInitiating);
+    if (state_.compare_exchange_strong(state, kSuspended))
+      return true;
+    if (state == kCompletedInline)
+      return false;
+    Resume();
+    return true;
+  }
+
+  T await_resume() {
+    if (error_)
+      BOOST_THROW_EXCEPTION(maidsafe_error(error_));
+    return value_.Take();
+  }
+
+ private:
+  Awaitable(const Awaitable&);
+  Awaitable(Awaitable&&);
+  Awaitable& operator=(Awaitable);
+
+  enum { kInitiating, kSuspended, kCompletedInline, kCompleted };
+
+  void Resume() {
+    auto coroutine(coroutine_);
+    io_service_.post([coroutine] { coroutine.resume(); });
+  }
+
+  boost::asio::io_service& io_service_;
+  Initiate initiate_;
+  std::coroutine_handle<> coroutine_;
+  std::thread::id initiating_thread_;
+  std::atomic<int> state_;
+  std::error_code error_;
+  detail::AwaitedValue<T> value_;
+};
+
+template <typename T, typename Initiate>
+Awaitable<T, Initiate> MakeAwaitable(boost::asio::io_service& io_service, Initiate initiate) {
+  return Awaitable<T, Initiate>(io_service, std::move(initiate));
+}
+
+// The return type of a coroutine which runs independently of its caller: it starts at once, and
+// its frame is freed when it finishes.  An exception escaping the coroutine is logged and dropped.
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() noexcept { return Detached(); }
+    std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+    std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept {
+      try {
+        std::rethrow_exception(std::current_exception());
+      }
+      catch (const std::exception& e) {
+        LOG(kError) << "Detached coroutine threw: " << e.what();
+      }
+      catch (...) {
+        LOG(kError) << "Detached coroutine threw";
+      }
+    }
+  };
+};
+
+// co_await-able forms of the client operations, e.g.
+//   auto versions(co_await AsyncGetVersions(client, data_name));
+// Each starts the operation with a completion handler, resumes on the client's io_service() (see
+// Awaitable) and throws maidsafe_error if the operation fails.  The client must outlive the
+// operation.
+template <typename DataName>
+auto AsyncGet(MaidNodeNfs& client, const DataName& data_name,
+              const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+              const CancellationToken& cancellation_token = CancellationToken()) {
+  return MakeAwaitable<typename DataName::data_type>(
+      client.io_service(), [&client, data_name, timeout, cancellation_token](auto handler) {
+        client.Get(data_name, std::move(handler), timeout, cancellation_token);
+      });
+}
+
+template <typename Data>
+auto AsyncPut(MaidNodeNfs& client, const Data& data,
+              const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+              const CancellationToken& cancellation_token = CancellationToken()) {
+  return MakeAwaitable<void>(
+      client.io_service(), [&client, data, timeout, cancellation_token](auto handler) {
+        client.Put(data, std::move(handler), timeout, cancellation_token);
+      });
+}
+
+template <typename DataName>
+auto AsyncGetVersions(MaidNodeNfs& client, const DataName& data_name,
+                      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+                      const std::chrono::steady_clock::duration& max_staleness =
+                          std::chrono::steady_clock::duration::zero(),
+                      const CancellationToken& cancellation_token = CancellationToken()) {
+  return MakeAwaitable<std::vector<StructuredDataVersions::VersionName>>(
+      client.io_service(),
+      [&client, data_name, timeout, max_staleness, cancellation_token](auto handler) {
+        client.GetVersions(data_name, std::move(handler), timeout, max_staleness,
+                           cancellation_token);
+      });
+}
+
+template <typename DataName>
+auto AsyncGetBranch(MaidNodeNfs& client, const DataName& data_name,
+                    const StructuredDataVersions::VersionName& branch_tip,
+                    const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+                    const std::chrono::steady_clock::duration& max_staleness =
+                        std::chrono::steady_clock::duration::zero(),
+                    const CancellationToken& cancellation_token = CancellationToken()) {
+  return MakeAwaitable<std::vector<StructuredDataVersions::VersionName>>(
+      client.io_service(),
+      [&client, data_name, branch_tip, timeout, max_staleness, cancellation_token](auto handler) {
+        client.GetBranch(data_name, branch_tip, std::move(handler), timeout, max_staleness,
+                         cancellation_token);
+      });
+}
+
+template <typename DataName>
+auto AsyncPutVersion(MaidNodeNfs& client, const DataName& data_name,
+                     const StructuredDataVersions::VersionName& old_version_name,
+                     const StructuredDataVersions::VersionName& new_version_name,
+                     const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+                     const CancellationToken& cancellation_token = CancellationToken()) {
+  return MakeAwaitable<std::unique_ptr<StructuredDataVersions::VersionName>>(
+      client.io_service(), [&client, data_name, old_version_name, new_version_name, timeout,
+                            cancellation_token](auto handler) {
+        client.PutVersion(data_name, old_version_name, new_version_name, std::move(handler),
+                          timeout, cancellation_token);
+      });
+}
+
+template <typename DataName>
+auto AsyncGet(DataGetter& data_getter, const DataName& data_name,
+              const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout) {
+  return MakeAwaitable<typename DataName::data_type>(
+      data_getter.io_service(), [&data_getter, data_name, timeout](auto handler) {
+        data_getter.Get(data_name, std::move(handler), timeout);
+      });
+}
+
+template <typename DataName>
+auto AsyncGetVersions(DataGetter& data_getter, const DataName& data_name,
+                      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout) {
+  return MakeAwaitable<std::vector<StructuredDataVersions::VersionName>>(
+      data_getter.io_service(), [&data_getter, data_name, timeout](auto handler) {
+        data_getter.GetVersions(data_name, std::move(handler), timeout);
+      });
+}
+
+template <typename DataName>
+auto AsyncGetBranch(DataGetter& data_getter, const DataName& data_name,
+                    const StructuredDataVersions::VersionName& branch_tip,
+                    const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout) {
+  return MakeAwaitable<std::vector<StructuredDataVersions::VersionName>>(
+      data_getter.io_service(), [&data_getter, data_name, branch_tip, timeout](auto handler) {
+        data_getter.GetBranch(data_name, branch_tip, std::move(handler), timeout);
+      });
+}
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_COROUTINES
+
+#endif  // MAIDSAFE_NFS_CLIENT_AWAITABLE_H_
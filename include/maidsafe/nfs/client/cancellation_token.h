@@ -0,0 +1,105 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_CLIENT_CANCELLATION_TOKEN_H_
+#define MAIDSAFE_NFS_CLIENT_CANCELLATION_TOKEN_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "maidsafe/common/error.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+// The error with which cancelled operations fail (std::errc::operation_canceled).
+maidsafe_error CancelledError();
+
+// Allows operations to be abandoned once started.  Copies share their state, so one token can be
+// passed to many operations and cancelled once to abandon all those still outstanding.  A
+// default-constructed token can't be cancelled, and costs nothing to pass.
+class CancellationToken {
+ public:
+  CancellationToken();
+  // Returns a token which can be cancelled.
+  static CancellationToken Create();
+
+  // Calls the functors registered by outstanding operations, on this thread.  Operations registered
+  // later are cancelled as they register.  Further calls do nothing.
+  void Cancel();
+  bool cancelled() const;
+  // False for a default-constructed token.
+  bool cancellable() const;
+
+  // Arranges for 'functor' to be called once the token is cancelled, calling it before returning if
+  // it already has been.  Returns an id for Deregister, or 0 if 'functor' won't be called later.
+  uint64_t Register(std::function<void()> functor) const;
+  // Drops the functor registered as 'id'.  If it's being called on another thread, waits for it to
+  // return.
+  void Deregister(uint64_t id) const;
+
+ private:
+  struct State;
+
+  explicit CancellationToken(std::shared_ptr<State> state);
+
+  std::shared_ptr<State> state_;
+};
+
+// Ties one operation to a token, ensuring that exactly one of its completion and its cancellation
+// proceeds.
+class CancellableOperation : public std::enable_shared_from_this<CancellableOperation> {
+ public:
+  explicit CancellableOperation(CancellationToken token);
+  ~CancellableOperation();
+
+  // Arranges for 'on_cancel' to be called if the token is cancelled before Complete is called.
+  // Returns false if it already has been (and 'on_cancel' has been called), in which case the
+  // operation's request needn't be sent.
+  bool Arm(std::function<void()> on_cancel);
+
+  // Must be called when the operation completes, before acting on its result.  Returns false if the
+  // operation has been cancelled, in which case the result must be dropped.  Waits for 'on_cancel'
+  // to return if it's being called on another thread.
+  bool Complete();
+
+ private:
+  CancellableOperation(const CancellableOperation&);
+  CancellableOperation(CancellableOperation&&);
+  CancellableOperation& operator=(CancellableOperation);
+
+  void Cancel();
+
+  std::atomic<bool> finished_, cancelled_;
+  const CancellationToken token_;
+  std::atomic<uint64_t> registration_;
+  std::function<void()> on_cancel_;
+};
+
+// Returns null if 'token' can't be cancelled, in which case there's nothing for an operation to
+// track.
+std::shared_ptr<CancellableOperation> MakeCancellableOperation(const CancellationToken& token);
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_CLIENT_CANCELLATION_TOKEN_H_
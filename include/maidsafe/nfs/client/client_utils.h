@@ -19,10 +19,16 @@
 #ifndef MAIDSAFE_NFS_CLIENT_CLIENT_UTILS_H_
 #define MAIDSAFE_NFS_CLIENT_CLIENT_UTILS_H_
 
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <system_error>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "boost/exception/all.hpp"
+#include "boost/optional/optional.hpp"
 #include "boost/thread/future.hpp"
 
 #include "maidsafe/common/data_types/structured_data_versions.h"
@@ -30,6 +36,7 @@
 #include "maidsafe/routing/timer.h"
 
 #include "maidsafe/nfs/utils.h"
+#include "maidsafe/nfs/client/data_cache.h"
 #include "maidsafe/nfs/client/messages.h"
 #include "maidsafe/nfs/client/maid_node_dispatcher.h"
 
@@ -37,21 +44,90 @@ namespace maidsafe {
 
 namespace nfs_client {
 
+// Completion handlers are called exactly once with the outcome of an operation: a zero error code
+// and the result if it succeeded, otherwise the error with which the equivalent future would fail
+// and a default result.  They are called on whichever thread completes the operation (or before the
+// operation returns, e.g. for cached data), and mustn't throw.
 template <typename Data>
+using GetCompletionHandler = std::function<void(std::error_code, boost::optional<Data>)>;
+typedef std::function<void(std::error_code)> PutCompletionHandler;
+typedef std::function<void(std::error_code, std::vector<StructuredDataVersions::VersionName>)>
+    VersionNamesCompletionHandler;
+typedef std::function<void(std::error_code,
+                           std::unique_ptr<StructuredDataVersions::VersionName>)>
+    PutVersionCompletionHandler;
+
+namespace detail {
+
+// Whether 'Handler' can be called as 'CompletionHandler' (one of the std::function types above),
+// which distinguishes a completion handler from the timeout the future-returning overloads take in
+// the same position, and rejects a handler taking the wrong operation's result.
+template <typename Handler, typename CompletionHandler>
+struct IsCompletionHandler;
+
+template <typename Handler, typename... Args>
+struct IsCompletionHandler<Handler, std::function<void(Args...)>> {
+ private:
+  template <typename H>
+  static auto Test(int)
+      -> decltype(std::declval<H&>()(std::declval<Args>()...), std::true_type());
+  template <typename H>
+  static std::false_type Test(...);
+
+ public:
+  static const bool value = decltype(Test<Handler>(0))::value;
+};
+
+}  // namespace detail
+
+// The error code passed to completion handlers for 'result': zero if it's a success.
+std::error_code HandlerError(const ReturnCode& result);
+
+// Returns a completion handler which sets 'promise' from the outcome, for the future-returning API.
+// 'Result' is either 'Data' or 'std::shared_ptr<const Data>'.
+template <typename Data, typename Result>
+GetCompletionHandler<Data> GetPromiseHandler(std::shared_ptr<boost::promise<Result>> promise);
+PutCompletionHandler PutPromiseHandler(std::shared_ptr<boost::promise<void>> promise);
+VersionNamesCompletionHandler VersionNamesPromiseHandler(
+    std::shared_ptr<boost::promise<std::vector<StructuredDataVersions::VersionName>>> promise);
+PutVersionCompletionHandler PutVersionPromiseHandler(
+    std::shared_ptr<boost::promise<std::unique_ptr<StructuredDataVersions::VersionName>>> promise);
+
+// As HandleGetResult, but passes the outcome to 'handler'.
+template <typename Data>
+void CompleteGet(DataNameAndContentOrReturnCode result, DataCache* cache,
+                 const GetCompletionHandler<Data>& handler);
+
+// 'Result' is either 'Data' or 'std::shared_ptr<const Data>'.  The fetched content is moved (not
+// copied) into the Data object, and that object is moved into the promise.  If 'cache' is non-null,
+// successfully fetched data is also added to it.
+template <typename Data, typename Result = Data>
 struct HandleGetResult {
-  explicit HandleGetResult(std::shared_ptr<boost::promise<Data>> promise_in)
-      : promise(std::move(promise_in)) {}
-  void operator()(const DataNameAndContentOrReturnCode& result) const;
-  std::shared_ptr<boost::promise<Data>> promise;
+  explicit HandleGetResult(std::shared_ptr<boost::promise<Result>> promise_in,
+                           DataCache* cache_in = nullptr)
+      : promise(std::move(promise_in)), cache(cache_in) {}
+  void operator()(DataNameAndContentOrReturnCode result) const;
+  std::shared_ptr<boost::promise<Result>> promise;
+  DataCache* cache;
 };
 
 void HandlePutResponseResult(const ReturnCode& result,
                              std::shared_ptr<boost::promise<void>> promise);
 
+// The versions are moved (not copied) into the promise.
 void HandleGetVersionsOrBranchResult(
-    const StructuredDataNameAndContentOrReturnCode& result,
+    StructuredDataNameAndContentOrReturnCode result,
     std::shared_ptr<boost::promise<std::vector<StructuredDataVersions::VersionName>>> promise);
 
+// As above, but passes the outcome to 'handler'.
+void CompleteGetVersionsOrBranch(StructuredDataNameAndContentOrReturnCode result,
+                                 const VersionNamesCompletionHandler& handler);
+
+// The result of a GetVersions or GetBranch which expires before enough responses have arrived to
+// decide its outcome: NfsErrors::timed_out.
+template <typename DataName>
+StructuredDataNameAndContentOrReturnCode VersionsTimedOutResult(const DataName& data_name);
+
 void HandleCreateAccountResult(const ReturnCode& result,
                                std::shared_ptr<boost::promise<void>> promise);
 
@@ -65,29 +141,91 @@ void HandlePutVersionResult(
     const TipOfTreeAndReturnCode& result,
     std::shared_ptr<boost::promise<std::unique_ptr<StructuredDataVersions::VersionName>>> promise);
 
+// As above, but passes the outcome to 'handler'.
+void CompletePutVersion(const TipOfTreeAndReturnCode& result,
+                        const PutVersionCompletionHandler& handler);
+
 void HandleRegisterPmidResult(const ReturnCode& result,
                               std::shared_ptr<boost::promise<void>> promise);
 
 // ==================== Implementation =============================================================
+namespace detail {
+
 template <typename Data>
-void HandleGetResult<Data>::operator()(const DataNameAndContentOrReturnCode& result) const {
+void SetGetResult(boost::promise<Data>& promise, Data&& data) {
+  promise.set_value(std::move(data));
+}
+
+template <typename Data>
+void SetGetResult(boost::promise<std::shared_ptr<const Data>>& promise, Data&& data) {
+  promise.set_value(std::make_shared<const Data>(std::move(data)));
+}
+
+// Builds the data from a Get's content response, moving (not copying) the content.  Throws if the
+// response is for a different type.
+template <typename Data>
+Data ParseGetContent(DataNameAndContentOrReturnCode& result) {
+  if (result.name.type != Data::Tag::kValue) {
+    LOG(kError) << "HandleGetResult incorrect returned data";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+  LOG(kInfo) << "HandleGetResult fetched chunk has name : "
+             << HexSubstr(result.name.raw_name) << " and content : "
+             << HexSubstr(result.content->data);
+  return Data(typename Data::Name(result.name.raw_name),
+              typename Data::serialised_type(NonEmptyString(std::move(result.content->data))));
+}
+
+}  // namespace detail
+
+template <typename Data, typename Result>
+GetCompletionHandler<Data> GetPromiseHandler(std::shared_ptr<boost::promise<Result>> promise) {
+  return [promise](std::error_code error, boost::optional<Data> data) {
+    if (error)
+      promise->set_exception(maidsafe_error(error));
+    else
+      detail::SetGetResult(*promise, std::move(*data));
+  };
+}
+
+template <typename Data>
+void CompleteGet(DataNameAndContentOrReturnCode result, DataCache* cache,
+                 const GetCompletionHandler<Data>& handler) {
+  if (!result.content) {
+    if (result.return_code && result.return_code->value)
+      return handler(result.return_code->value, boost::none);
+    LOG(kError) << "CompleteGet result uninitialised";
+    return handler(make_error_code(CommonErrors::uninitialised), boost::none);
+  }
+  boost::optional<Data> data;
+  try {
+    data = detail::ParseGetContent<Data>(result);
+    if (cache)
+      cache->Put(*data);
+  }
+  catch (const maidsafe_error& error) {
+    return handler(error.code(), boost::none);
+  }
+  catch (const std::exception& e) {
+    LOG(kError) << "CompleteGet failed to parse data: " << e.what();
+    return handler(make_error_code(CommonErrors::parsing_error), boost::none);
+  }
+  handler(std::error_code(), std::move(data));
+}
+
+template <typename Data, typename Result>
+void HandleGetResult<Data, Result>::operator()(DataNameAndContentOrReturnCode result) const {
   LOG(kVerbose) << "HandleGetResult<Data>::operator()";
   try {
     if (result.content) {
-      if (result.name.type != Data::Tag::kValue) {
-        LOG(kError) << "HandleGetResult incorrect returned data";
-        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
-      }
-      LOG(kInfo) << "HandleGetResult fetched chunk has name : "
-                 << HexSubstr(result.name.raw_name) << " and content : "
-                 << HexSubstr(result.content->data);
-      Data data(typename Data::Name(result.name.raw_name),
-                typename Data::serialised_type(NonEmptyString(result.content->data)));
-      promise->set_value(data);
+      Data data(detail::ParseGetContent<Data>(result));
+      if (cache)
+        cache->Put(data);
+      detail::SetGetResult(*promise, std::move(data));
     } else if (result.return_code) {
       LOG(kWarning) << "HandleGetResult don't have a result but having a return code "
-                    << result.return_code->value.what();
-      boost::throw_exception(result.return_code->value);
+                    << result.return_code->value.message();
+      boost::throw_exception(result.return_code->error());
     } else {
       LOG(kError) << "HandleGetResult result uninitialised";
       BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
@@ -99,6 +237,14 @@ void HandleGetResult<Data>::operator()(const DataNameAndContentOrReturnCode& res
   }
 }
 
+template <typename DataName>
+StructuredDataNameAndContentOrReturnCode VersionsTimedOutResult(const DataName& data_name) {
+  StructuredDataNameAndContentOrReturnCode result;
+  result.data_name_and_return_code = DataNameAndReturnCode(
+      nfs_vault::DataName(data_name), ReturnCode(NfsErrors::timed_out));
+  return result;
+}
+
 }  // namespace nfs_client
 
 }  // namespace maidsafe
@@ -0,0 +1,154 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_CLIENT_DATA_CACHE_H_
+#define MAIDSAFE_NFS_CLIENT_DATA_CACHE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem/path.hpp"
+#include "boost/optional/optional.hpp"
+
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/data_types/data_type_values.h"
+
+#include "maidsafe/nfs/client/disk_cache.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+struct DataCacheParameters {
+  // Caching is disabled by default.
+  DataCacheParameters();
+  explicit DataCacheParameters(uint64_t max_bytes_in);
+  DataCacheParameters(uint64_t max_bytes_in, boost::filesystem::path disk_path_in,
+                      uint64_t max_disk_bytes_in);
+
+  // Upper bound on the total size of the contents cached in memory.  Zero disables this tier.
+  uint64_t max_bytes;
+  // Directory holding the on-disk tier (see DiskCache), which only holds ImmutableData.  An empty
+  // path disables this tier.
+  boost::filesystem::path disk_path;
+  uint64_t max_disk_bytes;
+  // How long a Get which found no such data is answered locally with that failure, per type (see
+  // NegativeCache).  Types which aren't present aren't cached.
+  std::map<DataTagValue, std::chrono::steady_clock::duration> negative_time_to_lives;
+  // How many names' version lists may be cached (see VersionCache).  Zero disables this cache.
+  size_t max_version_lists;
+};
+
+struct DataCacheStats {
+  DataCacheStats();
+
+  // 'hits' are served from memory and 'disk_hits' from disk; 'misses' are in neither tier.
+  uint64_t hits, disk_hits, misses, insertions, evictions, entries, bytes;
+  DiskCacheStats disk;
+};
+
+// In-memory cache of the serialised contents of data types which are 'is_cacheable' (i.e.
+// content-addressed and immutable, so a cached copy can never be stale).
+//
+// The cache is split into shards, each with its own lock and an equal share of the byte budget.
+// Each shard is a segmented LRU: new entries go into a probationary segment and are only promoted
+// to the protected segment (80% of the shard) when hit again, so a scan of once-read chunks can
+// only evict other probationary entries, never the hot ones.
+//
+// If a disk path is given, ImmutableData is also kept on disk so that it survives restarts.
+// Entries found on disk but not in memory are added to memory when read.
+class DataCache {
+ public:
+  // Throws CommonErrors::filesystem_io_error if the disk tier can't be opened.
+  explicit DataCache(const DataCacheParameters& parameters);
+
+  bool enabled() const { return !shards_.empty() || disk_cache_; }
+
+  // True if 'Data' is a type which this cache holds.
+  template <typename Data>
+  bool Holds() const;
+
+  // Returns the cached contents, or null if absent.
+  std::shared_ptr<const std::string> Get(DataTagValue type, const Identity& name);
+  // Returns the cached data, or none if absent or if 'Data' isn't held.
+  template <typename Data>
+  boost::optional<Data> Get(const typename Data::Name& name);
+
+  // Contents larger than a shard's budget aren't cached.
+  void Put(DataTagValue type, const Identity& name, std::string content);
+  // Does nothing if 'Data' isn't held.
+  template <typename Data>
+  void Put(const Data& data);
+
+  DataCacheStats stats() const;
+
+ private:
+  struct Shard;
+
+  DataCache(const DataCache&);
+  DataCache(DataCache&&);
+  DataCache& operator=(DataCache);
+
+  Shard& GetShard(DataTagValue type, const Identity& name) const;
+  void PutInMemory(DataTagValue type, const Identity& name,
+                   std::shared_ptr<const std::string> content);
+
+  std::vector<std::shared_ptr<Shard>> shards_;
+  std::unique_ptr<DiskCache> disk_cache_;
+  std::atomic<uint64_t> hits_, disk_hits_, misses_, insertions_, evictions_;
+};
+
+// ==================== Implementation =============================================================
+template <typename Data>
+bool DataCache::Holds() const {
+  return is_cacheable<Data>::value && enabled();
+}
+
+template <typename Data>
+boost::optional<Data> DataCache::Get(const typename Data::Name& name) {
+  if (!Holds<Data>())
+    return boost::none;
+  auto content(Get(Data::Tag::kValue, name.value));
+  if (!content)
+    return boost::none;
+  try {
+    return Data(name, typename Data::serialised_type(NonEmptyString(*content)));
+  }
+  catch (const std::exception& e) {
+    LOG(kError) << "Failed to parse cached " << HexSubstr(name.value) << ": " << e.what();
+    return boost::none;
+  }
+}
+
+template <typename Data>
+void DataCache::Put(const Data& data) {
+  if (Holds<Data>())
+    Put(Data::Tag::kValue, data.name().value, data.Serialise().data.string());
+}
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_CLIENT_DATA_CACHE_H_
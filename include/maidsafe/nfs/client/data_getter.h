@@ -21,12 +21,14 @@
 
 #include <functional>
 #include <memory>
+#include <type_traits>
 #include <vector>
 #include <mutex>
 
 #include "boost/thread/future.hpp"
 
 #include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/data_types/data_name_variant.h"
 #include "maidsafe/common/data_types/structured_data_versions.h"
 #include "maidsafe/passport/types.h"
 #include "maidsafe/routing/parameters.h"
@@ -37,8 +39,12 @@
 #include "maidsafe/nfs/service.h"
 #include "maidsafe/nfs/utils.h"
 #include "maidsafe/nfs/client/client_utils.h"
+#include "maidsafe/nfs/client/data_cache.h"
 #include "maidsafe/nfs/client/data_getter_dispatcher.h"
 #include "maidsafe/nfs/client/data_getter_service.h"
+#include "maidsafe/nfs/client/get_coalescer.h"
+#include "maidsafe/nfs/client/latency_estimator.h"
+#include "maidsafe/nfs/client/request_window.h"
 
 namespace maidsafe {
 
@@ -49,23 +55,72 @@ class DataGetter {
   typedef boost::future<std::vector<StructuredDataVersions::VersionName>> VersionNamesFuture;
 
   // all_pmids_from_file should only be non-empty if TESTING is defined
-  DataGetter(AsioService& asio_service, routing::Routing& routing);
+  // By default, data isn't cached (see DataCache).
+  DataGetter(AsioService& asio_service, routing::Routing& routing,
+             const DataCacheParameters& data_cache_parameters = DataCacheParameters());
 
+  // The service which runs this getter's timers and callbacks (e.g. for resuming coroutines
+  // awaiting its operations, see awaitable.h).
+  boost::asio::io_service& io_service() { return io_service_; }
+
+  // Data held in the cache is returned immediately, and fetched data is added to it.  Concurrent
+  // Gets for the same name share a single request to the network, which is resent if it takes
+  // longer than the estimated timeout for Gets while the Get still has time left.
   template <typename DataName>
   boost::future<typename DataName::data_type> Get(
       const DataName& data_name,
-      const std::chrono::steady_clock::duration& timeout = std::chrono::seconds(10));
+      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout);
+
+  // As above, but calls 'handler' (which must be convertible to
+  // GetCompletionHandler<DataName::data_type>) with the outcome rather than returning a future.
+  template <typename DataName, typename Handler>
+  void Get(const DataName& data_name, Handler handler,
+           const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+           typename std::enable_if<detail::IsCompletionHandler<
+               Handler, GetCompletionHandler<typename DataName::data_type>>::value>::type* = 0);
+
+  // Gets each of 'data_names', keeping at most 'window' requests outstanding and starting the next
+  // as each completes.  'result_functor' is called with each name's index in 'data_names' and a
+  // ready future holding its data or error, in the order the Gets complete.  The returned future
+  // becomes ready once all have completed.  Throws CommonErrors::invalid_parameter if 'window' is
+  // zero.
+  template <typename DataName>
+  boost::future<void> GetMany(
+      std::vector<DataName> data_names, size_t window,
+      std::function<void(size_t, boost::future<typename DataName::data_type>)> result_functor,
+      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout);
 
+  // As above, but returns a future per name, in the order of 'data_names'.
   template <typename DataName>
-  VersionNamesFuture GetVersions(const DataName& data_name,
-                                 const std::chrono::steady_clock::duration& timeout =
-                                     std::chrono::seconds(10));
+  std::vector<boost::future<typename DataName::data_type>> GetMany(
+      std::vector<DataName> data_names, size_t window,
+      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout);
+
+  template <typename DataName>
+  VersionNamesFuture GetVersions(
+      const DataName& data_name,
+      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout);
+
+  // 'handler' must be convertible to VersionNamesCompletionHandler.
+  template <typename DataName, typename Handler>
+  void GetVersions(
+      const DataName& data_name, Handler handler,
+      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+      typename std::enable_if<detail::IsCompletionHandler<
+          Handler, VersionNamesCompletionHandler>::value>::type* = 0);
 
   template <typename DataName>
-  VersionNamesFuture GetBranch(const DataName& data_name,
-                               const StructuredDataVersions::VersionName& branch_tip,
-                               const std::chrono::steady_clock::duration& timeout =
-                                   std::chrono::seconds(10));
+  VersionNamesFuture GetBranch(
+      const DataName& data_name, const StructuredDataVersions::VersionName& branch_tip,
+      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout);
+
+  // 'handler' must be convertible to VersionNamesCompletionHandler.
+  template <typename DataName, typename Handler>
+  void GetBranch(
+      const DataName& data_name, const StructuredDataVersions::VersionName& branch_tip,
+      Handler handler, const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+      typename std::enable_if<detail::IsCompletionHandler<
+          Handler, VersionNamesCompletionHandler>::value>::type* = 0);
 
   // This should be the function used in the GroupToSingle (and maybe also SingleToSingle) functors
   // passed to 'routing.Join'.
@@ -74,21 +129,55 @@ class DataGetter {
 
   nfs::Service<DataGetterService>& service() { return service_; }
 
+  DataCacheStats data_cache_stats() const { return data_cache_.stats(); }
+
+  // Operations given a timeout of kAdaptiveTimeout (the default) use one estimated from the
+  // round-trip times of earlier operations of the same kind.
+  LatencyEstimator::Estimates latency_estimates() const { return latency_estimator_.estimates(); }
+
  private:
   typedef std::function<void(const DataNameAndContentOrReturnCode&)> GetFunctor;
   typedef std::function<void(const StructuredDataNameAndContentOrReturnCode&)> GetVersionsFunctor;
   typedef std::function<void(const StructuredDataNameAndContentOrReturnCode&)> GetBranchFunctor;
-  typedef boost::promise<std::vector<StructuredDataVersions::VersionName>> VersionNamesPromise;
 
   DataGetter(const DataGetter&);
   DataGetter(DataGetter&&);
   DataGetter& operator=(DataGetter);
 
+  template <typename DataName>
+  void DoGet(const DataName& data_name, GetCompletionHandler<typename DataName::data_type> handler,
+             const std::chrono::steady_clock::duration& timeout);
+
+  template <typename DataName>
+  void DoGetVersions(const DataName& data_name, VersionNamesCompletionHandler handler,
+                     const std::chrono::steady_clock::duration& timeout);
+
+  template <typename DataName>
+  void DoGetBranch(const DataName& data_name,
+                   const StructuredDataVersions::VersionName& branch_tip,
+                   VersionNamesCompletionHandler handler,
+                   const std::chrono::steady_clock::duration& timeout);
+
+  template <typename DataName>
+  std::function<void(const DataName&,
+                     std::shared_ptr<boost::promise<typename DataName::data_type>>,
+                     std::function<void()>)>
+      GetManyFunctor(const std::chrono::steady_clock::duration& timeout);
+
+  void SendGetRequest(const DataNameVariant& data_name,
+                      const std::chrono::steady_clock::duration& timeout,
+                      GetCoalescer::ResultFunctor result_functor);
+
+  boost::asio::io_service& io_service_;
+  // Declared before the timers so that expiring requests can still record timeouts.
+  LatencyEstimator latency_estimator_;
   routing::Timer<DataGetterService::GetResponse::Contents> get_timer_;
   routing::Timer<DataGetterService::GetVersionsResponse::Contents> get_versions_timer_;
   routing::Timer<DataGetterService::GetBranchResponse::Contents> get_branch_timer_;
   DataGetterDispatcher dispatcher_;
   nfs::Service<DataGetterService> service_;
+  DataCache data_cache_;
+  GetCoalescer get_coalescer_;
 };
 
 // ==================== Implementation =============================================================
@@ -97,59 +186,158 @@ boost::future<typename DataName::data_type> DataGetter::Get(
     const DataName& data_name,
     const std::chrono::steady_clock::duration& timeout) {
   LOG(kVerbose) << "DataGetter Get " << HexSubstr(data_name.value);
-  typedef DataGetterService::GetResponse::Contents ResponseContents;
   auto promise(std::make_shared<boost::promise<typename DataName::data_type>>());
-  HandleGetResult<typename DataName::data_type> response_functor(promise);
-  auto op_data(std::make_shared<nfs::OpData<ResponseContents>>(1, response_functor));
-  auto task_id(get_timer_.NewTaskId());
-  get_timer_.AddTask(timeout,
-                     [op_data, data_name](ResponseContents get_response) {
-                         LOG(kVerbose) << "DataGetter Get HandleResponseContents for "
-                                       << HexSubstr(data_name.value);
-                         op_data->HandleResponseContents(std::move(get_response));
-                     },
-                      // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
-                      routing::Parameters::group_size * 2, task_id);
-  dispatcher_.SendGetRequest(task_id, data_name);
+  DoGet(data_name, GetPromiseHandler<typename DataName::data_type>(promise), timeout);
   return promise->get_future();
 }
 
+template <typename DataName, typename Handler>
+void DataGetter::Get(const DataName& data_name, Handler handler,
+                     const std::chrono::steady_clock::duration& timeout,
+                     typename std::enable_if<detail::IsCompletionHandler<
+                         Handler,
+                         GetCompletionHandler<typename DataName::data_type>>::value>::type*) {
+  LOG(kVerbose) << "DataGetter Get " << HexSubstr(data_name.value);
+  DoGet(data_name, GetCompletionHandler<typename DataName::data_type>(std::move(handler)),
+        timeout);
+}
+
+template <typename DataName>
+boost::future<void> DataGetter::GetMany(
+    std::vector<DataName> data_names, size_t window,
+    std::function<void(size_t, boost::future<typename DataName::data_type>)> result_functor,
+    const std::chrono::steady_clock::duration& timeout) {
+  LOG(kVerbose) << "DataGetter GetMany " << data_names.size() << " with window " << window;
+  return detail::GetMany(std::move(data_names), window, GetManyFunctor<DataName>(timeout),
+                         std::move(result_functor));
+}
+
+template <typename DataName>
+std::vector<boost::future<typename DataName::data_type>> DataGetter::GetMany(
+    std::vector<DataName> data_names, size_t window,
+    const std::chrono::steady_clock::duration& timeout) {
+  LOG(kVerbose) << "DataGetter GetMany " << data_names.size() << " with window " << window;
+  return detail::GetMany(std::move(data_names), window, GetManyFunctor<DataName>(timeout));
+}
+
+template <typename DataName>
+void DataGetter::DoGet(const DataName& data_name,
+                       GetCompletionHandler<typename DataName::data_type> handler,
+                       const std::chrono::steady_clock::duration& timeout) {
+  typedef typename DataName::data_type Data;
+  auto cached(data_cache_.Get<Data>(data_name));
+  if (cached)
+    return handler(std::error_code(), std::move(cached));
+  auto cache(data_cache_.Holds<Data>() ? &data_cache_ : nullptr);
+  get_coalescer_.Get(Data::Tag::kValue, data_name.value,
+                     latency_estimator_.ResolveTimeout(LatencyEstimator::Operation::kGet, timeout),
+                     [handler, cache](DataNameAndContentOrReturnCode result) {
+                       CompleteGet(std::move(result), cache, handler);
+                     });
+}
+
+template <typename DataName>
+std::function<void(const DataName&,
+                   std::shared_ptr<boost::promise<typename DataName::data_type>>,
+                   std::function<void()>)>
+    DataGetter::GetManyFunctor(const std::chrono::steady_clock::duration& timeout) {
+  return [this, timeout](const DataName& data_name,
+                         std::shared_ptr<boost::promise<typename DataName::data_type>> promise,
+                         std::function<void()> on_completion) {
+    auto set_promise(GetPromiseHandler<typename DataName::data_type>(promise));
+    DoGet(data_name,
+          [set_promise, on_completion](std::error_code error,
+                                       boost::optional<typename DataName::data_type> data) {
+            set_promise(error, std::move(data));
+            on_completion();
+          },
+          timeout);
+  };
+}
+
 template <typename DataName>
 DataGetter::VersionNamesFuture DataGetter::GetVersions(
     const DataName& data_name, const std::chrono::steady_clock::duration& timeout) {
+  auto promise(
+      std::make_shared<boost::promise<std::vector<StructuredDataVersions::VersionName>>>());
+  DoGetVersions(data_name, VersionNamesPromiseHandler(promise), timeout);
+  return promise->get_future();
+}
+
+template <typename DataName, typename Handler>
+void DataGetter::GetVersions(
+    const DataName& data_name, Handler handler, const std::chrono::steady_clock::duration& timeout,
+    typename std::enable_if<detail::IsCompletionHandler<
+        Handler, VersionNamesCompletionHandler>::value>::type*) {
+  DoGetVersions(data_name, VersionNamesCompletionHandler(std::move(handler)), timeout);
+}
+
+template <typename DataName>
+void DataGetter::DoGetVersions(const DataName& data_name, VersionNamesCompletionHandler handler,
+                               const std::chrono::steady_clock::duration& timeout) {
   typedef DataGetterService::GetVersionsResponse::Contents ResponseContents;
-  auto promise(std::make_shared<VersionNamesPromise>());
-  auto response_functor([promise](const StructuredDataNameAndContentOrReturnCode&
-                                  result) { HandleGetVersionsOrBranchResult(result, promise); });
+  auto get_timeout(
+      latency_estimator_.ResolveTimeout(LatencyEstimator::Operation::kGetVersions, timeout, 0));
+  auto sent(std::chrono::steady_clock::now());
+  auto response_functor([this, handler, sent, get_timeout](
+                            StructuredDataNameAndContentOrReturnCode result) {
+                           latency_estimator_.AddResponse(
+                               LatencyEstimator::Operation::kGetVersions, 0, sent, get_timeout);
+                           CompleteGetVersionsOrBranch(std::move(result), handler);
+                        });
   auto op_data(std::make_shared<nfs::OpData<ResponseContents>>(1, response_functor));
   auto task_id(get_versions_timer_.NewTaskId());
   get_versions_timer_.AddTask(
-      timeout, [op_data](ResponseContents get_versions_response) {
+      get_timeout, [op_data](ResponseContents get_versions_response) {
                  op_data->HandleResponseContents(std::move(get_versions_response));
                },
       // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
       routing::Parameters::group_size * 2, task_id);
   dispatcher_.SendGetVersionsRequest(task_id, data_name);
-  return promise->get_future();
 }
 
 template <typename DataName>
 DataGetter::VersionNamesFuture DataGetter::GetBranch(
     const DataName& data_name, const StructuredDataVersions::VersionName& branch_tip,
     const std::chrono::steady_clock::duration& timeout) {
+  auto promise(
+      std::make_shared<boost::promise<std::vector<StructuredDataVersions::VersionName>>>());
+  DoGetBranch(data_name, branch_tip, VersionNamesPromiseHandler(promise), timeout);
+  return promise->get_future();
+}
+
+template <typename DataName, typename Handler>
+void DataGetter::GetBranch(
+    const DataName& data_name, const StructuredDataVersions::VersionName& branch_tip,
+    Handler handler, const std::chrono::steady_clock::duration& timeout,
+    typename std::enable_if<detail::IsCompletionHandler<
+        Handler, VersionNamesCompletionHandler>::value>::type*) {
+  DoGetBranch(data_name, branch_tip, VersionNamesCompletionHandler(std::move(handler)), timeout);
+}
+
+template <typename DataName>
+void DataGetter::DoGetBranch(const DataName& data_name,
+                             const StructuredDataVersions::VersionName& branch_tip,
+                             VersionNamesCompletionHandler handler,
+                             const std::chrono::steady_clock::duration& timeout) {
   typedef DataGetterService::GetBranchResponse::Contents ResponseContents;
-  auto promise(std::make_shared<VersionNamesPromise>());
-  auto response_functor([promise](const StructuredDataNameAndContentOrReturnCode &
-                                  result) { HandleGetVersionsOrBranchResult(result, promise); });
+  auto get_timeout(
+      latency_estimator_.ResolveTimeout(LatencyEstimator::Operation::kGetBranch, timeout, 0));
+  auto sent(std::chrono::steady_clock::now());
+  auto response_functor([this, handler, sent, get_timeout](
+                            StructuredDataNameAndContentOrReturnCode result) {
+                           latency_estimator_.AddResponse(
+                               LatencyEstimator::Operation::kGetBranch, 0, sent, get_timeout);
+                           CompleteGetVersionsOrBranch(std::move(result), handler);
+                        });
   auto op_data(std::make_shared<nfs::OpData<ResponseContents>>(1, response_functor));
-  auto task_id(get_branch_timer_.AddTask(timeout, [op_data](ResponseContents get_branch_response) {
-                                                    op_data->HandleResponseContents(
-                                                        std::move(get_branch_response));
-                                                  },
-                                         // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
-                                         routing::Parameters::group_size * 2));
+  auto task_id(get_branch_timer_.AddTask(
+      get_timeout, [op_data](ResponseContents get_branch_response) {
+                     op_data->HandleResponseContents(std::move(get_branch_response));
+                   },
+      // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
+      routing::Parameters::group_size * 2));
   dispatcher_.SendGetBranchRequest(task_id, data_name, branch_tip);
-  return promise->get_future();
 }
 
 template <typename T>
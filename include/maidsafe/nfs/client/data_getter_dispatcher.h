@@ -40,13 +40,13 @@ class DataGetterDispatcher {
   explicit DataGetterDispatcher(routing::Routing& routing);
 
   template <typename DataName>
-  void SendGetRequest(routing::TaskId task_id, const DataName& data_name);
+  void SendGetRequest(nfs::TaskId task_id, const DataName& data_name);
 
   template <typename DataName>
-  void SendGetVersionsRequest(routing::TaskId task_id, const DataName& data_name);
+  void SendGetVersionsRequest(nfs::TaskId task_id, const DataName& data_name);
 
   template <typename DataName>
-  void SendGetBranchRequest(routing::TaskId task_id, const DataName& data_name,
+  void SendGetBranchRequest(nfs::TaskId task_id, const DataName& data_name,
                             const StructuredDataVersions::VersionName& branch_tip);
 
  private:
@@ -64,7 +64,7 @@ class DataGetterDispatcher {
 
 // ==================== Implementation =============================================================
 template <typename DataName>
-void DataGetterDispatcher::SendGetRequest(routing::TaskId task_id, const DataName& data_name) {
+void DataGetterDispatcher::SendGetRequest(nfs::TaskId task_id, const DataName& data_name) {
   LOG(kVerbose) << "DataGetterDispatcher::SendGetRequest " << HexSubstr(data_name.value)
                 << " with task_id : " << task_id;
   typedef nfs::GetRequestFromDataGetterToDataManager NfsMessage;
@@ -83,7 +83,7 @@ void DataGetterDispatcher::SendGetRequest(routing::TaskId task_id, const DataNam
 }
 
 template <typename DataName>
-void DataGetterDispatcher::SendGetVersionsRequest(routing::TaskId task_id,
+void DataGetterDispatcher::SendGetVersionsRequest(nfs::TaskId task_id,
                                                   const DataName& data_name) {
   typedef nfs::GetVersionsRequestFromDataGetterToVersionHandler NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
@@ -100,7 +100,7 @@ void DataGetterDispatcher::SendGetVersionsRequest(routing::TaskId task_id,
 
 template <typename DataName>
 void DataGetterDispatcher::SendGetBranchRequest(
-    routing::TaskId task_id, const DataName& data_name,
+    nfs::TaskId task_id, const DataName& data_name,
     const StructuredDataVersions::VersionName& branch_tip) {
   typedef nfs::GetBranchRequestFromDataGetterToVersionHandler NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
@@ -0,0 +1,88 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_CLIENT_DISK_CACHE_H_
+#define MAIDSAFE_NFS_CLIENT_DISK_CACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+// 'entries' includes those still queued to be written; 'bytes' and 'segments' are as on disk.
+struct DiskCacheStats {
+  DiskCacheStats();
+
+  uint64_t entries, bytes, segments;
+};
+
+// Persistent cache of content-addressed chunks (i.e. ImmutableData, whose name is the SHA512 hash
+// of its contents), kept in append-only segment files under 'directory'.
+//
+// Only a small index (name to segment, offset and size) is held in memory.  On construction this
+// is rebuilt by reading just the record headers of any existing segments; a record truncated by a
+// crash is discarded.  Reads are served from memory-mapped segments, and the contents are checked
+// against their name before being returned, so a corrupt entry is dropped rather than served.
+//
+// When the segments exceed 'max_bytes', the oldest segment is compacted: entries which have been
+// read since they were written are copied into the current segment (up to half a segment's
+// worth), and the rest are discarded along with the segment file.  A segment more than half of
+// which has been discarded (e.g. corrupt entries) is compacted the same way.
+//
+// Puts are queued and written, along with any compaction they trigger, by a thread owned by the
+// cache, so callers never wait on the disk; the internal lock is only held while the index is
+// consulted or updated.  A queued entry is served from memory until written.  At most a segment's
+// worth is queued at once, beyond which Puts are dropped.  Queued entries are written before the
+// cache is destroyed.
+class DiskCache {
+ public:
+  // Throws CommonErrors::filesystem_io_error if 'directory' can't be created.
+  DiskCache(const boost::filesystem::path& directory, uint64_t max_bytes);
+  ~DiskCache();
+
+  // Returns null if absent or corrupt.
+  std::shared_ptr<const std::string> Get(const Identity& name);
+  // Failures to write are logged, but otherwise ignored.
+  void Put(const Identity& name, std::shared_ptr<const std::string> content);
+  // Blocks until all entries queued so far have been written, along with any compaction.
+  void Flush();
+
+  DiskCacheStats stats() const;
+
+ private:
+  struct Impl;
+
+  DiskCache(const DiskCache&);
+  DiskCache(DiskCache&&);
+  DiskCache& operator=(DiskCache);
+
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_CLIENT_DISK_CACHE_H_
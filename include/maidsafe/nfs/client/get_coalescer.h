@@ -0,0 +1,85 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_CLIENT_GET_COALESCER_H_
+#define MAIDSAFE_NFS_CLIENT_GET_COALESCER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/data_types/data_name_variant.h"
+#include "maidsafe/common/data_types/data_type_values.h"
+
+#include "maidsafe/nfs/client/messages.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+// Coalesces concurrent Gets for the same name into a single network request (a "flight") whose
+// response is shared by every caller.  Each caller keeps its own timeout:
+// - a caller whose timeout is shorter than the flight's gets NfsErrors::timed_out when it expires,
+//   while the flight carries on for the others;
+// - if the flight times out while some callers still have time left, a new flight is started for
+//   them with the longest of their remaining times.
+// A caller may also cancel its Get; once a flight has no callers left, its request is cancelled.
+class GetCoalescer {
+ public:
+  typedef std::function<void(DataNameAndContentOrReturnCode)> ResultFunctor;
+  // Cancels a request, after which its result functor needn't be called.
+  typedef std::function<void()> CancelFunctor;
+  // Sends a Get for the name, arranging for the functor to be called with the chosen response, or
+  // with a default-constructed response if the request times out.  Further calls are ignored.
+  // Returns a functor which cancels the request, or an empty one if it can't be cancelled.
+  typedef std::function<CancelFunctor(const DataNameVariant&,
+                                      const std::chrono::steady_clock::duration&, ResultFunctor)>
+      SendFunctor;
+
+  GetCoalescer(AsioService& asio_service, SendFunctor send_functor);
+  ~GetCoalescer();
+
+  // 'result_functor' is called exactly once, unless the coalescer is destroyed first.  Returns an
+  // id for Cancel.
+  uint64_t Get(DataTagValue type, const Identity& raw_name,
+               const std::chrono::steady_clock::duration& timeout, ResultFunctor result_functor);
+
+  // Calls the result functor of the Get given 'id' by Get with CancelledError (see
+  // CancellationToken), unless it has already been called.
+  void Cancel(DataTagValue type, const Identity& raw_name, uint64_t id);
+
+  size_t InFlightCount() const;
+
+ private:
+  struct State;
+
+  GetCoalescer(const GetCoalescer&);
+  GetCoalescer(GetCoalescer&&);
+  GetCoalescer& operator=(GetCoalescer);
+
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_CLIENT_GET_COALESCER_H_
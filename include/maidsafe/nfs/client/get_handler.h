@@ -19,94 +19,202 @@
 #ifndef MAIDSAFE_NFS_CLIENT_GET_HANDLER_H_
 #define MAIDSAFE_NFS_CLIENT_GET_HANDLER_H_
 
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <tuple>
 #include <string>
 
+#include "boost/optional/optional.hpp"
 #include "boost/thread/future.hpp"
 
+#include "maidsafe/common/asio_service.h"
 #include "maidsafe/common/data_types/data_name_variant.h"
 
 #include "maidsafe/routing/routing_api.h"
 #include "maidsafe/routing/timer.h"
 
+#include "maidsafe/nfs/pending_operations.h"
 #include "maidsafe/nfs/service.h"
+#include "maidsafe/nfs/client/cancellation_token.h"
+#include "maidsafe/nfs/client/data_cache.h"
+#include "maidsafe/nfs/client/get_coalescer.h"
+#include "maidsafe/nfs/client/latency_estimator.h"
 #include "maidsafe/nfs/client/maid_node_dispatcher.h"
 #include "maidsafe/nfs/client/maid_node_service.h"
+#include "maidsafe/nfs/client/negative_cache.h"
 #include "maidsafe/nfs/client/client_utils.h"
 
 namespace maidsafe {
 
 namespace nfs_client {
 
+struct HedgeParameters {
+  // Hedging is disabled by default.
+  HedgeParameters();
+  explicit HedgeParameters(double percentile_in,
+                           boost::optional<routing::Cacheable> cacheable_in = boost::none);
+
+  // A request which hasn't received content within this percentile (a fraction between 0 and 1)
+  // of recent Get round trips is hedged by sending a second one.  Zero disables hedging.
+  double percentile;
+  // Requests are only hedged once this many Get round trips have been measured.
+  size_t minimum_samples;
+  // If set, hedge requests are sent with this cacheability rather than the one for the data type,
+  // e.g. routing::Cacheable::kGet to allow a cache on the route to answer.
+  boost::optional<routing::Cacheable> cacheable;
+};
+
 class GetHandlerVisitor : public boost::static_visitor<> {
  public:
-  GetHandlerVisitor(MaidNodeDispatcher& dispatcher_in, routing::TaskId task_id)
-      : dispatcher_(dispatcher_in), kTaskId_(task_id) {}
+  GetHandlerVisitor(MaidNodeDispatcher& dispatcher_in, nfs::TaskId task_id,
+                    boost::optional<routing::Cacheable> cacheable = boost::none)
+      : dispatcher_(dispatcher_in), kTaskId_(task_id), kCacheable_(cacheable) {}
 
   template <typename Name>
   void operator()(const Name& data_name) {
     LOG(kVerbose) << "Get handler visitor sending get request for chunk "
                   << HexSubstr(data_name.value.string());
-    dispatcher_.SendGetRequest(kTaskId_, data_name);
+    if (kCacheable_)
+      dispatcher_.SendGetRequest(kTaskId_, data_name, *kCacheable_);
+    else
+      dispatcher_.SendGetRequest(kTaskId_, data_name);
   }
 
  private:
   MaidNodeDispatcher& dispatcher_;
-  const routing::TaskId kTaskId_;
+  const nfs::TaskId kTaskId_;
+  const boost::optional<routing::Cacheable> kCacheable_;
 };
 
 class GetHandler {
-  typedef std::tuple<size_t, routing::TaskId, DataNameVariant> GetInfo;
+  // Responses received, original task id, name, and how many of the responses were
+  // CommonErrors::no_such_element.
+  typedef std::tuple<size_t, nfs::TaskId, DataNameVariant, size_t> GetInfo;
   enum class Operation : int {
     kNoOperation = 0,
     kAddResponse = 1,
     kSendRequest = 2,
-    kCancelTask = 3
+    kCancelTask = 3,
+    kFailGet = 4
   };
 
  public:
-  GetHandler(routing::Timer<DataNameAndContentOrReturnCode>& get_timer_in,
-             MaidNodeDispatcher& dispatcher_in)
-      : get_timer(get_timer_in), dispatcher(dispatcher_in), get_info(), mutex() {}
-
+  // Sends a Get request for the name as the given task, with the given cacheability if set, or
+  // else the one for the data type.
+  typedef std::function<void(nfs::TaskId, const DataNameVariant&,
+                             boost::optional<routing::Cacheable>)> SendFunctor;
+
+  // 'latency_estimator_in' must outlive 'pending_operations_in'.
+  GetHandler(AsioService& asio_service, nfs::PendingOperations& pending_operations_in,
+             MaidNodeDispatcher& dispatcher_in, DataCache& data_cache_in,
+             NegativeCache& negative_cache_in, LatencyEstimator& latency_estimator_in,
+             const HedgeParameters& hedge_parameters_in = HedgeParameters());
+  // As above, but sends requests via 'send_request_in' rather than a dispatcher (e.g. for tests).
+  GetHandler(AsioService& asio_service, nfs::PendingOperations& pending_operations_in,
+             SendFunctor send_request_in, DataCache& data_cache_in,
+             NegativeCache& negative_cache_in, LatencyEstimator& latency_estimator_in,
+             const HedgeParameters& hedge_parameters_in = HedgeParameters());
+  ~GetHandler();
+
+  // Data held in 'data_cache' is returned immediately, and fetched data is added to it.  For types
+  // held by 'negative_cache', a name which a whole group reports as missing fails the Get (rather
+  // than the request being retried until it times out), and further Gets fail immediately until
+  // the cached failure expires.
+  // Concurrent Gets for the same name share a single request to the network.
+  // A 'timeout' of kAdaptiveTimeout is replaced by the estimated timeout for Gets (see
+  // LatencyEstimator).  Each request to the network is given at most the estimated timeout, after
+  // which it's resent if the Get still has time left, so that a lost or stalled request is retried
+  // promptly rather than holding up the Get until its timeout.  If hedging is enabled (see
+  // HedgeParameters), a request which is slow to receive content is hedged by a second one; the
+  // first content from either is used and the other is cancelled.
+  // 'handler' is called with the outcome (possibly before returning).  Cancelling
+  // 'cancellation_token' fails the Get with CancelledError, cancelling its requests if no other
+  // Gets are waiting on them.
   template <typename DataName>
-  void Get(const DataName& data_name,
-           std::shared_ptr<boost::promise<typename DataName::data_type>> promise,
-           const std::chrono::steady_clock::duration& timeout);
+  void Get(const DataName& data_name, GetCompletionHandler<typename DataName::data_type> handler,
+           const std::chrono::steady_clock::duration& timeout,
+           const CancellationToken& cancellation_token = CancellationToken());
 
-  void AddResponse(routing::TaskId task_id, const DataNameAndContentOrReturnCode& response);
+  // Header-only check which allows callers to drop late or duplicate responses without decoding
+  // their contents.
+  bool HasPendingTask(nfs::TaskId task_id);
+
+  void AddResponse(nfs::TaskId task_id, const DataNameAndContentOrReturnCode& response);
 
  private:
-  routing::Timer<DataNameAndContentOrReturnCode>& get_timer;
-  MaidNodeDispatcher& dispatcher;
-  std::map<routing::TaskId, GetInfo> get_info;
+  // The requests sent for one attempt at a Get by the coalescer: the original and any hedge.
+  struct Attempt;
+  // Shared with hedge timers, which must not send once the handler is being destroyed.
+  struct Lifetime {
+    Lifetime() : mutex(), destroyed(false) {}
+    std::mutex mutex;
+    bool destroyed;
+  };
+
+  GetHandler(const GetHandler&);
+  GetHandler(GetHandler&&);
+  GetHandler& operator=(GetHandler);
+
+  GetCoalescer::CancelFunctor SendGet(const DataNameVariant& data_name,
+                                      const std::chrono::steady_clock::duration& timeout,
+                                      GetCoalescer::ResultFunctor result_functor);
+  void SendRequest(std::shared_ptr<Attempt> attempt, const DataNameVariant& data_name,
+                   const std::chrono::steady_clock::duration& timeout,
+                   boost::optional<routing::Cacheable> cacheable);
+  // Returns how long to wait for content before hedging a request, or none not to hedge.
+  boost::optional<std::chrono::steady_clock::duration> HedgeDelay() const;
+  // Drops the entries of requests which have expired.  Must be called with 'mutex' locked.
+  void PurgeExpiredGetInfo();
+
+  nfs::PendingOperations& pending_operations;
+  const SendFunctor send_request;
+  DataCache& data_cache;
+  NegativeCache& negative_cache;
+  LatencyEstimator& latency_estimator;
+  const HedgeParameters hedge_parameters;
+  boost::asio::io_service& io_service;
+  std::shared_ptr<Lifetime> lifetime;
+  std::map<nfs::TaskId, GetInfo> get_info;
+  // 'get_info' is purged once it reaches this size.
+  size_t purge_size;
   std::mutex mutex;
+  GetCoalescer coalescer;
 };
 
 template <typename DataName>
 void GetHandler::Get(const DataName& data_name,
-                     std::shared_ptr<boost::promise<typename DataName::data_type>> promise,
-                     const std::chrono::steady_clock::duration& timeout) {
-  auto task_id(get_timer.NewTaskId());
-  HandleGetResult<typename DataName::data_type> response_functor(promise);
-  auto op_data(
-           std::make_shared<nfs::OpData<DataNameAndContentOrReturnCode>>(1, response_functor));
-  {
-    std::lock_guard<std::mutex> lock(mutex);
-    get_info.insert(std::make_pair(task_id, std::make_tuple(0, task_id,
-                                   GetDataNameVariant(DataName::data_type::Tag::kValue,
-                                                      data_name.value))));
+                     GetCompletionHandler<typename DataName::data_type> handler,
+                     const std::chrono::steady_clock::duration& timeout,
+                     const CancellationToken& cancellation_token) {
+  typedef typename DataName::data_type Data;
+  if (cancellation_token.cancelled())
+    return handler(CancelledError().code(), boost::none);
+  auto cached(data_cache.Get<Data>(data_name));
+  if (cached)
+    return handler(std::error_code(), std::move(cached));
+  auto failure(negative_cache.Get(Data::Tag::kValue, data_name.value));
+  if (failure)
+    return CompleteGet(DataNameAndContentOrReturnCode(data_name, *failure), nullptr, handler);
+  auto cache(data_cache.Holds<Data>() ? &data_cache : nullptr);
+  auto cancellable(MakeCancellableOperation(cancellation_token));
+  GetCoalescer::ResultFunctor handle_result([handler, cache, cancellable](
+      DataNameAndContentOrReturnCode result) {
+    // The coalescer passes exactly one result, which is CancelledError if the Get was cancelled.
+    if (cancellable)
+      cancellable->Complete();
+    CompleteGet(std::move(result), cache, handler);
+  });
+  auto id(coalescer.Get(
+      Data::Tag::kValue, data_name.value,
+      latency_estimator.ResolveTimeout(LatencyEstimator::Operation::kGet, timeout),
+      std::move(handle_result)));
+  if (cancellable) {
+    cancellable->Arm([this, data_name, id] {
+      coalescer.Cancel(Data::Tag::kValue, data_name.value, id);
+    });
   }
-  get_timer.AddTask(timeout,
-                    [op_data, data_name](DataNameAndContentOrReturnCode get_response) {
-                       LOG(kVerbose) << "GetHandler Get HandleResponseContents for "
-                                     << HexSubstr(data_name.value);
-                       op_data->HandleResponseContents(std::move(get_response));
-                    },
-                    // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
-                    routing::Parameters::group_size * 2, task_id);
-  dispatcher.SendGetRequest(task_id, data_name);
 }
 
 }  // namespace nfs_client
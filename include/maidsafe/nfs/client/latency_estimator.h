@@ -0,0 +1,136 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_CLIENT_LATENCY_ESTIMATOR_H_
+#define MAIDSAFE_NFS_CLIENT_LATENCY_ESTIMATOR_H_
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "boost/optional/optional.hpp"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+// Passed as the timeout of a MaidNodeNfs or DataGetter operation (it is the default), selects one
+// derived from the measured latency of that kind of operation (see LatencyEstimator).
+const std::chrono::steady_clock::duration kAdaptiveTimeout(
+    std::chrono::steady_clock::duration::zero());
+
+// Estimates a timeout for each kind of operation from the round-trip times of earlier ones, in the
+// way TCP computes its retransmission timeout (RFC 6298): a smoothed mean plus four times the
+// smoothed mean deviation, doubled after each timeout until a round trip is measured again.
+// Estimates are kept per operation and per payload size bucket (each bucket four times the size
+// of the one before, from 4 KiB), and also per operation across all sizes for when the payload
+// size isn't known in advance (e.g. for a Get).  Until an estimate has any samples, the initial
+// timeout is used.
+class LatencyEstimator {
+ public:
+  enum class Operation : int {
+    kGet,
+    kPut,
+    kCreateVersionTree,
+    kGetVersions,
+    kGetBranch,
+    kPutVersion
+  };
+
+  struct Estimate {
+    Estimate() : smoothed(), deviation(), timeout(), samples(0), timeouts(0) {}
+    std::chrono::steady_clock::duration smoothed, deviation, timeout;
+    uint64_t samples, timeouts;
+  };
+
+  struct OperationEstimates {
+    OperationEstimates() : all_sizes(), by_size() {}
+    Estimate all_sizes;
+    // Keyed by the smallest payload size in the bucket.
+    std::map<uint64_t, Estimate> by_size;
+  };
+
+  typedef std::map<Operation, OperationEstimates> Estimates;
+
+  // Throws CommonErrors::invalid_parameter unless 0 < minimum <= initial <= maximum.
+  explicit LatencyEstimator(
+      const std::chrono::steady_clock::duration& initial_timeout = std::chrono::seconds(10),
+      const std::chrono::steady_clock::duration& minimum_timeout = std::chrono::seconds(1),
+      const std::chrono::steady_clock::duration& maximum_timeout = std::chrono::seconds(60));
+
+  // Timeout for an operation whose payload size isn't known.
+  std::chrono::steady_clock::duration Timeout(Operation operation) const;
+  std::chrono::steady_clock::duration Timeout(Operation operation, uint64_t payload_size) const;
+
+  // Returns 'timeout', or the estimated timeout if 'timeout' is kAdaptiveTimeout.
+  std::chrono::steady_clock::duration ResolveTimeout(
+      Operation operation, const std::chrono::steady_clock::duration& timeout) const;
+  std::chrono::steady_clock::duration ResolveTimeout(
+      Operation operation, const std::chrono::steady_clock::duration& timeout,
+      uint64_t payload_size) const;
+
+  void AddSample(Operation operation, uint64_t payload_size,
+                 const std::chrono::steady_clock::duration& round_trip);
+  void AddTimeout(Operation operation, uint64_t payload_size);
+  // Adds the round trip of a request sent at 'sent' with the given 'timeout', or a timeout if the
+  // response only arrived once that had passed (i.e. it's the one passed on expiry).
+  void AddResponse(Operation operation, uint64_t payload_size,
+                   std::chrono::steady_clock::time_point sent,
+                   const std::chrono::steady_clock::duration& timeout);
+
+  Estimates estimates() const;
+
+  // Returns the given percentile (a fraction between 0 and 1) of the most recent round trips of
+  // 'operation' across all sizes, or none if fewer than 'minimum_samples' have been measured.
+  boost::optional<std::chrono::steady_clock::duration> Percentile(Operation operation,
+                                                                  double fraction,
+                                                                  size_t minimum_samples) const;
+
+  // Returns the smallest payload size in the bucket holding 'payload_size'.
+  static uint64_t SizeBucket(uint64_t payload_size);
+
+ private:
+  LatencyEstimator(const LatencyEstimator&);
+  LatencyEstimator(LatencyEstimator&&);
+  LatencyEstimator& operator=(LatencyEstimator);
+
+  // A ring buffer of the most recent round trips.
+  struct RecentRoundTrips {
+    RecentRoundTrips() : round_trips(), next(0) {}
+    std::vector<std::chrono::steady_clock::duration> round_trips;
+    size_t next;
+  };
+
+  // Must be called with 'mutex_' locked.
+  void Update(Estimate& estimate, const std::chrono::steady_clock::duration& round_trip) const;
+  void BackOff(Estimate& estimate) const;
+  std::chrono::steady_clock::duration Timeout(const Estimate* estimate) const;
+
+  const std::chrono::steady_clock::duration initial_timeout_, minimum_timeout_, maximum_timeout_;
+  mutable std::mutex mutex_;
+  Estimates estimates_;
+  std::map<Operation, RecentRoundTrips> recent_round_trips_;
+};
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_CLIENT_LATENCY_ESTIMATOR_H_
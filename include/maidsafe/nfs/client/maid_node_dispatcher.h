@@ -19,8 +19,10 @@
 #ifndef MAIDSAFE_NFS_CLIENT_MAID_NODE_DISPATCHER_H_
 #define MAIDSAFE_NFS_CLIENT_MAID_NODE_DISPATCHER_H_
 
+#include <memory>
 #include <string>
 
+#include "maidsafe/common/asio_service.h"
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/types.h"
 #include "maidsafe/common/data_types/data_type_values.h"
@@ -30,6 +32,7 @@
 #include "maidsafe/routing/routing_api.h"
 #include "maidsafe/routing/timer.h"
 
+#include "maidsafe/nfs/message_batcher.h"
 #include "maidsafe/nfs/message_types.h"
 #include "maidsafe/nfs/types.h"
 #include "maidsafe/nfs/client/messages.h"
@@ -42,31 +45,40 @@ namespace nfs_client {
 class MaidNodeDispatcher {
  public:
   explicit MaidNodeDispatcher(routing::Routing& routing);
+  // Requests to the MaidManagers are coalesced into batches according to 'batch_parameters'.  The
+  // receiving service must then handle them via nfs::Service::HandleMessages.
+  MaidNodeDispatcher(routing::Routing& routing, AsioService& asio_service,
+                     const nfs::BatchParameters& batch_parameters);
 
   template <typename DataName>
-  void SendGetRequest(routing::TaskId task_id, const DataName& data_name);
+  void SendGetRequest(nfs::TaskId task_id, const DataName& data_name);
+
+  // As above, but sent with the given cacheability rather than the one for the data type.
+  template <typename DataName>
+  void SendGetRequest(nfs::TaskId task_id, const DataName& data_name,
+                      routing::Cacheable cacheable);
 
   template <typename Data>
-  void SendPutRequest(routing::TaskId task_id, const Data& data,
+  void SendPutRequest(nfs::TaskId task_id, const Data& data,
                       const passport::PublicPmid::Name& pmid_node_hint);
 
   template <typename DataName>
   void SendDeleteRequest(const DataName& data_name);
 
   template <typename DataName>
-  void SendCreateVersionTreeRequest(routing::TaskId task_id, const DataName& data_name,
+  void SendCreateVersionTreeRequest(nfs::TaskId task_id, const DataName& data_name,
                                     const StructuredDataVersions::VersionName& version_name,
                                     uint32_t max_versions, uint32_t max_branches);
 
   template <typename DataName>
-  void SendGetVersionsRequest(routing::TaskId task_id, const DataName& data_name);
+  void SendGetVersionsRequest(nfs::TaskId task_id, const DataName& data_name);
 
   template <typename DataName>
-  void SendGetBranchRequest(routing::TaskId task_id, const DataName& data_name,
+  void SendGetBranchRequest(nfs::TaskId task_id, const DataName& data_name,
                             const StructuredDataVersions::VersionName& branch_tip);
 
   template <typename DataName>
-  void SendPutVersionRequest(routing::TaskId task_id, const DataName& data_name,
+  void SendPutVersionRequest(nfs::TaskId task_id, const DataName& data_name,
                              const StructuredDataVersions::VersionName& old_version_name,
                              const StructuredDataVersions::VersionName& new_version_name);
 
@@ -74,17 +86,17 @@ class MaidNodeDispatcher {
   void SendDeleteBranchUntilForkRequest(const DataName& data_name,
                                         const StructuredDataVersions::VersionName& branch_tip);
 
-  void SendCreateAccountRequest(routing::TaskId task_id,
+  void SendCreateAccountRequest(nfs::TaskId task_id,
                                 const nfs_vault::AccountCreation& account_creation);
 
   void SendRemoveAccountRequest(const nfs_vault::AccountRemoval& account_removal);
 
-  void SendRegisterPmidRequest(routing::TaskId task_id,
+  void SendRegisterPmidRequest(nfs::TaskId task_id,
                                const nfs_vault::PmidRegistration& pmid_registration);
 
   void SendUnregisterPmidRequest(const passport::PublicPmid::Name& pmid_name);
 
-  void SendPmidHealthRequest(routing::TaskId task_id, const passport::PublicPmid::Name& pmid_name);
+  void SendPmidHealthRequest(nfs::TaskId task_id, const passport::PublicPmid::Name& pmid_name);
 
  private:
   MaidNodeDispatcher();
@@ -95,57 +107,64 @@ class MaidNodeDispatcher {
   template <typename Message>
   void CheckSourcePersonaType() const;
 
+  void SendToMaidManager(std::string serialised_message);
+
   routing::Routing& routing_;
   const routing::SingleSource kThisNodeAsSender_;
   const routing::GroupId kMaidManagerReceiver_;
+  std::unique_ptr<nfs::MessageBatcher> maid_manager_batcher_;
 };
 
 // ==================== Implementation =============================================================
 template <typename DataName>
-void MaidNodeDispatcher::SendGetRequest(routing::TaskId task_id, const DataName& data_name) {
+void MaidNodeDispatcher::SendGetRequest(nfs::TaskId task_id, const DataName& data_name) {
+  static const routing::Cacheable kCacheable(is_cacheable<typename DataName::data_type>::value ?
+      routing::Cacheable::kGet : routing::Cacheable::kNone);
+  SendGetRequest(task_id, data_name, kCacheable);
+}
+
+template <typename DataName>
+void MaidNodeDispatcher::SendGetRequest(nfs::TaskId task_id, const DataName& data_name,
+                                        routing::Cacheable cacheable) {
   typedef nfs::GetRequestFromMaidNodeToDataManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
   typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
-  static const routing::Cacheable kCacheable(is_cacheable<typename DataName::data_type>::value ?
-      routing::Cacheable::kGet : routing::Cacheable::kNone);
   LOG(kVerbose) << "MaidNodeDispatcher::SendGetRequest for task_id " << task_id
                 << ", data name: " << HexSubstr(data_name->string());
   nfs::MessageId message_id(task_id);
   NfsMessage::Contents content(data_name);
   NfsMessage nfs_message(message_id, content);
   NfsMessage::Receiver receiver(routing::GroupId(NodeId(data_name->string())));
-  RoutingMessage routing_message(nfs_message.Serialise(), kThisNodeAsSender_, receiver, kCacheable);
+  RoutingMessage routing_message(nfs_message.Serialise(), kThisNodeAsSender_, receiver, cacheable);
   routing_.Send(routing_message);
 }
 
 template <typename Data>
-void MaidNodeDispatcher::SendPutRequest(routing::TaskId task_id, const Data& data,
+void MaidNodeDispatcher::SendPutRequest(nfs::TaskId task_id, const Data& data,
                                         const passport::PublicPmid::Name& pmid_node_hint) {
   LOG(kVerbose) << "MaidNodeDispatcher::SendPutRequest for chunk "
                 << HexSubstr(data.name().value.string())
                 << " to PmidHint " << HexSubstr(pmid_node_hint.value);
   typedef nfs::PutRequestFromMaidNodeToMaidManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
-  typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
   NfsMessage::Contents contents;
   contents.data = nfs_vault::DataNameAndContent(data);
   contents.pmid_hint = pmid_node_hint.value;
   NfsMessage nfs_message(nfs::MessageId(task_id), contents);
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  SendToMaidManager(nfs_message.Serialise());
 }
 
 template <typename DataName>
 void MaidNodeDispatcher::SendDeleteRequest(const DataName& data_name) {
   typedef nfs::DeleteRequestFromMaidNodeToMaidManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
-  typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
 
   NfsMessage nfs_message((NfsMessage::Contents(data_name)));
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  SendToMaidManager(nfs_message.Serialise());
 }
 
 template <typename DataName>
-void MaidNodeDispatcher::SendGetVersionsRequest(routing::TaskId task_id,
+void MaidNodeDispatcher::SendGetVersionsRequest(nfs::TaskId task_id,
                                                 const DataName& data_name) {
   typedef nfs::GetVersionsRequestFromMaidNodeToVersionHandler NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
@@ -160,7 +179,7 @@ void MaidNodeDispatcher::SendGetVersionsRequest(routing::TaskId task_id,
 
 template <typename DataName>
 void MaidNodeDispatcher::SendGetBranchRequest(
-    routing::TaskId task_id, const DataName& data_name,
+    nfs::TaskId task_id, const DataName& data_name,
     const StructuredDataVersions::VersionName& branch_tip) {
   typedef nfs::GetBranchRequestFromMaidNodeToVersionHandler NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
@@ -174,30 +193,28 @@ void MaidNodeDispatcher::SendGetBranchRequest(
 
 template <typename DataName>
 void MaidNodeDispatcher::SendCreateVersionTreeRequest(
-    routing::TaskId task_id, const DataName& data_name,
+    nfs::TaskId task_id, const DataName& data_name,
     const StructuredDataVersions::VersionName& version_name, uint32_t max_versions,
     uint32_t max_branches) {
   typedef nfs::CreateVersionTreeRequestFromMaidNodeToMaidManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
-  typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
 
   NfsMessage::Contents contents(data_name, version_name, max_versions, max_branches);
   NfsMessage nfs_message(nfs::MessageId(task_id), contents);
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  SendToMaidManager(nfs_message.Serialise());
 }
 
 template <typename DataName>
-void MaidNodeDispatcher::SendPutVersionRequest(routing::TaskId task_id,
+void MaidNodeDispatcher::SendPutVersionRequest(nfs::TaskId task_id,
     const DataName& data_name,
     const StructuredDataVersions::VersionName& old_version_name,
     const StructuredDataVersions::VersionName& new_version_name) {
   typedef nfs::PutVersionRequestFromMaidNodeToMaidManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
-  typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
 
   NfsMessage nfs_message(nfs::MessageId(task_id),
                          NfsMessage::Contents(data_name, old_version_name, new_version_name));
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  SendToMaidManager(nfs_message.Serialise());
 }
 
 template <typename DataName>
@@ -205,11 +222,10 @@ void MaidNodeDispatcher::SendDeleteBranchUntilForkRequest(
     const DataName& data_name, const StructuredDataVersions::VersionName& branch_tip) {
   typedef nfs::DeleteBranchUntilForkRequestFromMaidNodeToMaidManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
-  typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
 
   NfsMessage::Contents contents(data_name, branch_tip);
   NfsMessage nfs_message(contents);
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  SendToMaidManager(nfs_message.Serialise());
 }
 
 template <typename Message>
@@ -19,10 +19,12 @@
 #ifndef MAIDSAFE_NFS_CLIENT_MAID_NODE_NFS_H_
 #define MAIDSAFE_NFS_CLIENT_MAID_NODE_NFS_H_
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "boost/thread/future.hpp"
@@ -32,15 +34,21 @@
 #include "maidsafe/passport/types.h"
 #include "maidsafe/routing/parameters.h"
 #include "maidsafe/routing/routing_api.h"
-#include "maidsafe/routing/timer.h"
 
 #include "maidsafe/nfs/message_wrapper.h"
+#include "maidsafe/nfs/pending_operations.h"
 #include "maidsafe/nfs/service.h"
 #include "maidsafe/nfs/utils.h"
+#include "maidsafe/nfs/client/cancellation_token.h"
 #include "maidsafe/nfs/client/client_utils.h"
+#include "maidsafe/nfs/client/data_cache.h"
 #include "maidsafe/nfs/client/maid_node_dispatcher.h"
 #include "maidsafe/nfs/client/maid_node_service.h"
+#include "maidsafe/nfs/client/negative_cache.h"
+#include "maidsafe/nfs/client/request_window.h"
+#include "maidsafe/nfs/client/version_cache.h"
 #include "maidsafe/nfs/client/get_handler.h"
+#include "maidsafe/nfs/client/latency_estimator.h"
 
 namespace maidsafe {
 
@@ -52,21 +60,102 @@ class MaidNodeNfs {
   typedef boost::future<std::unique_ptr<StructuredDataVersions::VersionName>> PutVersionFuture;
   typedef boost::future<uint64_t> PmidHealthFuture;
 
+  // By default, requests are not batched (see MaidNodeDispatcher), data isn't cached (see
+  // DataCache) and Get requests aren't hedged (see HedgeParameters).
   MaidNodeNfs(AsioService& asio_service, routing::Routing& routing,
               passport::PublicPmid::Name pmid_node_hint =
-                  passport::PublicPmid::Name(Identity(RandomString(64))));
+                  passport::PublicPmid::Name(Identity(RandomString(64))),
+              const nfs::BatchParameters& batch_parameters = nfs::BatchParameters(),
+              const DataCacheParameters& data_cache_parameters = DataCacheParameters(),
+              const HedgeParameters& hedge_parameters = HedgeParameters());
+  ~MaidNodeNfs();
 
   passport::PublicPmid::Name pmid_node_hint() const;
   void set_pmid_node_hint(const passport::PublicPmid::Name& pmid_node_hint);
 
+  DataCacheStats data_cache_stats() const { return data_cache_.stats(); }
+
+  // The service which runs this client's timers and callbacks (e.g. for resuming coroutines
+  // awaiting its operations, see awaitable.h).
+  boost::asio::io_service& io_service() { return io_service_; }
+
+  // Unless stated otherwise, operations given a timeout of kAdaptiveTimeout (the default) use one
+  // estimated from the round-trip times of earlier operations of the same kind.
+  // Once an operation's 'cancellation_token' is cancelled, the operation fails with CancelledError
+  // (see CancellationToken): its pending request is dropped at once and any later responses to it
+  // are ignored.  By default operations can't be cancelled.
+  // Get, Put, GetVersions, GetBranch and PutVersion also take a completion handler in place of
+  // returning a future (see GetCompletionHandler), which avoids allocating a future's shared state
+  // per operation; the future forms are adapters over these.
+  LatencyEstimator::Estimates latency_estimates() const { return latency_estimator_.estimates(); }
+
   template <typename DataName>
   boost::future<typename DataName::data_type> Get(
       const DataName& data_name,
-      const std::chrono::steady_clock::duration& timeout = std::chrono::seconds(10));
+      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+      const CancellationToken& cancellation_token = CancellationToken());
+
+  // As Get, but the fetched data is handed over without being copied into the future.
+  template <typename DataName>
+  boost::future<std::shared_ptr<const typename DataName::data_type>> GetShared(
+      const DataName& data_name,
+      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+      const CancellationToken& cancellation_token = CancellationToken());
+
+  // 'handler' must be convertible to GetCompletionHandler<DataName::data_type>.
+  template <typename DataName, typename Handler>
+  void Get(const DataName& data_name, Handler handler,
+           const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+           const CancellationToken& cancellation_token = CancellationToken(),
+           typename std::enable_if<detail::IsCompletionHandler<
+               Handler, GetCompletionHandler<typename DataName::data_type>>::value>::type* = 0);
+
+  // Gets each of 'data_names', keeping at most 'window' requests outstanding and starting the next
+  // as each completes.  'result_functor' is called with each name's index in 'data_names' and a
+  // ready future holding its data or error, in the order the Gets complete.  The returned future
+  // becomes ready once all have completed.  Throws CommonErrors::invalid_parameter if 'window' is
+  // zero.
+  template <typename DataName>
+  boost::future<void> GetMany(
+      std::vector<DataName> data_names, size_t window,
+      std::function<void(size_t, boost::future<typename DataName::data_type>)> result_functor,
+      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+      const CancellationToken& cancellation_token = CancellationToken());
+
+  // As above, but returns a future per name, in the order of 'data_names'.
+  template <typename DataName>
+  std::vector<boost::future<typename DataName::data_type>> GetMany(
+      std::vector<DataName> data_names, size_t window,
+      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+      const CancellationToken& cancellation_token = CancellationToken());
 
   template <typename Data>
-  boost::future<void> Put(const Data& data, const std::chrono::steady_clock::duration& timeout =
-                                                std::chrono::seconds(10));
+  boost::future<void> Put(const Data& data,
+                          const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+                          const CancellationToken& cancellation_token = CancellationToken());
+
+  // 'handler' must be convertible to PutCompletionHandler.
+  template <typename Data, typename Handler>
+  void Put(const Data& data, Handler handler,
+           const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+           const CancellationToken& cancellation_token = CancellationToken(),
+           typename std::enable_if<detail::IsCompletionHandler<
+               Handler, PutCompletionHandler>::value>::type* = 0);
+
+  // Puts each data returned by 'generator' until it returns none, pulling the next only when there
+  // is room for it, so that the whole upload needn't be held in memory.  At most 'max_outstanding'
+  // Puts, totalling at most 'max_outstanding_bytes' of serialised data, are awaiting acks at any
+  // time (a single data larger than this is Put alone).  'result_functor' is called with each
+  // data's name and a ready future holding its outcome as the acks arrive.  The returned future
+  // becomes ready once all have completed, holding any exception thrown by 'generator'.  Throws
+  // CommonErrors::invalid_parameter if either limit is zero.
+  template <typename Data>
+  boost::future<void> PutMany(
+      std::function<boost::optional<Data>()> generator, size_t max_outstanding,
+      uint64_t max_outstanding_bytes,
+      std::function<void(const typename Data::Name&, boost::future<void>)> result_functor,
+      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+      const CancellationToken& cancellation_token = CancellationToken());
 
   template <typename DataName>
   void Delete(const DataName& data_name);
@@ -84,46 +173,89 @@ class MaidNodeNfs {
   boost::future<void> CreateVersionTree(const DataName& data_name,
                          const StructuredDataVersions::VersionName& version_name,
                          uint32_t max_versions, uint32_t max_branches,
-                         const std::chrono::steady_clock::duration& timeout =
-                             std::chrono::seconds(10));
+                         const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+                         const CancellationToken& cancellation_token = CancellationToken());
 
+  // If the version cache is enabled (see VersionCache) and holds a list fetched within
+  // 'max_staleness', that list is returned without going to the network.  By default the network
+  // is always used.
   template <typename DataName>
-  VersionNamesFuture GetVersions(const DataName& data_name,
-                                 const std::chrono::steady_clock::duration& timeout =
-                                     std::chrono::seconds(10));
+  VersionNamesFuture GetVersions(
+      const DataName& data_name,
+      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+      const std::chrono::steady_clock::duration& max_staleness =
+          std::chrono::steady_clock::duration::zero(),
+      const CancellationToken& cancellation_token = CancellationToken());
+
+  // 'handler' must be convertible to VersionNamesCompletionHandler.
+  template <typename DataName, typename Handler>
+  void GetVersions(
+      const DataName& data_name, Handler handler,
+      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+      const std::chrono::steady_clock::duration& max_staleness =
+          std::chrono::steady_clock::duration::zero(),
+      const CancellationToken& cancellation_token = CancellationToken(),
+      typename std::enable_if<detail::IsCompletionHandler<
+          Handler, VersionNamesCompletionHandler>::value>::type* = 0);
 
   template <typename DataName>
-  VersionNamesFuture GetBranch(const DataName& data_name,
-                               const StructuredDataVersions::VersionName& branch_tip,
-                               const std::chrono::steady_clock::duration& timeout =
-                                   std::chrono::seconds(10));
+  VersionNamesFuture GetBranch(
+      const DataName& data_name, const StructuredDataVersions::VersionName& branch_tip,
+      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+      const std::chrono::steady_clock::duration& max_staleness =
+          std::chrono::steady_clock::duration::zero(),
+      const CancellationToken& cancellation_token = CancellationToken());
+
+  // 'handler' must be convertible to VersionNamesCompletionHandler.
+  template <typename DataName, typename Handler>
+  void GetBranch(
+      const DataName& data_name, const StructuredDataVersions::VersionName& branch_tip,
+      Handler handler, const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+      const std::chrono::steady_clock::duration& max_staleness =
+          std::chrono::steady_clock::duration::zero(),
+      const CancellationToken& cancellation_token = CancellationToken(),
+      typename std::enable_if<detail::IsCompletionHandler<
+          Handler, VersionNamesCompletionHandler>::value>::type* = 0);
 
   template <typename DataName>
-  PutVersionFuture PutVersion(const DataName& data_name,
-                              const StructuredDataVersions::VersionName& old_version_name,
-                              const StructuredDataVersions::VersionName& new_version_name,
-                              const std::chrono::steady_clock::duration& timeout =
-                                  std::chrono::seconds(10));
+  PutVersionFuture PutVersion(
+      const DataName& data_name, const StructuredDataVersions::VersionName& old_version_name,
+      const StructuredDataVersions::VersionName& new_version_name,
+      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+      const CancellationToken& cancellation_token = CancellationToken());
+
+  // 'handler' must be convertible to PutVersionCompletionHandler.
+  template <typename DataName, typename Handler>
+  void PutVersion(
+      const DataName& data_name, const StructuredDataVersions::VersionName& old_version_name,
+      const StructuredDataVersions::VersionName& new_version_name, Handler handler,
+      const std::chrono::steady_clock::duration& timeout = kAdaptiveTimeout,
+      const CancellationToken& cancellation_token = CancellationToken(),
+      typename std::enable_if<detail::IsCompletionHandler<
+          Handler, PutVersionCompletionHandler>::value>::type* = 0);
 
   template <typename DataName>
   void DeleteBranchUntilFork(const DataName& data_name,
                              const StructuredDataVersions::VersionName& branch_tip);
 
-  boost::future<void> CreateAccount(const nfs_vault::AccountCreation& account_creation,
-                                    const std::chrono::steady_clock::duration& timeout =
-                                        std::chrono::seconds(10));
+  boost::future<void> CreateAccount(
+      const nfs_vault::AccountCreation& account_creation,
+      const std::chrono::steady_clock::duration& timeout = std::chrono::seconds(10),
+      const CancellationToken& cancellation_token = CancellationToken());
 
   void RemoveAccount(const nfs_vault::AccountRemoval& account_removal);
 
-  boost::future<void> RegisterPmid(const nfs_vault::PmidRegistration& pmid_registration,
-                                   const std::chrono::steady_clock::duration& timeout =
-                                       std::chrono::seconds(10));
+  boost::future<void> RegisterPmid(
+      const nfs_vault::PmidRegistration& pmid_registration,
+      const std::chrono::steady_clock::duration& timeout = std::chrono::seconds(10),
+      const CancellationToken& cancellation_token = CancellationToken());
 
   void UnregisterPmid(const passport::PublicPmid::Name& pmid_name);
 
-  PmidHealthFuture GetPmidHealth(const passport::PublicPmid::Name& pmid_name,
-                                 const std::chrono::steady_clock::duration& timeout =
-                                     std::chrono::seconds(10));
+  PmidHealthFuture GetPmidHealth(
+      const passport::PublicPmid::Name& pmid_name,
+      const std::chrono::steady_clock::duration& timeout = std::chrono::seconds(10),
+      const CancellationToken& cancellation_token = CancellationToken());
 
   // This should be the function used in the GroupToSingle (and maybe also SingleToSingle) functors
   // passed to 'routing.Join'.
@@ -134,22 +266,69 @@ class MaidNodeNfs {
   typedef std::function<void(const DataNameAndContentOrReturnCode&)> GetFunctor;
   typedef std::function<void(const StructuredDataNameAndContentOrReturnCode&)> GetVersionsFunctor;
   typedef std::function<void(const StructuredDataNameAndContentOrReturnCode&)> GetBranchFunctor;
-  typedef boost::promise<std::vector<StructuredDataVersions::VersionName>> VersionNamesPromise;
   typedef std::function<void(const AvailableSizeAndReturnCode&)> PmidHealthFunctor;
 
   MaidNodeNfs(const MaidNodeNfs&);
   MaidNodeNfs(MaidNodeNfs&&);
   MaidNodeNfs& operator=(MaidNodeNfs);
 
-  routing::Timer<MaidNodeService::GetResponse::Contents> get_timer_;
-  routing::Timer<MaidNodeService::PutResponse::Contents> put_timer_;
-  routing::Timer<MaidNodeService::GetVersionsResponse::Contents> get_versions_timer_;
-  routing::Timer<MaidNodeService::GetBranchResponse::Contents> get_branch_timer_;
-  routing::Timer<MaidNodeService::CreateAccountResponse::Contents> create_account_timer_;
-  routing::Timer<MaidNodeService::PmidHealthResponse::Contents> pmid_health_timer_;
-  routing::Timer<MaidNodeService::CreateVersionTreeResponse::Contents> create_version_tree_timer_;
-  routing::Timer<MaidNodeService::PutVersionResponse::Contents> put_version_timer_;
-  routing::Timer<MaidNodeService::RegisterPmidResponse::Contents> register_pmid_timer_;
+  // Gets one name for GetMany, calling the given functor once the promise has been set.
+  template <typename DataName>
+  std::function<void(const DataName&,
+                     std::shared_ptr<boost::promise<typename DataName::data_type>>,
+                     std::function<void()>)>
+      GetManyFunctor(const std::chrono::steady_clock::duration& timeout,
+                     const CancellationToken& cancellation_token);
+
+  template <typename Data>
+  void DoPut(const Data& data, PutCompletionHandler handler,
+             const std::chrono::steady_clock::duration& timeout,
+             const CancellationToken& cancellation_token);
+
+  template <typename DataName>
+  void DoGetVersions(const DataName& data_name, VersionNamesCompletionHandler handler,
+                     const std::chrono::steady_clock::duration& timeout,
+                     const std::chrono::steady_clock::duration& max_staleness,
+                     const CancellationToken& cancellation_token);
+
+  template <typename DataName>
+  void DoGetBranch(const DataName& data_name,
+                   const StructuredDataVersions::VersionName& branch_tip,
+                   VersionNamesCompletionHandler handler,
+                   const std::chrono::steady_clock::duration& timeout,
+                   const std::chrono::steady_clock::duration& max_staleness,
+                   const CancellationToken& cancellation_token);
+
+  template <typename DataName>
+  void DoPutVersion(const DataName& data_name,
+                    const StructuredDataVersions::VersionName& old_version_name,
+                    const StructuredDataVersions::VersionName& new_version_name,
+                    PutVersionCompletionHandler handler,
+                    const std::chrono::steady_clock::duration& timeout,
+                    const CancellationToken& cancellation_token);
+
+  // Arms 'cancellable' to cancel 'task_id' and then call 'on_cancelled'.  Returns false if already
+  // cancelled, in which case the request needn't be sent.  Returns true if 'cancellable' is null
+  // (see MakeCancellableOperation).
+  bool ArmCancellation(std::shared_ptr<CancellableOperation> cancellable, nfs::TaskId task_id,
+                       std::function<void()> on_cancelled);
+
+  // As above, failing 'promise' with CancelledError.
+  template <typename T>
+  bool ArmCancellation(std::shared_ptr<CancellableOperation> cancellable, nfs::TaskId task_id,
+                       std::shared_ptr<boost::promise<T>> promise);
+
+  // Set on destruction, when 'pending_operations_' expires any outstanding requests, so that
+  // GetMany and PutMany don't start more as those complete.  Declared first so as to outlive them.
+  std::atomic<bool> stopped_;
+  boost::asio::io_service& io_service_;
+  // Declared before 'pending_operations_' so that requests expired on its destruction can still
+  // record timeouts and reach the caches.
+  LatencyEstimator latency_estimator_;
+  DataCache data_cache_;
+  NegativeCache negative_cache_;
+  VersionCache version_cache_;
+  nfs::PendingOperations pending_operations_;
   MaidNodeDispatcher dispatcher_;
   nfs::Service<MaidNodeService> service_;
   mutable std::mutex pmid_node_hint_mutex_;
@@ -165,39 +344,212 @@ void CreateAccount(std::shared_ptr<passport::Maid> maid,
 template <typename DataName>
 boost::future<typename DataName::data_type> MaidNodeNfs::Get(
     const DataName& data_name,
-    const std::chrono::steady_clock::duration& timeout) {
+    const std::chrono::steady_clock::duration& timeout,
+    const CancellationToken& cancellation_token) {
   LOG(kVerbose) << "MaidNodeNfs Get " << HexSubstr(data_name.value);
   auto promise(std::make_shared<boost::promise<typename DataName::data_type>>());
-  get_handler_.Get(data_name, promise, timeout);
+  get_handler_.Get(data_name, GetPromiseHandler<typename DataName::data_type>(promise), timeout,
+                   cancellation_token);
   return promise->get_future();
 }
 
+template <typename DataName>
+boost::future<std::shared_ptr<const typename DataName::data_type>> MaidNodeNfs::GetShared(
+    const DataName& data_name,
+    const std::chrono::steady_clock::duration& timeout,
+    const CancellationToken& cancellation_token) {
+  LOG(kVerbose) << "MaidNodeNfs GetShared " << HexSubstr(data_name.value);
+  auto promise(
+      std::make_shared<boost::promise<std::shared_ptr<const typename DataName::data_type>>>());
+  get_handler_.Get(data_name, GetPromiseHandler<typename DataName::data_type>(promise), timeout,
+                   cancellation_token);
+  return promise->get_future();
+}
+
+template <typename DataName, typename Handler>
+void MaidNodeNfs::Get(const DataName& data_name, Handler handler,
+                      const std::chrono::steady_clock::duration& timeout,
+                      const CancellationToken& cancellation_token,
+                      typename std::enable_if<detail::IsCompletionHandler<
+                          Handler,
+                          GetCompletionHandler<typename DataName::data_type>>::value>::type*) {
+  LOG(kVerbose) << "MaidNodeNfs Get " << HexSubstr(data_name.value);
+  get_handler_.Get(data_name, GetCompletionHandler<typename DataName::data_type>(
+                                  std::move(handler)), timeout, cancellation_token);
+}
+
+template <typename DataName>
+boost::future<void> MaidNodeNfs::GetMany(
+    std::vector<DataName> data_names, size_t window,
+    std::function<void(size_t, boost::future<typename DataName::data_type>)> result_functor,
+    const std::chrono::steady_clock::duration& timeout,
+    const CancellationToken& cancellation_token) {
+  LOG(kVerbose) << "MaidNodeNfs GetMany " << data_names.size() << " with window " << window;
+  return detail::GetMany(std::move(data_names), window,
+                         GetManyFunctor<DataName>(timeout, cancellation_token),
+                         std::move(result_functor));
+}
+
+template <typename DataName>
+std::vector<boost::future<typename DataName::data_type>> MaidNodeNfs::GetMany(
+    std::vector<DataName> data_names, size_t window,
+    const std::chrono::steady_clock::duration& timeout,
+    const CancellationToken& cancellation_token) {
+  LOG(kVerbose) << "MaidNodeNfs GetMany " << data_names.size() << " with window " << window;
+  return detail::GetMany(std::move(data_names), window,
+                         GetManyFunctor<DataName>(timeout, cancellation_token));
+}
+
+template <typename DataName>
+std::function<void(const DataName&,
+                   std::shared_ptr<boost::promise<typename DataName::data_type>>,
+                   std::function<void()>)>
+    MaidNodeNfs::GetManyFunctor(const std::chrono::steady_clock::duration& timeout,
+                                const CancellationToken& cancellation_token) {
+  return [this, timeout, cancellation_token](
+      const DataName& data_name,
+      std::shared_ptr<boost::promise<typename DataName::data_type>> promise,
+      std::function<void()> on_completion) {
+    if (stopped_) {
+      promise->set_exception(MakeError(CommonErrors::unable_to_handle_request));
+      return on_completion();
+    }
+    auto set_promise(GetPromiseHandler<typename DataName::data_type>(promise));
+    get_handler_.Get(
+        data_name,
+        [set_promise, on_completion](std::error_code error,
+                                     boost::optional<typename DataName::data_type> data) {
+          set_promise(error, std::move(data));
+          on_completion();
+        },
+        timeout, cancellation_token);
+  };
+}
+
 template <typename Data>
 boost::future<void> MaidNodeNfs::Put(const Data& data,
-                                     const std::chrono::steady_clock::duration& timeout) {
-  LOG(kVerbose) << "MaidNodeNfs put " << HexSubstr(data.name().value.string())
-                << " of size " << data.Serialise().data.string().size();
-  typedef MaidNodeService::PutResponse::Contents ResponseContents;
+                                     const std::chrono::steady_clock::duration& timeout,
+                                     const CancellationToken& cancellation_token) {
   auto promise(std::make_shared<boost::promise<void>>());
+  DoPut(data, PutPromiseHandler(promise), timeout, cancellation_token);
+  return promise->get_future();
+}
+
+template <typename Data, typename Handler>
+void MaidNodeNfs::Put(const Data& data, Handler handler,
+                      const std::chrono::steady_clock::duration& timeout,
+                      const CancellationToken& cancellation_token,
+                      typename std::enable_if<detail::IsCompletionHandler<
+                          Handler, PutCompletionHandler>::value>::type*) {
+  DoPut(data, PutCompletionHandler(std::move(handler)), timeout, cancellation_token);
+}
+
+template <typename Data>
+boost::future<void> MaidNodeNfs::PutMany(
+    std::function<boost::optional<Data>()> generator, size_t max_outstanding,
+    uint64_t max_outstanding_bytes,
+    std::function<void(const typename Data::Name&, boost::future<void>)> result_functor,
+    const std::chrono::steady_clock::duration& timeout,
+    const CancellationToken& cancellation_token) {
+  LOG(kVerbose) << "MaidNodeNfs PutMany with at most " << max_outstanding << " Puts and "
+                << max_outstanding_bytes << " bytes outstanding";
+  auto request_window(std::make_shared<RequestWindow<Data>>(
+      max_outstanding, max_outstanding_bytes,
+      [](const Data& data) -> uint64_t { return data.Serialise().data.string().size(); },
+      [this, generator, cancellation_token]() -> boost::optional<Data> {
+        // Once cancelled, no more data is pulled.
+        if (stopped_ || cancellation_token.cancelled())
+          return boost::none;
+        return generator();
+      },
+      [this, result_functor, timeout, cancellation_token](Data data,
+                                                          std::function<void()> done) {
+        auto data_name(data.name());
+        auto on_completion([data_name, result_functor, done](std::error_code error) {
+          boost::promise<void> promise;
+          if (error)
+            promise.set_exception(maidsafe_error(error));
+          else
+            promise.set_value();
+          try {
+            result_functor(data_name, promise.get_future());
+          }
+          catch (const std::exception& e) {
+            LOG(kError) << "PutMany result functor threw: " << e.what();
+          }
+          done();
+        });
+        if (stopped_)
+          return on_completion(make_error_code(CommonErrors::unable_to_handle_request));
+        DoPut(data, on_completion, timeout, cancellation_token);
+      }));
+  return request_window->Run();
+}
+
+template <typename Data>
+void MaidNodeNfs::DoPut(const Data& data, PutCompletionHandler handler,
+                        const std::chrono::steady_clock::duration& timeout,
+                        const CancellationToken& cancellation_token) {
+  typedef MaidNodeService::PutResponse::Contents ResponseContents;
+  auto payload_size(data.Serialise().data.string().size());
+  LOG(kVerbose) << "MaidNodeNfs put " << HexSubstr(data.name().value.string())
+                << " of size " << payload_size;
+  auto put_timeout(
+      latency_estimator_.ResolveTimeout(LatencyEstimator::Operation::kPut, timeout, payload_size));
   NodeId node_id;
   passport::PublicPmid::Name pmid_hint(Identity((node_id.string())));
-
-  auto response_functor([promise](const nfs_client::ReturnCode& result) {
-                           HandlePutResponseResult(result, promise);
+  // Once stored, the name is no longer missing.
+  negative_cache_.Remove(Data::Tag::kValue, data.name().value);
+
+  // Cacheable data is added to the cache once it has been stored.  A request which expires without
+  // enough responses reports NfsErrors::timed_out, so nothing is cached unless the store succeeded.
+  std::shared_ptr<const Data> cache_copy(
+      data_cache_.Holds<Data>() ? std::make_shared<const Data>(data) : nullptr);
+  auto cancellable(MakeCancellableOperation(cancellation_token));
+  auto sent(std::chrono::steady_clock::now());
+  auto response_functor([this, handler, cancellable, cache_copy, payload_size, sent,
+                         put_timeout](const nfs_client::ReturnCode& result) {
+                           if (cancellable && !cancellable->Complete())
+                             return;
+                           latency_estimator_.AddResponse(LatencyEstimator::Operation::kPut,
+                                                          payload_size, sent, put_timeout);
+                           if (nfs::IsSuccess(result)) {
+                             LOG(kInfo) << "Put succeeded";
+                             if (cache_copy)
+                               data_cache_.Put(*cache_copy);
+                           } else {
+                             LOG(kWarning) << "MaidNodeNfs error in Put: "
+                                           << result.value.message();
+                           }
+                           handler(HandlerError(result));
                         });
   auto op_data(std::make_shared<nfs::OpData<ResponseContents>>(1, response_functor));
-  auto task_id(put_timer_.NewTaskId());
-  put_timer_.AddTask(
-      timeout,
-      [op_data, data](ResponseContents put_response) {
+  auto task_id(pending_operations_.NewTaskId());
+  // Only the name is kept for the lifetime of the request, not the data itself.
+  auto data_name(data.name());
+  pending_operations_.AddTask<ResponseContents>(
+      put_timeout,
+      [op_data, data_name](ResponseContents put_response) {
         LOG(kVerbose) << "MaidNodeNfs Put HandleResponseContents for "
-                      << HexSubstr(data.name().value);
+                      << HexSubstr(data_name.value);
         op_data->HandleResponseContents(std::move(put_response));
       },
+      [op_data] { op_data->HandleExpiry(ResponseContents(NfsErrors::timed_out)); },
       routing::Parameters::group_size - 1, task_id);
-  put_timer_.PrintTaskIds();
+  if (cancellable && !ArmCancellation(cancellable, task_id, [handler] {
+        handler(CancelledError().code());
+      })) {
+    return;
+  }
   dispatcher_.SendPutRequest(task_id, data, pmid_hint);
-  return promise->get_future();
+}
+
+template <typename T>
+bool MaidNodeNfs::ArmCancellation(std::shared_ptr<CancellableOperation> cancellable,
+                                  nfs::TaskId task_id,
+                                  std::shared_ptr<boost::promise<T>> promise) {
+  return ArmCancellation(cancellable, task_id,
+                         [promise] { promise->set_exception(CancelledError()); });
 }
 
 template <typename DataName>
@@ -217,24 +569,36 @@ template <typename DataName>
 boost::future<void> MaidNodeNfs::CreateVersionTree(const DataName& data_name,
                        const StructuredDataVersions::VersionName& version_name,
                        uint32_t max_versions, uint32_t max_branches,
-                       const std::chrono::steady_clock::duration& timeout) {
+                       const std::chrono::steady_clock::duration& timeout,
+                       const CancellationToken& cancellation_token) {
   LOG(kVerbose) << "MaidNodeNfs Create Version " << HexSubstr(data_name.value);
   typedef MaidNodeService::CreateVersionTreeResponse::Contents ResponseContents;
   auto promise(std::make_shared<boost::promise<void>>());
-  auto response_functor([promise](const nfs_client::ReturnCode& result) {
+  auto create_timeout(latency_estimator_.ResolveTimeout(
+      LatencyEstimator::Operation::kCreateVersionTree, timeout, 0));
+  auto cancellable(MakeCancellableOperation(cancellation_token));
+  auto sent(std::chrono::steady_clock::now());
+  auto response_functor([this, promise, cancellable, sent, create_timeout](
+                            const nfs_client::ReturnCode& result) {
+                           if (cancellable && !cancellable->Complete())
+                             return;
+                           latency_estimator_.AddResponse(
+                               LatencyEstimator::Operation::kCreateVersionTree, 0, sent,
+                               create_timeout);
                            HandleCreateVersionTreeResult(result, promise);
                         });
   auto op_data(std::make_shared<nfs::OpData<ResponseContents>>(1, response_functor));
-  auto task_id(create_version_tree_timer_.NewTaskId());
-  create_version_tree_timer_.AddTask(
-      timeout,
+  auto task_id(pending_operations_.NewTaskId());
+  pending_operations_.AddTask<ResponseContents>(
+      create_timeout,
       [op_data, data_name](ResponseContents get_response) {
         LOG(kVerbose) << "MaidNodeNfs CreateVersionTree HandleResponseContents for "
                       << HexSubstr(data_name.value);
         op_data->HandleResponseContents(std::move(get_response));
       },
       routing::Parameters::group_size * 3, task_id);
-  create_version_tree_timer_.PrintTaskIds();
+  if (!ArmCancellation(cancellable, task_id, promise))
+    return promise->get_future();
   dispatcher_.SendCreateVersionTreeRequest(task_id, data_name, version_name, max_versions,
                                            max_branches);
   return promise->get_future();
@@ -242,75 +606,229 @@ boost::future<void> MaidNodeNfs::CreateVersionTree(const DataName& data_name,
 
 template <typename DataName>
 MaidNodeNfs::VersionNamesFuture MaidNodeNfs::GetVersions(
-    const DataName& data_name, const std::chrono::steady_clock::duration& timeout) {
+    const DataName& data_name, const std::chrono::steady_clock::duration& timeout,
+    const std::chrono::steady_clock::duration& max_staleness,
+    const CancellationToken& cancellation_token) {
+  auto promise(
+      std::make_shared<boost::promise<std::vector<StructuredDataVersions::VersionName>>>());
+  DoGetVersions(data_name, VersionNamesPromiseHandler(promise), timeout, max_staleness,
+                cancellation_token);
+  return promise->get_future();
+}
+
+template <typename DataName, typename Handler>
+void MaidNodeNfs::GetVersions(
+    const DataName& data_name, Handler handler, const std::chrono::steady_clock::duration& timeout,
+    const std::chrono::steady_clock::duration& max_staleness,
+    const CancellationToken& cancellation_token,
+    typename std::enable_if<detail::IsCompletionHandler<
+        Handler, VersionNamesCompletionHandler>::value>::type*) {
+  DoGetVersions(data_name, VersionNamesCompletionHandler(std::move(handler)), timeout,
+                max_staleness, cancellation_token);
+}
+
+template <typename DataName>
+void MaidNodeNfs::DoGetVersions(const DataName& data_name, VersionNamesCompletionHandler handler,
+                                const std::chrono::steady_clock::duration& timeout,
+                                const std::chrono::steady_clock::duration& max_staleness,
+                                const CancellationToken& cancellation_token) {
   LOG(kVerbose) << "MaidNodeNfs Get Version for " << HexSubstr(data_name.value);
   typedef MaidNodeService::GetVersionsResponse::Contents ResponseContents;
-  auto promise(std::make_shared<VersionNamesPromise>());
-  auto response_functor([promise](const StructuredDataNameAndContentOrReturnCode&
-                                  result) { HandleGetVersionsOrBranchResult(result, promise); });
+  const DataTagValue kType(DataName::data_type::Tag::kValue);
+  auto cached(version_cache_.GetVersions(kType, data_name.value, max_staleness));
+  if (cached)
+    return handler(std::error_code(), std::move(*cached));
+  auto write_count(version_cache_.write_count());
+  auto get_timeout(
+      latency_estimator_.ResolveTimeout(LatencyEstimator::Operation::kGetVersions, timeout, 0));
+  auto cancellable(MakeCancellableOperation(cancellation_token));
+  auto sent(std::chrono::steady_clock::now());
+  auto response_functor([this, handler, cancellable, kType, data_name, write_count, sent,
+                         get_timeout](StructuredDataNameAndContentOrReturnCode result) {
+                          if (cancellable && !cancellable->Complete())
+                            return;
+                          latency_estimator_.AddResponse(LatencyEstimator::Operation::kGetVersions,
+                                                         0, sent, get_timeout);
+                          if (result.structured_data) {
+                            version_cache_.SetVersions(kType, data_name.value,
+                                                       result.structured_data->versions,
+                                                       write_count);
+                          }
+                          CompleteGetVersionsOrBranch(std::move(result), handler);
+                        });
   auto op_data(std::make_shared<nfs::OpData<ResponseContents>>(1, response_functor));
-  auto task_id(get_versions_timer_.NewTaskId());
-  get_versions_timer_.AddTask(
-      timeout, [op_data](ResponseContents get_versions_response) {
+  auto task_id(pending_operations_.NewTaskId());
+  pending_operations_.AddTask<ResponseContents>(
+      get_timeout, [op_data](ResponseContents get_versions_response) {
                  op_data->HandleResponseContents(std::move(get_versions_response));
                },
+      [op_data, data_name] { op_data->HandleExpiry(VersionsTimedOutResult(data_name)); },
       // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
       routing::Parameters::group_size * 2, task_id);
+  if (cancellable && !ArmCancellation(cancellable, task_id, [handler] {
+        handler(CancelledError().code(), std::vector<StructuredDataVersions::VersionName>());
+      })) {
+    return;
+  }
   dispatcher_.SendGetVersionsRequest(task_id, data_name);
-  return promise->get_future();
 }
 
 template <typename DataName>
 MaidNodeNfs::VersionNamesFuture MaidNodeNfs::GetBranch(
     const DataName& data_name, const StructuredDataVersions::VersionName& branch_tip,
-    const std::chrono::steady_clock::duration& timeout) {
+    const std::chrono::steady_clock::duration& timeout,
+    const std::chrono::steady_clock::duration& max_staleness,
+    const CancellationToken& cancellation_token) {
+  auto promise(
+      std::make_shared<boost::promise<std::vector<StructuredDataVersions::VersionName>>>());
+  DoGetBranch(data_name, branch_tip, VersionNamesPromiseHandler(promise), timeout, max_staleness,
+              cancellation_token);
+  return promise->get_future();
+}
+
+template <typename DataName, typename Handler>
+void MaidNodeNfs::GetBranch(
+    const DataName& data_name, const StructuredDataVersions::VersionName& branch_tip,
+    Handler handler, const std::chrono::steady_clock::duration& timeout,
+    const std::chrono::steady_clock::duration& max_staleness,
+    const CancellationToken& cancellation_token,
+    typename std::enable_if<detail::IsCompletionHandler<
+        Handler, VersionNamesCompletionHandler>::value>::type*) {
+  DoGetBranch(data_name, branch_tip, VersionNamesCompletionHandler(std::move(handler)), timeout,
+              max_staleness, cancellation_token);
+}
+
+template <typename DataName>
+void MaidNodeNfs::DoGetBranch(const DataName& data_name,
+                              const StructuredDataVersions::VersionName& branch_tip,
+                              VersionNamesCompletionHandler handler,
+                              const std::chrono::steady_clock::duration& timeout,
+                              const std::chrono::steady_clock::duration& max_staleness,
+                              const CancellationToken& cancellation_token) {
   LOG(kVerbose) << "MaidNodeNfs Get Branch for " << HexSubstr(data_name.value);
   typedef MaidNodeService::GetBranchResponse::Contents ResponseContents;
-  auto promise(std::make_shared<VersionNamesPromise>());
-  auto response_functor([promise](const StructuredDataNameAndContentOrReturnCode &
-                                  result) { HandleGetVersionsOrBranchResult(result, promise); });
+  const DataTagValue kType(DataName::data_type::Tag::kValue);
+  auto cached(version_cache_.GetBranch(kType, data_name.value, branch_tip, max_staleness));
+  if (cached)
+    return handler(std::error_code(), std::move(*cached));
+  auto write_count(version_cache_.write_count());
+  auto get_timeout(
+      latency_estimator_.ResolveTimeout(LatencyEstimator::Operation::kGetBranch, timeout, 0));
+  auto cancellable(MakeCancellableOperation(cancellation_token));
+  auto sent(std::chrono::steady_clock::now());
+  auto response_functor([this, handler, cancellable, kType, data_name, branch_tip, write_count,
+                         sent, get_timeout](StructuredDataNameAndContentOrReturnCode result) {
+                          if (cancellable && !cancellable->Complete())
+                            return;
+                          latency_estimator_.AddResponse(LatencyEstimator::Operation::kGetBranch,
+                                                         0, sent, get_timeout);
+                          if (result.structured_data) {
+                            version_cache_.SetBranch(kType, data_name.value, branch_tip,
+                                                     result.structured_data->versions,
+                                                     write_count);
+                          }
+                          CompleteGetVersionsOrBranch(std::move(result), handler);
+                        });
   auto op_data(std::make_shared<nfs::OpData<ResponseContents>>(1, response_functor));
-  auto task_id(get_branch_timer_.NewTaskId());
-  get_branch_timer_.AddTask(timeout,
+  auto task_id(pending_operations_.NewTaskId());
+  pending_operations_.AddTask<ResponseContents>(get_timeout,
       [op_data](ResponseContents get_branch_response) {
           op_data->HandleResponseContents(std::move(get_branch_response));
       },
+      [op_data, data_name] { op_data->HandleExpiry(VersionsTimedOutResult(data_name)); },
       // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
       routing::Parameters::group_size * 2, task_id);
+  if (cancellable && !ArmCancellation(cancellable, task_id, [handler] {
+        handler(CancelledError().code(), std::vector<StructuredDataVersions::VersionName>());
+      })) {
+    return;
+  }
   dispatcher_.SendGetBranchRequest(task_id, data_name, branch_tip);
-  return promise->get_future();
 }
 
 template <typename DataName>
 MaidNodeNfs::PutVersionFuture MaidNodeNfs::PutVersion(
     const DataName& data_name, const StructuredDataVersions::VersionName& old_version_name,
     const StructuredDataVersions::VersionName& new_version_name,
-    const std::chrono::steady_clock::duration& timeout) {
-  LOG(kVerbose) << "MaidNodeNfs Put Version " << HexSubstr(data_name.value);
-  typedef MaidNodeService::PutVersionResponse::Contents ResponseContents;
+    const std::chrono::steady_clock::duration& timeout,
+    const CancellationToken& cancellation_token) {
   auto promise(
       std::make_shared<boost::promise<std::unique_ptr<StructuredDataVersions::VersionName>>>());
-  auto response_functor([promise](const nfs_client::TipOfTreeAndReturnCode& result) {
-                           HandlePutVersionResult(result, promise);
+  DoPutVersion(data_name, old_version_name, new_version_name, PutVersionPromiseHandler(promise),
+               timeout, cancellation_token);
+  return promise->get_future();
+}
+
+template <typename DataName, typename Handler>
+void MaidNodeNfs::PutVersion(
+    const DataName& data_name, const StructuredDataVersions::VersionName& old_version_name,
+    const StructuredDataVersions::VersionName& new_version_name, Handler handler,
+    const std::chrono::steady_clock::duration& timeout,
+    const CancellationToken& cancellation_token,
+    typename std::enable_if<detail::IsCompletionHandler<
+        Handler, PutVersionCompletionHandler>::value>::type*) {
+  DoPutVersion(data_name, old_version_name, new_version_name,
+               PutVersionCompletionHandler(std::move(handler)), timeout, cancellation_token);
+}
+
+template <typename DataName>
+void MaidNodeNfs::DoPutVersion(const DataName& data_name,
+                               const StructuredDataVersions::VersionName& old_version_name,
+                               const StructuredDataVersions::VersionName& new_version_name,
+                               PutVersionCompletionHandler handler,
+                               const std::chrono::steady_clock::duration& timeout,
+                               const CancellationToken& cancellation_token) {
+  LOG(kVerbose) << "MaidNodeNfs Put Version " << HexSubstr(data_name.value);
+  typedef MaidNodeService::PutVersionResponse::Contents ResponseContents;
+  auto put_timeout(
+      latency_estimator_.ResolveTimeout(LatencyEstimator::Operation::kPutVersion, timeout, 0));
+  auto cancellable(MakeCancellableOperation(cancellation_token));
+  auto sent(std::chrono::steady_clock::now());
+  auto response_functor([this, handler, cancellable, data_name, old_version_name,
+                         new_version_name, sent, put_timeout](
+                            const nfs_client::TipOfTreeAndReturnCode& result) {
+                           if (cancellable && !cancellable->Complete())
+                             return;
+                           latency_estimator_.AddResponse(LatencyEstimator::Operation::kPutVersion,
+                                                          0, sent, put_timeout);
+                           // Without a confirmed tip of tree (e.g. on expiry), whether the new
+                           // version was applied is unknown.
+                           if (nfs::IsSuccess(result.return_code) && result.tip_of_tree) {
+                             version_cache_.PutVersion(DataName::data_type::Tag::kValue,
+                                                       data_name.value, old_version_name,
+                                                       new_version_name, result.tip_of_tree);
+                           } else {
+                             version_cache_.Invalidate(DataName::data_type::Tag::kValue,
+                                                       data_name.value);
+                           }
+                           CompletePutVersion(result, handler);
                         });
   auto op_data(std::make_shared<nfs::OpData<ResponseContents>>(1, response_functor));
-  auto task_id(put_version_timer_.NewTaskId());
-  put_version_timer_.AddTask(
-      timeout,
+  auto task_id(pending_operations_.NewTaskId());
+  pending_operations_.AddTask<ResponseContents>(
+      put_timeout,
       [op_data, data_name](ResponseContents get_response) {
-        LOG(kVerbose) << "MaidNodeNfs CreateVersionTree HandleResponseContents for "
+        LOG(kVerbose) << "MaidNodeNfs PutVersion HandleResponseContents for "
                       << HexSubstr(data_name.value);
         op_data->HandleResponseContents(std::move(get_response));
       },
+      [op_data] {
+        op_data->HandleExpiry(ResponseContents(nfs_client::ReturnCode(NfsErrors::timed_out)));
+      },
       routing::Parameters::group_size * 3, task_id);
-  put_version_timer_.PrintTaskIds();
+  if (cancellable && !ArmCancellation(cancellable, task_id, [this, handler, data_name] {
+        version_cache_.Invalidate(DataName::data_type::Tag::kValue, data_name.value);
+        handler(CancelledError().code(), nullptr);
+      })) {
+    return;
+  }
   dispatcher_.SendPutVersionRequest(task_id, data_name, old_version_name, new_version_name);
-  return promise->get_future();
 }
 
 template <typename DataName>
 void MaidNodeNfs::DeleteBranchUntilFork(const DataName& data_name,
                                         const StructuredDataVersions::VersionName& branch_tip) {
+  version_cache_.Invalidate(DataName::data_type::Tag::kValue, data_name.value);
   dispatcher_.SendDeleteBranchUntilForkRequest(data_name, branch_tip);
 }
 
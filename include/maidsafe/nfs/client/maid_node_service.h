@@ -19,10 +19,12 @@
 #ifndef MAIDSAFE_NFS_CLIENT_MAID_NODE_SERVICE_H_
 #define MAIDSAFE_NFS_CLIENT_MAID_NODE_SERVICE_H_
 
+#include "maidsafe/common/log.h"
 #include "maidsafe/routing/routing_api.h"
-#include "maidsafe/routing/timer.h"
 
 #include "maidsafe/nfs/message_types.h"
+#include "maidsafe/nfs/pending_operations.h"
+#include "maidsafe/nfs/utils.h"
 #include "maidsafe/nfs/client/messages.h"
 #include "maidsafe/nfs/vault/messages.h"
 #include "maidsafe/nfs/client/get_handler.h"
@@ -52,18 +54,10 @@ class MaidNodeService {
   typedef nfs::RegisterPmidResponseFromMaidManagerToMaidNode RegisterPmidResponse;
 
 
-  MaidNodeService(
-      routing::Routing& routing, routing::Timer<MaidNodeService::GetResponse::Contents>& get_timer,
-      routing::Timer<MaidNodeService::PutResponse::Contents>& put_timer,
-      routing::Timer<MaidNodeService::GetVersionsResponse::Contents>& get_versions_timer,
-      routing::Timer<MaidNodeService::GetBranchResponse::Contents>& get_branch_timer,
-      routing::Timer<MaidNodeService::CreateAccountResponse::Contents>& create_account_timer,
-      routing::Timer<MaidNodeService::PmidHealthResponse::Contents>& pmid_health_timer,
-      routing::Timer<MaidNodeService::CreateVersionTreeResponse::Contents>&
-          create_version_tree_timer,
-      routing::Timer<MaidNodeService::PutVersionResponse::Contents>& put_version_timer,
-      routing::Timer<MaidNodeService::RegisterPmidResponse::Contents>& register_pmid_timer,
-      GetHandler& get_handler);
+  // Responses are routed to the requests awaiting them through 'pending_operations', except for
+  // Get responses which go via 'get_handler'.
+  MaidNodeService(routing::Routing& routing, nfs::PendingOperations& pending_operations,
+                  GetHandler& get_handler);
 
   void HandleMessage(const GetResponse& message, const GetResponse::Sender& sender,
                      const GetResponse::Receiver& receiver);
@@ -106,19 +100,21 @@ class MaidNodeService {
   void HandlePutResponse(const nfs::PutRequestFromMaidNodeToMaidManager& message,
                          const typename nfs::PutRequestFromMaidNodeToMaidManager::Sender& sender);
 
+  template <typename Message>
+  void AddResponse(const Message& message);
+
   routing::Routing& routing_;
-  routing::Timer<MaidNodeService::GetResponse::Contents>& get_timer_;
-  routing::Timer<MaidNodeService::PutResponse::Contents>& put_timer_;
-  routing::Timer<MaidNodeService::GetVersionsResponse::Contents>& get_versions_timer_;
-  routing::Timer<MaidNodeService::GetBranchResponse::Contents>& get_branch_timer_;
-  routing::Timer<MaidNodeService::CreateAccountResponse::Contents>& create_account_timer_;
-  routing::Timer<MaidNodeService::PmidHealthResponse::Contents>& pmid_health_timer_;
-  routing::Timer<MaidNodeService::CreateVersionTreeResponse::Contents>& create_version_tree_timer_;
-  routing::Timer<MaidNodeService::PutVersionResponse::Contents>& put_version_timer_;
-  routing::Timer<MaidNodeService::RegisterPmidResponse::Contents>& register_pmid_timer_;
+  nfs::PendingOperations& pending_operations_;
   GetHandler& get_handler_;
 };
 
+// ==================== Implementation =============================================================
+template <typename Message>
+void MaidNodeService::AddResponse(const Message& message) {
+  if (!pending_operations_.AddResponse(nfs::GetTaskId(message.id), *message.contents))
+    LOG(kWarning) << "No pending operation expects:" << message.id.data;
+}
+
 }  // namespace nfs_client
 
 }  // namespace maidsafe
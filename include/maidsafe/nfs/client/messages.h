@@ -35,6 +35,7 @@
 
 #include "maidsafe/nfs/client/structured_data.h"
 #include "maidsafe/nfs/vault/messages.h"
+#include "maidsafe/nfs/shared_buffer.h"
 #include "maidsafe/nfs/utils.h"
 
 namespace maidsafe {
@@ -47,22 +48,26 @@ struct ReturnCode {
   template <typename ErrorCode>
   explicit ReturnCode(ErrorCode error_code,
                       typename std::enable_if<std::is_error_code_enum<ErrorCode>::value>::type* = 0)
-      : value(MakeError(error_code)) {}
+      : value(error_code) {}
 
   template <typename Error>
-  explicit ReturnCode(Error error,
+  explicit ReturnCode(const Error& error,
                       typename std::enable_if<!std::is_error_code_enum<Error>::value>::type* = 0)
-      : value(error) {}
+      : value(error.code()) {}
+
+  explicit ReturnCode(std::error_code error_code) : value(error_code) {}
 
   ReturnCode();
-  ReturnCode(const ReturnCode& other);
-  ReturnCode(ReturnCode&& other);
-  ReturnCode& operator=(ReturnCode other);
 
   explicit ReturnCode(const std::string& serialised_copy);
   std::string Serialise() const;
 
-  maidsafe_error value;
+  // Builds the exception corresponding to 'value', e.g. for passing to boost::throw_exception.
+  maidsafe_error error() const;
+
+  // Held as a plain code/category pair (trivially copyable); the what-string is only built if
+  // error() is called.
+  std::error_code value;
 };
 
 bool operator==(const ReturnCode& lhs, const ReturnCode& rhs);
@@ -218,6 +223,13 @@ bool operator==(const DataNameAndContentOrReturnCode& lhs,
                 const DataNameAndContentOrReturnCode& rhs);
 void swap(DataNameAndContentOrReturnCode& lhs,
           DataNameAndContentOrReturnCode& rhs) MAIDSAFE_NOEXCEPT;
+// Single-pass writer used by nfs::MessageWrapper::Serialise and parser used when constructing a
+// MessageWrapper from a received buffer (see maidsafe/nfs/wire_format.h).  The parser copies the
+// content directly from the received buffer into 'content->data'.
+void AppendSerialised(const DataNameAndContentOrReturnCode& data_name_and_content_or_return_code,
+                      std::string& output);
+DataNameAndContentOrReturnCode ParseContents(const nfs::SharedBuffer& serialised_contents,
+                                             DataNameAndContentOrReturnCode* /*tag*/);
 
 // ==================== StructuredDataNameAndContentOrReturnCode ===================================
 struct StructuredDataNameAndContentOrReturnCode {
@@ -0,0 +1,81 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_CLIENT_NEGATIVE_CACHE_H_
+#define MAIDSAFE_NFS_CLIENT_NEGATIVE_CACHE_H_
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "boost/optional/optional.hpp"
+
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/data_types/data_type_values.h"
+
+#include "maidsafe/nfs/client/messages.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+// Remembers, for a configurable time per type, names which a Get found not to exist, so that
+// repeated Gets for them can be failed locally.  Entries are removed when this client Puts the
+// name.
+class NegativeCache {
+ public:
+  typedef std::map<DataTagValue, std::chrono::steady_clock::duration> TimeToLives;
+
+  // Types absent from 'time_to_lives' (or with a zero time) aren't cached.
+  explicit NegativeCache(TimeToLives time_to_lives);
+
+  bool Holds(DataTagValue type) const;
+
+  // Returns the failure cached for the name, or none if there isn't an unexpired one.
+  boost::optional<ReturnCode> Get(DataTagValue type, const Identity& name);
+  // Does nothing if 'type' isn't held.
+  void Add(DataTagValue type, const Identity& name, const ReturnCode& return_code);
+  void Remove(DataTagValue type, const Identity& name);
+
+  size_t size() const;
+
+ private:
+  typedef std::pair<DataTagValue, Identity> Key;
+  typedef std::pair<std::chrono::steady_clock::time_point, ReturnCode> Entry;
+
+  NegativeCache(const NegativeCache&);
+  NegativeCache(NegativeCache&&);
+  NegativeCache& operator=(NegativeCache);
+
+  // Must be called with 'mutex_' locked.
+  void PurgeExpired(std::chrono::steady_clock::time_point now);
+
+  const TimeToLives time_to_lives_;
+  // Expired entries are purged at most this often.
+  const std::chrono::steady_clock::duration purge_interval_;
+  mutable std::mutex mutex_;
+  std::map<Key, Entry> entries_;
+  std::chrono::steady_clock::time_point next_purge_;
+};
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_CLIENT_NEGATIVE_CACHE_H_
@@ -0,0 +1,280 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_CLIENT_REQUEST_WINDOW_H_
+#define MAIDSAFE_NFS_CLIENT_REQUEST_WINDOW_H_
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "boost/exception_ptr.hpp"
+#include "boost/optional/optional.hpp"
+#include "boost/thread/future.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+// Flow control for bulk requests.  Items are pulled one at a time from 'pull_functor' (which
+// returns none once exhausted) and passed to 'start_functor', which must arrange for the given
+// 'done' functor to be called exactly once when that item's request completes.  At most
+// 'max_outstanding' items are started but not yet done; as each finishes, the next is pulled and
+// started.  'done' may be called from within 'start_functor'.
+//
+// If a 'cost_functor' is given, the total cost of the items started but not yet done is also kept
+// within 'max_outstanding_cost', except that an item costing more than that is started alone.  An
+// item which doesn't fit is held until enough of those outstanding are done, so at most one item
+// beyond the budget has been pulled at any time.
+//
+// The future returned by Run becomes ready once every item is done, holding any exception thrown
+// by 'pull_functor' (after which no more items are pulled).  The window keeps itself alive until
+// then.
+template <typename Item>
+class RequestWindow : public std::enable_shared_from_this<RequestWindow<Item>> {
+ public:
+  typedef std::function<boost::optional<Item>()> PullFunctor;
+  typedef std::function<void(Item item, std::function<void()> done)> StartFunctor;
+  typedef std::function<uint64_t(const Item&)> CostFunctor;
+
+  // Throws CommonErrors::invalid_parameter if 'max_outstanding' is zero.
+  RequestWindow(size_t max_outstanding, PullFunctor pull_functor, StartFunctor start_functor);
+  // Throws CommonErrors::invalid_parameter if 'max_outstanding' or 'max_outstanding_cost' is zero,
+  // or if 'cost_functor' is empty.
+  RequestWindow(size_t max_outstanding, uint64_t max_outstanding_cost, CostFunctor cost_functor,
+                PullFunctor pull_functor, StartFunctor start_functor);
+
+  boost::future<void> Run();
+
+ private:
+  RequestWindow(const RequestWindow&);
+  RequestWindow(RequestWindow&&);
+  RequestWindow& operator=(RequestWindow);
+
+  // Pulls and starts items while there's room.  Only one thread does this at a time; others
+  // calling it meanwhile return at once, leaving the thread already doing it to see the room.
+  void Launch();
+  void Done(uint64_t cost);
+
+  const size_t max_outstanding_;
+  const uint64_t max_outstanding_cost_;
+  const CostFunctor cost_functor_;
+  const PullFunctor pull_functor_;
+  const StartFunctor start_functor_;
+  std::mutex mutex_;
+  size_t outstanding_;
+  uint64_t outstanding_cost_;
+  // An item pulled but not yet started for want of room, and its cost.
+  boost::optional<Item> held_;
+  uint64_t held_cost_;
+  bool launching_, exhausted_, finished_;
+  boost::exception_ptr error_;
+  boost::promise<void> completion_;
+};
+
+namespace detail {
+
+// Gets each of 'data_names' through 'get_functor' with at most 'window' outstanding, calling
+// 'result_functor' with each name's index and a ready future as it completes.  'get_functor' takes
+// a name, the promise to set and a functor to call once it has been set.
+template <typename DataName, typename GetFunctor>
+boost::future<void> GetMany(
+    std::vector<DataName> data_names, size_t window, GetFunctor get_functor,
+    std::function<void(size_t, boost::future<typename DataName::data_type>)> result_functor);
+
+// As above, but returns a future per name (in order) instead of calling a result functor.
+template <typename DataName, typename GetFunctor>
+std::vector<boost::future<typename DataName::data_type>> GetMany(
+    std::vector<DataName> data_names, size_t window, GetFunctor get_functor);
+
+}  // namespace detail
+
+// ==================== Implementation =============================================================
+template <typename Item>
+RequestWindow<Item>::RequestWindow(size_t max_outstanding, PullFunctor pull_functor,
+                                   StartFunctor start_functor)
+    : RequestWindow(max_outstanding, std::numeric_limits<uint64_t>::max(),
+                    [](const Item&) { return uint64_t(0); }, std::move(pull_functor),
+                    std::move(start_functor)) {}
+
+template <typename Item>
+RequestWindow<Item>::RequestWindow(size_t max_outstanding, uint64_t max_outstanding_cost,
+                                   CostFunctor cost_functor, PullFunctor pull_functor,
+                                   StartFunctor start_functor)
+    : max_outstanding_(max_outstanding),
+      max_outstanding_cost_(max_outstanding_cost),
+      cost_functor_(std::move(cost_functor)),
+      pull_functor_(std::move(pull_functor)),
+      start_functor_(std::move(start_functor)),
+      mutex_(),
+      outstanding_(0),
+      outstanding_cost_(0),
+      held_(),
+      held_cost_(0),
+      launching_(false),
+      exhausted_(false),
+      finished_(false),
+      error_(),
+      completion_() {
+  if (max_outstanding_ == 0 || max_outstanding_cost_ == 0 || !cost_functor_) {
+    LOG(kError) << "RequestWindow needs room for at least one request.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+}
+
+template <typename Item>
+boost::future<void> RequestWindow<Item>::Run() {
+  auto future(completion_.get_future());
+  Launch();
+  return future;
+}
+
+template <typename Item>
+void RequestWindow<Item>::Launch() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (launching_)
+    return;
+  launching_ = true;
+  auto self(this->shared_from_this());
+  while (outstanding_ < max_outstanding_ && (held_ || !exhausted_)) {
+    if (!held_) {
+      lock.unlock();
+      boost::optional<Item> item;
+      uint64_t cost(0);
+      try {
+        item = pull_functor_();
+        if (item)
+          cost = cost_functor_(*item);
+      }
+      catch (...) {
+        LOG(kError) << "Failed to pull next item: "
+                    << boost::current_exception_diagnostic_information();
+        lock.lock();
+        error_ = boost::current_exception();
+        exhausted_ = true;
+        break;
+      }
+      lock.lock();
+      if (!item) {
+        exhausted_ = true;
+        break;
+      }
+      held_ = std::move(item);
+      held_cost_ = cost;
+    }
+    if (outstanding_ != 0 && (outstanding_cost_ >= max_outstanding_cost_ ||
+                              held_cost_ > max_outstanding_cost_ - outstanding_cost_))
+      break;
+    ++outstanding_;
+    outstanding_cost_ += held_cost_;
+    Item item(std::move(*held_));
+    held_ = boost::none;
+    auto cost(held_cost_);
+    lock.unlock();
+    start_functor_(std::move(item), [self, cost] { self->Done(cost); });
+    lock.lock();
+  }
+  launching_ = false;
+  bool finished(exhausted_ && !held_ && outstanding_ == 0 && !finished_);
+  finished_ = finished_ || finished;
+  lock.unlock();
+  if (!finished)
+    return;
+  if (error_)
+    completion_.set_exception(error_);
+  else
+    completion_.set_value();
+}
+
+template <typename Item>
+void RequestWindow<Item>::Done(uint64_t cost) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --outstanding_;
+    outstanding_cost_ -= cost;
+  }
+  Launch();
+}
+
+namespace detail {
+
+template <typename DataName, typename GetFunctor>
+boost::future<void> GetMany(
+    std::vector<DataName> data_names, size_t window, GetFunctor get_functor,
+    std::function<void(size_t, boost::future<typename DataName::data_type>)> result_functor) {
+  typedef typename DataName::data_type Data;
+  auto names(std::make_shared<std::vector<DataName>>(std::move(data_names)));
+  auto next(std::make_shared<size_t>(0));
+  auto request_window(std::make_shared<RequestWindow<size_t>>(
+      window,
+      // Only called by one thread at a time.
+      [names, next]() -> boost::optional<size_t> {
+        if (*next == names->size())
+          return boost::none;
+        return (*next)++;
+      },
+      [names, get_functor, result_functor](size_t index, std::function<void()> done) {
+        auto promise(std::make_shared<boost::promise<Data>>());
+        get_functor((*names)[index], promise, [index, promise, result_functor, done] {
+          try {
+            result_functor(index, promise->get_future());
+          }
+          catch (const std::exception& e) {
+            LOG(kError) << "GetMany result functor threw: " << e.what();
+          }
+          done();
+        });
+      }));
+  return request_window->Run();
+}
+
+template <typename DataName, typename GetFunctor>
+std::vector<boost::future<typename DataName::data_type>> GetMany(
+    std::vector<DataName> data_names, size_t window, GetFunctor get_functor) {
+  typedef typename DataName::data_type Data;
+  auto promises(std::make_shared<std::vector<boost::promise<Data>>>(data_names.size()));
+  std::vector<boost::future<Data>> futures;
+  for (auto& promise : *promises)
+    futures.push_back(promise.get_future());
+  GetMany(std::move(data_names), window, get_functor,
+          std::function<void(size_t, boost::future<Data>)>(
+              [promises](size_t index, boost::future<Data> result) {
+                try {
+                  (*promises)[index].set_value(result.get());
+                }
+                catch (...) {
+                  (*promises)[index].set_exception(boost::current_exception());
+                }
+              }));
+  return futures;
+}
+
+}  // namespace detail
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_CLIENT_REQUEST_WINDOW_H_
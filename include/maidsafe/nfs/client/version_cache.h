@@ -0,0 +1,120 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_CLIENT_VERSION_CACHE_H_
+#define MAIDSAFE_NFS_CLIENT_VERSION_CACHE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "boost/optional/optional.hpp"
+
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/data_types/data_type_values.h"
+#include "maidsafe/common/data_types/structured_data_versions.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+// Client-side cache of the version lists returned by GetVersions (the tips) and GetBranch, for up
+// to 'max_names' names (least recently used first out).
+//
+// Lists are only returned if fetched from the network within the caller's 'max_staleness', so a
+// zero staleness never hits.  A successful PutVersion by this client updates the cached tips in
+// place; since it may also cause the network to prune the oldest versions, the name's cached
+// branches are dropped.  A PutVersion whose outcome is a failure or unknown (e.g. it timed out)
+// should invalidate the name, as should a DeleteBranchUntilFork.
+//
+// A fetched list is only stored if no write has been applied to the cache since the fetch began
+// (see write_count), so a slow fetch can't overwrite a later write.
+class VersionCache {
+ public:
+  typedef StructuredDataVersions::VersionName VersionName;
+  typedef std::vector<VersionName> Versions;
+
+  explicit VersionCache(size_t max_names);
+
+  bool enabled() const { return max_names_ != 0; }
+
+  std::shared_ptr<const Versions> GetVersions(
+      DataTagValue type, const Identity& name,
+      const std::chrono::steady_clock::duration& max_staleness);
+  std::shared_ptr<const Versions> GetBranch(
+      DataTagValue type, const Identity& name, const VersionName& branch_tip,
+      const std::chrono::steady_clock::duration& max_staleness);
+
+  // To be read before sending the request whose result is then stored.
+  uint64_t write_count() const;
+  void SetVersions(DataTagValue type, const Identity& name, const Versions& versions,
+                   uint64_t write_count_at_request);
+  void SetBranch(DataTagValue type, const Identity& name, const VersionName& branch_tip,
+                 const Versions& versions, uint64_t write_count_at_request);
+
+  // 'tip_of_tree' is as returned by the successful PutVersion.  If it names a version other than
+  // 'new_version', the cached state can't be deduced, so the name is dropped.
+  void PutVersion(DataTagValue type, const Identity& name, const VersionName& old_version,
+                  const VersionName& new_version,
+                  const boost::optional<VersionName>& tip_of_tree);
+  void Invalidate(DataTagValue type, const Identity& name);
+
+  size_t size() const;
+
+ private:
+  typedef std::pair<DataTagValue, Identity> Key;
+  typedef std::pair<std::chrono::steady_clock::time_point, std::shared_ptr<const Versions>>
+      FetchedVersions;
+
+  struct Entry {
+    explicit Entry(Key key_in) : key(std::move(key_in)), versions(), branches() {}
+
+    Key key;
+    FetchedVersions versions;
+    std::map<VersionName, FetchedVersions> branches;
+  };
+  typedef std::list<Entry> Entries;
+
+  VersionCache(const VersionCache&);
+  VersionCache(VersionCache&&);
+  VersionCache& operator=(VersionCache);
+
+  // Must be called with 'mutex_' locked.  Returns null if absent, otherwise moves the entry to the
+  // front.
+  Entry* Find(const Key& key);
+  // Must be called with 'mutex_' locked.  Returns the entry, adding it (and evicting the least
+  // recently used) if need be.
+  Entry& FindOrAdd(const Key& key);
+
+  const size_t max_names_;
+  mutable std::mutex mutex_;
+  Entries entries_;
+  std::map<Key, Entries::iterator> index_;
+  uint64_t write_count_;
+};
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_CLIENT_VERSION_CACHE_H_
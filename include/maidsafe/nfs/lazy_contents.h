@@ -0,0 +1,163 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_LAZY_CONTENTS_H_
+#define MAIDSAFE_NFS_LAZY_CONTENTS_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "boost/optional/optional.hpp"
+
+#include "maidsafe/common/config.h"
+#include "maidsafe/common/error.h"
+
+#include "maidsafe/nfs/shared_buffer.h"
+#include "maidsafe/nfs/wire_format.h"
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace detail {
+
+// Holds a message's contents either already decoded, or as the serialised bytes received from the
+// network.  In the latter case, the contents are only parsed on first access (via operator* or
+// operator->) and the result is cached; the serialised bytes are released once parsed.  Copies
+// share the same state, so contents are decoded at most once however many copies are made.
+// Parsing failures are thrown as CommonErrors::parsing_error from the accessing call.
+template <typename ContentsType>
+class LazyContents {
+ public:
+  LazyContents();
+  explicit LazyContents(ContentsType contents);
+  explicit LazyContents(SharedBuffer serialised_contents);
+  LazyContents(const LazyContents& other);
+  LazyContents(LazyContents&& other);
+  LazyContents& operator=(LazyContents other);
+
+  // Throws CommonErrors::uninitialised if this holds no contents.
+  ContentsType& operator*() const;
+  ContentsType* operator->() const;
+
+  // True if this holds contents, whether or not they have been decoded yet.  Never decodes.
+  explicit operator bool() const;
+  // Header-only queries: neither of these causes the contents to be decoded.
+  bool decoded() const;
+  // Size of the serialised contents if not yet decoded, otherwise 0.
+  size_t serialised_size() const;
+
+  friend void swap(LazyContents& lhs, LazyContents& rhs) MAIDSAFE_NOEXCEPT {
+    using std::swap;
+    swap(lhs.state_, rhs.state_);
+  }
+
+ private:
+  struct State {
+    explicit State(ContentsType contents_in)
+        : mutex(), is_decoded(true), serialised(), contents(std::move(contents_in)) {}
+    explicit State(SharedBuffer serialised_in)
+        : mutex(), is_decoded(false), serialised(std::move(serialised_in)), contents() {}
+    std::mutex mutex;
+    std::atomic<bool> is_decoded;
+    SharedBuffer serialised;
+    boost::optional<ContentsType> contents;
+  };
+
+  ContentsType& Decode() const;
+
+  std::shared_ptr<State> state_;
+};
+
+// ==================== Implementation =============================================================
+template <typename ContentsType>
+LazyContents<ContentsType>::LazyContents() : state_() {}
+
+template <typename ContentsType>
+LazyContents<ContentsType>::LazyContents(ContentsType contents)
+    : state_(std::make_shared<State>(std::move(contents))) {}
+
+template <typename ContentsType>
+LazyContents<ContentsType>::LazyContents(SharedBuffer serialised_contents)
+    : state_(std::make_shared<State>(std::move(serialised_contents))) {}
+
+template <typename ContentsType>
+LazyContents<ContentsType>::LazyContents(const LazyContents& other) : state_(other.state_) {}
+
+template <typename ContentsType>
+LazyContents<ContentsType>::LazyContents(LazyContents&& other)
+    : state_(std::move(other.state_)) {}
+
+template <typename ContentsType>
+LazyContents<ContentsType>& LazyContents<ContentsType>::operator=(LazyContents other) {
+  swap(*this, other);
+  return *this;
+}
+
+template <typename ContentsType>
+ContentsType& LazyContents<ContentsType>::operator*() const {
+  return Decode();
+}
+
+template <typename ContentsType>
+ContentsType* LazyContents<ContentsType>::operator->() const {
+  return &Decode();
+}
+
+template <typename ContentsType>
+LazyContents<ContentsType>::operator bool() const {
+  return static_cast<bool>(state_);
+}
+
+template <typename ContentsType>
+bool LazyContents<ContentsType>::decoded() const {
+  return state_ && state_->is_decoded.load(std::memory_order_acquire);
+}
+
+template <typename ContentsType>
+size_t LazyContents<ContentsType>::serialised_size() const {
+  if (!state_ || decoded())
+    return 0;
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->serialised.size();
+}
+
+template <typename ContentsType>
+ContentsType& LazyContents<ContentsType>::Decode() const {
+  if (!state_)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  if (!state_->is_decoded.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (!state_->contents) {
+      state_->contents = ParseContents(state_->serialised, static_cast<ContentsType*>(nullptr));
+      state_->serialised = SharedBuffer();
+      state_->is_decoded.store(true, std::memory_order_release);
+    }
+  }
+  return *state_->contents;
+}
+
+}  // namespace detail
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_LAZY_CONTENTS_H_
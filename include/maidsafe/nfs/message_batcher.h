@@ -0,0 +1,73 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_MESSAGE_BATCHER_H_
+#define MAIDSAFE_NFS_MESSAGE_BATCHER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "maidsafe/common/asio_service.h"
+
+namespace maidsafe {
+
+namespace nfs {
+
+struct BatchParameters {
+  // Batching is disabled by default.
+  BatchParameters();
+  BatchParameters(std::chrono::steady_clock::duration window_in, size_t max_size_in);
+
+  // The longest a message is held before being sent.  A zero window disables batching.
+  std::chrono::steady_clock::duration window;
+  // A batch is sent as soon as its total size reaches this many bytes.
+  size_t max_size;
+};
+
+// Coalesces serialised message wrappers bound for a single receiver, passing them to 'send_functor'
+// as a batch (see AppendToMessageWrapperBatch) once the window expires or the batch is full.  A
+// lone message is passed on unbatched.  Any messages still pending on destruction are sent then.
+class MessageBatcher {
+ public:
+  typedef std::function<void(std::string)> SendFunctor;
+
+  MessageBatcher(AsioService& asio_service, const BatchParameters& parameters,
+                 SendFunctor send_functor);
+  ~MessageBatcher();
+
+  void Add(std::string serialised_message_wrapper);
+  void Flush();
+
+ private:
+  struct State;
+
+  MessageBatcher(const MessageBatcher&);
+  MessageBatcher(MessageBatcher&&);
+  MessageBatcher& operator=(MessageBatcher);
+
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_MESSAGE_BATCHER_H_
@@ -23,13 +23,17 @@
 #include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include "boost/exception/error_info.hpp"
 
 #include "maidsafe/common/utils.h"
 #include "maidsafe/common/tagged_value.h"
 
+#include "maidsafe/nfs/lazy_contents.h"
+#include "maidsafe/nfs/shared_buffer.h"
 #include "maidsafe/nfs/types.h"
+#include "maidsafe/nfs/wire_format.h"
 
 namespace maidsafe {
 
@@ -44,8 +48,9 @@ typedef TaggedValue<Persona, struct detail::DestinationTag> DestinationTaggedVal
 
 }  // namespace detail
 
+// The final element is a view of the serialised contents within the received buffer.
 typedef std::tuple<MessageAction, detail::SourceTaggedValue, detail::DestinationTaggedValue,
-                   MessageId, std::string> TypeErasedMessageWrapper;
+                   MessageId, SharedBuffer> TypeErasedMessageWrapper;
 
 template <MessageAction action, typename SourcePersonaType, typename RoutingSenderType,
           typename DestinationPersonaType, typename RoutingReceiverType, typename ContentsType>
@@ -57,6 +62,7 @@ struct MessageWrapper {
   typedef ContentsType Contents;
   struct Tag;
   typedef boost::error_info<Tag, MessageWrapper> ErrorInfo;
+  static const MessageAction kAction = action;
 
   MessageWrapper();
 
@@ -91,8 +97,11 @@ struct MessageWrapper {
     return ostream;
   }
 
+  // The id is always available.  For incoming messages, the contents are only parsed on first
+  // access, so handlers which can reject a message on its id alone (e.g. a late or duplicate
+  // response) should do so before touching 'contents'.
   MessageId id;
-  std::shared_ptr<ContentsType> contents;
+  detail::LazyContents<ContentsType> contents;
 
  private:
   static const detail::SourceTaggedValue kSourceTaggedValue;
@@ -120,17 +129,51 @@ bool operator==(
     return *lhs.contents == *rhs.contents;
   return true;
 }
+
+// Accepts both the flat encoding produced by MessageWrapper::Serialise and the older
+// protobuf-encoded wrapper.  For the flat encoding, the returned contents are a view into
+// 'serialised_message_wrapper', so no further copy of the contents is made.
+TypeErasedMessageWrapper ParseMessageWrapper(SharedBuffer serialised_message_wrapper);
+// Copies 'serialised_message_wrapper' once into a SharedBuffer.
 TypeErasedMessageWrapper ParseMessageWrapper(const std::string& serialised_message_wrapper);
 
+// Appends an already-serialised message wrapper to 'batch', starting a new batch if 'batch' is
+// empty.  A batch packs several independent message wrappers bound for the same receiver into a
+// single routing message.
+void AppendToMessageWrapperBatch(const std::string& serialised_message_wrapper,
+                                 std::string& batch);
+
+// Accepts either a batch or a single serialised message wrapper (in which case a single element is
+// returned).  The returned contents are views into 'serialised_message_wrappers'.
+std::vector<TypeErasedMessageWrapper> ParseMessageWrappers(
+    SharedBuffer serialised_message_wrappers);
+std::vector<TypeErasedMessageWrapper> ParseMessageWrappers(
+    const std::string& serialised_message_wrappers);
+
 // ==================== Implementation =============================================================
 namespace detail {
 
 MessageId GetNewMessageId();
 
+// Legacy protobuf encoding, where the contents are serialised separately then copied into the
+// wrapper.  Still accepted by ParseMessageWrapper.
 std::string SerialiseMessageWrapper(const TypeErasedMessageWrapper& message_tuple);
 
+// Flat encoding: a marker byte, a version byte, then the action, personas and message id as
+// varints, followed by the serialised contents which run to the end of the buffer.  The contents
+// are appended directly to the same buffer, so no intermediate copy of them is made.
+void AppendMessageWrapperHeader(MessageAction action, const SourceTaggedValue& source_persona,
+                                const DestinationTaggedValue& destination_persona,
+                                const MessageId& message_id, std::string& output);
+
 }  // namespace detail
 
+template <MessageAction action, typename SourcePersonaType, typename RoutingSenderType,
+          typename DestinationPersonaType, typename RoutingReceiverType, typename ContentsType>
+const MessageAction MessageWrapper<action, SourcePersonaType, RoutingSenderType,
+                                   DestinationPersonaType, RoutingReceiverType,
+                                   ContentsType>::kAction;
+
 template <MessageAction action, typename SourcePersonaType, typename RoutingSenderType,
           typename DestinationPersonaType, typename RoutingReceiverType, typename ContentsType>
 const detail::SourceTaggedValue MessageWrapper<
@@ -154,14 +197,14 @@ template <MessageAction action, typename SourcePersonaType, typename RoutingSend
           typename DestinationPersonaType, typename RoutingReceiverType, typename ContentsType>
 MessageWrapper<action, SourcePersonaType, RoutingSenderType, DestinationPersonaType,
                RoutingReceiverType, ContentsType>::MessageWrapper(const ContentsType& contents_in)
-    : id(detail::GetNewMessageId()), contents(std::make_shared<ContentsType>(contents_in)) {}
+    : id(detail::GetNewMessageId()), contents(contents_in) {}
 
 template <MessageAction action, typename SourcePersonaType, typename RoutingSenderType,
           typename DestinationPersonaType, typename RoutingReceiverType, typename ContentsType>
 MessageWrapper<action, SourcePersonaType, RoutingSenderType, DestinationPersonaType,
                RoutingReceiverType, ContentsType>::MessageWrapper(MessageId message_id,
                                                                   ContentsType contents_in)
-    : id(std::move(message_id)), contents(std::make_shared<ContentsType>(contents_in)) {}
+    : id(std::move(message_id)), contents(std::move(contents_in)) {}
 
 template <MessageAction action, typename SourcePersonaType, typename RoutingSenderType,
           typename DestinationPersonaType, typename RoutingReceiverType, typename ContentsType>
@@ -169,7 +212,7 @@ MessageWrapper<action, SourcePersonaType, RoutingSenderType, DestinationPersonaT
                RoutingReceiverType,
                ContentsType>::MessageWrapper(const TypeErasedMessageWrapper& parsed_message_wrapper)
     : id(std::get<3>(parsed_message_wrapper)),
-      contents(std::make_shared<ContentsType>(std::get<4>(parsed_message_wrapper))) {}
+      contents(std::get<4>(parsed_message_wrapper)) {}
 
 template <MessageAction action, typename SourcePersonaType, typename RoutingSenderType,
           typename DestinationPersonaType, typename RoutingReceiverType, typename ContentsType>
@@ -198,8 +241,12 @@ template <MessageAction action, typename SourcePersonaType, typename RoutingSend
           typename DestinationPersonaType, typename RoutingReceiverType, typename ContentsType>
 std::string MessageWrapper<action, SourcePersonaType, RoutingSenderType, DestinationPersonaType,
                            RoutingReceiverType, ContentsType>::Serialise() const {
-  return detail::SerialiseMessageWrapper(std::make_tuple(
-      action, kSourceTaggedValue, kDestinationTaggedValue, id, contents->Serialise()));
+  std::string serialised;
+  detail::AppendMessageWrapperHeader(action, kSourceTaggedValue, kDestinationTaggedValue, id,
+                                     serialised);
+  using detail::AppendSerialised;
+  AppendSerialised(*contents, serialised);
+  return serialised;
 }
 
 template <MessageAction action, typename SourcePersonaType, typename RoutingSenderType,
@@ -0,0 +1,168 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_PENDING_OPERATIONS_H_
+#define MAIDSAFE_NFS_PENDING_OPERATIONS_H_
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/asio_service.h"
+
+#include "maidsafe/nfs/types.h"
+
+namespace maidsafe {
+
+namespace nfs {
+
+// Single table of the requests awaiting responses, replacing a routing::Timer per response type.
+// Each task holds a type-erased completion functor keyed by its task id, which is the full 64-bit
+// message id of the request (see detail::GetNewMessageId), so ids don't repeat across clients.
+// The table is split into shards, each with its own lock and expiry timer, so the cost of adding,
+// completing or expiring a task doesn't grow with the number of tasks in flight on other threads.
+//
+// As with routing::Timer, a task's functor is called once per response until 'expected_count'
+// responses have been received, and once with a default-constructed response if the task times
+// out, is cancelled or is still pending when the table is destroyed.  Where a default-constructed
+// response can't be told apart from a real one (e.g. a successful ReturnCode), the task can
+// instead be given a separate functor to call on expiry.
+class PendingOperations {
+ public:
+  explicit PendingOperations(AsioService& asio_service);
+  ~PendingOperations();
+
+  TaskId NewTaskId();
+
+  // Throws CommonErrors::invalid_parameter if 'task_id' is already in use.
+  template <typename Response>
+  void AddTask(const std::chrono::steady_clock::duration& timeout,
+               std::function<void(Response)> functor, int expected_count,
+               TaskId task_id);
+
+  // As above, but calls 'on_expiry' rather than passing 'functor' a default-constructed response if
+  // the task times out, is cancelled or is still pending on destruction.  'functor' and 'on_expiry'
+  // are held in the task itself rather than each in a std::function.
+  template <typename Response, typename Functor, typename ExpiryFunctor>
+  void AddTask(const std::chrono::steady_clock::duration& timeout, Functor functor,
+               ExpiryFunctor on_expiry, int expected_count, TaskId task_id);
+
+  // Returns false (and drops 'response') if there is no pending task for 'task_id' expecting a
+  // response of this type.
+  template <typename Response>
+  bool AddResponse(TaskId task_id, Response response);
+
+  bool HasTask(TaskId task_id) const;
+  void CancelTask(TaskId task_id);
+  size_t size() const;
+
+ private:
+  typedef std::multimap<std::chrono::steady_clock::time_point, TaskId> Deadlines;
+
+  struct Task {
+    Task(std::type_index response_type_in, int expected_count);
+    virtual ~Task() {}
+    // Calls the expiry functor, or the functor with a default-constructed response if it has none.
+    virtual void Expire() = 0;
+
+    const std::type_index response_type;
+    int outstanding_responses;
+    Deadlines::iterator deadline;
+  };
+
+  template <typename Response>
+  struct TypedTask : public Task {
+    explicit TypedTask(int expected_count) : Task(typeid(Response), expected_count) {}
+    virtual void HandleResponse(Response response) = 0;
+  };
+
+  template <typename Response>
+  struct DefaultExpiryTask : public TypedTask<Response> {
+    DefaultExpiryTask(std::function<void(Response)> functor_in, int expected_count)
+        : TypedTask<Response>(expected_count), functor(std::move(functor_in)) {}
+    virtual void HandleResponse(Response response) { functor(std::move(response)); }
+    virtual void Expire() { functor(Response()); }
+
+    std::function<void(Response)> functor;
+  };
+
+  template <typename Response, typename Functor, typename ExpiryFunctor>
+  struct ExpiryFunctorTask : public TypedTask<Response> {
+    ExpiryFunctorTask(Functor functor_in, ExpiryFunctor on_expiry_in, int expected_count)
+        : TypedTask<Response>(expected_count),
+          functor(std::move(functor_in)),
+          on_expiry(std::move(on_expiry_in)) {}
+    virtual void HandleResponse(Response response) { functor(std::move(response)); }
+    virtual void Expire() { on_expiry(); }
+
+    Functor functor;
+    ExpiryFunctor on_expiry;
+  };
+
+  struct Shard;
+
+  PendingOperations(const PendingOperations&);
+  PendingOperations(PendingOperations&&);
+  PendingOperations& operator=(PendingOperations);
+
+  Shard& GetShard(TaskId task_id) const;
+  void Insert(TaskId task_id, const std::chrono::steady_clock::duration& timeout,
+              std::shared_ptr<Task> task);
+  // Returns the task if it expects a response of 'response_type', removing it from the table if
+  // this is its last expected response.
+  std::shared_ptr<Task> TakeResponseSlot(TaskId task_id,
+                                         const std::type_index& response_type);
+
+  std::vector<std::shared_ptr<Shard>> shards_;
+};
+
+// ==================== Implementation =============================================================
+template <typename Response>
+void PendingOperations::AddTask(const std::chrono::steady_clock::duration& timeout,
+                                std::function<void(Response)> functor, int expected_count,
+                                TaskId task_id) {
+  Insert(task_id, timeout,
+         std::make_shared<DefaultExpiryTask<Response>>(std::move(functor), expected_count));
+}
+
+template <typename Response, typename Functor, typename ExpiryFunctor>
+void PendingOperations::AddTask(const std::chrono::steady_clock::duration& timeout,
+                                Functor functor, ExpiryFunctor on_expiry, int expected_count,
+                                TaskId task_id) {
+  Insert(task_id, timeout, std::make_shared<ExpiryFunctorTask<Response, Functor, ExpiryFunctor>>(
+                               std::move(functor), std::move(on_expiry), expected_count));
+}
+
+template <typename Response>
+bool PendingOperations::AddResponse(TaskId task_id, Response response) {
+  auto task(TakeResponseSlot(task_id, typeid(Response)));
+  if (!task)
+    return false;
+  static_cast<TypedTask<Response>&>(*task).HandleResponse(std::move(response));
+  return true;
+}
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_PENDING_OPERATIONS_H_
@@ -0,0 +1,109 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_SCRATCH_PROTOBUF_H_
+#define MAIDSAFE_NFS_SCRATCH_PROTOBUF_H_
+
+#include <memory>
+
+#include "boost/thread/tss.hpp"
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace detail {
+
+// Provides a cleared instance of ProtobufMessage for use as a temporary while serialising or
+// parsing.  Rather than heap-allocating a fresh protobuf message (and all of its string and
+// repeated field storage) on every call, each thread keeps one instance per message type which is
+// cleared and reused.  Clear() retains the capacity of the message's fields, so after warm-up the
+// serialise and parse paths allocate nothing for these temporaries.
+//
+// If the thread's instance is already in use (e.g. nested use of the same type), a private
+// instance is allocated instead.  Instances whose contents grew beyond kMaxRetainedBytes are freed
+// rather than retained, so that a single large message doesn't pin memory to every thread.
+template <typename ProtobufMessage>
+class ScratchProtobuf {
+ public:
+  ScratchProtobuf();
+  ~ScratchProtobuf();
+
+  ProtobufMessage* operator->() const { return message_; }
+  ProtobufMessage& operator*() const { return *message_; }
+
+ private:
+  struct Slot {
+    Slot() : message(new ProtobufMessage), in_use(false) {}
+    std::unique_ptr<ProtobufMessage> message;
+    bool in_use;
+  };
+
+  ScratchProtobuf(const ScratchProtobuf&);
+  ScratchProtobuf(ScratchProtobuf&&);
+  ScratchProtobuf& operator=(ScratchProtobuf);
+
+  static Slot& ThisThreadsSlot();
+
+  static const int kMaxRetainedBytes = 64 * 1024;
+  Slot* slot_;
+  std::unique_ptr<ProtobufMessage> private_message_;
+  ProtobufMessage* message_;
+};
+
+// ==================== Implementation =============================================================
+template <typename ProtobufMessage>
+ScratchProtobuf<ProtobufMessage>::ScratchProtobuf()
+    : slot_(&ThisThreadsSlot()), private_message_(), message_(nullptr) {
+  if (slot_->in_use) {
+    slot_ = nullptr;
+    private_message_.reset(new ProtobufMessage);
+    message_ = private_message_.get();
+  } else {
+    slot_->in_use = true;
+    message_ = slot_->message.get();
+  }
+}
+
+template <typename ProtobufMessage>
+ScratchProtobuf<ProtobufMessage>::~ScratchProtobuf() {
+  if (!slot_)
+    return;
+  if (message_->ByteSize() > kMaxRetainedBytes)
+    slot_->message.reset(new ProtobufMessage);
+  else
+    message_->Clear();
+  slot_->in_use = false;
+}
+
+template <typename ProtobufMessage>
+typename ScratchProtobuf<ProtobufMessage>::Slot&
+    ScratchProtobuf<ProtobufMessage>::ThisThreadsSlot() {
+  static boost::thread_specific_ptr<Slot> slot;
+  if (!slot.get())
+    slot.reset(new Slot);
+  return *slot;
+}
+
+}  // namespace detail
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_SCRATCH_PROTOBUF_H_
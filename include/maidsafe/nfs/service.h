@@ -19,9 +19,17 @@
 #ifndef MAIDSAFE_NFS_SERVICE_H_
 #define MAIDSAFE_NFS_SERVICE_H_
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "boost/mpl/for_each.hpp"
+#include "boost/mpl/placeholders.hpp"
+#include "boost/type_traits/add_pointer.hpp"
 #include "boost/variant/static_visitor.hpp"
 #include "boost/variant/variant.hpp"
 
@@ -35,13 +43,6 @@
 
 namespace maidsafe {
 
-namespace vault {
-
-template <typename T>
-inline bool GetVariant(const maidsafe::nfs::TypeErasedMessageWrapper& message, T& variant);
-
-}  // namespace vault
-
 namespace nfs {
 
 namespace detail {
@@ -79,6 +80,131 @@ class PersonaDemuxer : public boost::static_visitor<
   const Receiver& receiver_;
 };
 
+// Maps each (action, source persona, destination persona) triple in PersonaService's PublicMessages
+// and VaultMessages variants to a function which constructs that exact message type from the
+// type-erased wrapper and passes it to the demuxer.  This replaces probing each variant in turn.
+// Where a triple appears in both variants, the public message type is used.  One table is built
+// per Sender/Receiver combination, on first use, from the variants generated into message_types.h
+// (the generator itself lives in the shared cmake_modules).  See service_dispatch_benchmark.cc for
+// its cost relative to probing the variants.
+//
+// The set of triples is fixed once the variants are known, so the table uses a perfect hash: a
+// multiplier is chosen at construction such that every triple maps to a distinct slot.  A lookup
+// is then a single multiply and shift plus one key comparison (to reject unknown triples),
+// regardless of how many actions or message types exist.
+template <typename PersonaService, typename Sender, typename Receiver>
+class MessageDispatchTable {
+ public:
+  typedef PersonaDemuxer<PersonaService, Sender, Receiver> Demuxer;
+  typedef typename PersonaService::HandleMessageReturnType ReturnType;
+  typedef ReturnType (*Handler)(const TypeErasedMessageWrapper&, const Demuxer&);
+
+  static const MessageDispatchTable& Instance() {
+    static const MessageDispatchTable table;
+    return table;
+  }
+
+  // Returns nullptr if no message type in either variant matches.
+  Handler Find(const TypeErasedMessageWrapper& message) const {
+    auto key(MakeKey(std::get<0>(message), std::get<1>(message).data, std::get<2>(message).data));
+    const Slot& slot(slots_[SlotIndex(key, multiplier_, shift_)]);
+    return (slot.handler && slot.key == key) ? slot.handler : nullptr;
+  }
+
+ private:
+  struct Slot {
+    Slot() : key(0), handler(nullptr) {}
+    Slot(uint32_t key_in, Handler handler_in) : key(key_in), handler(handler_in) {}
+    uint32_t key;
+    Handler handler;
+  };
+
+  class Registrar {
+   public:
+    explicit Registrar(std::vector<Slot>& entries) : entries_(entries) {}
+    template <typename Message>
+    void operator()(Message* /*tag*/) const {
+      auto key(MakeKey(Message::kAction, Message::SourcePersona::value,
+                       Message::DestinationPersona::value));
+      if (std::none_of(std::begin(entries_), std::end(entries_),
+                       [key](const Slot& entry) { return entry.key == key; })) {
+        entries_.emplace_back(key, &MessageDispatchTable::HandleAs<Message>);
+      }
+    }
+
+   private:
+    std::vector<Slot>& entries_;
+  };
+
+  MessageDispatchTable() : slots_(), multiplier_(0), shift_(0) {
+    std::vector<Slot> entries;
+    AddMessages<typename PersonaService::PublicMessages>(
+        entries, std::is_void<typename PersonaService::PublicMessages>());
+    AddMessages<typename PersonaService::VaultMessages>(
+        entries, std::is_void<typename PersonaService::VaultMessages>());
+    BuildPerfectHash(entries);
+  }
+
+  static uint32_t MakeKey(MessageAction action, Persona source, Persona destination) {
+    return (static_cast<uint32_t>(action) << 16) | (static_cast<uint32_t>(source) << 8) |
+           static_cast<uint32_t>(destination);
+  }
+
+  static size_t SlotIndex(uint32_t key, uint32_t multiplier, uint32_t shift) {
+    return static_cast<size_t>(static_cast<uint32_t>(key * multiplier) >> shift);
+  }
+
+  template <typename Variant>
+  void AddMessages(std::vector<Slot>& /*entries*/, std::true_type /*is_void*/) {}
+
+  template <typename Variant>
+  void AddMessages(std::vector<Slot>& entries, std::false_type /*is_void*/) {
+    boost::mpl::for_each<typename Variant::types, boost::add_pointer<boost::mpl::_1>>(
+        Registrar(entries));
+  }
+
+  // Starts with at least twice as many slots as entries and tries a series of odd multipliers,
+  // doubling the number of slots if none is collision-free.  With at least n^2 slots, a random
+  // multiplier succeeds with probability of at least one half, so this always terminates quickly.
+  void BuildPerfectHash(const std::vector<Slot>& entries) {
+    const int kMaxAttemptsPerSize(64);
+    shift_ = 31;
+    while ((uint64_t(1) << (32 - shift_)) < entries.size() * 2)
+      --shift_;
+    for (;;) {
+      std::vector<Slot> slots(size_t(1) << (32 - shift_));
+      uint32_t multiplier(0x9E3779B1);  // Fibonacci hashing constant
+      for (int attempt(0); attempt != kMaxAttemptsPerSize; ++attempt, multiplier += 0x6A09E668) {
+        multiplier |= 1;
+        std::fill(std::begin(slots), std::end(slots), Slot());
+        bool collision(false);
+        for (const auto& entry : entries) {
+          Slot& slot(slots[SlotIndex(entry.key, multiplier, shift_)]);
+          if (slot.handler) {
+            collision = true;
+            break;
+          }
+          slot = entry;
+        }
+        if (!collision) {
+          slots_.swap(slots);
+          multiplier_ = multiplier;
+          return;
+        }
+      }
+      --shift_;
+    }
+  }
+
+  template <typename Message>
+  static ReturnType HandleAs(const TypeErasedMessageWrapper& message, const Demuxer& demuxer) {
+    return demuxer(Message(message));
+  }
+
+  std::vector<Slot> slots_;
+  uint32_t multiplier_, shift_;
+};
+
 }  // namespace detail
 
 template <typename PersonaService>
@@ -99,10 +225,16 @@ class Service {
       const Receiver& receiver) {
     const detail::PersonaDemuxer<PersonaService, Sender, Receiver> demuxer(*impl_, sender,
                                                                            receiver);
-    static std::is_void<PublicMessages> public_messages_void_state;
-    static std::is_void<VaultMessages> vault_messages_void_state;
     try {
-      return HandleMessage(message, demuxer, public_messages_void_state, vault_messages_void_state);
+      auto handler(detail::MessageDispatchTable<PersonaService, Sender, Receiver>::Instance().Find(
+          message));
+      if (!handler) {
+        LOG(kError) << "Not a valid message for this persona: " << std::get<0>(message)
+                    << " from " << std::get<1>(message).data << " to "
+                    << std::get<2>(message).data;
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+      }
+      return handler(message, demuxer);
     }
     catch (const maidsafe_error& error) {
       LOG(kError) << "Invalid request. " << boost::diagnostic_information(error);
@@ -110,6 +242,20 @@ class Service {
     }
   }
 
+  // Handles each message of a serialised batch (see MessageBatcher) or of a single serialised
+  // message wrapper in turn.  The batched messages are independent, so a failure to handle one is
+  // logged and doesn't prevent the remainder from being handled.
+  template <typename Sender, typename Receiver>
+  void HandleMessages(const std::string& serialised_messages, const Sender& sender,
+                      const Receiver& receiver) {
+    for (const auto& message : ParseMessageWrappers(serialised_messages)) {
+      try {
+        HandleMessage(message, sender, receiver);
+      }
+      catch (const maidsafe_error&) {}  // Already logged by HandleMessage.
+    }
+  }
+
   void HandleChurnEvent(std::shared_ptr<routing::MatrixChange> matrix_change) {
     LOG(kVerbose) << "NFS service calling persona_service HandleChurnEvent";
     return impl_->HandleChurnEvent(matrix_change);
@@ -136,60 +282,6 @@ class Service {
   }
 
  private:
-  typedef std::true_type IsVoid;
-  typedef std::false_type IsNotVoid;
-
-  template <typename Demuxer>
-  ReturnType HandlePublicMessage(const nfs::TypeErasedMessageWrapper& message,
-                                 const Demuxer& demuxer) {
-    LOG(kVerbose) << "nfs HandlePublicMessage";
-    PublicMessages public_variant_message;
-    if (!nfs::GetVariant(message, public_variant_message)) {
-      LOG(kError) << "Not a valid public message";
-      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
-    }
-    return boost::apply_visitor(demuxer, public_variant_message);
-  }
-  template <typename Demuxer>
-  ReturnType HandleVaultMessage(const nfs::TypeErasedMessageWrapper& message,
-                                const Demuxer& demuxer) {
-    LOG(kVerbose) << "nfs HandleVaultMessage";
-    VaultMessages vault_variant_message;
-    if (!vault::GetVariant(message, vault_variant_message)) {
-      LOG(kError) << "Not a valid vault message" << vault_variant_message;
-      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
-    } else {
-      LOG(kVerbose) << "processing: " << vault_variant_message;
-    }
-    return boost::apply_visitor(demuxer, vault_variant_message);
-  }
-
-  // Public messages only are non-void.
-  template <typename Demuxer>
-  ReturnType HandleMessage(const nfs::TypeErasedMessageWrapper& message, const Demuxer& demuxer,
-                           IsNotVoid, IsVoid) {
-    return HandlePublicMessage(message, demuxer);
-  }
-
-  // Vault messages only are non-void.
-  template <typename Demuxer>
-  ReturnType HandleMessage(const nfs::TypeErasedMessageWrapper& message, const Demuxer& demuxer,
-                           IsVoid, IsNotVoid) {
-    return HandleVaultMessage(message, demuxer);
-  }
-
-  // Both types of message are non-void.
-  template <typename Demuxer>
-  ReturnType HandleMessage(const nfs::TypeErasedMessageWrapper& message, const Demuxer& demuxer,
-                           IsNotVoid, IsNotVoid) {
-    try {
-      return HandlePublicMessage(message, demuxer);
-    }
-    catch (const maidsafe_error& /*error*/) {
-      return HandleVaultMessage(message, demuxer);
-    }
-  }
-
   std::unique_ptr<PersonaService> impl_;
 };
 
@@ -0,0 +1,67 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_SHARED_BUFFER_H_
+#define MAIDSAFE_NFS_SHARED_BUFFER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "maidsafe/common/config.h"
+
+namespace maidsafe {
+
+namespace nfs {
+
+// An immutable, reference-counted view of a range within a byte buffer.  Used to pass received
+// messages (and parts of them) around without copying the underlying bytes.  Copies of a
+// SharedBuffer share the same underlying buffer, which is freed when the last view is destroyed.
+class SharedBuffer {
+ public:
+  SharedBuffer();
+  // Takes ownership of 'buffer'; the view covers the whole of it.
+  explicit SharedBuffer(std::string buffer);
+  SharedBuffer(std::shared_ptr<const std::string> buffer, size_t offset, size_t length);
+  SharedBuffer(const SharedBuffer& other);
+  SharedBuffer(SharedBuffer&& other);
+  SharedBuffer& operator=(SharedBuffer other);
+
+  const char* data() const;
+  size_t size() const;
+  bool empty() const;
+  // Returns a copy of the viewed bytes.
+  std::string string() const;
+  // Returns a view of a sub-range of this view, sharing the same underlying buffer.  Throws
+  // CommonErrors::invalid_parameter if the range isn't contained within this view.
+  SharedBuffer Slice(size_t offset, size_t length) const;
+
+  friend void swap(SharedBuffer& lhs, SharedBuffer& rhs) MAIDSAFE_NOEXCEPT;
+
+ private:
+  std::shared_ptr<const std::string> buffer_;
+  size_t offset_, length_;
+};
+
+bool operator==(const SharedBuffer& lhs, const SharedBuffer& rhs);
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_SHARED_BUFFER_H_
@@ -117,7 +117,13 @@ struct PersonaTypes;
 namespace detail {
 struct MessageIdTag;
 }
-typedef TaggedValue<int32_t, detail::MessageIdTag> MessageId;
+// The top bits are a random per-process prefix and the remainder a counter (see
+// detail::GetNewMessageId), so ids are unique within a process and unlikely to collide across them.
+typedef TaggedValue<int64_t, detail::MessageIdTag> MessageId;
+
+// Requests awaiting responses are tracked by the full id of the request's message, so the id of a
+// response identifies the task it completes.
+typedef int64_t TaskId;
 
 }  // namespace nfs
 
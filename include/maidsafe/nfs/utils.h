@@ -19,7 +19,9 @@
 #ifndef MAIDSAFE_NFS_UTILS_H_
 #define MAIDSAFE_NFS_UTILS_H_
 
+#include <algorithm>
 #include <functional>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -32,8 +34,10 @@
 #include "maidsafe/common/utils.h"
 #include "maidsafe/routing/parameters.h"
 #include "maidsafe/routing/api_config.h"
+#include "maidsafe/routing/timer.h"
 
 #include "maidsafe/nfs/public_pmid_helper.h"
+#include "maidsafe/nfs/types.h"
 
 namespace maidsafe {
 
@@ -72,15 +76,23 @@ bool CheckMutuallyExclusive(const A& a, const B& b) {
   return (!a != !b);
 }
 
+// Requests awaiting responses are tracked by task id, and the task id is sent as the request's
+// message id, so a response's message id identifies the task.
+inline TaskId GetTaskId(const MessageId& message_id) { return message_id.data; }
+
+// As above, for requests tracked by a routing::Timer, whose task ids are only 32 bits wide.
+inline routing::TaskId GetTimerTaskId(const MessageId& message_id) {
+  return static_cast<routing::TaskId>(message_id.data);
+}
+
 template <typename MessageContents>
 bool IsSuccess(const MessageContents& response) {
-  LOG(kVerbose) << "IsSuccess return_code " << response.return_code.value.what();
-  return response.return_code.value.code().value() == static_cast<int>(CommonErrors::success);
+  return response.return_code.value.value() == static_cast<int>(CommonErrors::success);
 }
 
 template <typename MessageContents>
 std::error_code ErrorCode(const MessageContents& response) {
-  return response.return_code.value.code();
+  return response.return_code.value;
 }
 
 // If 'responses' contains >= n successsful responses where n is 'successes_required', returns
@@ -93,11 +105,22 @@ std::pair<typename std::vector<MessageContents>::const_iterator, bool>
     GetSuccessOrMostFrequentResponse(const std::vector<MessageContents>& responses,
                                      int successes_required);
 
+// Collects the responses to a request, calling 'callback' once with the chosen response as soon as
+// the operation has succeeded or failed overall (see HandleResponseContents).  Responses are
+// tallied as they arrive rather than stored, so each costs O(1) however many have been received.
 template <typename MessageContents>
 class OpData {
  public:
   OpData(int successes_required, std::function<void(MessageContents)> callback);
+  // Once 'successes_required' successful responses have arrived, the first of these is passed to
+  // the callback; the others are dropped as duplicates.  Otherwise, once more than half a group has
+  // responded, the failure with the most frequent error code is passed (the first to reach that
+  // frequency if tied).
   void HandleResponseContents(MessageContents&& response_contents);
+  // Passes 'response_contents' to the callback unless it has already been called, i.e. if the
+  // request expires before enough responses have arrived to decide its outcome.  Returns whether
+  // it was passed.
+  bool HandleExpiry(MessageContents&& response_contents);
 
  private:
   OpData(const OpData&);
@@ -107,7 +130,10 @@ class OpData {
   mutable std::mutex mutex_;
   int successes_required_;
   std::function<void(MessageContents)> callback_;
-  std::vector<MessageContents> responses_;
+  // Number of failures seen for each distinct error code.  There are only ever a few of these.
+  std::vector<std::pair<std::error_code, int>> error_counts_;
+  std::unique_ptr<MessageContents> first_success_, most_frequent_failure_;
+  int response_count_, success_count_, most_frequent_failure_count_;
   bool callback_executed_;
 };
 
@@ -148,7 +174,12 @@ OpData<MessageContents>::OpData(int successes_required,
     : mutex_(),
       successes_required_(successes_required),
       callback_(callback),
-      responses_(),
+      error_counts_(),
+      first_success_(),
+      most_frequent_failure_(),
+      response_count_(0),
+      success_count_(0),
+      most_frequent_failure_count_(0),
       callback_executed_(!callback) {
   if (!callback || successes_required <= 0) {
     LOG(kError) << "invalid parameters for OpData constructor";
@@ -158,31 +189,71 @@ OpData<MessageContents>::OpData(int successes_required,
 
 template <typename MessageContents>
 void OpData<MessageContents>::HandleResponseContents(MessageContents&& response_contents) {
-  LOG(kVerbose) << "OpData<MessageContents>::HandleResponseContents";
   std::function<void(MessageContents)> callback;
   std::unique_ptr<MessageContents> result_ptr;
   {
     std::lock_guard<std::mutex> lock(mutex_);
     if (callback_executed_) {
-      LOG(kInfo) << "OpData<MessageContents>::HandleResponseContents already called back";
+      LOG(kVerbose) << "OpData<MessageContents>::HandleResponseContents already called back";
       return;
     }
-    responses_.push_back(std::move(response_contents));
-    auto result(GetSuccessOrMostFrequentResponse(responses_, successes_required_));
+    ++response_count_;
+    if (IsSuccess(response_contents)) {
+      ++success_count_;
+      if (!first_success_)
+        first_success_.reset(new MessageContents(std::move(response_contents)));
+    } else {
+      auto error_code(ErrorCode(response_contents));
+      auto itr(std::find_if(std::begin(error_counts_), std::end(error_counts_),
+                            [&error_code](const std::pair<std::error_code, int>& error_count) {
+                              return error_count.first == error_code;
+                            }));
+      if (itr == std::end(error_counts_))
+        itr = error_counts_.insert(itr, std::make_pair(error_code, 0));
+      if (++itr->second > most_frequent_failure_count_) {
+        most_frequent_failure_count_ = itr->second;
+        most_frequent_failure_.reset(new MessageContents(std::move(response_contents)));
+      }
+    }
+
     // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
-    if (result.second || responses_.size() > (routing::Parameters::group_size / 2U)) {
-      // Operation has succeeded or failed overall
-      callback = callback_;
-      callback_executed_ = true;
-      result_ptr = std::unique_ptr<MessageContents>(new MessageContents(*result.first));
+    if (success_count_ >= successes_required_) {
+      result_ptr = std::move(first_success_);
+    } else if (response_count_ > static_cast<int>(routing::Parameters::group_size / 2U)) {
+      // Operation has failed overall.  If every response was a success (but too few to satisfy
+      // 'successes_required_') the first success is returned.
+      result_ptr = most_frequent_failure_ ? std::move(most_frequent_failure_)
+                                          : std::move(first_success_);
     } else {
-      LOG(kWarning) << "OpData<MessageContents>::HandleResponseContents"
-                    << " incorrect result or not enough result";
+      LOG(kVerbose) << "OpData<MessageContents>::HandleResponseContents not enough responses yet";
       return;
     }
+    callback = callback_;
+    callback_executed_ = true;
+    error_counts_.clear();
+    first_success_.reset();
+    most_frequent_failure_.reset();
   }
   LOG(kInfo) << "OpData<MessageContents>::HandleResponseContents call back";
-  callback(*result_ptr);
+  callback(std::move(*result_ptr));
+}
+
+template <typename MessageContents>
+bool OpData<MessageContents>::HandleExpiry(MessageContents&& response_contents) {
+  std::function<void(MessageContents)> callback;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (callback_executed_)
+      return false;
+    callback = callback_;
+    callback_executed_ = true;
+    error_counts_.clear();
+    first_success_.reset();
+    most_frequent_failure_.reset();
+  }
+  LOG(kInfo) << "OpData<MessageContents>::HandleExpiry call back";
+  callback(std::move(response_contents));
+  return true;
 }
 
 }  // namespace nfs
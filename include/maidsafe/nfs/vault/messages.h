@@ -29,6 +29,8 @@
 #include "maidsafe/common/data_types/data_type_values.h"
 #include "maidsafe/common/data_types/structured_data_versions.h"
 
+#include "maidsafe/nfs/shared_buffer.h"
+
 #include "maidsafe/nfs/vault/account_creation.h"
 #include "maidsafe/nfs/vault/account_removal.h"
 #include "maidsafe/nfs/vault/pmid_registration.h"
@@ -218,6 +220,12 @@ struct DataNameAndContent {
 
 bool operator==(const DataNameAndContent& lhs, const DataNameAndContent& rhs);
 void swap(DataNameAndContent& lhs, DataNameAndContent& rhs) MAIDSAFE_NOEXCEPT;
+// Single-pass writer used by nfs::MessageWrapper::Serialise and parser used when constructing a
+// MessageWrapper from a received buffer (see maidsafe/nfs/wire_format.h).  The parser copies the
+// content directly from the received buffer into 'content'.
+void AppendSerialised(const DataNameAndContent& data_name_and_content, std::string& output);
+DataNameAndContent ParseContents(const nfs::SharedBuffer& serialised_contents,
+                                 DataNameAndContent* /*tag*/);
 
 // ========================== Content ==============================================================
 
@@ -324,6 +332,9 @@ struct DataAndPmidHint {
 
 bool operator==(const DataAndPmidHint& lhs, const DataAndPmidHint& rhs);
 void swap(DataAndPmidHint& lhs, DataAndPmidHint& rhs) MAIDSAFE_NOEXCEPT;
+void AppendSerialised(const DataAndPmidHint& data_and_pmid_hint, std::string& output);
+DataAndPmidHint ParseContents(const nfs::SharedBuffer& serialised_contents,
+                              DataAndPmidHint* /*tag*/);
 
 // ========================== DataNameAndContentOrCheckResult ======================================
 
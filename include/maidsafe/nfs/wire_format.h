@@ -0,0 +1,87 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_WIRE_FORMAT_H_
+#define MAIDSAFE_NFS_WIRE_FORMAT_H_
+
+#include <cstdint>
+#include <string>
+
+#include "maidsafe/nfs/shared_buffer.h"
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace detail {
+
+// Helpers for writing protobuf-compatible fields straight into an output buffer.  These allow
+// messages with nested 'bytes' fields to be serialised in a single pass, rather than having each
+// level serialised to a temporary string and then copied into its parent.
+size_t VarintSize(uint64_t value);
+void AppendVarint(uint64_t value, std::string& output);
+// Throws CommonErrors::parsing_error if 'data' doesn't hold a complete varint at 'offset'.
+uint64_t ReadVarint(const char* data, size_t size, size_t& offset);
+
+// Size of a complete length-delimited field (tag, length and value) with a value of 'length' bytes.
+size_t LengthDelimitedFieldSize(uint32_t field_number, size_t length);
+// Appends the tag and length only; the caller is responsible for appending exactly 'length' bytes.
+void AppendLengthDelimitedFieldHeader(uint32_t field_number, size_t length, std::string& output);
+void AppendLengthDelimitedField(uint32_t field_number, const std::string& value,
+                                std::string& output);
+
+// A field's value within a buffer being parsed.  Only valid while the buffer is.
+struct FieldView {
+  FieldView() : data(nullptr), size(0) {}
+  bool present() const { return data != nullptr; }
+  std::string string() const { return std::string(data, size); }
+
+  const char* data;
+  size_t size;
+};
+
+// Parses a protobuf-encoded message in place, setting 'fields[n]' to the value of length-delimited
+// field 'n' for each n in [1, field_count).  Other fields are skipped.  No bytes are copied.
+// Throws CommonErrors::parsing_error if the message is malformed.
+void ParseLengthDelimitedFields(const char* data, size_t size, FieldView* fields,
+                                uint32_t field_count);
+
+// Fallback for contents types which don't provide a dedicated single-pass writer.  Types which do
+// provide one declare an 'AppendSerialised' overload in their own namespace, so callers should use
+// this in the same way as 'std::swap', i.e. 'using detail::AppendSerialised;' followed by an
+// unqualified call.
+template <typename Contents>
+void AppendSerialised(const Contents& contents, std::string& output) {
+  output += contents.Serialise();
+}
+
+// Fallback for contents types which can't parse directly from a SharedBuffer.  Types which can
+// declare a 'ParseContents(const nfs::SharedBuffer&, Type*)' overload in their own namespace; the
+// pointer is only used to select the overload.  Use as for 'AppendSerialised' above.
+template <typename Contents>
+Contents ParseContents(const SharedBuffer& serialised_contents, Contents* /*tag*/) {
+  return Contents(serialised_contents.string());
+}
+
+}  // namespace detail
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_WIRE_FORMAT_H_
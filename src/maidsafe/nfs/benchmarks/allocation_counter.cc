@@ -0,0 +1,105 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/benchmarks/allocation_counter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "maidsafe/common/config.h"
+
+namespace {
+
+// Each allocation is prefixed with its size so that live bytes can be tracked on deallocation.
+const std::size_t kHeaderSize(alignof(std::max_align_t));
+
+std::atomic<uint64_t> g_allocations(0);
+std::atomic<uint64_t> g_bytes(0);
+std::atomic<uint64_t> g_live_bytes(0);
+std::atomic<uint64_t> g_peak_live_bytes(0);
+
+void* CountedAllocate(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_bytes.fetch_add(size, std::memory_order_relaxed);
+  auto live(g_live_bytes.fetch_add(size, std::memory_order_relaxed) + size);
+  auto peak(g_peak_live_bytes.load(std::memory_order_relaxed));
+  while (live > peak &&
+         !g_peak_live_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+  if (auto memory = static_cast<char*>(std::malloc(size + kHeaderSize))) {
+    *reinterpret_cast<std::size_t*>(memory) = size;
+    return memory + kHeaderSize;
+  }
+  throw std::bad_alloc();
+}
+
+void CountedFree(void* memory) {
+  if (!memory)
+    return;
+  auto block(static_cast<char*>(memory) - kHeaderSize);
+  g_live_bytes.fetch_sub(*reinterpret_cast<std::size_t*>(block), std::memory_order_relaxed);
+  std::free(block);
+}
+
+}  // unnamed namespace
+
+void* operator new(std::size_t size) { return CountedAllocate(size); }
+
+void* operator new[](std::size_t size) { return CountedAllocate(size); }
+
+void operator delete(void* memory) MAIDSAFE_NOEXCEPT { CountedFree(memory); }
+
+void operator delete[](void* memory) MAIDSAFE_NOEXCEPT { CountedFree(memory); }
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace benchmarks {
+
+AllocationCount CurrentAllocationCount() {
+  AllocationCount count;
+  count.allocations = g_allocations.load(std::memory_order_relaxed);
+  count.bytes = g_bytes.load(std::memory_order_relaxed);
+  return count;
+}
+
+uint64_t ResetPeakLiveBytes() {
+  auto live(g_live_bytes.load(std::memory_order_relaxed));
+  g_peak_live_bytes.store(live, std::memory_order_relaxed);
+  return live;
+}
+
+uint64_t PeakLiveBytes() { return g_peak_live_bytes.load(std::memory_order_relaxed); }
+
+AllocationCounter::AllocationCounter() : start_(CurrentAllocationCount()) {}
+
+void AllocationCounter::Report(::benchmark::State& state) const {
+  auto end(CurrentAllocationCount());
+  auto iterations(static_cast<double>(state.iterations() == 0 ? 1 : state.iterations()));
+  state.counters["allocs/op"] = static_cast<double>(end.allocations - start_.allocations) /
+                                iterations;
+  state.counters["bytes/op"] = static_cast<double>(end.bytes - start_.bytes) / iterations;
+}
+
+}  // namespace benchmarks
+
+}  // namespace nfs
+
+}  // namespace maidsafe
@@ -0,0 +1,62 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_BENCHMARKS_ALLOCATION_COUNTER_H_
+#define MAIDSAFE_NFS_BENCHMARKS_ALLOCATION_COUNTER_H_
+
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace benchmarks {
+
+// Snapshot of the process-wide counters maintained by the replacement global operator new
+// defined in allocation_counter.cc.
+struct AllocationCount {
+  uint64_t allocations;
+  uint64_t bytes;
+};
+
+AllocationCount CurrentAllocationCount();
+
+// High-water mark of heap bytes in use.  Reset returns the number of bytes in use at the time.
+uint64_t ResetPeakLiveBytes();
+uint64_t PeakLiveBytes();
+
+// Records the allocations made between construction and Report() and adds them to the
+// benchmark's output as per-iteration "allocs/op" and "bytes/op" counters.
+class AllocationCounter {
+ public:
+  AllocationCounter();
+  void Report(::benchmark::State& state) const;
+
+ private:
+  AllocationCount start_;
+};
+
+}  // namespace benchmarks
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_BENCHMARKS_ALLOCATION_COUNTER_H_
@@ -0,0 +1,161 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+// Runs N concurrent workflows, each a chain of three dependent requests (in the manner of
+// GetVersions, then Get, then PutVersion), against a simulated network which answers each request
+// after kLatency.  The coroutine version awaits each request on a client AsioService of
+// kClientThreads threads; the baseline gives each workflow its own thread blocking on futures.
+// "workflows/s" counts completed workflows.  The simulated network stands in for MaidNodeNfs so
+// that only the cost of waiting is measured.
+
+#include "maidsafe/nfs/client/awaitable.h"
+
+#ifdef MAIDSAFE_NFS_COROUTINES
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "boost/asio/steady_timer.hpp"
+#include "boost/optional/optional.hpp"
+#include "boost/thread/future.hpp"
+
+#include "benchmark/benchmark.h"
+
+#include "maidsafe/common/asio_service.h"
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace benchmarks {
+
+namespace {
+
+const std::chrono::milliseconds kLatency(1);
+const int kClientThreads(4);
+const int kNetworkThreads(2);
+
+class Latch {
+ public:
+  explicit Latch(int count) : mutex_(), cond_var_(), count_(count) {}
+  void CountDown() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--count_ == 0)
+      cond_var_.notify_all();
+  }
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_var_.wait(lock, [this] { return count_ == 0; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cond_var_;
+  int count_;
+};
+
+// Calls 'handler' on 'network' with 'value' after kLatency, as a response would arrive.
+template <typename Handler>
+void SimulatedRequest(boost::asio::io_service& network, int value, Handler handler) {
+  auto timer(std::make_shared<boost::asio::steady_timer>(network, kLatency));
+  timer->async_wait([timer, value, handler](const boost::system::error_code&) mutable {
+    handler(std::error_code(), boost::optional<int>(value));
+  });
+}
+
+auto AwaitRequest(boost::asio::io_service& client, boost::asio::io_service& network, int value) {
+  return nfs_client::MakeAwaitable<int>(client, [&network, value](auto handler) {
+    SimulatedRequest(network, value, std::move(handler));
+  });
+}
+
+boost::future<int> FutureRequest(boost::asio::io_service& network, int value) {
+  auto promise(std::make_shared<boost::promise<int>>());
+  SimulatedRequest(network, value, [promise](std::error_code, boost::optional<int> result) {
+    promise->set_value(*result);
+  });
+  return promise->get_future();
+}
+
+nfs_client::Detached CoroutineWorkflow(boost::asio::io_service& client,
+                                       boost::asio::io_service& network, Latch& latch) {
+  auto versions(co_await AwaitRequest(client, network, 1));
+  auto data(co_await AwaitRequest(client, network, versions + 1));
+  co_await AwaitRequest(client, network, data + 1);
+  latch.CountDown();
+}
+
+void ThreadWorkflow(boost::asio::io_service& network) {
+  auto versions(FutureRequest(network, 1).get());
+  auto data(FutureRequest(network, versions + 1).get());
+  FutureRequest(network, data + 1).get();
+}
+
+// The argument is the number of concurrent workflows.
+void BM_CoroutineWorkflows(::benchmark::State& state) {
+  const int workflows(static_cast<int>(state.range(0)));
+  AsioService client(kClientThreads), network(kNetworkThreads);
+  while (state.KeepRunning()) {
+    Latch latch(workflows);
+    for (int i(0); i != workflows; ++i)
+      client.service().post([&] { CoroutineWorkflow(client.service(), network.service(), latch); });
+    latch.Wait();
+  }
+  state.counters["workflows/s"] = ::benchmark::Counter(
+      static_cast<double>(state.iterations() * workflows), ::benchmark::Counter::kIsRate);
+  state.counters["threads"] = kClientThreads + kNetworkThreads;
+}
+
+void BM_ThreadPerWorkflow(::benchmark::State& state) {
+  const int workflows(static_cast<int>(state.range(0)));
+  AsioService network(kNetworkThreads);
+  while (state.KeepRunning()) {
+    std::vector<std::thread> threads;
+    threads.reserve(workflows);
+    for (int i(0); i != workflows; ++i)
+      threads.emplace_back([&network] { ThreadWorkflow(network.service()); });
+    for (auto& thread : threads)
+      thread.join();
+  }
+  state.counters["workflows/s"] = ::benchmark::Counter(
+      static_cast<double>(state.iterations() * workflows), ::benchmark::Counter::kIsRate);
+  state.counters["threads"] = workflows + kNetworkThreads;
+}
+
+BENCHMARK(BM_CoroutineWorkflows)->RangeMultiplier(10)->Range(100, 100000)
+    ->Unit(::benchmark::kMillisecond)->UseRealTime();
+// Beyond a few thousand threads the baseline hits per-process thread limits rather than measuring
+// anything useful.
+BENCHMARK(BM_ThreadPerWorkflow)->RangeMultiplier(10)->Range(100, 1000)
+    ->Unit(::benchmark::kMillisecond)->UseRealTime();
+
+}  // unnamed namespace
+
+}  // namespace benchmarks
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_COROUTINES
@@ -0,0 +1,63 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+// Cost of generating message ids as the number of threads generating them concurrently grows.
+// detail::GetNewMessageId hands out ids from per-thread blocks, so only one id in every block
+// touches shared state.  The baseline takes every id from a single shared atomic counter, the
+// simplest thread-safe alternative, so each id contends for the same cache line.
+
+#include <atomic>
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+
+#include "maidsafe/nfs/message_wrapper.h"
+#include "maidsafe/nfs/types.h"
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace benchmarks {
+
+namespace {
+
+std::atomic<uint64_t> shared_counter(0);
+
+void BM_GetNewMessageId(::benchmark::State& state) {
+  while (state.KeepRunning())
+    ::benchmark::DoNotOptimize(detail::GetNewMessageId());
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_SharedAtomicCounter(::benchmark::State& state) {
+  while (state.KeepRunning())
+    ::benchmark::DoNotOptimize(MessageId(static_cast<int64_t>(shared_counter.fetch_add(1))));
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_GetNewMessageId)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_SharedAtomicCounter)->ThreadRange(1, 16)->UseRealTime();
+
+}  // unnamed namespace
+
+}  // namespace benchmarks
+
+}  // namespace nfs
+
+}  // namespace maidsafe
@@ -0,0 +1,384 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+// Serialise/parse microbenchmarks for every nfs_client and nfs_vault message type, plus full
+// MessageWrapper round-trips.  Types carrying a blob are run over payload sizes from 0 B to 1 MB
+// (types built on NonEmptyString use 1 B for the 0 B case); types carrying name or version lists
+// are run over list lengths.  Each case reports "allocs/op" and "bytes/op" as well as ns/op.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/data_types/immutable_data.h"
+#include "maidsafe/common/data_types/structured_data_versions.h"
+#include "maidsafe/passport/types.h"
+
+#include "maidsafe/nfs/message_types.h"
+#include "maidsafe/nfs/message_wrapper.h"
+#include "maidsafe/nfs/types.h"
+#include "maidsafe/nfs/benchmarks/allocation_counter.h"
+#include "maidsafe/nfs/client/messages.h"
+#include "maidsafe/nfs/client/structured_data.h"
+#include "maidsafe/nfs/vault/messages.h"
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace benchmarks {
+
+namespace {
+
+typedef StructuredDataVersions::VersionName VersionName;
+
+const int64_t kMaxPayloadSize(1 << 20);
+const int64_t kMaxVersionCount(4096);
+
+// ==================== Argument sets ==============================================================
+void FixedSize(::benchmark::internal::Benchmark* benchmark) { benchmark->Arg(0); }
+
+void PayloadSizes(::benchmark::internal::Benchmark* benchmark) {
+  benchmark->Arg(0);
+  for (int64_t size(64); size < kMaxPayloadSize; size *= 16)
+    benchmark->Arg(size);
+  benchmark->Arg(kMaxPayloadSize);
+}
+
+void VersionCounts(::benchmark::internal::Benchmark* benchmark) {
+  for (int64_t count(1); count <= kMaxVersionCount; count *= 16)
+    benchmark->Arg(count);
+}
+
+// ==================== Building blocks ============================================================
+Identity RandomName() { return Identity(RandomString(crypto::SHA512::DIGESTSIZE)); }
+
+NonEmptyString Payload(int64_t size) {
+  return NonEmptyString(RandomString(static_cast<size_t>(size == 0 ? 1 : size)));
+}
+
+nfs_vault::DataName RandomDataName() {
+  return nfs_vault::DataName(DataTagValue::kImmutableDataValue, RandomName());
+}
+
+VersionName RandomVersionName() {
+  return VersionName(RandomUint32(), ImmutableData::Name(RandomName()));
+}
+
+std::vector<VersionName> RandomVersionNames(int64_t count) {
+  std::vector<VersionName> versions;
+  for (int64_t i(0); i != count; ++i)
+    versions.push_back(RandomVersionName());
+  return versions;
+}
+
+nfs_client::ReturnCode FailureReturnCode() {
+  return nfs_client::ReturnCode(CommonErrors::no_such_element);
+}
+
+// Keys are slow to generate, so are built once and shared by every case needing them.
+const passport::Anmaid& Anmaid() {
+  static const passport::Anmaid anmaid;
+  return anmaid;
+}
+
+const passport::Maid& Maid() {
+  static const passport::Maid maid(Anmaid());
+  return maid;
+}
+
+const passport::Pmid& Pmid() {
+  static const passport::Anpmid anpmid;
+  static const passport::Pmid pmid(anpmid);
+  return pmid;
+}
+
+// ==================== Factories (one overload per message type) ==================================
+nfs_vault::AvailableSize Make(int64_t, nfs_vault::AvailableSize*) {
+  return nfs_vault::AvailableSize(RandomUint32());
+}
+
+nfs_vault::DataName Make(int64_t, nfs_vault::DataName*) { return RandomDataName(); }
+
+nfs_vault::DataNames Make(int64_t count, nfs_vault::DataNames*) {
+  std::vector<nfs_vault::DataName> names;
+  for (int64_t i(0); i != count; ++i)
+    names.push_back(RandomDataName());
+  return nfs_vault::DataNames(names);
+}
+
+nfs_vault::DataNameAndVersion Make(int64_t, nfs_vault::DataNameAndVersion*) {
+  return nfs_vault::DataNameAndVersion(RandomDataName(), RandomVersionName());
+}
+
+nfs_vault::DataNameOldNewVersion Make(int64_t, nfs_vault::DataNameOldNewVersion*) {
+  return nfs_vault::DataNameOldNewVersion(RandomDataName(), RandomVersionName(),
+                                          RandomVersionName());
+}
+
+nfs_vault::VersionTreeCreation Make(int64_t, nfs_vault::VersionTreeCreation*) {
+  return nfs_vault::VersionTreeCreation(RandomDataName(), RandomVersionName(), 100, 10);
+}
+
+nfs_vault::DataNameAndContent Make(int64_t size, nfs_vault::DataNameAndContent*) {
+  return nfs_vault::DataNameAndContent(DataTagValue::kImmutableDataValue, RandomName(),
+                                       Payload(size));
+}
+
+nfs_vault::Content Make(int64_t size, nfs_vault::Content*) {
+  return nfs_vault::Content(RandomString(static_cast<size_t>(size)));
+}
+
+nfs_vault::DataNameAndRandomString Make(int64_t size, nfs_vault::DataNameAndRandomString*) {
+  return nfs_vault::DataNameAndRandomString(DataTagValue::kImmutableDataValue, RandomName(),
+                                            Payload(size));
+}
+
+nfs_vault::DataNameAndCost Make(int64_t, nfs_vault::DataNameAndCost*) {
+  return nfs_vault::DataNameAndCost(DataTagValue::kImmutableDataValue, RandomName(),
+                                    static_cast<int32_t>(RandomUint32() % 1000));
+}
+
+nfs_vault::DataNameAndSize Make(int64_t, nfs_vault::DataNameAndSize*) {
+  return nfs_vault::DataNameAndSize(DataTagValue::kImmutableDataValue, RandomName(),
+                                    static_cast<int32_t>(RandomUint32() % 1000));
+}
+
+nfs_vault::DataAndPmidHint Make(int64_t size, nfs_vault::DataAndPmidHint*) {
+  return nfs_vault::DataAndPmidHint(RandomDataName(), Payload(size), RandomName());
+}
+
+nfs_vault::DataNameAndContentOrCheckResult Make(int64_t size,
+                                                nfs_vault::DataNameAndContentOrCheckResult*) {
+  return nfs_vault::DataNameAndContentOrCheckResult(DataTagValue::kImmutableDataValue,
+                                                    RandomName(), Payload(size));
+}
+
+nfs_vault::PmidHealth Make(int64_t size, nfs_vault::PmidHealth*) {
+  nfs_vault::PmidHealth pmid_health;
+  pmid_health.serialised_pmid_health = RandomString(static_cast<size_t>(size));
+  return pmid_health;
+}
+
+nfs_vault::PmidRegistration Make(int64_t, nfs_vault::PmidRegistration*) {
+  return nfs_vault::PmidRegistration(Maid(), Pmid(), false);
+}
+
+nfs_vault::AccountCreation Make(int64_t, nfs_vault::AccountCreation*) {
+  return nfs_vault::AccountCreation(passport::PublicMaid(Maid()),
+                                    passport::PublicAnmaid(Anmaid()));
+}
+
+nfs_vault::AccountRemoval Make(int64_t, nfs_vault::AccountRemoval*) {
+  return nfs_vault::AccountRemoval(Anmaid());
+}
+
+nfs_client::ReturnCode Make(int64_t, nfs_client::ReturnCode*) { return FailureReturnCode(); }
+
+nfs_client::AvailableSizeAndReturnCode Make(int64_t, nfs_client::AvailableSizeAndReturnCode*) {
+  return nfs_client::AvailableSizeAndReturnCode(RandomUint32(), nfs_client::ReturnCode());
+}
+
+nfs_client::DataNameAndReturnCode Make(int64_t, nfs_client::DataNameAndReturnCode*) {
+  return nfs_client::DataNameAndReturnCode(RandomDataName(), FailureReturnCode());
+}
+
+nfs_client::DataNamesAndReturnCode Make(int64_t count, nfs_client::DataNamesAndReturnCode*) {
+  std::vector<nfs_vault::DataName> names;
+  for (int64_t i(0); i != count; ++i)
+    names.push_back(RandomDataName());
+  return nfs_client::DataNamesAndReturnCode(names, FailureReturnCode());
+}
+
+nfs_client::DataNameVersionAndReturnCode Make(int64_t,
+                                              nfs_client::DataNameVersionAndReturnCode*) {
+  nfs_client::DataNameVersionAndReturnCode message;
+  message.data_name_and_version = Make(0, static_cast<nfs_vault::DataNameAndVersion*>(nullptr));
+  message.return_code = FailureReturnCode();
+  return message;
+}
+
+nfs_client::DataNameOldNewVersionAndReturnCode Make(
+    int64_t, nfs_client::DataNameOldNewVersionAndReturnCode*) {
+  nfs_client::DataNameOldNewVersionAndReturnCode message;
+  message.data_name_old_new_version =
+      Make(0, static_cast<nfs_vault::DataNameOldNewVersion*>(nullptr));
+  message.return_code = FailureReturnCode();
+  return message;
+}
+
+nfs_client::DataAndReturnCode Make(int64_t size, nfs_client::DataAndReturnCode*) {
+  nfs_client::DataAndReturnCode message;
+  message.data = Make(size, static_cast<nfs_vault::DataNameAndContent*>(nullptr));
+  message.return_code = FailureReturnCode();
+  return message;
+}
+
+nfs_client::DataNameAndContentOrReturnCode Make(int64_t size,
+                                                nfs_client::DataNameAndContentOrReturnCode*) {
+  return nfs_client::DataNameAndContentOrReturnCode(ImmutableData(Payload(size)));
+}
+
+nfs_client::StructuredData Make(int64_t count, nfs_client::StructuredData*) {
+  return nfs_client::StructuredData(RandomVersionNames(count));
+}
+
+nfs_client::StructuredDataNameAndContentOrReturnCode Make(
+    int64_t count, nfs_client::StructuredDataNameAndContentOrReturnCode*) {
+  nfs_client::StructuredDataNameAndContentOrReturnCode message;
+  message.structured_data = nfs_client::StructuredData(RandomVersionNames(count));
+  return message;
+}
+
+nfs_client::TipOfTreeAndReturnCode Make(int64_t, nfs_client::TipOfTreeAndReturnCode*) {
+  nfs_client::TipOfTreeAndReturnCode message;
+  message.tip_of_tree = RandomVersionName();
+  return message;
+}
+
+nfs_client::DataPmidHintAndReturnCode Make(int64_t size,
+                                           nfs_client::DataPmidHintAndReturnCode*) {
+  nfs_client::DataPmidHintAndReturnCode message;
+  message.data_and_pmid_hint = Make(size, static_cast<nfs_vault::DataAndPmidHint*>(nullptr));
+  message.return_code = FailureReturnCode();
+  return message;
+}
+
+nfs_client::PmidRegistrationAndReturnCode Make(int64_t,
+                                               nfs_client::PmidRegistrationAndReturnCode*) {
+  return nfs_client::PmidRegistrationAndReturnCode(
+      Make(0, static_cast<nfs_vault::PmidRegistration*>(nullptr)), FailureReturnCode());
+}
+
+nfs_client::DataNameAndSpaceAndReturnCode Make(int64_t,
+                                               nfs_client::DataNameAndSpaceAndReturnCode*) {
+  return nfs_client::DataNameAndSpaceAndReturnCode(DataTagValue::kImmutableDataValue,
+                                                   RandomName(), RandomUint32(),
+                                                   FailureReturnCode());
+}
+
+nfs_client::PmidHealthAndReturnCode Make(int64_t size, nfs_client::PmidHealthAndReturnCode*) {
+  return nfs_client::PmidHealthAndReturnCode(
+      Make(size, static_cast<nfs_vault::PmidHealth*>(nullptr)), nfs_client::ReturnCode());
+}
+
+// ==================== Benchmarks =================================================================
+template <typename Message>
+void BM_Serialise(::benchmark::State& state) {
+  const auto message(Make(state.range(0), static_cast<Message*>(nullptr)));
+  std::string serialised;
+  AllocationCounter allocation_counter;
+  while (state.KeepRunning()) {
+    serialised = message.Serialise();
+    ::benchmark::DoNotOptimize(serialised.data());
+  }
+  allocation_counter.Report(state);
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(serialised.size()));
+}
+
+template <typename Message>
+void BM_Parse(::benchmark::State& state) {
+  const auto serialised(Make(state.range(0), static_cast<Message*>(nullptr)).Serialise());
+  AllocationCounter allocation_counter;
+  while (state.KeepRunning()) {
+    Message parsed(serialised);
+    ::benchmark::DoNotOptimize(&parsed);
+  }
+  allocation_counter.Report(state);
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(serialised.size()));
+}
+
+// Serialise, ParseMessageWrapper, construction of the typed wrapper and decoding of its (lazily
+// parsed) contents, as done for every message sent and handled.
+template <typename Wrapper>
+void BM_MessageWrapperRoundTrip(::benchmark::State& state) {
+  const Wrapper message(MessageId(RandomInt32()),
+                        Make(state.range(0), static_cast<typename Wrapper::Contents*>(nullptr)));
+  int64_t serialised_size(0);
+  AllocationCounter allocation_counter;
+  while (state.KeepRunning()) {
+    auto serialised(message.Serialise());
+    serialised_size = static_cast<int64_t>(serialised.size());
+    Wrapper parsed(ParseMessageWrapper(serialised));
+    ::benchmark::DoNotOptimize(&*parsed.contents);
+  }
+  allocation_counter.Report(state);
+  state.SetBytesProcessed(state.iterations() * serialised_size);
+}
+
+#define NFS_MESSAGE_BENCHMARKS(Message, Arguments)                \
+  BENCHMARK_TEMPLATE(BM_Serialise, Message)->Apply(Arguments);   \
+  BENCHMARK_TEMPLATE(BM_Parse, Message)->Apply(Arguments)
+
+NFS_MESSAGE_BENCHMARKS(nfs_vault::AvailableSize, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_vault::DataName, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_vault::DataNames, VersionCounts);
+NFS_MESSAGE_BENCHMARKS(nfs_vault::DataNameAndVersion, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_vault::DataNameOldNewVersion, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_vault::VersionTreeCreation, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_vault::DataNameAndContent, PayloadSizes);
+NFS_MESSAGE_BENCHMARKS(nfs_vault::Content, PayloadSizes);
+NFS_MESSAGE_BENCHMARKS(nfs_vault::DataNameAndRandomString, PayloadSizes);
+NFS_MESSAGE_BENCHMARKS(nfs_vault::DataNameAndCost, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_vault::DataNameAndSize, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_vault::DataAndPmidHint, PayloadSizes);
+NFS_MESSAGE_BENCHMARKS(nfs_vault::DataNameAndContentOrCheckResult, PayloadSizes);
+NFS_MESSAGE_BENCHMARKS(nfs_vault::PmidHealth, PayloadSizes);
+NFS_MESSAGE_BENCHMARKS(nfs_vault::PmidRegistration, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_vault::AccountCreation, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_vault::AccountRemoval, FixedSize);
+
+NFS_MESSAGE_BENCHMARKS(nfs_client::ReturnCode, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_client::AvailableSizeAndReturnCode, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_client::DataNameAndReturnCode, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_client::DataNamesAndReturnCode, VersionCounts);
+NFS_MESSAGE_BENCHMARKS(nfs_client::DataNameVersionAndReturnCode, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_client::DataNameOldNewVersionAndReturnCode, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_client::DataAndReturnCode, PayloadSizes);
+NFS_MESSAGE_BENCHMARKS(nfs_client::DataNameAndContentOrReturnCode, PayloadSizes);
+NFS_MESSAGE_BENCHMARKS(nfs_client::StructuredData, VersionCounts);
+NFS_MESSAGE_BENCHMARKS(nfs_client::StructuredDataNameAndContentOrReturnCode, VersionCounts);
+NFS_MESSAGE_BENCHMARKS(nfs_client::TipOfTreeAndReturnCode, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_client::DataPmidHintAndReturnCode, PayloadSizes);
+NFS_MESSAGE_BENCHMARKS(nfs_client::PmidRegistrationAndReturnCode, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_client::DataNameAndSpaceAndReturnCode, FixedSize);
+NFS_MESSAGE_BENCHMARKS(nfs_client::PmidHealthAndReturnCode, PayloadSizes);
+
+#undef NFS_MESSAGE_BENCHMARKS
+
+BENCHMARK_TEMPLATE(BM_MessageWrapperRoundTrip, PutRequestFromMaidNodeToMaidManager)
+    ->Apply(PayloadSizes);
+BENCHMARK_TEMPLATE(BM_MessageWrapperRoundTrip, GetRequestFromMaidNodeToDataManager)
+    ->Apply(FixedSize);
+BENCHMARK_TEMPLATE(BM_MessageWrapperRoundTrip, GetResponseFromDataManagerToMaidNode)
+    ->Apply(PayloadSizes);
+BENCHMARK_TEMPLATE(BM_MessageWrapperRoundTrip, GetVersionsResponseFromVersionHandlerToMaidNode)
+    ->Apply(VersionCounts);
+
+}  // unnamed namespace
+
+}  // namespace benchmarks
+
+}  // namespace nfs
+
+}  // namespace maidsafe
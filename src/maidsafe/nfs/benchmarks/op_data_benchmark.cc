@@ -0,0 +1,125 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+// Compares nfs::OpData, which tallies responses as they arrive, with the previous approach of
+// storing every response and re-evaluating the whole set on each arrival.  Each iteration feeds a
+// group's worth of 1 MB Get responses through a fresh instance.  "peak_bytes" is the most heap in
+// use at once over and above that held before the iteration started.
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/data_types/immutable_data.h"
+#include "maidsafe/routing/parameters.h"
+
+#include "maidsafe/nfs/utils.h"
+#include "maidsafe/nfs/benchmarks/allocation_counter.h"
+#include "maidsafe/nfs/client/messages.h"
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace benchmarks {
+
+namespace {
+
+typedef nfs_client::DataNameAndContentOrReturnCode GetResponse;
+
+// The previous OpData implementation, kept here as the baseline.
+template <typename MessageContents>
+class StoreAllOpData {
+ public:
+  StoreAllOpData(int successes_required, std::function<void(MessageContents)> callback)
+      : mutex_(),
+        successes_required_(successes_required),
+        callback_(callback),
+        responses_(),
+        callback_executed_(false) {}
+
+  void HandleResponseContents(MessageContents&& response_contents) {
+    std::unique_ptr<MessageContents> result_ptr;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (callback_executed_)
+        return;
+      responses_.push_back(std::move(response_contents));
+      auto result(GetSuccessOrMostFrequentResponse(responses_, successes_required_));
+      if (!result.second && responses_.size() <= (routing::Parameters::group_size / 2U))
+        return;
+      callback_executed_ = true;
+      auto index(std::distance(responses_.cbegin(), result.first));
+      result_ptr.reset(new MessageContents(std::move(responses_[index])));
+    }
+    callback_(std::move(*result_ptr));
+  }
+
+ private:
+  std::mutex mutex_;
+  int successes_required_;
+  std::function<void(MessageContents)> callback_;
+  std::vector<MessageContents> responses_;
+  bool callback_executed_;
+};
+
+// The argument is the number of successes required.
+template <typename OpDataType>
+void BM_GroupOfGetResponses(::benchmark::State& state) {
+  const int successes_required(static_cast<int>(state.range(0)));
+  const int response_count(static_cast<int>(routing::Parameters::group_size));
+  const GetResponse response((ImmutableData(NonEmptyString(RandomString(1 << 20)))));
+  uint64_t peak_bytes(0);
+  int call_count(0);
+  AllocationCounter allocation_counter;
+  while (state.KeepRunning()) {
+    auto baseline(ResetPeakLiveBytes());
+    OpDataType op_data(successes_required, [&call_count](GetResponse) { ++call_count; });
+    for (int i(0); i != response_count; ++i)
+      op_data.HandleResponseContents(GetResponse(response));
+    // The op data lives on until the task awaiting these responses is removed.
+    peak_bytes = std::max(peak_bytes, PeakLiveBytes() - baseline);
+  }
+  allocation_counter.Report(state);
+  state.counters["peak_bytes"] = static_cast<double>(peak_bytes);
+  if (call_count != static_cast<int>(state.iterations()))
+    state.SkipWithError("Callback not invoked exactly once per operation.");
+}
+
+void SuccessesRequired(::benchmark::internal::Benchmark* benchmark) {
+  benchmark->Arg(1);
+  benchmark->Arg(static_cast<int64_t>(routing::Parameters::group_size) - 1);
+}
+
+BENCHMARK_TEMPLATE(BM_GroupOfGetResponses, OpData<GetResponse>)->Apply(SuccessesRequired);
+BENCHMARK_TEMPLATE(BM_GroupOfGetResponses, StoreAllOpData<GetResponse>)->Apply(SuccessesRequired);
+
+}  // unnamed namespace
+
+}  // namespace benchmarks
+
+}  // namespace nfs
+
+}  // namespace maidsafe
@@ -0,0 +1,165 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/cancellation_token.h"
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include "boost/exception/diagnostic_information.hpp"
+
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+maidsafe_error CancelledError() {
+  return maidsafe_error(std::make_error_code(std::errc::operation_canceled));
+}
+
+struct CancellationToken::State {
+  State()
+      : mutex(),
+        cond_var(),
+        functors(),
+        next_id(0),
+        running_id(0),
+        running_thread(),
+        cancelled(false) {}
+
+  std::mutex mutex;
+  std::condition_variable cond_var;
+  std::map<uint64_t, std::function<void()>> functors;
+  uint64_t next_id, running_id;
+  std::thread::id running_thread;
+  bool cancelled;
+};
+
+CancellationToken::CancellationToken() : state_() {}
+
+CancellationToken::CancellationToken(std::shared_ptr<State> state) : state_(std::move(state)) {}
+
+CancellationToken CancellationToken::Create() {
+  return CancellationToken(std::make_shared<State>());
+}
+
+void CancellationToken::Cancel() {
+  if (!state_)
+    return;
+  std::unique_lock<std::mutex> lock(state_->mutex);
+  if (state_->cancelled)
+    return;
+  state_->cancelled = true;
+  while (!state_->functors.empty()) {
+    auto first(std::begin(state_->functors));
+    auto functor(std::move(first->second));
+    state_->running_id = first->first;
+    state_->running_thread = std::this_thread::get_id();
+    state_->functors.erase(first);
+    lock.unlock();
+    try {
+      functor();
+    }
+    catch (const std::exception& e) {
+      LOG(kError) << "Cancellation functor threw: " << boost::diagnostic_information(e);
+    }
+    lock.lock();
+    state_->running_id = 0;
+    state_->cond_var.notify_all();
+  }
+}
+
+bool CancellationToken::cancelled() const {
+  if (!state_)
+    return false;
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->cancelled;
+}
+
+bool CancellationToken::cancellable() const { return static_cast<bool>(state_); }
+
+uint64_t CancellationToken::Register(std::function<void()> functor) const {
+  if (!state_)
+    return 0;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (!state_->cancelled) {
+      auto id(++state_->next_id);
+      state_->functors.insert(std::make_pair(id, std::move(functor)));
+      return id;
+    }
+  }
+  functor();
+  return 0;
+}
+
+void CancellationToken::Deregister(uint64_t id) const {
+  if (!state_ || id == 0)
+    return;
+  std::unique_lock<std::mutex> lock(state_->mutex);
+  if (state_->functors.erase(id) != 0 ||
+      state_->running_thread == std::this_thread::get_id()) {
+    return;
+  }
+  state_->cond_var.wait(lock, [this, id] { return state_->running_id != id; });
+}
+
+CancellableOperation::CancellableOperation(CancellationToken token)
+    : finished_(false), cancelled_(false), token_(std::move(token)), registration_(0),
+      on_cancel_() {}
+
+CancellableOperation::~CancellableOperation() { token_.Deregister(registration_); }
+
+bool CancellableOperation::Arm(std::function<void()> on_cancel) {
+  on_cancel_ = std::move(on_cancel);
+  std::weak_ptr<CancellableOperation> weak_operation(shared_from_this());
+  registration_ = token_.Register([weak_operation] {
+    if (auto operation = weak_operation.lock())
+      operation->Cancel();
+  });
+  // The operation may have completed while registering, in which case the functor isn't needed.
+  if (finished_ && !cancelled_)
+    token_.Deregister(registration_);
+  return !cancelled_;
+}
+
+bool CancellableOperation::Complete() {
+  bool completed(!finished_.exchange(true));
+  token_.Deregister(registration_);
+  return completed;
+}
+
+void CancellableOperation::Cancel() {
+  if (finished_.exchange(true))
+    return;
+  cancelled_ = true;
+  on_cancel_();
+}
+
+std::shared_ptr<CancellableOperation> MakeCancellableOperation(const CancellationToken& token) {
+  return token.cancellable() ? std::make_shared<CancellableOperation>(token) : nullptr;
+}
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
@@ -22,17 +22,52 @@ namespace maidsafe {
 
 namespace nfs_client {
 
+std::error_code HandlerError(const ReturnCode& result) {
+  return nfs::IsSuccess(result) ? std::error_code() : result.value;
+}
+
+PutCompletionHandler PutPromiseHandler(std::shared_ptr<boost::promise<void>> promise) {
+  return [promise](std::error_code error) {
+    if (error)
+      promise->set_exception(maidsafe_error(error));
+    else
+      promise->set_value();
+  };
+}
+
+VersionNamesCompletionHandler VersionNamesPromiseHandler(
+    std::shared_ptr<boost::promise<std::vector<StructuredDataVersions::VersionName>>> promise) {
+  return [promise](std::error_code error,
+                   std::vector<StructuredDataVersions::VersionName> versions) {
+    if (error)
+      promise->set_exception(maidsafe_error(error));
+    else
+      promise->set_value(std::move(versions));
+  };
+}
+
+PutVersionCompletionHandler PutVersionPromiseHandler(
+    std::shared_ptr<boost::promise<std::unique_ptr<StructuredDataVersions::VersionName>>> promise) {
+  return [promise](std::error_code error,
+                   std::unique_ptr<StructuredDataVersions::VersionName> tip_of_tree) {
+    if (error)
+      promise->set_exception(maidsafe_error(error));
+    else
+      promise->set_value(std::move(tip_of_tree));
+  };
+}
+
 void HandleGetVersionsOrBranchResult(
-    const StructuredDataNameAndContentOrReturnCode& result,
+    StructuredDataNameAndContentOrReturnCode result,
     std::shared_ptr<boost::promise<std::vector<StructuredDataVersions::VersionName>>> promise) {
   LOG(kVerbose) << "nfs_client::HandleGetVersionsOrBranchResult";
   try {
     if (result.structured_data) {
-      promise->set_value(result.structured_data->versions);
+      promise->set_value(std::move(result.structured_data->versions));
     } else if (result.data_name_and_return_code) {
       LOG(kInfo) << "nfs_client::HandleGetVersionsOrBranchResult"
                  << " error during get version or branch";
-      boost::throw_exception(result.data_name_and_return_code->return_code.value);
+      boost::throw_exception(result.data_name_and_return_code->return_code.error());
     } else {
       LOG(kInfo) << "nfs_client::HandleGetVersionsOrBranchResult"
                  << " uninitialised during get version or branch";
@@ -46,6 +81,21 @@ void HandleGetVersionsOrBranchResult(
   }
 }
 
+void CompleteGetVersionsOrBranch(StructuredDataNameAndContentOrReturnCode result,
+                                 const VersionNamesCompletionHandler& handler) {
+  LOG(kVerbose) << "nfs_client::CompleteGetVersionsOrBranch";
+  if (result.structured_data)
+    return handler(std::error_code(), std::move(result.structured_data->versions));
+  std::error_code error(make_error_code(CommonErrors::uninitialised));
+  if (result.data_name_and_return_code &&
+      !nfs::IsSuccess(result.data_name_and_return_code->return_code)) {
+    error = result.data_name_and_return_code->return_code.value;
+  }
+  LOG(kInfo) << "nfs_client::CompleteGetVersionsOrBranch error during get version or branch: "
+             << error.message();
+  handler(error, std::vector<StructuredDataVersions::VersionName>());
+}
+
 void HandleCreateAccountResult(const ReturnCode& result,
                                std::shared_ptr<boost::promise<void>> promise) {
   LOG(kVerbose) << "nfs_client::HandleCreateAccountResult";
@@ -55,7 +105,7 @@ void HandleCreateAccountResult(const ReturnCode& result,
       promise->set_value();
     } else {
       LOG(kWarning) << "nfs_client::HandleCreateAccountResult error during create account";
-      boost::throw_exception(result.value);
+      boost::throw_exception(result.error());
     }
   }
   catch (...) {
@@ -73,7 +123,7 @@ void HandlePutResponseResult(const ReturnCode& result,
       promise->set_value();
     } else {
       LOG(kWarning) << "nfs_client::HandlePutResponseResult error in Put";
-      boost::throw_exception(result.value);
+      boost::throw_exception(result.error());
     }
   }
   catch (...) {
@@ -92,7 +142,7 @@ void HandlePmidHealthResult(const AvailableSizeAndReturnCode& result,
       promise->set_value(result.available_size.available_size);
     } else {
       LOG(kWarning) << "nfs_client::HandlePmidHealthResult error during getPmidHealth";
-      boost::throw_exception(result.return_code.value);
+      boost::throw_exception(result.return_code.error());
     }
   }
   catch (...) {
@@ -110,7 +160,7 @@ void HandleCreateVersionTreeResult(const ReturnCode& result,
       promise->set_value();
     } else {
       LOG(kWarning) << "nfs_client::HandleCreateVersionTreeResult error during version creation";
-      boost::throw_exception(result.value);
+      boost::throw_exception(result.error());
     }
   }
   catch (...) {
@@ -132,7 +182,7 @@ void HandlePutVersionResult(
       promise->set_value(std::move(tip_of_tree));
     } else {
       LOG(kWarning) << "nfs_client::HandlePutVersionResult error during put version";
-      boost::throw_exception(result.return_code.value);
+      boost::throw_exception(result.return_code.error());
     }
   }
   catch (...) {
@@ -141,6 +191,20 @@ void HandlePutVersionResult(
   }
 }
 
+void CompletePutVersion(const TipOfTreeAndReturnCode& result,
+                        const PutVersionCompletionHandler& handler) {
+  LOG(kVerbose) << "nfs_client::CompletePutVersion";
+  std::unique_ptr<StructuredDataVersions::VersionName> tip_of_tree;
+  if (!nfs::IsSuccess(result.return_code)) {
+    LOG(kWarning) << "nfs_client::CompletePutVersion error during put version";
+    return handler(result.return_code.value, std::move(tip_of_tree));
+  }
+  LOG(kInfo) << "Put Version succeeded";
+  if (result.tip_of_tree)
+    tip_of_tree.reset(new StructuredDataVersions::VersionName(*result.tip_of_tree));
+  handler(std::error_code(), std::move(tip_of_tree));
+}
+
 void HandleRegisterPmidResult(const ReturnCode& result,
                               std::shared_ptr<boost::promise<void>> promise) {
   LOG(kVerbose) << "nfs_client::HandleRegisterPmidResult";
@@ -150,7 +214,7 @@ void HandleRegisterPmidResult(const ReturnCode& result,
       promise->set_value();
     } else {
       LOG(kWarning) << "nfs_client::HandleRegisterPmidResult error during pmid registration";
-      boost::throw_exception(result.value);
+      boost::throw_exception(result.error());
     }
   }
   catch (...) {
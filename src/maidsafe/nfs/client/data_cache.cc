@@ -0,0 +1,259 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/data_cache.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace {
+
+// Shards are only added while each can still hold several maximum-sized chunks.
+const uint64_t kMinShardBytes(4 * 1024 * 1024);
+const uint64_t kProtectedPercentage(80);
+
+typedef std::pair<DataTagValue, Identity> Key;
+
+struct KeyHash {
+  size_t operator()(const Key& key) const {
+    return std::hash<std::string>()(key.second.string()) ^ static_cast<size_t>(key.first);
+  }
+};
+
+size_t ShardCount(uint64_t max_bytes) {
+  uint64_t thread_count(std::max(1U, std::thread::hardware_concurrency()));
+  return static_cast<size_t>(
+      std::max<uint64_t>(1, std::min(thread_count, max_bytes / kMinShardBytes)));
+}
+
+}  // unnamed namespace
+
+DataCacheParameters::DataCacheParameters()
+    : max_bytes(0),
+      disk_path(),
+      max_disk_bytes(0),
+      negative_time_to_lives(),
+      max_version_lists(0) {}
+
+DataCacheParameters::DataCacheParameters(uint64_t max_bytes_in)
+    : max_bytes(max_bytes_in),
+      disk_path(),
+      max_disk_bytes(0),
+      negative_time_to_lives(),
+      max_version_lists(0) {}
+
+DataCacheParameters::DataCacheParameters(uint64_t max_bytes_in,
+                                         boost::filesystem::path disk_path_in,
+                                         uint64_t max_disk_bytes_in)
+    : max_bytes(max_bytes_in),
+      disk_path(std::move(disk_path_in)),
+      max_disk_bytes(max_disk_bytes_in),
+      negative_time_to_lives(),
+      max_version_lists(0) {}
+
+DataCacheStats::DataCacheStats()
+    : hits(0),
+      disk_hits(0),
+      misses(0),
+      insertions(0),
+      evictions(0),
+      entries(0),
+      bytes(0),
+      disk() {}
+
+struct DataCache::Shard {
+  struct Entry {
+    Key key;
+    std::shared_ptr<const std::string> content;
+  };
+  typedef std::list<Entry> Segment;
+  struct Location {
+    bool in_protected;
+    Segment::iterator entry;
+  };
+
+  explicit Shard(uint64_t max_bytes_in)
+      : max_bytes(max_bytes_in),
+        max_protected_bytes(max_bytes_in * kProtectedPercentage / 100),
+        mutex(),
+        probation(),
+        protected_segment(),
+        index(),
+        probation_bytes(0),
+        protected_bytes(0) {}
+
+  // Must be called with 'mutex' locked.  Moves the entry to the front of the protected segment,
+  // demoting the least recently used protected entries to the probationary segment to make room.
+  void Promote(Location& location) {
+    if (location.in_protected) {
+      protected_segment.splice(std::begin(protected_segment), protected_segment, location.entry);
+      return;
+    }
+    auto size(location.entry->content->size());
+    protected_segment.splice(std::begin(protected_segment), probation, location.entry);
+    location.in_protected = true;
+    probation_bytes -= size;
+    protected_bytes += size;
+    while (protected_bytes > max_protected_bytes && !protected_segment.empty()) {
+      auto demoted(std::prev(std::end(protected_segment)));
+      auto demoted_size(demoted->content->size());
+      index.find(demoted->key)->second.in_protected = false;
+      probation.splice(std::begin(probation), protected_segment, demoted);
+      protected_bytes -= demoted_size;
+      probation_bytes += demoted_size;
+    }
+  }
+
+  // Must be called with 'mutex' locked.  Evicts from the back of the probationary segment (never
+  // the entry just added at its front) and only then from the protected one.  Returns the number
+  // of entries evicted.
+  uint64_t Evict() {
+    uint64_t evicted(0);
+    while (probation_bytes + protected_bytes > max_bytes) {
+      bool from_probation(probation.size() > 1 || protected_segment.empty());
+      auto& segment(from_probation ? probation : protected_segment);
+      auto& segment_bytes(from_probation ? probation_bytes : protected_bytes);
+      auto victim(std::prev(std::end(segment)));
+      segment_bytes -= victim->content->size();
+      index.erase(victim->key);
+      segment.erase(victim);
+      ++evicted;
+    }
+    return evicted;
+  }
+
+  const uint64_t max_bytes, max_protected_bytes;
+  std::mutex mutex;
+  Segment probation, protected_segment;
+  std::unordered_map<Key, Location, KeyHash> index;
+  uint64_t probation_bytes, protected_bytes;
+};
+
+DataCache::DataCache(const DataCacheParameters& parameters)
+    : shards_(),
+      disk_cache_(),
+      hits_(0),
+      disk_hits_(0),
+      misses_(0),
+      insertions_(0),
+      evictions_(0) {
+  if (parameters.max_bytes != 0) {
+    auto shard_count(ShardCount(parameters.max_bytes));
+    for (size_t i(0); i != shard_count; ++i)
+      shards_.push_back(std::make_shared<Shard>(parameters.max_bytes / shard_count));
+  }
+  if (!parameters.disk_path.empty() && parameters.max_disk_bytes != 0)
+    disk_cache_.reset(new DiskCache(parameters.disk_path, parameters.max_disk_bytes));
+}
+
+DataCache::Shard& DataCache::GetShard(DataTagValue type, const Identity& name) const {
+  return *shards_[KeyHash()(Key(type, name)) % shards_.size()];
+}
+
+std::shared_ptr<const std::string> DataCache::Get(DataTagValue type, const Identity& name) {
+  if (!enabled())
+    return nullptr;
+  std::shared_ptr<const std::string> content;
+  if (!shards_.empty()) {
+    auto& shard(GetShard(type, name));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found(shard.index.find(Key(type, name)));
+    if (found != std::end(shard.index)) {
+      content = found->second.entry->content;
+      shard.Promote(found->second);
+    }
+  }
+  if (content) {
+    ++hits_;
+    return content;
+  }
+  if (disk_cache_ && type == DataTagValue::kImmutableDataValue) {
+    content = disk_cache_->Get(name);
+    if (content) {
+      ++disk_hits_;
+      PutInMemory(type, name, content);
+      return content;
+    }
+  }
+  ++misses_;
+  return nullptr;
+}
+
+void DataCache::Put(DataTagValue type, const Identity& name, std::string content) {
+  if (!enabled())
+    return;
+  auto cached(std::make_shared<const std::string>(std::move(content)));
+  if (disk_cache_ && type == DataTagValue::kImmutableDataValue)
+    disk_cache_->Put(name, cached);
+  PutInMemory(type, name, std::move(cached));
+}
+
+void DataCache::PutInMemory(DataTagValue type, const Identity& name,
+                            std::shared_ptr<const std::string> content) {
+  if (shards_.empty())
+    return;
+  auto& shard(GetShard(type, name));
+  auto size(content->size());
+  if (size > shard.max_bytes)
+    return;
+  Key key(type, name);
+  uint64_t evicted(0);
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // Contents never change, so an existing entry is left as it is.
+    if (shard.index.find(key) != std::end(shard.index))
+      return;
+    shard.probation.push_front(Shard::Entry{key, std::move(content)});
+    shard.index.insert(std::make_pair(key, Shard::Location{false, std::begin(shard.probation)}));
+    shard.probation_bytes += size;
+    evicted = shard.Evict();
+  }
+  ++insertions_;
+  evictions_ += evicted;
+}
+
+DataCacheStats DataCache::stats() const {
+  DataCacheStats result;
+  result.hits = hits_;
+  result.disk_hits = disk_hits_;
+  result.misses = misses_;
+  result.insertions = insertions_;
+  result.evictions = evictions_;
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    result.entries += shard->index.size();
+    result.bytes += shard->probation_bytes + shard->protected_bytes;
+  }
+  if (disk_cache_)
+    result.disk = disk_cache_->stats();
+  return result;
+}
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
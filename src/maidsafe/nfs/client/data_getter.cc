@@ -18,6 +18,8 @@
 
 #include "maidsafe/nfs/client/data_getter.h"
 
+#include <algorithm>
+
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/log.h"
 
@@ -25,8 +27,30 @@ namespace maidsafe {
 
 namespace nfs_client {
 
-DataGetter::DataGetter(AsioService& asio_service, routing::Routing& routing)
-    : get_timer_(asio_service),
+namespace {
+
+class SendGetRequestVisitor : public boost::static_visitor<> {
+ public:
+  SendGetRequestVisitor(DataGetterDispatcher& dispatcher, nfs::TaskId task_id)
+      : dispatcher_(dispatcher), kTaskId_(task_id) {}
+
+  template <typename Name>
+  void operator()(const Name& data_name) {
+    dispatcher_.SendGetRequest(kTaskId_, data_name);
+  }
+
+ private:
+  DataGetterDispatcher& dispatcher_;
+  const nfs::TaskId kTaskId_;
+};
+
+}  // unnamed namespace
+
+DataGetter::DataGetter(AsioService& asio_service, routing::Routing& routing,
+                       const DataCacheParameters& data_cache_parameters)
+    : io_service_(asio_service.service()),
+      latency_estimator_(),
+      get_timer_(asio_service),
       get_versions_timer_(asio_service),
       get_branch_timer_(asio_service),
       dispatcher_(routing),
@@ -35,7 +59,48 @@ DataGetter::DataGetter(AsioService& asio_service, routing::Routing& routing)
                  new DataGetterService(routing, get_timer_, get_versions_timer_,
                                        get_branch_timer_));
                  return std::move(service);
-               }()) {
+               }()),
+      data_cache_(data_cache_parameters),
+      get_coalescer_(asio_service, [this](const DataNameVariant& data_name,
+                                          const std::chrono::steady_clock::duration& timeout,
+                                          GetCoalescer::ResultFunctor result_functor)
+                                          -> GetCoalescer::CancelFunctor {
+                                     SendGetRequest(data_name, timeout, std::move(result_functor));
+                                     // Requests sent via routing::Timer can't be cancelled.
+                                     return nullptr;
+                                   }) {}
+
+void DataGetter::SendGetRequest(const DataNameVariant& data_name,
+                                const std::chrono::steady_clock::duration& timeout,
+                                GetCoalescer::ResultFunctor result_functor) {
+  typedef DataGetterService::GetResponse::Contents ResponseContents;
+  auto op_data(std::make_shared<nfs::OpData<ResponseContents>>(1, result_functor));
+  auto task_id(get_timer_.NewTaskId());
+  // The coalescer resends the request if this attempt times out while the Get has time left.
+  auto attempt_timeout(
+      std::min(timeout, latency_estimator_.Timeout(LatencyEstimator::Operation::kGet)));
+  auto sent(std::chrono::steady_clock::now());
+  get_timer_.AddTask(attempt_timeout,
+                     [this, op_data, sent](ResponseContents get_response) {
+                       // A default-constructed response means the task timed out.  The task
+                       // can't be cancelled, so it also expires after a successful Get, which
+                       // mustn't count as a timeout.
+                       if (!get_response.content && !get_response.return_code) {
+                         if (op_data->HandleExpiry(std::move(get_response)))
+                           latency_estimator_.AddTimeout(LatencyEstimator::Operation::kGet, 0);
+                         return;
+                       }
+                       if (get_response.content) {
+                         latency_estimator_.AddSample(LatencyEstimator::Operation::kGet,
+                                                      get_response.content->data.size(),
+                                                      std::chrono::steady_clock::now() - sent);
+                       }
+                       op_data->HandleResponseContents(std::move(get_response));
+                     },
+                     // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
+                     routing::Parameters::group_size * 2, task_id);
+  SendGetRequestVisitor send_get_request_visitor(dispatcher_, task_id);
+  boost::apply_visitor(send_get_request_visitor, data_name);
 }
 
 }  // namespace nfs_client
@@ -41,7 +41,7 @@ void DataGetterService::HandleMessage(const GetResponse& message,
   static_cast<void>(receiver);
   static_cast<void>(routing_);
   try {
-    get_timer_.AddResponse(message.id.data, *message.contents);
+    get_timer_.AddResponse(nfs::GetTimerTaskId(message.id), *message.contents);
   }
   catch (const maidsafe_error& error) {
     if (error.code() != make_error_code(CommonErrors::invalid_parameter))
@@ -61,7 +61,7 @@ void DataGetterService::HandleMessage(const GetCachedResponse& message,
   static_cast<void>(receiver);
   static_cast<void>(routing_);
   try {
-    get_timer_.AddResponse(message.id.data, *message.contents);
+    get_timer_.AddResponse(nfs::GetTimerTaskId(message.id), *message.contents);
   }
   catch (const maidsafe_error& error) {
     if (error.code() != make_error_code(CommonErrors::invalid_parameter))
@@ -77,7 +77,7 @@ void DataGetterService::HandleMessage(const GetVersionsResponse& message,
   assert(receiver.data == routing_.kNodeId());
   static_cast<void>(receiver);
   try {
-    get_versions_timer_.AddResponse(message.id.data, *message.contents);
+    get_versions_timer_.AddResponse(nfs::GetTimerTaskId(message.id), *message.contents);
   }
   catch (const maidsafe_error& error) {
     if (error.code() != make_error_code(CommonErrors::invalid_parameter))
@@ -93,7 +93,7 @@ void DataGetterService::HandleMessage(const GetBranchResponse& message,
   assert(receiver.data == routing_.kNodeId());
   static_cast<void>(receiver);
   try {
-    get_branch_timer_.AddResponse(message.id.data, *message.contents);
+    get_branch_timer_.AddResponse(nfs::GetTimerTaskId(message.id), *message.contents);
   }
   catch (const maidsafe_error& error) {
     if (error.code() != make_error_code(CommonErrors::invalid_parameter))
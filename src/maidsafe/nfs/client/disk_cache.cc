@@ -0,0 +1,515 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/disk_cache.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "boost/filesystem/fstream.hpp"
+#include "boost/filesystem/operations.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/utils.h"
+
+namespace fs = boost::filesystem;
+namespace bi = boost::interprocess;
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace {
+
+// Each record is a header, then the name, then the contents.  Integers are in host byte order,
+// since the segments are only ever read by the machine which wrote them.
+struct RecordHeader {
+  uint32_t magic, name_size, content_size;
+};
+
+const uint32_t kRecordMagic(0x4d534443);
+const uint32_t kMaxNameSize(1024);
+const uint64_t kMinSegmentBytes(4 * 1024 * 1024), kMaxSegmentBytes(64 * 1024 * 1024);
+const char kSegmentExtension[] = ".segment";
+
+uint64_t RecordSize(size_t name_size, size_t content_size) {
+  return sizeof(RecordHeader) + name_size + content_size;
+}
+
+}  // unnamed namespace
+
+DiskCacheStats::DiskCacheStats() : entries(0), bytes(0), segments(0) {}
+
+// 'mutex' guards the index, the segments' metadata and mappings, and the write queue.  The segment
+// files are only written by the writer thread, which holds 'mutex' just long enough to consult or
+// update the index; 'active' and 'active_id' are only used by that thread (and by the constructor,
+// before the thread starts).  A record is only indexed once it has been written and flushed, so any
+// indexed record can be read through a mapping of its segment.
+struct DiskCache::Impl {
+  struct Location {
+    uint32_t segment, content_size;
+    // Offset of the contents within the segment.
+    uint64_t offset;
+    // Set when the entry is read, and cleared when it survives the compaction of its segment.
+    bool read;
+  };
+
+  struct Segment {
+    Segment() : size(0), live_bytes(0), region() {}
+
+    uint64_t size, live_bytes;
+    // Shared with readers copying out of it, so that it can be replaced (or the segment deleted)
+    // while they do so without holding 'mutex'.
+    std::shared_ptr<const bi::mapped_region> region;
+  };
+
+  typedef std::unordered_map<std::string, Location> Index;
+  typedef std::pair<std::string, std::shared_ptr<const std::string>> QueuedPut;
+
+  Impl(const fs::path& directory_in, uint64_t max_bytes_in)
+      : directory(directory_in),
+        max_bytes(max_bytes_in),
+        segment_capacity(std::min(kMaxSegmentBytes, std::max(kMinSegmentBytes, max_bytes / 8))),
+        mutex(),
+        cond_var(),
+        index(),
+        segments(),
+        queue(),
+        queued(),
+        queued_bytes(0),
+        writing(false),
+        stopping(false),
+        active_id(0),
+        active(),
+        total_bytes(0),
+        writer() {}
+
+  fs::path SegmentPath(uint32_t id) const {
+    return directory / (std::to_string(id) + kSegmentExtension);
+  }
+
+  // Reads only the record headers and names, truncating the segment after its last whole record.
+  void LoadSegment(uint32_t id) {
+    auto path(SegmentPath(id));
+    boost::system::error_code error_code;
+    auto file_size(fs::file_size(path, error_code));
+    if (error_code) {
+      LOG(kError) << "Failed to read size of " << path << ": " << error_code.message();
+      return;
+    }
+    auto& segment(segments[id]);
+    fs::ifstream stream(path, std::ios::binary);
+    RecordHeader header;
+    while (file_size - segment.size >= sizeof(header)) {
+      stream.seekg(segment.size);
+      stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+      if (!stream || header.magic != kRecordMagic || header.name_size == 0 ||
+          header.name_size > kMaxNameSize ||
+          file_size - segment.size < RecordSize(header.name_size, header.content_size)) {
+        break;
+      }
+      std::string name(header.name_size, 0);
+      stream.read(&name[0], header.name_size);
+      if (!stream)
+        break;
+      Location location = { id, header.content_size,
+                            segment.size + sizeof(header) + header.name_size, false };
+      auto record_size(RecordSize(header.name_size, header.content_size));
+      auto result(index.insert(std::make_pair(std::move(name), location)));
+      if (!result.second) {
+        // A later copy (written by compaction) supersedes an earlier one.
+        segments[result.first->second.segment].live_bytes -= record_size;
+        result.first->second = location;
+      }
+      segment.size += record_size;
+      segment.live_bytes += record_size;
+    }
+    if (segment.size != file_size) {
+      LOG(kWarning) << "Discarding " << file_size - segment.size << " bytes from end of " << path;
+      fs::resize_file(path, segment.size, error_code);
+    }
+    total_bytes += segment.size;
+  }
+
+  // Writer thread only.
+  void OpenSegment(uint32_t id) {
+    active.close();
+    active_id = id;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      segments[active_id];
+    }
+    active.open(SegmentPath(active_id), std::ios::binary | std::ios::app);
+    if (!active)
+      LOG(kError) << "Failed to open " << SegmentPath(active_id);
+  }
+
+  // Must be called with 'mutex' locked.  Returns a mapping of the location's segment which covers
+  // the location (remapping the segment if it has grown since it was mapped), or null on failure.
+  std::shared_ptr<const bi::mapped_region> Map(const Location& location) {
+    auto& segment(segments.at(location.segment));
+    auto end(location.offset + location.content_size);
+    if (!segment.region || segment.region->get_size() < end) {
+      segment.region.reset();
+      try {
+        bi::file_mapping mapping(SegmentPath(location.segment).string().c_str(), bi::read_only);
+        segment.region = std::make_shared<const bi::mapped_region>(mapping, bi::read_only);
+      }
+      catch (const bi::interprocess_exception& e) {
+        LOG(kError) << "Failed to map " << SegmentPath(location.segment) << ": " << e.what();
+        return nullptr;
+      }
+      if (segment.region->get_size() < end)
+        return nullptr;
+    }
+    return segment.region;
+  }
+
+  static std::string Copy(const bi::mapped_region& region, const Location& location) {
+    return std::string(static_cast<const char*>(region.get_address()) + location.offset,
+                       location.content_size);
+  }
+
+  // Writer thread only, without 'mutex' locked.  Writes a record to the active segment and then
+  // indexes it.  For a queued Put, the entry is removed from the queue at the same time, and isn't
+  // indexed if it was dropped from the queue meanwhile.  For a copy made by compaction ('replaces'
+  // non-null), the copy is only indexed if the index still refers to the original.
+  bool Append(const std::string& name, const std::string& content, const Location* replaces) {
+    auto record_size(RecordSize(name.size(), content.size()));
+    uint64_t offset(0);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      offset = segments[active_id].size;
+    }
+    if (offset != 0 && offset + record_size > segment_capacity) {
+      OpenSegment(active_id + 1);
+      offset = 0;
+    }
+    RecordHeader header = { kRecordMagic, static_cast<uint32_t>(name.size()),
+                            static_cast<uint32_t>(content.size()) };
+    active.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    active.write(name.data(), name.size());
+    active.write(content.data(), content.size());
+    active.flush();
+    if (!active) {
+      LOG(kError) << "Failed to write to " << SegmentPath(active_id);
+      // Drop any partial record, so the segment still ends on a whole one.
+      boost::system::error_code error_code;
+      active.close();
+      fs::resize_file(SegmentPath(active_id), offset, error_code);
+      OpenSegment(active_id);
+      if (!replaces) {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.erase(name);
+      }
+      return false;
+    }
+    Location location = { active_id, static_cast<uint32_t>(content.size()),
+                          offset + sizeof(header) + name.size(), false };
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& segment(segments[active_id]);
+    segment.size += record_size;
+    total_bytes += record_size;
+    bool current(false);
+    if (replaces) {
+      auto found(index.find(name));
+      current = found != std::end(index) && found->second.segment == replaces->segment &&
+                found->second.offset == replaces->offset;
+    } else {
+      current = queued.erase(name) == 1;
+    }
+    if (current) {
+      index[name] = location;
+      segment.live_bytes += record_size;
+    }
+    return true;
+  }
+
+  // Must be called with 'mutex' locked.
+  void Discard(Index::iterator entry) {
+    segments.at(entry->second.segment).live_bytes -=
+        RecordSize(entry->first.size(), entry->second.content_size);
+    index.erase(entry);
+  }
+
+  // Writer thread only, without 'mutex' locked.  Copies entries from segment 'id' into the active
+  // one (all of them, or only those which have been read, up to 'max_retained_bytes'), discards the
+  // rest and deletes the segment.
+  void Compact(uint32_t id, bool only_read, uint64_t max_retained_bytes) {
+    std::vector<std::pair<std::string, Location>> entries;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (const auto& entry : index) {
+        if (entry.second.segment == id)
+          entries.push_back(entry);
+      }
+    }
+    uint64_t retained(0);
+    for (auto& entry : entries) {
+      auto record_size(RecordSize(entry.first.size(), entry.second.content_size));
+      std::shared_ptr<const bi::mapped_region> region;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found(index.find(entry.first));
+        if (found == std::end(index) || found->second.segment != id)
+          continue;
+        entry.second = found->second;
+        if ((entry.second.read || !only_read) && retained + record_size <= max_retained_bytes)
+          region = Map(entry.second);
+        if (!region) {
+          index.erase(found);
+          continue;
+        }
+      }
+      if (Append(entry.first, Copy(*region, entry.second), &entry.second)) {
+        retained += record_size;
+      } else {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found(index.find(entry.first));
+        if (found != std::end(index) && found->second.segment == id)
+          index.erase(found);
+      }
+    }
+    uint64_t segment_size(0);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      segment_size = segments.at(id).size;
+      total_bytes -= segment_size;
+      segments.erase(id);
+    }
+    LOG(kVerbose) << "Compacted disk cache segment " << id << ", retaining " << retained
+                  << " bytes of " << segment_size;
+    boost::system::error_code error_code;
+    fs::remove(SegmentPath(id), error_code);
+    if (error_code)
+      LOG(kError) << "Failed to remove " << SegmentPath(id) << ": " << error_code.message();
+  }
+
+  // Writer thread only (or the constructor), without 'mutex' locked.
+  void Reclaim() {
+    for (;;) {
+      uint32_t oldest(0);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (total_bytes <= max_bytes || segments.begin()->first == active_id)
+          break;
+        oldest = segments.begin()->first;
+      }
+      Compact(oldest, true, segment_capacity / 2);
+    }
+    std::vector<uint32_t> sparse_segments;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (const auto& segment : segments) {
+        if (segment.first != active_id && segment.second.live_bytes * 2 < segment.second.size)
+          sparse_segments.push_back(segment.first);
+      }
+    }
+    for (auto id : sparse_segments)
+      Compact(id, false, std::numeric_limits<uint64_t>::max());
+  }
+
+  // Body of the writer thread: writes queued Puts in order, compacting as needed after each, until
+  // stopped with nothing left queued.
+  void Write() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      cond_var.wait(lock, [this] { return stopping || !queue.empty(); });
+      if (queue.empty())
+        return;
+      auto queued_put(std::move(queue.front()));
+      queue.pop_front();
+      writing = true;
+      lock.unlock();
+      try {
+        if (Append(queued_put.first, *queued_put.second, nullptr))
+          Reclaim();
+      }
+      catch (const std::exception& e) {
+        LOG(kError) << "Failed to write to disk cache: " << e.what();
+      }
+      lock.lock();
+      queued.erase(queued_put.first);
+      queued_bytes -= queued_put.second->size();
+      writing = false;
+      cond_var.notify_all();
+    }
+  }
+
+  const fs::path directory;
+  const uint64_t max_bytes, segment_capacity;
+  mutable std::mutex mutex;
+  std::condition_variable cond_var;
+  Index index;
+  // Ordered oldest first.
+  std::map<uint32_t, Segment> segments;
+  // Puts waiting to be written, oldest first, and the same indexed by name so that they can be
+  // read meanwhile.  The queue is bounded by the size of a segment; further Puts are dropped.
+  std::deque<QueuedPut> queue;
+  std::unordered_map<std::string, std::shared_ptr<const std::string>> queued;
+  uint64_t queued_bytes;
+  bool writing, stopping;
+  uint32_t active_id;
+  fs::ofstream active;
+  uint64_t total_bytes;
+  std::thread writer;
+};
+
+DiskCache::DiskCache(const fs::path& directory, uint64_t max_bytes)
+    : impl_(new Impl(directory, max_bytes)) {
+  boost::system::error_code error_code;
+  fs::create_directories(directory, error_code);
+  if (error_code) {
+    LOG(kError) << "Failed to create " << directory << ": " << error_code.message();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  std::vector<uint32_t> ids;
+  for (fs::directory_iterator itr(directory, error_code), end; !error_code && itr != end;
+       itr.increment(error_code)) {
+    if (itr->path().extension() != kSegmentExtension)
+      continue;
+    try {
+      ids.push_back(static_cast<uint32_t>(std::stoul(itr->path().stem().string())));
+    }
+    catch (const std::exception&) {
+      LOG(kWarning) << "Ignoring " << itr->path();
+    }
+  }
+  std::sort(std::begin(ids), std::end(ids));
+
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    for (auto id : ids)
+      impl_->LoadSegment(id);
+  }
+  // Appending resumes in the newest segment if it has room.
+  if (!ids.empty() && impl_->segments[ids.back()].size < impl_->segment_capacity)
+    impl_->OpenSegment(ids.back());
+  else
+    impl_->OpenSegment(ids.empty() ? 0 : ids.back() + 1);
+  impl_->Reclaim();
+  LOG(kInfo) << "Disk cache in " << directory << " has " << impl_->index.size() << " entries in "
+             << impl_->segments.size() << " segments";
+  auto impl(impl_.get());
+  impl_->writer = std::thread([impl] { impl->Write(); });
+}
+
+DiskCache::~DiskCache() {
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->stopping = true;
+  }
+  impl_->cond_var.notify_all();
+  impl_->writer.join();
+}
+
+std::shared_ptr<const std::string> DiskCache::Get(const Identity& name) {
+  std::shared_ptr<const std::string> content;
+  std::shared_ptr<const bi::mapped_region> region;
+  Impl::Location location;
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    auto queued(impl_->queued.find(name.string()));
+    if (queued != std::end(impl_->queued)) {
+      content = queued->second;
+    } else {
+      auto found(impl_->index.find(name.string()));
+      if (found == std::end(impl_->index))
+        return nullptr;
+      region = impl_->Map(found->second);
+      if (!region) {
+        impl_->Discard(found);
+        return nullptr;
+      }
+      found->second.read = true;
+      location = found->second;
+    }
+  }
+  if (region)
+    content = std::make_shared<const std::string>(Impl::Copy(*region, location));
+
+  if (crypto::Hash<crypto::SHA512>(*content).string() == name.string())
+    return content;
+
+  LOG(kError) << "Discarding corrupt disk cache entry for " << HexSubstr(name);
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  if (!region) {
+    // Not yet written; the writer won't index it once it's no longer queued.
+    impl_->queued.erase(name.string());
+    return nullptr;
+  }
+  auto found(impl_->index.find(name.string()));
+  if (found != std::end(impl_->index) && found->second.segment == location.segment &&
+      found->second.offset == location.offset) {
+    impl_->Discard(found);
+  }
+  return nullptr;
+}
+
+void DiskCache::Put(const Identity& name, std::shared_ptr<const std::string> content) {
+  if (!content || content->empty() ||
+      RecordSize(name.string().size(), content->size()) > impl_->segment_capacity) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (impl_->index.find(name.string()) != std::end(impl_->index) ||
+        impl_->queued.find(name.string()) != std::end(impl_->queued)) {
+      return;
+    }
+    if (impl_->queued_bytes + content->size() > impl_->segment_capacity) {
+      LOG(kWarning) << "Disk cache write queue is full; not caching " << HexSubstr(name);
+      return;
+    }
+    impl_->queued.insert(std::make_pair(name.string(), content));
+    impl_->queued_bytes += content->size();
+    impl_->queue.push_back(std::make_pair(name.string(), std::move(content)));
+  }
+  impl_->cond_var.notify_all();
+}
+
+void DiskCache::Flush() {
+  std::unique_lock<std::mutex> lock(impl_->mutex);
+  impl_->cond_var.wait(lock, [this] { return impl_->queue.empty() && !impl_->writing; });
+}
+
+DiskCacheStats DiskCache::stats() const {
+  DiskCacheStats result;
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  result.entries = impl_->index.size() + impl_->queued.size();
+  result.bytes = impl_->total_bytes;
+  result.segments = impl_->segments.size();
+  return result;
+}
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
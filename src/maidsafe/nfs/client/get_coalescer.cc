@@ -0,0 +1,314 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/get_coalescer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "boost/asio/steady_timer.hpp"
+#include "boost/exception/diagnostic_information.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/nfs/client/cancellation_token.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace {
+
+typedef std::chrono::steady_clock::time_point TimePoint;
+
+DataNameAndContentOrReturnCode TimedOut() {
+  DataNameAndContentOrReturnCode response;
+  response.return_code = ReturnCode(NfsErrors::timed_out);
+  return response;
+}
+
+DataNameAndContentOrReturnCode Cancelled() {
+  DataNameAndContentOrReturnCode response;
+  response.return_code = ReturnCode(CancelledError());
+  return response;
+}
+
+void Notify(std::vector<GetCoalescer::ResultFunctor>& result_functors,
+            DataNameAndContentOrReturnCode response) {
+  for (size_t i(0); i != result_functors.size(); ++i) {
+    try {
+      // Only the last caller can take the response; the others each get a copy.
+      if (i + 1 == result_functors.size())
+        result_functors[i](std::move(response));
+      else
+        result_functors[i](response);
+    }
+    catch (const std::exception& e) {
+      LOG(kError) << "Get result functor threw: " << boost::diagnostic_information(e);
+    }
+  }
+}
+
+}  // unnamed namespace
+
+struct GetCoalescer::State : public std::enable_shared_from_this<State> {
+  typedef std::pair<DataTagValue, Identity> Key;
+
+  struct Subscriber {
+    Subscriber(ResultFunctor result_functor_in, TimePoint deadline_in)
+        : result_functor(std::move(result_functor_in)), deadline(deadline_in), timer() {}
+
+    ResultFunctor result_functor;
+    TimePoint deadline;
+    // Only set if the subscriber's deadline is earlier than its flight's.
+    std::unique_ptr<boost::asio::steady_timer> timer;
+  };
+
+  struct Flight {
+    Flight() : id(0), deadline(), subscribers(), cancel() {}
+
+    uint64_t id;
+    TimePoint deadline;
+    std::map<uint64_t, Subscriber> subscribers;
+    // Cancels the flight's current request.
+    CancelFunctor cancel;
+  };
+
+  State(AsioService& asio_service, SendFunctor send_functor_in)
+      : io_service(asio_service.service()),
+        send_functor(std::move(send_functor_in)),
+        mutex(),
+        flights(),
+        next_id(0),
+        stopped(false) {}
+
+  // Must be called with 'mutex' locked.
+  void StartTimer(const Key& key, uint64_t subscriber_id, Subscriber& subscriber) {
+    subscriber.timer.reset(new boost::asio::steady_timer(io_service));
+    subscriber.timer->expires_at(subscriber.deadline);
+    std::weak_ptr<State> weak_state(shared_from_this());
+    subscriber.timer->async_wait(
+        [weak_state, key, subscriber_id](const boost::system::error_code& error) {
+          if (error == boost::asio::error::operation_aborted)
+            return;
+          if (auto state = weak_state.lock())
+            state->Expire(key, subscriber_id);
+        });
+  }
+
+  void Send(const Key& key, const std::chrono::steady_clock::duration& timeout,
+            uint64_t flight_id) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (stopped)
+        return;
+    }
+    std::weak_ptr<State> weak_state(shared_from_this());
+    CancelFunctor cancel;
+    try {
+      cancel = send_functor(GetDataNameVariant(key.first, key.second), timeout,
+                            [weak_state, key, flight_id](DataNameAndContentOrReturnCode response) {
+                              if (auto state = weak_state.lock())
+                                state->Complete(key, flight_id, std::move(response));
+                            });
+    }
+    catch (const maidsafe_error& error) {
+      LOG(kError) << "Failed to send Get request: " << boost::diagnostic_information(error);
+      DataNameAndContentOrReturnCode response;
+      response.return_code = ReturnCode(error);
+      return Complete(key, flight_id, std::move(response));
+    }
+    if (!cancel)
+      return;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto found(flights.find(key));
+      if (found != std::end(flights) && found->second.id == flight_id) {
+        found->second.cancel = std::move(cancel);
+        return;
+      }
+    }
+    // The flight was cancelled (or completed) while the request was being sent.
+    cancel();
+  }
+
+  void Complete(const Key& key, uint64_t flight_id, DataNameAndContentOrReturnCode response) {
+    std::vector<ResultFunctor> completed;
+    std::chrono::steady_clock::duration resend_timeout(std::chrono::steady_clock::duration::zero());
+    uint64_t resend_flight_id(0);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto found(flights.find(key));
+      // A flight which has been replaced (or already completed) is ignored.
+      if (stopped || found == std::end(flights) || found->second.id != flight_id)
+        return;
+      auto& flight(found->second);
+      auto& subscribers(flight.subscribers);
+      if (!response.content && !response.return_code) {
+        // The flight timed out.  Callers with time left are given a new flight.
+        auto now(std::chrono::steady_clock::now());
+        auto latest(now);
+        for (auto itr(std::begin(subscribers)); itr != std::end(subscribers);) {
+          if (itr->second.deadline <= now) {
+            completed.push_back(std::move(itr->second.result_functor));
+            itr = subscribers.erase(itr);
+          } else {
+            latest = std::max(latest, itr->second.deadline);
+            ++itr;
+          }
+        }
+        if (!subscribers.empty()) {
+          flight.id = resend_flight_id = ++next_id;
+          flight.cancel = nullptr;
+          flight.deadline = latest;
+          resend_timeout = latest - now;
+          for (auto& entry : subscribers) {
+            if (!entry.second.timer && entry.second.deadline < latest)
+              StartTimer(key, entry.first, entry.second);
+          }
+        }
+        response = TimedOut();
+      } else {
+        for (auto& entry : subscribers)
+          completed.push_back(std::move(entry.second.result_functor));
+        subscribers.clear();
+      }
+      if (subscribers.empty())
+        flights.erase(found);
+    }
+    Notify(completed, std::move(response));
+    if (resend_flight_id != 0) {
+      LOG(kVerbose) << "Resending timed out Get for " << HexSubstr(key.second);
+      Send(key, resend_timeout, resend_flight_id);
+    }
+  }
+
+  void Expire(const Key& key, uint64_t subscriber_id) {
+    std::vector<ResultFunctor> expired;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto found(flights.find(key));
+      if (stopped || found == std::end(flights))
+        return;
+      auto subscriber(found->second.subscribers.find(subscriber_id));
+      if (subscriber == std::end(found->second.subscribers))
+        return;
+      expired.push_back(std::move(subscriber->second.result_functor));
+      // The flight itself is left in place for its other (or future) callers.
+      found->second.subscribers.erase(subscriber);
+    }
+    Notify(expired, TimedOut());
+  }
+
+  void Cancel(const Key& key, uint64_t subscriber_id) {
+    std::vector<ResultFunctor> cancelled;
+    CancelFunctor cancel_flight;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto found(flights.find(key));
+      if (stopped || found == std::end(flights))
+        return;
+      auto subscriber(found->second.subscribers.find(subscriber_id));
+      if (subscriber == std::end(found->second.subscribers))
+        return;
+      cancelled.push_back(std::move(subscriber->second.result_functor));
+      found->second.subscribers.erase(subscriber);
+      if (found->second.subscribers.empty()) {
+        cancel_flight = std::move(found->second.cancel);
+        flights.erase(found);
+      }
+    }
+    if (cancel_flight) {
+      LOG(kVerbose) << "Cancelling Get for " << HexSubstr(key.second) << " with no callers left";
+      cancel_flight();
+    }
+    Notify(cancelled, Cancelled());
+  }
+
+  boost::asio::io_service& io_service;
+  const SendFunctor send_functor;
+  mutable std::mutex mutex;
+  std::map<Key, Flight> flights;
+  uint64_t next_id;
+  bool stopped;
+};
+
+GetCoalescer::GetCoalescer(AsioService& asio_service, SendFunctor send_functor)
+    : state_(std::make_shared<State>(asio_service, std::move(send_functor))) {
+  if (!state_->send_functor) {
+    LOG(kError) << "GetCoalescer requires a send functor.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+}
+
+GetCoalescer::~GetCoalescer() {
+  std::map<State::Key, State::Flight> flights;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->stopped = true;
+    flights.swap(state_->flights);
+  }
+}
+
+uint64_t GetCoalescer::Get(DataTagValue type, const Identity& raw_name,
+                           const std::chrono::steady_clock::duration& timeout,
+                           ResultFunctor result_functor) {
+  State::Key key(type, raw_name);
+  uint64_t flight_id(0), subscriber_id(0);
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    auto deadline(std::chrono::steady_clock::now() + timeout);
+    subscriber_id = ++state_->next_id;
+    auto found(state_->flights.find(key));
+    if (found != std::end(state_->flights)) {
+      LOG(kVerbose) << "Joining Get already in flight for " << HexSubstr(raw_name);
+      auto& flight(found->second);
+      auto& subscriber(flight.subscribers.insert(std::make_pair(
+          subscriber_id, State::Subscriber(std::move(result_functor), deadline))).first->second);
+      if (deadline < flight.deadline)
+        state_->StartTimer(key, subscriber_id, subscriber);
+      return subscriber_id;
+    }
+    State::Flight flight;
+    flight.id = flight_id = ++state_->next_id;
+    flight.deadline = deadline;
+    flight.subscribers.insert(
+        std::make_pair(subscriber_id, State::Subscriber(std::move(result_functor), deadline)));
+    state_->flights.insert(std::make_pair(key, std::move(flight)));
+  }
+  state_->Send(key, timeout, flight_id);
+  return subscriber_id;
+}
+
+void GetCoalescer::Cancel(DataTagValue type, const Identity& raw_name, uint64_t id) {
+  state_->Cancel(State::Key(type, raw_name), id);
+}
+
+size_t GetCoalescer::InFlightCount() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->flights.size();
+}
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
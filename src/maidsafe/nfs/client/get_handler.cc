@@ -18,46 +18,339 @@
 
 #include "maidsafe/nfs/client/get_handler.h"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "boost/asio/steady_timer.hpp"
+
+#include "maidsafe/common/error.h"
+
 namespace maidsafe {
 
 namespace nfs_client {
 
-void GetHandler::AddResponse(routing::TaskId task_id,
+namespace {
+
+class TypeAndNameVisitor
+    : public boost::static_visitor<std::pair<DataTagValue, Identity>> {
+ public:
+  template <typename Name>
+  result_type operator()(const Name& data_name) const {
+    return std::make_pair(Name::data_type::Tag::kValue, data_name.value);
+  }
+};
+
+const size_t kMinimumPurgeSize(64);
+const size_t kMinimumHedgeSamples(20);
+
+bool IsNoSuchElement(const DataNameAndContentOrReturnCode& response) {
+  return response.return_code &&
+         response.return_code->value == make_error_code(CommonErrors::no_such_element);
+}
+
+}  // unnamed namespace
+
+HedgeParameters::HedgeParameters()
+    : percentile(0.0), minimum_samples(kMinimumHedgeSamples), cacheable() {}
+
+HedgeParameters::HedgeParameters(double percentile_in,
+                                 boost::optional<routing::Cacheable> cacheable_in)
+    : percentile(percentile_in), minimum_samples(kMinimumHedgeSamples), cacheable(cacheable_in) {}
+
+struct GetHandler::Attempt {
+  Attempt(nfs::PendingOperations& pending_operations_in,
+          GetCoalescer::ResultFunctor result_functor_in)
+      : pending_operations(pending_operations_in),
+        result_functor(std::move(result_functor_in)),
+        op_data(1, [this](DataNameAndContentOrReturnCode response) {
+                     Complete(std::move(response));
+                   }),
+        mutex(),
+        task_ids(),
+        completed(false),
+        hedge_timer() {}
+
+  // Returns false if the attempt has already completed, in which case 'task_id' isn't needed.
+  bool Add(nfs::TaskId task_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (completed)
+      return false;
+    task_ids.push_back(task_id);
+    return true;
+  }
+
+  // Called with the first content received by any of the requests.
+  void Complete(DataNameAndContentOrReturnCode response) {
+    std::vector<nfs::TaskId> outstanding;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (completed)
+        return;
+      Finish(outstanding);
+    }
+    Cancel(outstanding);
+    result_functor(std::move(response));
+  }
+
+  // Called when the request for 'task_id' fails.  A failure AddResponse has settled on completes
+  // the attempt, but a timeout or cancellation only does once no other request is outstanding.
+  void Fail(nfs::TaskId task_id, DataNameAndContentOrReturnCode response) {
+    std::vector<nfs::TaskId> outstanding;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto found(std::find(std::begin(task_ids), std::end(task_ids), task_id));
+      if (completed || found == std::end(task_ids))
+        return;
+      task_ids.erase(found);
+      if (!response.return_code && !task_ids.empty())
+        return;
+      Finish(outstanding);
+    }
+    Cancel(outstanding);
+    result_functor(std::move(response));
+  }
+
+  // Returns the requests to be cancelled, or none if the attempt has already completed.
+  std::vector<nfs::TaskId> Abandon() {
+    std::vector<nfs::TaskId> outstanding;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!completed)
+      Finish(outstanding);
+    return outstanding;
+  }
+
+  // Must be called with 'mutex' locked.
+  void Finish(std::vector<nfs::TaskId>& outstanding) {
+    completed = true;
+    outstanding.swap(task_ids);
+    if (hedge_timer)
+      hedge_timer->cancel();
+  }
+
+  // Cancelled tasks call back into Fail, which ignores them as the attempt has completed.
+  void Cancel(const std::vector<nfs::TaskId>& outstanding) {
+    for (auto task_id : outstanding)
+      pending_operations.CancelTask(task_id);
+  }
+
+  nfs::PendingOperations& pending_operations;
+  const GetCoalescer::ResultFunctor result_functor;
+  // Shared by the requests so that only the first content is passed on.
+  nfs::OpData<DataNameAndContentOrReturnCode> op_data;
+  std::mutex mutex;
+  // The requests which haven't yet failed.
+  std::vector<nfs::TaskId> task_ids;
+  bool completed;
+  // Armed before the first request is sent, and only cancelled after, so never used concurrently.
+  std::unique_ptr<boost::asio::steady_timer> hedge_timer;
+};
+
+GetHandler::GetHandler(AsioService& asio_service, nfs::PendingOperations& pending_operations_in,
+                       MaidNodeDispatcher& dispatcher_in, DataCache& data_cache_in,
+                       NegativeCache& negative_cache_in, LatencyEstimator& latency_estimator_in,
+                       const HedgeParameters& hedge_parameters_in)
+    : GetHandler(asio_service, pending_operations_in,
+                 [&dispatcher_in](nfs::TaskId task_id, const DataNameVariant& data_name,
+                                  boost::optional<routing::Cacheable> cacheable) {
+                   GetHandlerVisitor get_handler_visitor(dispatcher_in, task_id, cacheable);
+                   boost::apply_visitor(get_handler_visitor, data_name);
+                 },
+                 data_cache_in, negative_cache_in, latency_estimator_in, hedge_parameters_in) {}
+
+GetHandler::GetHandler(AsioService& asio_service, nfs::PendingOperations& pending_operations_in,
+                       SendFunctor send_request_in, DataCache& data_cache_in,
+                       NegativeCache& negative_cache_in, LatencyEstimator& latency_estimator_in,
+                       const HedgeParameters& hedge_parameters_in)
+    : pending_operations(pending_operations_in),
+      send_request(std::move(send_request_in)),
+      data_cache(data_cache_in),
+      negative_cache(negative_cache_in),
+      latency_estimator(latency_estimator_in),
+      hedge_parameters(hedge_parameters_in),
+      io_service(asio_service.service()),
+      lifetime(std::make_shared<Lifetime>()),
+      get_info(),
+      purge_size(kMinimumPurgeSize),
+      mutex(),
+      coalescer(asio_service, [this](const DataNameVariant& data_name,
+                                     const std::chrono::steady_clock::duration& timeout,
+                                     GetCoalescer::ResultFunctor result_functor) {
+                                return SendGet(data_name, timeout, std::move(result_functor));
+                              }) {}
+
+GetHandler::~GetHandler() {
+  // Waits for any hedge request being sent.
+  std::lock_guard<std::mutex> lock(lifetime->mutex);
+  lifetime->destroyed = true;
+}
+
+GetCoalescer::CancelFunctor GetHandler::SendGet(
+    const DataNameVariant& data_name, const std::chrono::steady_clock::duration& timeout,
+    GetCoalescer::ResultFunctor result_functor) {
+  // The coalescer resends the request if this attempt times out while the Get has time left.
+  auto attempt_timeout(
+      std::min(timeout, latency_estimator.Timeout(LatencyEstimator::Operation::kGet)));
+  auto attempt(std::make_shared<Attempt>(pending_operations, std::move(result_functor)));
+  auto hedge_delay(HedgeDelay());
+  if (hedge_delay && *hedge_delay < attempt_timeout) {
+    // The hedge request is given whatever is left of the attempt's timeout.
+    auto deadline(std::chrono::steady_clock::now() + attempt_timeout);
+    std::weak_ptr<Attempt> weak_attempt(attempt);
+    std::weak_ptr<Lifetime> weak_lifetime(lifetime);
+    attempt->hedge_timer.reset(new boost::asio::steady_timer(io_service, *hedge_delay));
+    attempt->hedge_timer->async_wait([this, weak_attempt, weak_lifetime, data_name, deadline](
+        const boost::system::error_code& error) {
+      auto attempt(weak_attempt.lock());
+      auto lifetime(weak_lifetime.lock());
+      if (error || !attempt || !lifetime)
+        return;
+      std::lock_guard<std::mutex> lock(lifetime->mutex);
+      auto remaining(deadline - std::chrono::steady_clock::now());
+      if (lifetime->destroyed || remaining <= std::chrono::steady_clock::duration::zero())
+        return;
+      LOG(kVerbose) << "GetHandler hedging request";
+      SendRequest(attempt, data_name, remaining, hedge_parameters.cacheable);
+    });
+  }
+  SendRequest(attempt, data_name, attempt_timeout, boost::none);
+  std::weak_ptr<Attempt> weak_attempt(attempt);
+  return [this, weak_attempt] {
+    auto attempt(weak_attempt.lock());
+    if (!attempt)
+      return;
+    auto task_ids(attempt->Abandon());
+    {
+      // Later responses are then dropped by HasPendingTask.
+      std::lock_guard<std::mutex> lock(mutex);
+      for (auto task_id : task_ids)
+        get_info.erase(task_id);
+    }
+    for (auto task_id : task_ids)
+      pending_operations.CancelTask(task_id);
+  };
+}
+
+void GetHandler::SendRequest(std::shared_ptr<Attempt> attempt, const DataNameVariant& data_name,
+                             const std::chrono::steady_clock::duration& timeout,
+                             boost::optional<routing::Cacheable> cacheable) {
+  auto task_id(pending_operations.NewTaskId());
+  auto sent(std::chrono::steady_clock::now());
+  // Tasks can expire after this handler has been destroyed, but not after the estimator has.
+  auto estimator(&latency_estimator);
+  pending_operations.AddTask<DataNameAndContentOrReturnCode>(
+      timeout,
+      [estimator, attempt, task_id, sent, timeout](DataNameAndContentOrReturnCode get_response) {
+        auto round_trip(std::chrono::steady_clock::now() - sent);
+        if (get_response.content) {
+          estimator->AddSample(LatencyEstimator::Operation::kGet,
+                               get_response.content->data.size(), round_trip);
+          return attempt->op_data.HandleResponseContents(std::move(get_response));
+        }
+        // A failure is only passed here once AddResponse has settled on it, and a
+        // default-constructed response means the task timed out or was cancelled.
+        if (!get_response.return_code && round_trip >= timeout)
+          estimator->AddTimeout(LatencyEstimator::Operation::kGet, 0);
+        attempt->Fail(task_id, std::move(get_response));
+      },
+      // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
+      routing::Parameters::group_size * 2, task_id);
+  if (!attempt->Add(task_id)) {
+    // The attempt completed while this (hedge) request was being added.
+    pending_operations.CancelTask(task_id);
+    return;
+  }
+  {
+    // Added after the task so that a concurrent purge can't drop it.
+    std::lock_guard<std::mutex> lock(mutex);
+    get_info.insert(std::make_pair(task_id, std::make_tuple(0, task_id, data_name, 0)));
+    if (get_info.size() >= purge_size)
+      PurgeExpiredGetInfo();
+  }
+  send_request(task_id, data_name, cacheable);
+}
+
+boost::optional<std::chrono::steady_clock::duration> GetHandler::HedgeDelay() const {
+  if (hedge_parameters.percentile <= 0.0)
+    return boost::none;
+  return latency_estimator.Percentile(LatencyEstimator::Operation::kGet,
+                                      hedge_parameters.percentile,
+                                      hedge_parameters.minimum_samples);
+}
+
+void GetHandler::PurgeExpiredGetInfo() {
+  for (auto itr(std::begin(get_info)); itr != std::end(get_info);) {
+    if (pending_operations.HasTask(std::get<1>(itr->second)))
+      ++itr;
+    else
+      itr = get_info.erase(itr);
+  }
+  // Purging again only once the table has doubled keeps the cost per request constant.
+  purge_size = std::max(kMinimumPurgeSize, get_info.size() * 2);
+}
+
+bool GetHandler::HasPendingTask(nfs::TaskId task_id) {
+  std::lock_guard<std::mutex> lock(mutex);
+  return get_info.find(task_id) != std::end(get_info);
+}
+
+void GetHandler::AddResponse(nfs::TaskId task_id,
                              const DataNameAndContentOrReturnCode& response) {
   Operation operation(Operation::kNoOperation);
-  routing::TaskId new_task_id(0);
+  nfs::TaskId original_task_id(0), new_task_id(0);
+  DataNameVariant data_name;
+  std::pair<DataTagValue, Identity> type_and_name;
 
   {
     std::lock_guard<std::mutex> lock(mutex);
     auto found(get_info.find(task_id));
     if (found == std::end(get_info))
       return;
-    std::get<0>(get_info[task_id])++;
+    auto& info(found->second);
+    ++std::get<0>(info);
+    if (IsNoSuchElement(response))
+      ++std::get<3>(info);
+    original_task_id = std::get<1>(info);
+    bool whole_group_missing(std::get<0>(info) >= routing::Parameters::group_size &&
+                             std::get<3>(info) == std::get<0>(info));
+    if (whole_group_missing)
+      type_and_name = boost::apply_visitor(TypeAndNameVisitor(), std::get<2>(info));
     if (response.content) {
+      // The first content response completes the Get, so any further responses for this task are
+      // redundant and can be dropped by HasPendingTask without being decoded.
+      get_info.erase(found);
       operation = Operation::kAddResponse;
+    } else if (whole_group_missing && negative_cache.Holds(type_and_name.first)) {
+      // The whole group reports the data as missing, so retrying would only find the same.
+      get_info.erase(found);
+      operation = Operation::kFailGet;
     } else if (response.return_code &&
-               (std::get<0>(get_info[task_id]) >= routing::Parameters::group_size)) {
-      new_task_id = get_timer.NewTaskId();
+               (std::get<0>(info) >= routing::Parameters::group_size)) {
+      new_task_id = pending_operations.NewTaskId();
+      data_name = std::get<2>(info);
+      get_info.erase(found);
       get_info.insert(std::make_pair(new_task_id,
-                                     std::make_tuple(0, std::get<1>(get_info[task_id]),
-                                                     std::get<2>(get_info[task_id]))));
-      get_info.erase(task_id);
+                                     std::make_tuple(0, original_task_id, data_name, 0)));
       operation = Operation::kSendRequest;
-    } else  if (!response.return_code && !response.content) {
+    } else if (!response.return_code && !response.content) {
+      get_info.erase(found);
       operation = Operation::kCancelTask;
     }
   }
 
   LOG(kVerbose) << static_cast<int>(operation) << " GetHandler::AddResponse "  << task_id
-                <<  " original task id: " << std::get<1>(get_info[task_id]);
+                <<  " original task id: " << original_task_id;
 
   if (operation == Operation::kAddResponse) {
-    get_timer.AddResponse(std::get<1>(get_info[task_id]), response);
+    pending_operations.AddResponse(original_task_id, response);
   } else if (operation == Operation::kSendRequest) {
-    GetHandlerVisitor get_handler_visitor(dispatcher, new_task_id);
-    boost::apply_visitor(get_handler_visitor, std::get<2>(get_info[new_task_id]));
+    send_request(new_task_id, data_name, boost::none);
   } else if (operation == Operation::kCancelTask) {
-    get_timer.CancelTask(std::get<1>(get_info[task_id]));
+    pending_operations.CancelTask(original_task_id);
+  } else if (operation == Operation::kFailGet) {
+    negative_cache.Add(type_and_name.first, type_and_name.second, *response.return_code);
+    pending_operations.AddResponse(original_task_id, response);
+    pending_operations.CancelTask(original_task_id);
   }
 }
 
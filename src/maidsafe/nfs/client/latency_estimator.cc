@@ -0,0 +1,175 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/latency_estimator.h"
+
+#include <algorithm>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace {
+
+const uint64_t kSmallestBucketLimit(4096);
+const int kBucketCount(8);
+const size_t kRecentRoundTripCount(256);
+
+}  // unnamed namespace
+
+LatencyEstimator::LatencyEstimator(const std::chrono::steady_clock::duration& initial_timeout,
+                                   const std::chrono::steady_clock::duration& minimum_timeout,
+                                   const std::chrono::steady_clock::duration& maximum_timeout)
+    : initial_timeout_(initial_timeout),
+      minimum_timeout_(minimum_timeout),
+      maximum_timeout_(maximum_timeout),
+      mutex_(),
+      estimates_(),
+      recent_round_trips_() {
+  if (minimum_timeout_ <= std::chrono::steady_clock::duration::zero() ||
+      minimum_timeout_ > initial_timeout_ || initial_timeout_ > maximum_timeout_) {
+    LOG(kError) << "LatencyEstimator timeouts must satisfy 0 < minimum <= initial <= maximum.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+}
+
+std::chrono::steady_clock::duration LatencyEstimator::Timeout(Operation operation) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found(estimates_.find(operation));
+  return Timeout(found == std::end(estimates_) ? nullptr : &found->second.all_sizes);
+}
+
+std::chrono::steady_clock::duration LatencyEstimator::Timeout(Operation operation,
+                                                              uint64_t payload_size) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found(estimates_.find(operation));
+  if (found == std::end(estimates_))
+    return Timeout(nullptr);
+  auto bucket(found->second.by_size.find(SizeBucket(payload_size)));
+  return Timeout(bucket == std::end(found->second.by_size) ? nullptr : &bucket->second);
+}
+
+std::chrono::steady_clock::duration LatencyEstimator::ResolveTimeout(
+    Operation operation, const std::chrono::steady_clock::duration& timeout) const {
+  return timeout == kAdaptiveTimeout ? Timeout(operation) : timeout;
+}
+
+std::chrono::steady_clock::duration LatencyEstimator::ResolveTimeout(
+    Operation operation, const std::chrono::steady_clock::duration& timeout,
+    uint64_t payload_size) const {
+  return timeout == kAdaptiveTimeout ? Timeout(operation, payload_size) : timeout;
+}
+
+void LatencyEstimator::AddSample(Operation operation, uint64_t payload_size,
+                                 const std::chrono::steady_clock::duration& round_trip) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& operation_estimates(estimates_[operation]);
+  Update(operation_estimates.all_sizes, round_trip);
+  Update(operation_estimates.by_size[SizeBucket(payload_size)], round_trip);
+  auto& recent(recent_round_trips_[operation]);
+  if (recent.round_trips.size() < kRecentRoundTripCount)
+    recent.round_trips.push_back(round_trip);
+  else
+    recent.round_trips[recent.next] = round_trip;
+  recent.next = (recent.next + 1) % kRecentRoundTripCount;
+}
+
+void LatencyEstimator::AddTimeout(Operation operation, uint64_t payload_size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& operation_estimates(estimates_[operation]);
+  BackOff(operation_estimates.all_sizes);
+  BackOff(operation_estimates.by_size[SizeBucket(payload_size)]);
+}
+
+void LatencyEstimator::AddResponse(Operation operation, uint64_t payload_size,
+                                   std::chrono::steady_clock::time_point sent,
+                                   const std::chrono::steady_clock::duration& timeout) {
+  auto round_trip(std::chrono::steady_clock::now() - sent);
+  if (round_trip < timeout)
+    AddSample(operation, payload_size, round_trip);
+  else
+    AddTimeout(operation, payload_size);
+}
+
+LatencyEstimator::Estimates LatencyEstimator::estimates() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return estimates_;
+}
+
+boost::optional<std::chrono::steady_clock::duration> LatencyEstimator::Percentile(
+    Operation operation, double fraction, size_t minimum_samples) const {
+  std::vector<std::chrono::steady_clock::duration> round_trips;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found(recent_round_trips_.find(operation));
+    if (found == std::end(recent_round_trips_) ||
+        found->second.round_trips.size() < std::max(minimum_samples, size_t(1))) {
+      return boost::none;
+    }
+    round_trips = found->second.round_trips;
+  }
+  auto index(static_cast<size_t>(std::max(0.0, std::min(1.0, fraction)) *
+                                 static_cast<double>(round_trips.size() - 1) + 0.5));
+  std::nth_element(std::begin(round_trips), std::begin(round_trips) + index,
+                   std::end(round_trips));
+  return round_trips[index];
+}
+
+uint64_t LatencyEstimator::SizeBucket(uint64_t payload_size) {
+  if (payload_size < kSmallestBucketLimit)
+    return 0;
+  uint64_t bucket(kSmallestBucketLimit);
+  for (int i(2); i < kBucketCount && payload_size >= bucket * 4; ++i)
+    bucket *= 4;
+  return bucket;
+}
+
+void LatencyEstimator::Update(Estimate& estimate,
+                              const std::chrono::steady_clock::duration& round_trip) const {
+  if (estimate.samples == 0) {
+    estimate.smoothed = round_trip;
+    estimate.deviation = round_trip / 2;
+  } else {
+    auto difference(estimate.smoothed > round_trip ? estimate.smoothed - round_trip
+                                                   : round_trip - estimate.smoothed);
+    estimate.deviation = (estimate.deviation * 3 + difference) / 4;
+    estimate.smoothed = (estimate.smoothed * 7 + round_trip) / 8;
+  }
+  ++estimate.samples;
+  auto timeout(estimate.smoothed + estimate.deviation * 4);
+  estimate.timeout = std::min(maximum_timeout_, std::max(minimum_timeout_, timeout));
+}
+
+void LatencyEstimator::BackOff(Estimate& estimate) const {
+  ++estimate.timeouts;
+  estimate.timeout = std::min(maximum_timeout_, Timeout(&estimate) * 2);
+}
+
+std::chrono::steady_clock::duration LatencyEstimator::Timeout(const Estimate* estimate) const {
+  // An estimate without samples or timeouts has no timeout set yet.
+  if (!estimate || estimate->timeout == std::chrono::steady_clock::duration::zero())
+    return initial_timeout_;
+  return estimate->timeout;
+}
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
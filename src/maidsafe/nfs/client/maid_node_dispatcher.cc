@@ -18,6 +18,8 @@
 
 #include "maidsafe/nfs/client/maid_node_dispatcher.h"
 
+#include <utility>
+
 namespace maidsafe {
 
 namespace nfs_client {
@@ -25,53 +27,73 @@ namespace nfs_client {
 MaidNodeDispatcher::MaidNodeDispatcher(routing::Routing& routing)
     : routing_(routing),
       kThisNodeAsSender_(routing_.kNodeId()),
-      kMaidManagerReceiver_(routing_.kNodeId()) {}
+      kMaidManagerReceiver_(routing_.kNodeId()),
+      maid_manager_batcher_() {}
+
+MaidNodeDispatcher::MaidNodeDispatcher(routing::Routing& routing, AsioService& asio_service,
+                                       const nfs::BatchParameters& batch_parameters)
+    : routing_(routing),
+      kThisNodeAsSender_(routing_.kNodeId()),
+      kMaidManagerReceiver_(routing_.kNodeId()),
+      maid_manager_batcher_() {
+  if (batch_parameters.window == std::chrono::steady_clock::duration::zero())
+    return;
+  maid_manager_batcher_.reset(new nfs::MessageBatcher(
+      asio_service, batch_parameters, [this](std::string serialised_messages) {
+        typedef routing::Message<routing::SingleSource, routing::GroupId> RoutingMessage;
+        routing_.Send(RoutingMessage(std::move(serialised_messages), kThisNodeAsSender_,
+                                     kMaidManagerReceiver_));
+      }));
+}
 
 void MaidNodeDispatcher::SendCreateAccountRequest(
-    routing::TaskId task_id,
+    nfs::TaskId task_id,
     const nfs_vault::AccountCreation& account_creation) {
   typedef nfs::CreateAccountRequestFromMaidNodeToMaidManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
-  typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
   NfsMessage nfs_message(nfs::MessageId(task_id), account_creation);
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  SendToMaidManager(nfs_message.Serialise());
 }
 
 void MaidNodeDispatcher::SendRemoveAccountRequest(
     const nfs_vault::AccountRemoval& account_removal) {
   typedef nfs::RemoveAccountRequestFromMaidNodeToMaidManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
-  typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
   NfsMessage nfs_message(account_removal);
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  SendToMaidManager(nfs_message.Serialise());
 }
 
 void MaidNodeDispatcher::SendRegisterPmidRequest(
-    routing::TaskId task_id,
+    nfs::TaskId task_id,
     const nfs_vault::PmidRegistration& pmid_registration) {
   typedef nfs::RegisterPmidRequestFromMaidNodeToMaidManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
   assert(!pmid_registration.unregister());
-  typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
   NfsMessage nfs_message(nfs::MessageId(task_id), pmid_registration);
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  SendToMaidManager(nfs_message.Serialise());
 }
 
 void MaidNodeDispatcher::SendUnregisterPmidRequest(const passport::PublicPmid::Name& pmid_name) {
   typedef nfs::UnregisterPmidRequestFromMaidNodeToMaidManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
-  typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
   NfsMessage nfs_message(nfs_vault::DataName(DataTagValue::kPmidValue, pmid_name.value));
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  SendToMaidManager(nfs_message.Serialise());
 }
 
-void MaidNodeDispatcher::SendPmidHealthRequest(routing::TaskId task_id,
+void MaidNodeDispatcher::SendPmidHealthRequest(nfs::TaskId task_id,
                                                const passport::PublicPmid::Name& pmid_name) {
   typedef nfs::PmidHealthRequestFromMaidNodeToMaidManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
-  typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
   NfsMessage nfs_message(nfs::MessageId(task_id), (nfs_vault::DataName(pmid_name)));
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  SendToMaidManager(nfs_message.Serialise());
+}
+
+void MaidNodeDispatcher::SendToMaidManager(std::string serialised_message) {
+  if (maid_manager_batcher_)
+    return maid_manager_batcher_->Add(std::move(serialised_message));
+  typedef routing::Message<routing::SingleSource, routing::GroupId> RoutingMessage;
+  routing_.Send(RoutingMessage(std::move(serialised_message), kThisNodeAsSender_,
+                               kMaidManagerReceiver_));
 }
 
 }  // namespace nfs_client
@@ -62,28 +62,29 @@ void CreateAccount(std::shared_ptr<passport::Maid> maid,
 }
 
 MaidNodeNfs::MaidNodeNfs(AsioService& asio_service, routing::Routing& routing,
-                         passport::PublicPmid::Name pmid_node_hint)
-    : get_timer_(asio_service),
-      put_timer_(asio_service),
-      get_versions_timer_(asio_service),
-      get_branch_timer_(asio_service),
-      create_account_timer_(asio_service),
-      pmid_health_timer_(asio_service),
-      create_version_tree_timer_(asio_service),
-      put_version_timer_(asio_service),
-      register_pmid_timer_(asio_service),
-      dispatcher_(routing),
+                         passport::PublicPmid::Name pmid_node_hint,
+                         const nfs::BatchParameters& batch_parameters,
+                         const DataCacheParameters& data_cache_parameters,
+                         const HedgeParameters& hedge_parameters)
+    : stopped_(false),
+      io_service_(asio_service.service()),
+      latency_estimator_(),
+      data_cache_(data_cache_parameters),
+      negative_cache_(data_cache_parameters.negative_time_to_lives),
+      version_cache_(data_cache_parameters.max_version_lists),
+      pending_operations_(asio_service),
+      dispatcher_(routing, asio_service, batch_parameters),
       service_([&]()->std::unique_ptr<MaidNodeService> {
         std::unique_ptr<MaidNodeService> service(
-            new MaidNodeService(routing, get_timer_, put_timer_, get_versions_timer_,
-                                get_branch_timer_, create_account_timer_, pmid_health_timer_,
-                                create_version_tree_timer_, put_version_timer_,
-                                register_pmid_timer_, get_handler_));
+            new MaidNodeService(routing, pending_operations_, get_handler_));
         return std::move(service);
       }()),
       pmid_node_hint_mutex_(),
       pmid_node_hint_(pmid_node_hint),
-      get_handler_(get_timer_, dispatcher_) {}
+      get_handler_(asio_service, pending_operations_, dispatcher_, data_cache_, negative_cache_,
+                   latency_estimator_, hedge_parameters) {}
+
+MaidNodeNfs::~MaidNodeNfs() { stopped_ = true; }
 
 passport::PublicPmid::Name MaidNodeNfs::pmid_node_hint() const {
   std::lock_guard<std::mutex> lock(pmid_node_hint_mutex_);
@@ -97,22 +98,26 @@ void MaidNodeNfs::set_pmid_node_hint(const passport::PublicPmid::Name& pmid_node
 
 boost::future<void> MaidNodeNfs::CreateAccount(
     const nfs_vault::AccountCreation& account_creation,
-    const std::chrono::steady_clock::duration& timeout) {
+    const std::chrono::steady_clock::duration& timeout,
+    const CancellationToken& cancellation_token) {
   typedef MaidNodeService::CreateAccountResponse::Contents ResponseContents;
   auto promise(std::make_shared<boost::promise<void>>());
-  auto response_functor([promise](const ResponseContents &result) {
-      HandleCreateAccountResult(result, promise);
+  auto cancellable(MakeCancellableOperation(cancellation_token));
+  auto response_functor([promise, cancellable](const ResponseContents &result) {
+      if (!cancellable || cancellable->Complete())
+        HandleCreateAccountResult(result, promise);
   });
   auto op_data(std::make_shared<nfs::OpData<ResponseContents>>(
       routing::Parameters::group_size - 1, response_functor));
-  auto task_id(create_account_timer_.NewTaskId());
-  create_account_timer_.AddTask(
+  auto task_id(pending_operations_.NewTaskId());
+  pending_operations_.AddTask<ResponseContents>(
       timeout, [op_data](ResponseContents create_account_response) {
                  op_data->HandleResponseContents(std::move(create_account_response));
                },
       // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
       routing::Parameters::group_size * 2, task_id);
-  dispatcher_.SendCreateAccountRequest(task_id, account_creation);
+  if (ArmCancellation(cancellable, task_id, promise))
+    dispatcher_.SendCreateAccountRequest(task_id, account_creation);
   return promise->get_future();
 }
 
@@ -122,22 +127,26 @@ void MaidNodeNfs::RemoveAccount(const nfs_vault::AccountRemoval& account_removal
 
 boost::future<void> MaidNodeNfs::RegisterPmid(
     const nfs_vault::PmidRegistration& pmid_registration,
-    const std::chrono::steady_clock::duration& timeout) {
+    const std::chrono::steady_clock::duration& timeout,
+    const CancellationToken& cancellation_token) {
   typedef MaidNodeService::RegisterPmidResponse::Contents ResponseContents;
   auto promise(std::make_shared<boost::promise<void>>());
-  auto response_functor([promise](const ResponseContents &result) {
-      HandleRegisterPmidResult(result, promise);
+  auto cancellable(MakeCancellableOperation(cancellation_token));
+  auto response_functor([promise, cancellable](const ResponseContents &result) {
+      if (!cancellable || cancellable->Complete())
+        HandleRegisterPmidResult(result, promise);
   });
   auto op_data(std::make_shared<nfs::OpData<ResponseContents>>(
       routing::Parameters::group_size - 1, response_functor));
-  auto task_id(create_account_timer_.NewTaskId());
-  register_pmid_timer_.AddTask(
+  auto task_id(pending_operations_.NewTaskId());
+  pending_operations_.AddTask<ResponseContents>(
       timeout, [op_data](ResponseContents create_account_response) {
                  op_data->HandleResponseContents(std::move(create_account_response));
                },
       // TODO(Mahmoud): Confirm expected count
       routing::Parameters::group_size - 1, task_id);
-  dispatcher_.SendRegisterPmidRequest(task_id, pmid_registration);
+  if (ArmCancellation(cancellable, task_id, promise))
+    dispatcher_.SendRegisterPmidRequest(task_id, pmid_registration);
   return promise->get_future();
 }
 
@@ -147,25 +156,40 @@ void MaidNodeNfs::UnregisterPmid(const passport::PublicPmid::Name& pmid_name) {
 
 MaidNodeNfs::PmidHealthFuture MaidNodeNfs::GetPmidHealth(
     const passport::PublicPmid::Name& pmid_name,
-    const std::chrono::steady_clock::duration& timeout) {
+    const std::chrono::steady_clock::duration& timeout,
+    const CancellationToken& cancellation_token) {
   typedef MaidNodeService::PmidHealthResponse::Contents ResponseContents;
   auto promise(std::make_shared<boost::promise<uint64_t>>());
-  auto response_functor([promise](const ResponseContents& result) {
-      HandlePmidHealthResult(result, promise);
+  auto cancellable(MakeCancellableOperation(cancellation_token));
+  auto response_functor([promise, cancellable](const ResponseContents& result) {
+      if (!cancellable || cancellable->Complete())
+        HandlePmidHealthResult(result, promise);
   });
   auto op_data(std::make_shared<nfs::OpData<ResponseContents>>(
       routing::Parameters::group_size - 1, response_functor));
-  auto task_id(pmid_health_timer_.NewTaskId());
-  pmid_health_timer_.AddTask(
+  auto task_id(pending_operations_.NewTaskId());
+  pending_operations_.AddTask<ResponseContents>(
       timeout, [op_data](ResponseContents pmid_health_response) {
                  op_data->HandleResponseContents(std::move(pmid_health_response));
                },
       // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
       routing::Parameters::group_size - 1, task_id);
-  dispatcher_.SendPmidHealthRequest(task_id, pmid_name);
+  if (ArmCancellation(cancellable, task_id, promise))
+    dispatcher_.SendPmidHealthRequest(task_id, pmid_name);
   return promise->get_future();
 }
 
+bool MaidNodeNfs::ArmCancellation(std::shared_ptr<CancellableOperation> cancellable,
+                                  nfs::TaskId task_id, std::function<void()> on_cancelled) {
+  if (!cancellable)
+    return true;
+  return cancellable->Arm([this, task_id, on_cancelled] {
+    // The task is expired as it's cancelled, and its response functor drops the result it's given.
+    pending_operations_.CancelTask(task_id);
+    on_cancelled();
+  });
+}
+
 }  // namespace nfs_client
 
 }  // namespace maidsafe
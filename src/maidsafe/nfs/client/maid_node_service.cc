@@ -34,36 +34,15 @@ std::error_code InvalidParameter() {
 
 }  // unnamed namespace
 
-MaidNodeService::MaidNodeService(
-    routing::Routing& routing, routing::Timer<MaidNodeService::GetResponse::Contents>& get_timer,
-    routing::Timer<MaidNodeService::PutResponse::Contents>& put_timer,
-    routing::Timer<MaidNodeService::GetVersionsResponse::Contents>& get_versions_timer,
-    routing::Timer<MaidNodeService::GetBranchResponse::Contents>& get_branch_timer,
-    routing::Timer<MaidNodeService::CreateAccountResponse::Contents>& create_account_timer,
-    routing::Timer<MaidNodeService::PmidHealthResponse::Contents>& pmid_health_timer,
-    routing::Timer<MaidNodeService::CreateVersionTreeResponse::Contents>& create_version_tree_timer,
-    routing::Timer<MaidNodeService::PutVersionResponse::Contents>& put_version_timer,
-    routing::Timer<MaidNodeService::RegisterPmidResponse::Contents>& register_pmid_timer,
-    GetHandler& get_handler)
-        : routing_(routing),
-          get_timer_(get_timer),
-          put_timer_(put_timer),
-          get_versions_timer_(get_versions_timer),
-          get_branch_timer_(get_branch_timer),
-          create_account_timer_(create_account_timer),
-          pmid_health_timer_(pmid_health_timer),
-          create_version_tree_timer_(create_version_tree_timer),
-          put_version_timer_(put_version_timer),
-          register_pmid_timer_(register_pmid_timer),
-          get_handler_(get_handler) {}
+MaidNodeService::MaidNodeService(routing::Routing& routing,
+                                 nfs::PendingOperations& pending_operations,
+                                 GetHandler& get_handler)
+    : routing_(routing), pending_operations_(pending_operations), get_handler_(get_handler) {}
 
 void MaidNodeService::HandleMessage(const GetResponse& message,
                                     const GetResponse::Sender& /*sender*/,
                                     const GetResponse::Receiver& receiver) {
-  LOG(kVerbose) << "MaidNodeService::HandleMessage GetResponse "
-                << HexSubstr(message.Serialise()) << " with content "
-                << HexSubstr(message.contents->Serialise());
-//   get_timer_.PrintTaskIds();
+  LOG(kVerbose) << "MaidNodeService::HandleMessage GetResponse " << message.id;
   try {
     if (receiver.data != routing_.kNodeId())
       return;
@@ -72,8 +51,13 @@ void MaidNodeService::HandleMessage(const GetResponse& message,
   }
   assert(receiver.data == routing_.kNodeId());
   static_cast<void>(receiver);
+  // Most group responses are redundant duplicates, so check the id before decoding the contents.
+  if (!get_handler_.HasPendingTask(nfs::GetTaskId(message.id))) {
+    LOG(kVerbose) << "Dropping unexpected or redundant response " << message.id;
+    return;
+  }
   try {
-    get_handler_.AddResponse(message.id.data, *message.contents);
+    get_handler_.AddResponse(nfs::GetTaskId(message.id), *message.contents);
   }
   catch (const maidsafe_error& error) {
     if (error.code() != InvalidParameter())
@@ -89,23 +73,13 @@ void MaidNodeService::HandleMessage(const PutResponse& message,
   LOG(kVerbose) << "MaidNodeService::HandleMessage PutResponse " << message.id;
   assert(receiver.data == routing_.kNodeId());
   static_cast<void>(receiver);
-  try {
-    put_timer_.AddResponse(message.id.data, *message.contents);
-  }
-  catch (const maidsafe_error& error) {
-    if (error.code() != InvalidParameter())
-      throw;
-    else
-      LOG(kWarning) << "Timer does not expect:" << message.id.data;
-  }
+  AddResponse(message);
 }
 
 void MaidNodeService::HandleMessage(const GetCachedResponse& message,
                                     const GetCachedResponse::Sender& /*sender*/,
                                     const GetCachedResponse::Receiver& receiver) {
-  LOG(kVerbose) << "MaidNodeService::HandleMessage GetCachedResponse "
-                << HexSubstr(message.Serialise()) << " with content "
-                << HexSubstr(message.contents->Serialise());
+  LOG(kVerbose) << "MaidNodeService::HandleMessage GetCachedResponse " << message.id;
   try {
     if (receiver.data != routing_.kNodeId())
       return;
@@ -114,8 +88,13 @@ void MaidNodeService::HandleMessage(const GetCachedResponse& message,
   }
   assert(receiver.data == routing_.kNodeId());
   static_cast<void>(receiver);
+  // Most group responses are redundant duplicates, so check the id before decoding the contents.
+  if (!get_handler_.HasPendingTask(nfs::GetTaskId(message.id))) {
+    LOG(kVerbose) << "Dropping unexpected or redundant response " << message.id;
+    return;
+  }
   try {
-    get_handler_.AddResponse(message.id.data, *message.contents);
+    get_handler_.AddResponse(nfs::GetTaskId(message.id), *message.contents);
   }
   catch (const maidsafe_error& error) {
     if (error.code() != InvalidParameter())
@@ -144,30 +123,14 @@ void MaidNodeService::HandleMessage(const GetVersionsResponse& message,
   }
   assert(receiver.data == routing_.kNodeId());
   static_cast<void>(receiver);
-  try {
-    get_versions_timer_.AddResponse(message.id.data, *message.contents);
-  }
-  catch (const maidsafe_error& error) {
-    if (error.code() != InvalidParameter())
-      throw;
-    else
-      LOG(kWarning) << "Timer does not expect:" << message.id.data;
-  }
+  AddResponse(message);
 }
 
 void MaidNodeService::HandleMessage(const PutVersionResponse& message,
                                     const PutVersionResponse::Sender& /*sender*/,
                                     const PutVersionResponse::Receiver& /*receiver*/) {
   LOG(kInfo) << "Get response for PutVersion";
-  try {
-    put_version_timer_.AddResponse(message.id.data, *message.contents);
-  }
-  catch (const maidsafe_error& error) {
-    if (error.code() != InvalidParameter())
-      throw;
-    else
-      LOG(kWarning) << "Timer does not expect:" << message.id.data;
-  }
+  AddResponse(message);
 }
 
 void MaidNodeService::HandleMessage(const GetBranchResponse& message,
@@ -181,75 +144,35 @@ void MaidNodeService::HandleMessage(const GetBranchResponse& message,
   }
   assert(receiver.data == routing_.kNodeId());
   static_cast<void>(receiver);
-  try {
-    get_branch_timer_.AddResponse(message.id.data, *message.contents);
-  }
-  catch (const maidsafe_error& error) {
-    if (error.code() != InvalidParameter())
-      throw;
-    else
-      LOG(kWarning) << "Timer does not expect:" << message.id.data;
-  }
+  AddResponse(message);
 }
 
 void MaidNodeService::HandleMessage(const PmidHealthResponse& message,
                                     const PmidHealthResponse::Sender& /*sender*/,
                                     const PmidHealthResponse::Receiver& /*receiver*/) {
   LOG(kInfo) << "Get response for PmidHealth";
-  try {
-    pmid_health_timer_.AddResponse(message.id.data, *message.contents);
-  }
-  catch (const maidsafe_error& error) {
-    if (error.code() != InvalidParameter())
-      throw;
-    else
-      LOG(kWarning) << "Timer does not expect:" << message.id.data;
-  }
+  AddResponse(message);
 }
 
 void MaidNodeService::HandleMessage(const CreateAccountResponse& message,
                                     const CreateAccountResponse::Sender& /*sender*/,
                                     const CreateAccountResponse::Receiver& /*receiver*/) {
   LOG(kInfo) << "Get response for CreateAccount";
-  try {
-    create_account_timer_.AddResponse(message.id.data, *message.contents);
-  }
-  catch (const maidsafe_error& error) {
-    if (error.code() != InvalidParameter())
-      throw;
-    else
-      LOG(kWarning) << "Timer does not expect:" << message.id.data;
-  }
+  AddResponse(message);
 }
 
 void MaidNodeService::HandleMessage(const CreateVersionTreeResponse& message,
                                     const CreateVersionTreeResponse::Sender& /*sender*/,
                                     const CreateVersionTreeResponse::Receiver& /*receiver*/) {
   LOG(kInfo) << "Get response for CreateVersionTree";
-  try {
-    create_version_tree_timer_.AddResponse(message.id.data, *message.contents);
-  }
-  catch (const maidsafe_error& error) {
-    if (error.code() != InvalidParameter())
-      throw;
-    else
-      LOG(kWarning) << "Timer does not expect:" << message.id.data;
-  }
+  AddResponse(message);
 }
 
 void MaidNodeService::HandleMessage(const RegisterPmidResponse& message,
                                     const RegisterPmidResponse::Sender& /*sender*/,
                                     const RegisterPmidResponse::Receiver& /*receiver*/) {
   LOG(kInfo) << "Get response for RegisterPmid";
-  try {
-    register_pmid_timer_.AddResponse(message.id.data, *message.contents);
-  }
-  catch (const maidsafe_error& error) {
-    if (error.code() != InvalidParameter())
-      throw;
-    else
-      LOG(kWarning) << "Timer does not expect:" << message.id.data;
-  }
+  AddResponse(message);
 }
 
 }  // namespace nfs_client
@@ -19,8 +19,12 @@
 #include "maidsafe/nfs/client/messages.h"
 
 #include <cstdint>
+#include <string>
+#include <system_error>
 
+#include "maidsafe/nfs/scratch_protobuf.h"
 #include "maidsafe/nfs/utils.h"
+#include "maidsafe/nfs/wire_format.h"
 #include "maidsafe/nfs/client/messages.pb.h"
 
 namespace maidsafe {
@@ -29,24 +33,47 @@ namespace nfs_client {
 
 namespace {
 
-maidsafe_error GetError(int error_value, const std::string& error_category_name) {
-  if (error_category_name == std::string(GetCommonCategory().name()))
-    return MakeError(static_cast<CommonErrors>(error_value));
-  if (error_category_name == std::string(GetAsymmCategory().name()))
-    return MakeError(static_cast<AsymmErrors>(error_value));
-  if (error_category_name == std::string(GetPassportCategory().name()))
-    return MakeError(static_cast<PassportErrors>(error_value));
-  if (error_category_name == std::string(GetNfsCategory().name()))
-    return MakeError(static_cast<NfsErrors>(error_value));
-  if (error_category_name == std::string(GetRoutingCategory().name()))
-    return MakeError(static_cast<RoutingErrors>(error_value));
-  if (error_category_name == std::string(GetDriveCategory().name()))
-    return MakeError(static_cast<DriveErrors>(error_value));
-  if (error_category_name == std::string(GetVaultCategory().name()))
-    return MakeError(static_cast<VaultErrors>(error_value));
-  if (error_category_name == std::string(GetApiCategory().name()))
-    return MakeError(static_cast<ApiErrors>(error_value));
+// Field numbers from protobuf::DataNameAndContentOrReturnCode.
+const uint32_t kSerialisedNameField(1), kContentField(2), kSerialisedReturnCodeField(3);
+
+// Interned ids of the error categories which may appear in a ReturnCode.  These are part of the
+// wire format, so entries must only ever be appended.
+typedef const std::error_category& (*ErrorCategoryGetter)();
+const ErrorCategoryGetter kErrorCategories[] = { &GetCommonCategory, &GetAsymmCategory,
+                                                 &GetPassportCategory, &GetNfsCategory,
+                                                 &GetRoutingCategory, &GetDriveCategory,
+                                                 &GetVaultCategory, &GetApiCategory };
+const int kErrorCategoryCount(static_cast<int>(sizeof(kErrorCategories) /
+                                               sizeof(kErrorCategories[0])));
+
+// Returns 0 for a category which isn't interned, which is then sent by name instead.
+int GetErrorCategoryId(const std::error_category& category) {
+  for (int index(0); index < kErrorCategoryCount; ++index) {
+    if (category == kErrorCategories[index]())
+      return index + 1;
+  }
+  return 0;
+}
+
+const std::error_category& GetErrorCategory(int error_category_id) {
+  if (error_category_id < 1 || error_category_id > kErrorCategoryCount) {
+    LOG(kError) << "ReturnCode has unknown error category id " << error_category_id;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  return kErrorCategories[error_category_id - 1]();
+}
 
+const std::error_category& GetErrorCategory(const std::string& error_category_name) {
+  for (const auto& category : kErrorCategories) {
+    if (error_category_name == category().name())
+      return category();
+  }
+  // The standard categories aren't interned, but are known to every peer.
+  if (error_category_name == std::generic_category().name())
+    return std::generic_category();
+  if (error_category_name == std::system_category().name())
+    return std::system_category();
+  LOG(kError) << "ReturnCode has unknown error category " << error_category_name;
   BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
 }
 
@@ -55,34 +82,34 @@ maidsafe_error GetError(int error_value, const std::string& error_category_name)
 // ==================== ReturnCode =================================================================
 ReturnCode::ReturnCode() : value(CommonErrors::success) {}
 
-ReturnCode::ReturnCode(const ReturnCode& other) : value(other.value) {}
-
-ReturnCode::ReturnCode(ReturnCode&& other) : value(std::move(other.value)) {}
-
-ReturnCode& ReturnCode::operator=(ReturnCode other) {
-  swap(*this, other);
-  return *this;
+ReturnCode::ReturnCode(const std::string& serialised_copy) : value() {
+  nfs::detail::ScratchProtobuf<protobuf::ReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy)) {
+    LOG(kError) << "ReturnCode parsing error";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  value = std::error_code(proto_copy->error_value(),
+                          proto_copy->has_error_category_name() ?
+                              GetErrorCategory(proto_copy->error_category_name()) :
+                              GetErrorCategory(proto_copy->error_category_id()));
 }
 
-ReturnCode::ReturnCode(const std::string& serialised_copy)
-    : value([&serialised_copy] {
-        protobuf::ReturnCode proto_copy;
-        if (!proto_copy.ParseFromString(serialised_copy)) {
-          LOG(kError) << "ReturnCode parsing error";
-          BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-        }
-        return GetError(proto_copy.error_value(), proto_copy.error_category_name());
-      }()) {}
-
 std::string ReturnCode::Serialise() const {
-  protobuf::ReturnCode proto_copy;
-  proto_copy.set_error_value(value.code().value());
-  proto_copy.set_error_category_name(value.code().category().name());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::ReturnCode> proto_copy;
+  if (value.value() != proto_copy->error_value())
+    proto_copy->set_error_value(value.value());
+  auto error_category_id(GetErrorCategoryId(value.category()));
+  if (error_category_id == 0)
+    proto_copy->set_error_category_name(value.category().name());
+  else if (error_category_id != proto_copy->error_category_id())
+    proto_copy->set_error_category_id(error_category_id);
+  return proto_copy->SerializeAsString();
 }
 
+maidsafe_error ReturnCode::error() const { return maidsafe_error(value); }
+
 bool operator==(const ReturnCode& lhs, const ReturnCode& rhs) {
-  return lhs.value.code() == rhs.value.code();
+  return lhs.value == rhs.value;
 }
 
 void swap(ReturnCode& lhs, ReturnCode& rhs) MAIDSAFE_NOEXCEPT {
@@ -111,20 +138,20 @@ AvailableSizeAndReturnCode& AvailableSizeAndReturnCode::operator=(
 
 AvailableSizeAndReturnCode::AvailableSizeAndReturnCode(const std::string& serialised_copy)
     : available_size(0), return_code() {
-  protobuf::AvailableSizeAndReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy)) {
+  nfs::detail::ScratchProtobuf<protobuf::AvailableSizeAndReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy)) {
     LOG(kError) << "can't parse AvailableSizeAndReturnCode from incoming string";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
   }
-  available_size = nfs_vault::AvailableSize(proto_copy.serialised_available_size());
-  return_code = ReturnCode(proto_copy.serialised_return_code());
+  available_size = nfs_vault::AvailableSize(proto_copy->serialised_available_size());
+  return_code = ReturnCode(proto_copy->serialised_return_code());
 }
 
 std::string AvailableSizeAndReturnCode::Serialise() const {
-  protobuf::AvailableSizeAndReturnCode proto_copy;
-  proto_copy.set_serialised_available_size(available_size.Serialise());
-  proto_copy.set_serialised_return_code(return_code.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::AvailableSizeAndReturnCode> proto_copy;
+  proto_copy->set_serialised_available_size(available_size.Serialise());
+  proto_copy->set_serialised_return_code(return_code.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const AvailableSizeAndReturnCode& lhs, const AvailableSizeAndReturnCode& rhs) {
@@ -156,18 +183,18 @@ DataNameAndReturnCode& DataNameAndReturnCode::operator=(DataNameAndReturnCode ot
 
 DataNameAndReturnCode::DataNameAndReturnCode(const std::string& serialised_copy)
     : name(), return_code() {
-  protobuf::DataNameAndReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataNameAndReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  name = nfs_vault::DataName(proto_copy.serialised_name());
-  return_code = ReturnCode(proto_copy.serialised_return_code());
+  name = nfs_vault::DataName(proto_copy->serialised_name());
+  return_code = ReturnCode(proto_copy->serialised_return_code());
 }
 
 std::string DataNameAndReturnCode::Serialise() const {
-  protobuf::DataNameAndReturnCode proto_copy;
-  proto_copy.set_serialised_name(name.Serialise());
-  proto_copy.set_serialised_return_code(return_code.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::DataNameAndReturnCode> proto_copy;
+  proto_copy->set_serialised_name(name.Serialise());
+  proto_copy->set_serialised_return_code(return_code.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataNameAndReturnCode& lhs, const DataNameAndReturnCode& rhs) {
@@ -211,22 +238,22 @@ void DataNamesAndReturnCode::AddDataName(const DataTagValue& tag_value, const Id
 DataNamesAndReturnCode::DataNamesAndReturnCode(const std::string& serialised_copy)
     : names(),
       return_code() {
-  protobuf::DataNamesAndReturnCode names_proto;
-  if (!names_proto.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataNamesAndReturnCode> names_proto;
+  if (!names_proto->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  for (auto index(0); index < names_proto.serialised_name_size(); ++index)
-    names.insert(nfs_vault::DataName(std::string(names_proto.serialised_name(index))));
-  return_code = nfs_client::ReturnCode(names_proto.serialised_return_code());
+  for (auto index(0); index < names_proto->serialised_name_size(); ++index)
+    names.insert(nfs_vault::DataName(std::string(names_proto->serialised_name(index))));
+  return_code = nfs_client::ReturnCode(names_proto->serialised_return_code());
 }
 
 std::string DataNamesAndReturnCode::Serialise() const {
-  protobuf::DataNamesAndReturnCode names_proto;
-  names_proto.set_serialised_return_code(return_code.Serialise());
+  nfs::detail::ScratchProtobuf<protobuf::DataNamesAndReturnCode> names_proto;
+  names_proto->set_serialised_return_code(return_code.Serialise());
   for (const auto& name : names) {
-    auto name_proto(names_proto.add_serialised_name());
+    auto name_proto(names_proto->add_serialised_name());
     *name_proto = name.Serialise();
   }
-  return names_proto.SerializeAsString();
+  return names_proto->SerializeAsString();
 }
 
 bool operator==(const DataNamesAndReturnCode& lhs, const DataNamesAndReturnCode& rhs) {
@@ -259,19 +286,19 @@ DataNameVersionAndReturnCode& DataNameVersionAndReturnCode::operator=(
 
 DataNameVersionAndReturnCode::DataNameVersionAndReturnCode(const std::string& serialised_copy)
     : data_name_and_version(), return_code() {
-  protobuf::DataNameVersionAndReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataNameVersionAndReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
   data_name_and_version =
-      nfs_vault::DataNameAndVersion(proto_copy.serialised_data_name_and_version());
-  return_code = ReturnCode(proto_copy.serialised_return_code());
+      nfs_vault::DataNameAndVersion(proto_copy->serialised_data_name_and_version());
+  return_code = ReturnCode(proto_copy->serialised_return_code());
 }
 
 std::string DataNameVersionAndReturnCode::Serialise() const {
-  protobuf::DataNameVersionAndReturnCode proto_copy;
-  proto_copy.set_serialised_data_name_and_version(data_name_and_version.Serialise());
-  proto_copy.set_serialised_return_code(return_code.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::DataNameVersionAndReturnCode> proto_copy;
+  proto_copy->set_serialised_data_name_and_version(data_name_and_version.Serialise());
+  proto_copy->set_serialised_return_code(return_code.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataNameVersionAndReturnCode& lhs, const DataNameVersionAndReturnCode& rhs) {
@@ -307,19 +334,19 @@ DataNameOldNewVersionAndReturnCode& DataNameOldNewVersionAndReturnCode::operator
 DataNameOldNewVersionAndReturnCode::DataNameOldNewVersionAndReturnCode(
     const std::string& serialised_copy)
     : data_name_old_new_version(), return_code() {
-  protobuf::DataNameOldNewVersionAndReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataNameOldNewVersionAndReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
   data_name_old_new_version =
-      nfs_vault::DataNameOldNewVersion(proto_copy.serialised_data_name_old_new_version());
-  return_code = ReturnCode(proto_copy.serialised_return_code());
+      nfs_vault::DataNameOldNewVersion(proto_copy->serialised_data_name_old_new_version());
+  return_code = ReturnCode(proto_copy->serialised_return_code());
 }
 
 std::string DataNameOldNewVersionAndReturnCode::Serialise() const {
-  protobuf::DataNameOldNewVersionAndReturnCode proto_copy;
-  proto_copy.set_serialised_data_name_old_new_version(data_name_old_new_version.Serialise());
-  proto_copy.set_serialised_return_code(return_code.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::DataNameOldNewVersionAndReturnCode> proto_copy;
+  proto_copy->set_serialised_data_name_old_new_version(data_name_old_new_version.Serialise());
+  proto_copy->set_serialised_return_code(return_code.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataNameOldNewVersionAndReturnCode& lhs,
@@ -350,18 +377,18 @@ DataAndReturnCode& DataAndReturnCode::operator=(DataAndReturnCode other) {
 }
 
 DataAndReturnCode::DataAndReturnCode(const std::string& serialised_copy) : data(), return_code() {
-  protobuf::DataAndReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataAndReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  data = nfs_vault::DataNameAndContent(proto_copy.serialised_data_name_and_content());
-  return_code = ReturnCode(proto_copy.serialised_return_code());
+  data = nfs_vault::DataNameAndContent(proto_copy->serialised_data_name_and_content());
+  return_code = ReturnCode(proto_copy->serialised_return_code());
 }
 
 std::string DataAndReturnCode::Serialise() const {
-  protobuf::DataAndReturnCode proto_copy;
-  proto_copy.set_serialised_data_name_and_content(data.Serialise());
-  proto_copy.set_serialised_return_code(return_code.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::DataAndReturnCode> proto_copy;
+  proto_copy->set_serialised_data_name_and_content(data.Serialise());
+  proto_copy->set_serialised_return_code(return_code.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataAndReturnCode& lhs, const DataAndReturnCode& rhs) {
@@ -400,16 +427,16 @@ DataNameAndContentOrReturnCode& DataNameAndContentOrReturnCode::operator=(
 
 DataNameAndContentOrReturnCode::DataNameAndContentOrReturnCode(const std::string& serialised_copy)
     : name(), content(), return_code() {
-  protobuf::DataNameAndContentOrReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataNameAndContentOrReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
 
-  name = nfs_vault::DataName(proto_copy.serialised_name());
+  name = nfs_vault::DataName(proto_copy->serialised_name());
 
-  if (proto_copy.has_content())
-    content.reset(nfs_vault::Content(proto_copy.content()));
-  if (proto_copy.has_serialised_return_code()) {
-    return_code.reset(ReturnCode(proto_copy.serialised_return_code()));
+  if (proto_copy->has_content())
+    content.reset(nfs_vault::Content(proto_copy->content()));
+  if (proto_copy->has_serialised_return_code()) {
+    return_code.reset(ReturnCode(proto_copy->serialised_return_code()));
   }
   if (!nfs::CheckMutuallyExclusive(content, return_code)) {
     assert(false);
@@ -418,18 +445,9 @@ DataNameAndContentOrReturnCode::DataNameAndContentOrReturnCode(const std::string
 }
 
 std::string DataNameAndContentOrReturnCode::Serialise() const {
-  if (!nfs::CheckMutuallyExclusive(content, return_code)) {
-    assert(false);
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::serialisation_error));
-  }
-  protobuf::DataNameAndContentOrReturnCode proto_copy;
-
-  proto_copy.set_serialised_name(name.Serialise());
-  if (content)
-    proto_copy.set_content(content->Serialise());
-  else
-    proto_copy.set_serialised_return_code(return_code->Serialise());
-  return proto_copy.SerializeAsString();
+  std::string serialised;
+  AppendSerialised(*this, serialised);
+  return serialised;
 }
 
 bool operator==(const DataNameAndContentOrReturnCode& lhs,
@@ -452,6 +470,53 @@ void swap(DataNameAndContentOrReturnCode& lhs,
   swap(lhs.return_code, rhs.return_code);
 }
 
+// Produces exactly the same bytes as protobuf::DataNameAndContentOrReturnCode::SerializeAsString.
+void AppendSerialised(const DataNameAndContentOrReturnCode& data_name_and_content_or_return_code,
+                      std::string& output) {
+  const auto& response(data_name_and_content_or_return_code);
+  if (!nfs::CheckMutuallyExclusive(response.content, response.return_code)) {
+    assert(false);
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::serialisation_error));
+  }
+  auto serialised_name(response.name.Serialise());
+  if (response.content) {
+    output.reserve(
+        output.size() +
+        nfs::detail::LengthDelimitedFieldSize(kSerialisedNameField, serialised_name.size()) +
+        nfs::detail::LengthDelimitedFieldSize(kContentField, response.content->data.size()));
+    nfs::detail::AppendLengthDelimitedField(kSerialisedNameField, serialised_name, output);
+    nfs::detail::AppendLengthDelimitedField(kContentField, response.content->data, output);
+  } else {
+    nfs::detail::AppendLengthDelimitedField(kSerialisedNameField, serialised_name, output);
+    nfs::detail::AppendLengthDelimitedField(kSerialisedReturnCodeField,
+                                            response.return_code->Serialise(), output);
+  }
+}
+
+DataNameAndContentOrReturnCode ParseContents(const nfs::SharedBuffer& serialised_contents,
+                                             DataNameAndContentOrReturnCode* /*tag*/) {
+  nfs::detail::FieldView fields[kSerialisedReturnCodeField + 1];
+  nfs::detail::ParseLengthDelimitedFields(serialised_contents.data(), serialised_contents.size(),
+                                          fields, kSerialisedReturnCodeField + 1);
+  if (!fields[kSerialisedNameField].present())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+
+  DataNameAndContentOrReturnCode response;
+  response.name = nfs_vault::DataName(fields[kSerialisedNameField].string());
+  if (fields[kContentField].present()) {
+    // Copy the payload straight from the received buffer into its final location.
+    response.content = nfs_vault::Content();
+    response.content->data.assign(fields[kContentField].data, fields[kContentField].size);
+  }
+  if (fields[kSerialisedReturnCodeField].present())
+    response.return_code.reset(ReturnCode(fields[kSerialisedReturnCodeField].string()));
+  if (!nfs::CheckMutuallyExclusive(response.content, response.return_code)) {
+    assert(false);
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  return response;
+}
+
 // ==================== StructuredDataNameAndContentOrReturnCode ===================================
 StructuredDataNameAndContentOrReturnCode::StructuredDataNameAndContentOrReturnCode()
     : structured_data(), data_name_and_return_code() {}
@@ -475,15 +540,15 @@ StructuredDataNameAndContentOrReturnCode& StructuredDataNameAndContentOrReturnCo
 StructuredDataNameAndContentOrReturnCode::StructuredDataNameAndContentOrReturnCode(
     const std::string& serialised_copy)
     : structured_data(), data_name_and_return_code() {
-  protobuf::StructuredDataNameAndContentOrReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::StructuredDataNameAndContentOrReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
 
-  if (proto_copy.has_serialised_structured_data())
-    structured_data.reset(StructuredData(proto_copy.serialised_structured_data()));
-  if (proto_copy.has_serialised_data_name_and_return_code()) {
+  if (proto_copy->has_serialised_structured_data())
+    structured_data.reset(StructuredData(proto_copy->serialised_structured_data()));
+  if (proto_copy->has_serialised_data_name_and_return_code()) {
     data_name_and_return_code.reset(
-        DataNameAndReturnCode(proto_copy.serialised_data_name_and_return_code()));
+        DataNameAndReturnCode(proto_copy->serialised_data_name_and_return_code()));
   }
   if (!nfs::CheckMutuallyExclusive(structured_data, data_name_and_return_code)) {
     assert(false);
@@ -496,13 +561,13 @@ std::string StructuredDataNameAndContentOrReturnCode::Serialise() const {
     assert(false);
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::serialisation_error));
   }
-  protobuf::StructuredDataNameAndContentOrReturnCode proto_copy;
+  nfs::detail::ScratchProtobuf<protobuf::StructuredDataNameAndContentOrReturnCode> proto_copy;
 
   if (structured_data)
-    proto_copy.set_serialised_structured_data(structured_data->Serialise());
+    proto_copy->set_serialised_structured_data(structured_data->Serialise());
   else
-    proto_copy.set_serialised_data_name_and_return_code(data_name_and_return_code->Serialise());
-  return proto_copy.SerializeAsString();
+    proto_copy->set_serialised_data_name_and_return_code(data_name_and_return_code->Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const StructuredDataNameAndContentOrReturnCode& lhs,
@@ -541,26 +606,26 @@ TipOfTreeAndReturnCode& TipOfTreeAndReturnCode::operator=(TipOfTreeAndReturnCode
 }
 
 TipOfTreeAndReturnCode::TipOfTreeAndReturnCode(const std::string& serialised_copy) {
-  protobuf::TipOfTreeAndReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::TipOfTreeAndReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
 
-  if (proto_copy.has_serialised_tip_of_tree()) {
+  if (proto_copy->has_serialised_tip_of_tree()) {
     tip_of_tree.reset(StructuredDataVersions::VersionName(
-                          proto_copy.serialised_tip_of_tree()));
+                          proto_copy->serialised_tip_of_tree()));
   }
 
-  return_code = ReturnCode(proto_copy.serialised_return_code());
+  return_code = ReturnCode(proto_copy->serialised_return_code());
 }
 
 std::string TipOfTreeAndReturnCode::Serialise() const {
-  protobuf::TipOfTreeAndReturnCode proto_copy;
+  nfs::detail::ScratchProtobuf<protobuf::TipOfTreeAndReturnCode> proto_copy;
 
   if (tip_of_tree)
-    proto_copy.set_serialised_tip_of_tree(tip_of_tree->Serialise());
+    proto_copy->set_serialised_tip_of_tree(tip_of_tree->Serialise());
 
-  proto_copy.set_serialised_return_code(return_code.Serialise());
-  return proto_copy.SerializeAsString();
+  proto_copy->set_serialised_return_code(return_code.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const TipOfTreeAndReturnCode& lhs, const TipOfTreeAndReturnCode& rhs) {
@@ -596,18 +661,18 @@ DataPmidHintAndReturnCode& DataPmidHintAndReturnCode::operator=(DataPmidHintAndR
 
 DataPmidHintAndReturnCode::DataPmidHintAndReturnCode(const std::string& serialised_copy)
     : data_and_pmid_hint(), return_code() {
-  protobuf::DataPmidHintAndReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataPmidHintAndReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  data_and_pmid_hint = nfs_vault::DataAndPmidHint(proto_copy.serialised_data_and_pmid_hint());
-  return_code = ReturnCode(proto_copy.serialised_return_code());
+  data_and_pmid_hint = nfs_vault::DataAndPmidHint(proto_copy->serialised_data_and_pmid_hint());
+  return_code = ReturnCode(proto_copy->serialised_return_code());
 }
 
 std::string DataPmidHintAndReturnCode::Serialise() const {
-  protobuf::DataPmidHintAndReturnCode proto_copy;
-  proto_copy.set_serialised_data_and_pmid_hint(data_and_pmid_hint.Serialise());
-  proto_copy.set_serialised_return_code(return_code.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::DataPmidHintAndReturnCode> proto_copy;
+  proto_copy->set_serialised_data_and_pmid_hint(data_and_pmid_hint.Serialise());
+  proto_copy->set_serialised_return_code(return_code.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataPmidHintAndReturnCode& lhs, const DataPmidHintAndReturnCode& rhs) {
@@ -644,18 +709,18 @@ PmidRegistrationAndReturnCode& PmidRegistrationAndReturnCode::operator=(
 
 PmidRegistrationAndReturnCode::PmidRegistrationAndReturnCode(const std::string& serialised_copy)
     : pmid_registration(), return_code() {
-  protobuf::PmidRegistrationAndReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::PmidRegistrationAndReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  pmid_registration = nfs_vault::PmidRegistration(proto_copy.serialised_pmid_registration());
-  return_code = ReturnCode(proto_copy.serialised_return_code());
+  pmid_registration = nfs_vault::PmidRegistration(proto_copy->serialised_pmid_registration());
+  return_code = ReturnCode(proto_copy->serialised_return_code());
 }
 
 std::string PmidRegistrationAndReturnCode::Serialise() const {
-  protobuf::PmidRegistrationAndReturnCode proto_copy;
-  proto_copy.set_serialised_pmid_registration(pmid_registration.Serialise());
-  proto_copy.set_serialised_return_code(return_code.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::PmidRegistrationAndReturnCode> proto_copy;
+  proto_copy->set_serialised_pmid_registration(pmid_registration.Serialise());
+  proto_copy->set_serialised_return_code(return_code.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const PmidRegistrationAndReturnCode& lhs,
@@ -692,21 +757,21 @@ DataNameAndSpaceAndReturnCode::DataNameAndSpaceAndReturnCode(DataNameAndSpaceAnd
       return_code(std::move(other.return_code)) {}
 
 DataNameAndSpaceAndReturnCode::DataNameAndSpaceAndReturnCode(const std::string& serialised_copy) {
-  protobuf::DataNameAndSpaceAndReturnCode proto;
-  if (!proto.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataNameAndSpaceAndReturnCode> proto;
+  if (!proto->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
 
-  name = nfs_vault::DataName(proto.serialised_name());
-  available_space = proto.space();
-  return_code = nfs_client::ReturnCode(proto.serialised_return_code());
+  name = nfs_vault::DataName(proto->serialised_name());
+  available_space = proto->space();
+  return_code = nfs_client::ReturnCode(proto->serialised_return_code());
 }
 
 std::string DataNameAndSpaceAndReturnCode::Serialise() const {
-  protobuf::DataNameAndSpaceAndReturnCode proto_copy;
-  proto_copy.set_serialised_name(name.Serialise());
-  proto_copy.set_space(available_space);
-  proto_copy.set_serialised_return_code(return_code.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::DataNameAndSpaceAndReturnCode> proto_copy;
+  proto_copy->set_serialised_name(name.Serialise());
+  proto_copy->set_space(available_space);
+  proto_copy->set_serialised_return_code(return_code.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 DataNameAndSpaceAndReturnCode& DataNameAndSpaceAndReturnCode::operator=(
@@ -736,21 +801,21 @@ PmidHealthAndReturnCode::PmidHealthAndReturnCode(const nfs_vault::PmidHealth& pm
   LOG(kVerbose) << "PmidHealthAndReturnCode pmid_health.serialised_pmid_health : "
                 << HexSubstr(pmid_health.serialised_pmid_health)
                 << " pmid_health.Serialise() " << HexSubstr(pmid_health.Serialise())
-                << " return_code : " << return_code.value.what();
+                << " return_code : " << return_code.value.message();
 }
 
 PmidHealthAndReturnCode::PmidHealthAndReturnCode(const std::string& serialised_copy) {
-  protobuf::PmidHealthAndReturnCode pmid_health_proto;
-  if (!pmid_health_proto.ParseFromString(serialised_copy)) {
+  nfs::detail::ScratchProtobuf<protobuf::PmidHealthAndReturnCode> pmid_health_proto;
+  if (!pmid_health_proto->ParseFromString(serialised_copy)) {
     LOG(kError) << "PmidHealthAndReturnCode can't parse from string " << HexSubstr(serialised_copy);
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
   }
-  pmid_health = nfs_vault::PmidHealth(pmid_health_proto.serialised_pmid_health());
-  return_code = ReturnCode(pmid_health_proto.serialised_return_code());
+  pmid_health = nfs_vault::PmidHealth(pmid_health_proto->serialised_pmid_health());
+  return_code = ReturnCode(pmid_health_proto->serialised_return_code());
   LOG(kVerbose) << "PmidHealthAndReturnCode from string, pmid_health.serialised_pmid_health : "
                 << HexSubstr(pmid_health.serialised_pmid_health)
                 << " pmid_health.Serialise() " << HexSubstr(pmid_health.Serialise())
-                << " return_code : " << return_code.value.what();
+                << " return_code : " << return_code.value.message();
 }
 
 PmidHealthAndReturnCode::PmidHealthAndReturnCode(const PmidHealthAndReturnCode& other)
@@ -766,10 +831,10 @@ PmidHealthAndReturnCode& PmidHealthAndReturnCode::operator=(PmidHealthAndReturnC
   return *this;
 }
 std::string PmidHealthAndReturnCode::Serialise() const {
-  protobuf::PmidHealthAndReturnCode pmid_health_proto;
-  pmid_health_proto.set_serialised_pmid_health(pmid_health.Serialise());
-  pmid_health_proto.set_serialised_return_code(return_code.Serialise());
-  std::string serialised_copy(pmid_health_proto.SerializeAsString());
+  nfs::detail::ScratchProtobuf<protobuf::PmidHealthAndReturnCode> pmid_health_proto;
+  pmid_health_proto->set_serialised_pmid_health(pmid_health.Serialise());
+  pmid_health_proto->set_serialised_return_code(return_code.Serialise());
+  std::string serialised_copy(pmid_health_proto->SerializeAsString());
   LOG(kVerbose) << "PmidHealthAndReturnCode serialised as " << HexSubstr(serialised_copy);
   return serialised_copy;
 }
@@ -790,13 +855,12 @@ namespace nfs {
 
 template <>
 bool IsSuccess<nfs_client::ReturnCode>(const nfs_client::ReturnCode& response) {
-  LOG(kVerbose) << "IsSuccess<nfs_client::ReturnCode> return_code " << response.value.what();
-  return response.value.code().value() == static_cast<int>(CommonErrors::success);
+  return response.value.value() == static_cast<int>(CommonErrors::success);
 }
 
 template <>
 std::error_code ErrorCode<nfs_client::ReturnCode>(const nfs_client::ReturnCode& response) {
-  return response.value.code();
+  return response.value;
 }
 
 template <>
@@ -809,7 +873,7 @@ bool IsSuccess<nfs_client::DataNameAndContentOrReturnCode>(
     if (response.return_code) {
       LOG(kWarning)
           << "IsSuccess<nfs_client::nfs_client::DataNameAndContentOrReturnCode> return_code "
-          << response.return_code->value.what();
+          << response.return_code->value.message();
     } else {
       LOG(kError) << "IsSuccess<nfs_client::nfs_client::DataNameAndContentOrReturnCode>"
                   << " neither data or data_name_and_return_code is initialized";
@@ -823,7 +887,7 @@ template <>
 std::error_code ErrorCode<nfs_client::DataNameAndContentOrReturnCode>(
     const nfs_client::DataNameAndContentOrReturnCode& response) {
   if (response.return_code)
-    return response.return_code->value.code();
+    return response.return_code->value;
   else if (response.content)
     return std::error_code(CommonErrors::success);
   else
@@ -840,7 +904,7 @@ bool IsSuccess<nfs_client::StructuredDataNameAndContentOrReturnCode>(
     if (response.data_name_and_return_code)
       LOG(kWarning) << "IsSuccess<nfs_client::nfs_client::StructuredDataNameAndContentOrReturnCode>"
                     << " return_code "
-                    << response.data_name_and_return_code->return_code.value.what();
+                    << response.data_name_and_return_code->return_code.value.message();
     else
       LOG(kError) << "IsSuccess<nfs_client::nfs_client::StructuredDataNameAndContentOrReturnCode>"
                   << " neither structured_data or data_name_and_return_code is initialized";
@@ -852,7 +916,7 @@ template <>
 std::error_code ErrorCode<nfs_client::StructuredDataNameAndContentOrReturnCode>(
     const nfs_client::StructuredDataNameAndContentOrReturnCode& response) {
   if (response.data_name_and_return_code)
-    return response.data_name_and_return_code->return_code.value.code();
+    return response.data_name_and_return_code->return_code.value;
   else if (response.structured_data)
     return std::error_code(CommonErrors::success);
   else
@@ -0,0 +1,103 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/negative_cache.h"
+
+#include <algorithm>
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace {
+
+std::chrono::steady_clock::duration ShortestTimeToLive(
+    const NegativeCache::TimeToLives& time_to_lives) {
+  auto shortest(std::chrono::steady_clock::duration::max());
+  for (const auto& time_to_live : time_to_lives) {
+    if (time_to_live.second > std::chrono::steady_clock::duration::zero())
+      shortest = std::min(shortest, time_to_live.second);
+  }
+  return shortest;
+}
+
+}  // unnamed namespace
+
+NegativeCache::NegativeCache(TimeToLives time_to_lives)
+    : time_to_lives_(std::move(time_to_lives)),
+      purge_interval_(ShortestTimeToLive(time_to_lives_)),
+      mutex_(),
+      entries_(),
+      next_purge_(std::chrono::steady_clock::now()) {}
+
+bool NegativeCache::Holds(DataTagValue type) const {
+  auto found(time_to_lives_.find(type));
+  return found != std::end(time_to_lives_) &&
+         found->second > std::chrono::steady_clock::duration::zero();
+}
+
+boost::optional<ReturnCode> NegativeCache::Get(DataTagValue type, const Identity& name) {
+  if (!Holds(type))
+    return boost::none;
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found(entries_.find(Key(type, name)));
+  if (found == std::end(entries_))
+    return boost::none;
+  if (found->second.first <= std::chrono::steady_clock::now()) {
+    entries_.erase(found);
+    return boost::none;
+  }
+  return found->second.second;
+}
+
+void NegativeCache::Add(DataTagValue type, const Identity& name, const ReturnCode& return_code) {
+  if (!Holds(type))
+    return;
+  auto now(std::chrono::steady_clock::now());
+  std::lock_guard<std::mutex> lock(mutex_);
+  PurgeExpired(now);
+  entries_[Key(type, name)] = Entry(now + time_to_lives_.at(type), return_code);
+}
+
+void NegativeCache::Remove(DataTagValue type, const Identity& name) {
+  if (!Holds(type))
+    return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.erase(Key(type, name));
+}
+
+size_t NegativeCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+void NegativeCache::PurgeExpired(std::chrono::steady_clock::time_point now) {
+  if (now < next_purge_)
+    return;
+  for (auto itr(std::begin(entries_)); itr != std::end(entries_);) {
+    if (itr->second.first <= now)
+      itr = entries_.erase(itr);
+    else
+      ++itr;
+  }
+  next_purge_ = now + purge_interval_;
+}
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
@@ -22,6 +22,7 @@
 
 #include "maidsafe/common/error.h"
 
+#include "maidsafe/nfs/scratch_protobuf.h"
 #include "maidsafe/nfs/client/structured_data.pb.h"
 
 namespace maidsafe {
@@ -43,18 +44,18 @@ StructuredData& StructuredData::operator=(StructuredData other) {
 }
 
 StructuredData::StructuredData(const std::string& serialised_copy) : versions() {
-  protobuf::StructuredData proto_structured_data;
-  if (!proto_structured_data.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::StructuredData> proto_structured_data;
+  if (!proto_structured_data->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  for (auto i(0); i < proto_structured_data.serialised_versions_size(); ++i)
-    versions.emplace_back(proto_structured_data.serialised_versions(i));
+  for (auto i(0); i < proto_structured_data->serialised_versions_size(); ++i)
+    versions.emplace_back(proto_structured_data->serialised_versions(i));
 }
 
 std::string StructuredData::Serialise() const {
-  protobuf::StructuredData proto_structured_data;
+  nfs::detail::ScratchProtobuf<protobuf::StructuredData> proto_structured_data;
   for (const auto& version : versions)
-    proto_structured_data.add_serialised_versions(version.Serialise());
-  return proto_structured_data.SerializeAsString();
+    proto_structured_data->add_serialised_versions(version.Serialise());
+  return proto_structured_data->SerializeAsString();
 }
 
 bool operator==(const StructuredData& lhs, const StructuredData& rhs) {
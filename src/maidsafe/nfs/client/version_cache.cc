@@ -0,0 +1,166 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/version_cache.h"
+
+#include <algorithm>
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace {
+
+typedef std::chrono::steady_clock::time_point TimePoint;
+
+bool IsFresh(TimePoint fetched, const std::chrono::steady_clock::duration& max_staleness) {
+  return std::chrono::steady_clock::now() - fetched < max_staleness;
+}
+
+}  // unnamed namespace
+
+VersionCache::VersionCache(size_t max_names)
+    : max_names_(max_names), mutex_(), entries_(), index_(), write_count_(0) {}
+
+std::shared_ptr<const VersionCache::Versions> VersionCache::GetVersions(
+    DataTagValue type, const Identity& name,
+    const std::chrono::steady_clock::duration& max_staleness) {
+  if (!enabled())
+    return nullptr;
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto entry(Find(Key(type, name)));
+  if (!entry || !entry->versions.second || !IsFresh(entry->versions.first, max_staleness))
+    return nullptr;
+  return entry->versions.second;
+}
+
+std::shared_ptr<const VersionCache::Versions> VersionCache::GetBranch(
+    DataTagValue type, const Identity& name, const VersionName& branch_tip,
+    const std::chrono::steady_clock::duration& max_staleness) {
+  if (!enabled())
+    return nullptr;
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto entry(Find(Key(type, name)));
+  if (!entry)
+    return nullptr;
+  auto branch(entry->branches.find(branch_tip));
+  if (branch == std::end(entry->branches) || !IsFresh(branch->second.first, max_staleness))
+    return nullptr;
+  return branch->second.second;
+}
+
+uint64_t VersionCache::write_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return write_count_;
+}
+
+void VersionCache::SetVersions(DataTagValue type, const Identity& name, const Versions& versions,
+                               uint64_t write_count_at_request) {
+  if (!enabled())
+    return;
+  auto cached(std::make_shared<const Versions>(versions));
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (write_count_ != write_count_at_request)
+    return;
+  FindOrAdd(Key(type, name)).versions =
+      FetchedVersions(std::chrono::steady_clock::now(), std::move(cached));
+}
+
+void VersionCache::SetBranch(DataTagValue type, const Identity& name,
+                             const VersionName& branch_tip, const Versions& versions,
+                             uint64_t write_count_at_request) {
+  if (!enabled())
+    return;
+  auto cached(std::make_shared<const Versions>(versions));
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (write_count_ != write_count_at_request)
+    return;
+  FindOrAdd(Key(type, name)).branches[branch_tip] =
+      FetchedVersions(std::chrono::steady_clock::now(), std::move(cached));
+}
+
+void VersionCache::PutVersion(DataTagValue type, const Identity& name,
+                              const VersionName& old_version, const VersionName& new_version,
+                              const boost::optional<VersionName>& tip_of_tree) {
+  if (!enabled())
+    return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++write_count_;
+  auto found(index_.find(Key(type, name)));
+  if (found == std::end(index_))
+    return;
+  auto& entry(*found->second);
+  if (tip_of_tree && !(*tip_of_tree == new_version)) {
+    entries_.erase(found->second);
+    index_.erase(found);
+    return;
+  }
+  entry.branches.clear();
+  if (!entry.versions.second)
+    return;
+  // The new version replaces its parent as a tip, or starts a new branch if the parent wasn't one.
+  Versions versions(*entry.versions.second);
+  auto parent(std::find(std::begin(versions), std::end(versions), old_version));
+  if (parent != std::end(versions))
+    *parent = new_version;
+  else
+    versions.push_back(new_version);
+  entry.versions.second = std::make_shared<const Versions>(std::move(versions));
+}
+
+void VersionCache::Invalidate(DataTagValue type, const Identity& name) {
+  if (!enabled())
+    return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++write_count_;
+  auto found(index_.find(Key(type, name)));
+  if (found == std::end(index_))
+    return;
+  entries_.erase(found->second);
+  index_.erase(found);
+}
+
+size_t VersionCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return index_.size();
+}
+
+VersionCache::Entry* VersionCache::Find(const Key& key) {
+  auto found(index_.find(key));
+  if (found == std::end(index_))
+    return nullptr;
+  entries_.splice(std::begin(entries_), entries_, found->second);
+  return &*found->second;
+}
+
+VersionCache::Entry& VersionCache::FindOrAdd(const Key& key) {
+  auto entry(Find(key));
+  if (entry)
+    return *entry;
+  entries_.emplace_front(key);
+  index_.insert(std::make_pair(key, std::begin(entries_)));
+  if (index_.size() > max_names_) {
+    index_.erase(entries_.back().key);
+    entries_.pop_back();
+  }
+  return entries_.front();
+}
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
@@ -0,0 +1,161 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/message_batcher.h"
+
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "boost/asio/steady_timer.hpp"
+#include "boost/exception/diagnostic_information.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/nfs/message_wrapper.h"
+
+namespace maidsafe {
+
+namespace nfs {
+
+BatchParameters::BatchParameters()
+    : window(std::chrono::steady_clock::duration::zero()), max_size(64 * 1024) {}
+
+BatchParameters::BatchParameters(std::chrono::steady_clock::duration window_in,
+                                 size_t max_size_in)
+    : window(window_in), max_size(max_size_in) {}
+
+struct MessageBatcher::State {
+  State(AsioService& asio_service, const BatchParameters& parameters_in,
+        SendFunctor send_functor_in)
+      : parameters(parameters_in),
+        send_functor(std::move(send_functor_in)),
+        mutex(),
+        timer(asio_service.service()),
+        pending(),
+        pending_size(0),
+        generation(0),
+        stopped(false) {}
+
+  // Must be called with 'mutex' locked.  Returns the pending messages as a single serialised
+  // string (unbatched if there is only one) and resets the batch.
+  std::string TakePending() {
+    std::string serialised;
+    if (pending.size() == 1) {
+      serialised.swap(pending.front());
+    } else {
+      serialised.reserve(pending_size + pending.size() * 4 + 2);
+      for (const auto& serialised_message_wrapper : pending)
+        AppendToMessageWrapperBatch(serialised_message_wrapper, serialised);
+    }
+    pending.clear();
+    pending_size = 0;
+    ++generation;
+    return serialised;
+  }
+
+  void Send(std::string serialised) {
+    if (!serialised.empty())
+      send_functor(std::move(serialised));
+  }
+
+  const BatchParameters parameters;
+  const SendFunctor send_functor;
+  std::mutex mutex;
+  boost::asio::steady_timer timer;
+  std::vector<std::string> pending;
+  size_t pending_size;
+  uint64_t generation;
+  bool stopped;
+};
+
+MessageBatcher::MessageBatcher(AsioService& asio_service, const BatchParameters& parameters,
+                               SendFunctor send_functor)
+    : state_(std::make_shared<State>(asio_service, parameters, std::move(send_functor))) {
+  if (!state_->send_functor) {
+    LOG(kError) << "MessageBatcher requires a send functor.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+}
+
+MessageBatcher::~MessageBatcher() {
+  try {
+    Flush();
+  }
+  catch (const std::exception& e) {
+    LOG(kError) << "Failed to send message batch: " << boost::diagnostic_information(e);
+  }
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->stopped = true;
+  boost::system::error_code ignored;
+  state_->timer.cancel(ignored);
+}
+
+void MessageBatcher::Add(std::string serialised_message_wrapper) {
+  if (state_->parameters.window == std::chrono::steady_clock::duration::zero())
+    return state_->Send(std::move(serialised_message_wrapper));
+
+  std::string full_batch;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->pending_size += serialised_message_wrapper.size();
+    state_->pending.push_back(std::move(serialised_message_wrapper));
+    if (state_->pending_size >= state_->parameters.max_size) {
+      full_batch = state_->TakePending();
+    } else if (state_->pending.size() == 1) {
+      // First message of a new batch, so start the window.
+      auto generation(state_->generation);
+      std::weak_ptr<State> weak_state(state_);
+      state_->timer.expires_from_now(state_->parameters.window);
+      state_->timer.async_wait([weak_state, generation](const boost::system::error_code&) {
+        auto state(weak_state.lock());
+        if (!state)
+          return;
+        // The send functor may refer to the batcher's owner, so the lock is held while sending to
+        // stop the batcher being destroyed part way through.
+        std::lock_guard<std::mutex> lock(state->mutex);
+        // The batch this timer was started for may already have been sent.
+        if (state->stopped || state->generation != generation)
+          return;
+        try {
+          state->Send(state->TakePending());
+        }
+        catch (const std::exception& e) {
+          LOG(kError) << "Failed to send message batch: " << boost::diagnostic_information(e);
+        }
+      });
+    }
+  }
+  state_->Send(std::move(full_batch));
+}
+
+void MessageBatcher::Flush() {
+  std::string batch;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->pending.empty())
+      return;
+    batch = state_->TakePending();
+  }
+  state_->Send(std::move(batch));
+}
+
+}  // namespace nfs
+
+}  // namespace maidsafe
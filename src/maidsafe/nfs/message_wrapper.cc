@@ -18,9 +18,14 @@
 
 #include "maidsafe/nfs/message_wrapper.h"
 
+#include <atomic>
+
+#include "boost/thread/tss.hpp"
+
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/utils.h"
 
+#include "maidsafe/nfs/scratch_protobuf.h"
 #include "maidsafe/nfs/message_wrapper.pb.h"
 
 namespace maidsafe {
@@ -29,43 +34,175 @@ namespace nfs {
 
 namespace detail {
 
+namespace {
+
+// Field number 0 is invalid in protobuf, so no protobuf-encoded wrapper can start with a zero byte
+// (or a one byte, which is used to mark a batch).
+const char kFlatMessageWrapperMarker(0);
+const char kFlatMessageWrapperVersion(1);
+const char kMessageWrapperBatchMarker(1);
+const char kMessageWrapperBatchVersion(1);
+
+bool IsFlatMessageWrapper(const SharedBuffer& serialised_message_wrapper) {
+  return !serialised_message_wrapper.empty() &&
+         serialised_message_wrapper.data()[0] == kFlatMessageWrapperMarker;
+}
+
+// A batch is a marker byte and a version byte, followed by each of the serialised message wrappers
+// preceded by its size as a varint.
+bool IsMessageWrapperBatch(const SharedBuffer& serialised_message_wrappers) {
+  return !serialised_message_wrappers.empty() &&
+         serialised_message_wrappers.data()[0] == kMessageWrapperBatchMarker;
+}
+
+// Message ids are a random 24-bit per-process prefix followed by a 40-bit counter.  Each thread
+// reserves a block of counter values at a time, so the shared counter is only touched once per
+// block and id generation is lock-free.
+const int kMessageIdPrefixBits(24);
+const int kMessageIdCounterBits(64 - kMessageIdPrefixBits);
+const uint64_t kMessageIdBlockSize(1024);
+
+struct MessageIdBlock {
+  MessageIdBlock() : next(0), end(0) {}
+  uint64_t next, end;
+};
+
+TypeErasedMessageWrapper ParseFlatMessageWrapper(const SharedBuffer& serialised_message_wrapper) {
+  const char* data(serialised_message_wrapper.data());
+  size_t size(serialised_message_wrapper.size());
+  if (size < 2 || data[1] != kFlatMessageWrapperVersion)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  size_t offset(2);
+  auto action(static_cast<MessageAction>(ReadVarint(data, size, offset)));
+  auto source_persona(static_cast<Persona>(ReadVarint(data, size, offset)));
+  auto destination_persona(static_cast<Persona>(ReadVarint(data, size, offset)));
+  auto message_id(static_cast<int64_t>(ReadVarint(data, size, offset)));
+  return std::make_tuple(action, SourceTaggedValue(source_persona),
+                         DestinationTaggedValue(destination_persona), MessageId(message_id),
+                         serialised_message_wrapper.Slice(offset, size - offset));
+}
+
+}  // unnamed namespace
+
 MessageId GetNewMessageId() {
-  static int32_t random_element(RandomInt32());
-  return MessageId(random_element++);
+  static const uint64_t kPrefix((static_cast<uint64_t>(RandomUint32()) &
+                                 ((uint64_t(1) << kMessageIdPrefixBits) - 1))
+                                << kMessageIdCounterBits);
+  static std::atomic<uint64_t> next_block(0);
+  static boost::thread_specific_ptr<MessageIdBlock> this_threads_block;
+  auto block(this_threads_block.get());
+  if (!block) {
+    block = new MessageIdBlock;
+    this_threads_block.reset(block);
+  }
+  if (block->next == block->end) {
+    block->next = next_block.fetch_add(kMessageIdBlockSize, std::memory_order_relaxed);
+    block->end = block->next + kMessageIdBlockSize;
+  }
+  auto counter((block->next++) & ((uint64_t(1) << kMessageIdCounterBits) - 1));
+  return MessageId(static_cast<int64_t>(kPrefix | counter));
 }
 
 std::string SerialiseMessageWrapper(const TypeErasedMessageWrapper& message_tuple) {
-  protobuf::MessageWrapper proto_message_wrapper;
+  detail::ScratchProtobuf<protobuf::MessageWrapper> proto_message_wrapper;
   auto action(static_cast<int32_t>(std::get<0>(message_tuple)));
-  proto_message_wrapper.set_action(action);
+  proto_message_wrapper->set_action(action);
   auto source_persona(static_cast<int32_t>(std::get<1>(message_tuple).data));
-  proto_message_wrapper.set_source_persona(source_persona);
+  proto_message_wrapper->set_source_persona(source_persona);
   auto destination_persona(static_cast<int32_t>(std::get<2>(message_tuple).data));
-  proto_message_wrapper.set_destination_persona(destination_persona);
+  proto_message_wrapper->set_destination_persona(destination_persona);
   auto message_id(std::get<3>(message_tuple));
-  proto_message_wrapper.set_message_id(message_id);
-  proto_message_wrapper.set_serialised_contents(std::get<4>(message_tuple));
+  proto_message_wrapper->set_message_id(message_id);
+  proto_message_wrapper->set_serialised_contents(std::get<4>(message_tuple).data(),
+                                                std::get<4>(message_tuple).size());
   LOG(kVerbose) << "Message Wrapper created for message from persona "
                 << std::get<1>(message_tuple).data
                 << " to persona " << std::get<2>(message_tuple).data
                 << " for action " << std::get<0>(message_tuple)
                 << " with id " << message_id.data;
-  return proto_message_wrapper.SerializeAsString();
+  return proto_message_wrapper->SerializeAsString();
+}
+
+void AppendMessageWrapperHeader(MessageAction action, const SourceTaggedValue& source_persona,
+                                const DestinationTaggedValue& destination_persona,
+                                const MessageId& message_id, std::string& output) {
+  output.push_back(kFlatMessageWrapperMarker);
+  output.push_back(kFlatMessageWrapperVersion);
+  AppendVarint(static_cast<uint32_t>(action), output);
+  AppendVarint(static_cast<uint32_t>(source_persona.data), output);
+  AppendVarint(static_cast<uint32_t>(destination_persona.data), output);
+  AppendVarint(static_cast<uint64_t>(message_id.data), output);
 }
 
 }  // namespace detail
 
-TypeErasedMessageWrapper ParseMessageWrapper(const std::string& serialised_message_wrapper) {
-  protobuf::MessageWrapper proto_message_wrapper;
-  if (!proto_message_wrapper.ParseFromString(serialised_message_wrapper))
+TypeErasedMessageWrapper ParseMessageWrapper(SharedBuffer serialised_message_wrapper) {
+  if (detail::IsFlatMessageWrapper(serialised_message_wrapper))
+    return detail::ParseFlatMessageWrapper(serialised_message_wrapper);
+
+  detail::ScratchProtobuf<protobuf::MessageWrapper> proto_message_wrapper;
+  if (!proto_message_wrapper->ParseFromArray(serialised_message_wrapper.data(),
+                                            static_cast<int>(serialised_message_wrapper.size())))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
 
   return std::make_tuple(
-      static_cast<MessageAction>(proto_message_wrapper.action()),
-      detail::SourceTaggedValue(static_cast<Persona>(proto_message_wrapper.source_persona())),
+      static_cast<MessageAction>(proto_message_wrapper->action()),
+      detail::SourceTaggedValue(static_cast<Persona>(proto_message_wrapper->source_persona())),
       detail::DestinationTaggedValue(
-          static_cast<Persona>(proto_message_wrapper.destination_persona())),
-      MessageId(proto_message_wrapper.message_id()), proto_message_wrapper.serialised_contents());
+          static_cast<Persona>(proto_message_wrapper->destination_persona())),
+      MessageId(proto_message_wrapper->message_id()),
+      SharedBuffer(std::move(*proto_message_wrapper->mutable_serialised_contents())));
+}
+
+TypeErasedMessageWrapper ParseMessageWrapper(const std::string& serialised_message_wrapper) {
+  return ParseMessageWrapper(SharedBuffer(serialised_message_wrapper));
+}
+
+void AppendToMessageWrapperBatch(const std::string& serialised_message_wrapper,
+                                 std::string& batch) {
+  if (batch.empty()) {
+    batch.push_back(detail::kMessageWrapperBatchMarker);
+    batch.push_back(detail::kMessageWrapperBatchVersion);
+  }
+  detail::AppendVarint(serialised_message_wrapper.size(), batch);
+  batch += serialised_message_wrapper;
+}
+
+std::vector<TypeErasedMessageWrapper> ParseMessageWrappers(
+    SharedBuffer serialised_message_wrappers) {
+  std::vector<TypeErasedMessageWrapper> message_wrappers;
+  if (!detail::IsMessageWrapperBatch(serialised_message_wrappers)) {
+    message_wrappers.push_back(ParseMessageWrapper(std::move(serialised_message_wrappers)));
+    return message_wrappers;
+  }
+
+  const char* data(serialised_message_wrappers.data());
+  size_t size(serialised_message_wrappers.size());
+  if (size < 2 || data[1] != detail::kMessageWrapperBatchVersion) {
+    LOG(kError) << "Unsupported message wrapper batch.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  size_t offset(2);
+  while (offset != size) {
+    auto length(detail::ReadVarint(data, size, offset));
+    if (length == 0 || length > size - offset) {
+      LOG(kError) << "Malformed message wrapper batch.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+    }
+    auto serialised_message_wrapper(
+        serialised_message_wrappers.Slice(offset, static_cast<size_t>(length)));
+    // Batches are never nested.
+    if (detail::IsMessageWrapperBatch(serialised_message_wrapper))
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+    message_wrappers.push_back(ParseMessageWrapper(std::move(serialised_message_wrapper)));
+    offset += static_cast<size_t>(length);
+  }
+  return message_wrappers;
+}
+
+std::vector<TypeErasedMessageWrapper> ParseMessageWrappers(
+    const std::string& serialised_message_wrappers) {
+  return ParseMessageWrappers(SharedBuffer(serialised_message_wrappers));
 }
 
 }  // namespace nfs
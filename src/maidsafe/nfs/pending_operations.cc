@@ -0,0 +1,210 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/pending_operations.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "boost/asio/steady_timer.hpp"
+#include "boost/exception/diagnostic_information.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/nfs/message_wrapper.h"
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace {
+
+template <typename Tasks>
+void ExpireAll(const Tasks& tasks) {
+  for (const auto& task : tasks) {
+    try {
+      task->Expire();
+    }
+    catch (const std::exception& e) {
+      LOG(kError) << "Failed to expire pending operation: " << boost::diagnostic_information(e);
+    }
+  }
+}
+
+}  // unnamed namespace
+
+PendingOperations::Task::Task(std::type_index response_type_in, int expected_count)
+    : response_type(response_type_in), outstanding_responses(expected_count), deadline() {}
+
+struct PendingOperations::Shard : public std::enable_shared_from_this<Shard> {
+  explicit Shard(AsioService& asio_service)
+      : mutex(),
+        timer(asio_service.service()),
+        tasks(),
+        deadlines(),
+        armed_deadline(),
+        armed(false),
+        stopped(false) {}
+
+  // Must be called with 'mutex' locked.  The timer is only re-armed if the earliest deadline has
+  // moved forward, so adding a task usually just costs the map insertions.
+  void ScheduleExpiry() {
+    if (stopped || deadlines.empty())
+      return;
+    auto earliest(deadlines.begin()->first);
+    if (armed && armed_deadline <= earliest)
+      return;
+    armed_deadline = earliest;
+    armed = true;
+    timer.expires_at(earliest);
+    std::weak_ptr<Shard> weak_shard(shared_from_this());
+    timer.async_wait([weak_shard](const boost::system::error_code& error) {
+      if (error == boost::asio::error::operation_aborted)
+        return;
+      if (auto shard = weak_shard.lock())
+        shard->ExpireTasks();
+    });
+  }
+
+  void ExpireTasks() {
+    std::vector<std::shared_ptr<Task>> expired;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      armed = false;
+      auto now(std::chrono::steady_clock::now());
+      while (!deadlines.empty() && deadlines.begin()->first <= now) {
+        auto found(tasks.find(deadlines.begin()->second));
+        expired.push_back(std::move(found->second));
+        tasks.erase(found);
+        deadlines.erase(deadlines.begin());
+      }
+      ScheduleExpiry();
+    }
+    ExpireAll(expired);
+  }
+
+  // Must be called with 'mutex' locked.
+  std::shared_ptr<Task> Remove(
+      std::unordered_map<TaskId, std::shared_ptr<Task>>::iterator itr) {
+    auto task(std::move(itr->second));
+    deadlines.erase(task->deadline);
+    tasks.erase(itr);
+    return task;
+  }
+
+  std::mutex mutex;
+  boost::asio::steady_timer timer;
+  std::unordered_map<TaskId, std::shared_ptr<Task>> tasks;
+  Deadlines deadlines;
+  std::chrono::steady_clock::time_point armed_deadline;
+  bool armed, stopped;
+};
+
+PendingOperations::PendingOperations(AsioService& asio_service) : shards_() {
+  auto shard_count(std::max(std::thread::hardware_concurrency(), 1U));
+  for (unsigned i(0); i != shard_count; ++i)
+    shards_.push_back(std::make_shared<Shard>(asio_service));
+}
+
+PendingOperations::~PendingOperations() {
+  for (auto& shard : shards_) {
+    std::vector<std::shared_ptr<Task>> remaining;
+    {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      shard->stopped = true;
+      boost::system::error_code ignored;
+      shard->timer.cancel(ignored);
+      for (auto& entry : shard->tasks)
+        remaining.push_back(std::move(entry.second));
+      shard->tasks.clear();
+      shard->deadlines.clear();
+    }
+    ExpireAll(remaining);
+  }
+}
+
+TaskId PendingOperations::NewTaskId() {
+  // Message ids are handed out from per-thread blocks, so this needs no shared counter.
+  return detail::GetNewMessageId().data;
+}
+
+bool PendingOperations::HasTask(TaskId task_id) const {
+  auto& shard(GetShard(task_id));
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  return shard.tasks.find(task_id) != std::end(shard.tasks);
+}
+
+void PendingOperations::CancelTask(TaskId task_id) {
+  std::shared_ptr<Task> task;
+  {
+    auto& shard(GetShard(task_id));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found(shard.tasks.find(task_id));
+    if (found == std::end(shard.tasks))
+      return;
+    task = shard.Remove(found);
+  }
+  task->Expire();
+}
+
+size_t PendingOperations::size() const {
+  size_t count(0);
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    count += shard->tasks.size();
+  }
+  return count;
+}
+
+PendingOperations::Shard& PendingOperations::GetShard(TaskId task_id) const {
+  return *shards_[static_cast<uint64_t>(task_id) % shards_.size()];
+}
+
+void PendingOperations::Insert(TaskId task_id,
+                               const std::chrono::steady_clock::duration& timeout,
+                               std::shared_ptr<Task> task) {
+  auto& shard(GetShard(task_id));
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if (!shard.tasks.insert(std::make_pair(task_id, task)).second) {
+    LOG(kError) << "Task " << task_id << " is already pending.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+  task->deadline = shard.deadlines.insert(
+      std::make_pair(std::chrono::steady_clock::now() + timeout, task_id));
+  shard.ScheduleExpiry();
+}
+
+std::shared_ptr<PendingOperations::Task> PendingOperations::TakeResponseSlot(
+    TaskId task_id, const std::type_index& response_type) {
+  auto& shard(GetShard(task_id));
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto found(shard.tasks.find(task_id));
+  if (found == std::end(shard.tasks) || found->second->response_type != response_type)
+    return std::shared_ptr<Task>();
+  if (--found->second->outstanding_responses > 0)
+    return found->second;
+  return shard.Remove(found);
+}
+
+}  // namespace nfs
+
+}  // namespace maidsafe
@@ -0,0 +1,87 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/shared_buffer.h"
+
+#include <cstring>
+#include <utility>
+
+#include "maidsafe/common/error.h"
+
+namespace maidsafe {
+
+namespace nfs {
+
+SharedBuffer::SharedBuffer() : buffer_(), offset_(0), length_(0) {}
+
+SharedBuffer::SharedBuffer(std::string buffer)
+    : buffer_(std::make_shared<const std::string>(std::move(buffer))),
+      offset_(0),
+      length_(buffer_->size()) {}
+
+SharedBuffer::SharedBuffer(std::shared_ptr<const std::string> buffer, size_t offset,
+                           size_t length)
+    : buffer_(std::move(buffer)), offset_(offset), length_(length) {
+  if (!buffer_ || offset_ > buffer_->size() || length_ > buffer_->size() - offset_)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+}
+
+SharedBuffer::SharedBuffer(const SharedBuffer& other)
+    : buffer_(other.buffer_), offset_(other.offset_), length_(other.length_) {}
+
+SharedBuffer::SharedBuffer(SharedBuffer&& other)
+    : buffer_(std::move(other.buffer_)), offset_(other.offset_), length_(other.length_) {}
+
+SharedBuffer& SharedBuffer::operator=(SharedBuffer other) {
+  swap(*this, other);
+  return *this;
+}
+
+const char* SharedBuffer::data() const { return buffer_ ? buffer_->data() + offset_ : nullptr; }
+
+size_t SharedBuffer::size() const { return length_; }
+
+bool SharedBuffer::empty() const { return length_ == 0; }
+
+std::string SharedBuffer::string() const {
+  return buffer_ ? buffer_->substr(offset_, length_) : std::string();
+}
+
+SharedBuffer SharedBuffer::Slice(size_t offset, size_t length) const {
+  if (offset > length_ || length > length_ - offset)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  if (!buffer_)
+    return SharedBuffer();
+  return SharedBuffer(buffer_, offset_ + offset, length);
+}
+
+void swap(SharedBuffer& lhs, SharedBuffer& rhs) MAIDSAFE_NOEXCEPT {
+  using std::swap;
+  swap(lhs.buffer_, rhs.buffer_);
+  swap(lhs.offset_, rhs.offset_);
+  swap(lhs.length_, rhs.length_);
+}
+
+bool operator==(const SharedBuffer& lhs, const SharedBuffer& rhs) {
+  return lhs.size() == rhs.size() &&
+         (lhs.size() == 0 || std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+}
+
+}  // namespace nfs
+
+}  // namespace maidsafe
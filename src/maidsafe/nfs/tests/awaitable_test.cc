@@ -0,0 +1,197 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/awaitable.h"
+
+#ifdef MAIDSAFE_NFS_COROUTINES
+
+#include <atomic>
+#include <chrono>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include "boost/optional/optional.hpp"
+#include "boost/thread/future.hpp"
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/data_types/immutable_data.h"
+#include "maidsafe/passport/types.h"
+#include "maidsafe/routing/routing_api.h"
+
+#include "maidsafe/nfs/client/data_cache.h"
+#include "maidsafe/nfs/client/data_getter.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+namespace {
+
+// Stands in for a client operation: completes on 'network' with 'value', or with 'error' if set.
+auto AsyncOperation(boost::asio::io_service& client, boost::asio::io_service& network, int value,
+                    std::error_code error = std::error_code()) {
+  return MakeAwaitable<int>(client, [&network, value, error](auto handler) {
+    network.post([handler, value, error]() mutable {
+      handler(error, error ? boost::optional<int>() : boost::optional<int>(value));
+    });
+  });
+}
+
+std::thread::id ThreadOf(boost::asio::io_service& io_service) {
+  boost::promise<std::thread::id> promise;
+  io_service.post([&promise] { promise.set_value(std::this_thread::get_id()); });
+  return promise.get_future().get();
+}
+
+// Coroutines are free functions rather than lambdas, since a lambda's captures don't outlive the
+// closure object once the coroutine suspends.
+Detached TwoSteps(boost::asio::io_service& client, boost::asio::io_service& network,
+                  boost::promise<std::pair<int, std::thread::id>>& promise) {
+  auto first(co_await AsyncOperation(client, network, 1));
+  auto second(co_await AsyncOperation(client, network, first + 1));
+  promise.set_value(std::make_pair(second, std::this_thread::get_id()));
+}
+
+Detached Failing(boost::asio::io_service& client, boost::asio::io_service& network,
+                 boost::promise<std::error_code>& promise) {
+  try {
+    co_await AsyncOperation(client, network, 1, make_error_code(CommonErrors::no_such_element));
+    promise.set_value(std::error_code());
+  }
+  catch (const maidsafe_error& error) {
+    promise.set_value(error.code());
+  }
+}
+
+Detached CompletesAtOnce(boost::asio::io_service& client, bool& finished) {
+  co_await MakeAwaitable<void>(client, [](auto handler) { handler(std::error_code()); });
+  finished = true;
+}
+
+Detached Workflow(boost::asio::io_service& client, boost::asio::io_service& network,
+                  std::atomic<int>& remaining, std::atomic<int>& total,
+                  boost::promise<void>& done) {
+  auto value(co_await AsyncOperation(client, network, 1));
+  value += co_await AsyncOperation(client, network, value);
+  total += value;
+  if (--remaining == 0)
+    done.set_value();
+}
+
+// Fetches via the real DataGetter, recording the thread on which the coroutine finished.
+Detached FetchData(DataGetter& data_getter, ImmutableData::Name name,
+                   std::chrono::steady_clock::duration timeout,
+                   boost::promise<ImmutableData>& promise, std::thread::id& finished_on) {
+  try {
+    auto data(co_await AsyncGet(data_getter, name, timeout));
+    finished_on = std::this_thread::get_id();
+    promise.set_value(std::move(data));
+  }
+  catch (const maidsafe_error& error) {
+    finished_on = std::this_thread::get_id();
+    promise.set_exception(error);
+  }
+}
+
+}  // unnamed namespace
+
+TEST(AwaitableTest, BEH_ResumesOnOwningService) {
+  AsioService client(1), network(1);
+  auto client_thread(ThreadOf(client.service()));
+  boost::promise<std::pair<int, std::thread::id>> promise;
+  TwoSteps(client.service(), network.service(), promise);
+  auto result(promise.get_future().get());
+  EXPECT_EQ(2, result.first);
+  EXPECT_EQ(client_thread, result.second);
+}
+
+TEST(AwaitableTest, BEH_ErrorIsThrown) {
+  AsioService client(1), network(1);
+  boost::promise<std::error_code> promise;
+  Failing(client.service(), network.service(), promise);
+  EXPECT_EQ(make_error_code(CommonErrors::no_such_element), promise.get_future().get());
+}
+
+TEST(AwaitableTest, BEH_SynchronousCompletionDoesNotSuspend) {
+  AsioService client(1);
+  bool finished(false);
+  CompletesAtOnce(client.service(), finished);
+  // Had the coroutine suspended, it would have been resumed on 'client' rather than finished here.
+  EXPECT_TRUE(finished);
+}
+
+TEST(AwaitableTest, BEH_DataGetterAsyncGet) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_Awaitable"));
+  const DataCacheParameters kCacheParameters(1024 * 1024, *test_path, 64 * 1024 * 1024);
+  ImmutableData data(NonEmptyString(RandomString(1024)));
+  {
+    // Left on disk, so that the DataGetter's cache holds it from the start.
+    DataCache data_cache(kCacheParameters);
+    data_cache.Put(data);
+  }
+  passport::Anmaid anmaid;
+  passport::Maid maid(anmaid);
+  // Not joined to a network, so anything not cached times out.
+  routing::Routing routing(maid);
+  AsioService asio_service(1);
+  DataGetter data_getter(asio_service, routing, kCacheParameters);
+
+  // Served by the cache before AsyncGet's handler returns, so the coroutine doesn't suspend.
+  boost::promise<ImmutableData> cached_promise;
+  auto cached_future(cached_promise.get_future());
+  std::thread::id finished_on;
+  FetchData(data_getter, data.name(), std::chrono::seconds(10), cached_promise, finished_on);
+  ASSERT_TRUE(cached_future.is_ready());
+  auto fetched(cached_future.get());
+  EXPECT_EQ(data.name(), fetched.name());
+  EXPECT_EQ(data.data(), fetched.data());
+  EXPECT_EQ(std::this_thread::get_id(), finished_on);
+  EXPECT_EQ(1U, data_getter.data_cache_stats().disk_hits);
+
+  // A failure is thrown from the co_await.
+  boost::promise<ImmutableData> missing_promise;
+  auto missing_future(missing_promise.get_future());
+  FetchData(data_getter, ImmutableData::Name(Identity(RandomString(64))),
+            std::chrono::milliseconds(200), missing_promise, finished_on);
+  EXPECT_THROW(missing_future.get(), maidsafe_error);
+}
+
+TEST(AwaitableTest, BEH_ManyConcurrentWorkflows) {
+  const int kWorkflows(10000);
+  AsioService client(2), network(2);
+  std::atomic<int> remaining(kWorkflows), total(0);
+  boost::promise<void> done;
+  for (int i(0); i != kWorkflows; ++i)
+    Workflow(client.service(), network.service(), remaining, total, done);
+  done.get_future().get();
+  EXPECT_EQ(2 * kWorkflows, total);
+}
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_COROUTINES
@@ -0,0 +1,125 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/cancellation_token.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+TEST(CancellationTokenTest, BEH_DefaultTokenNeverCancels) {
+  CancellationToken token;
+  int calls(0);
+  EXPECT_EQ(0U, token.Register([&calls] { ++calls; }));
+  token.Cancel();
+  EXPECT_FALSE(token.cancelled());
+  EXPECT_EQ(0, calls);
+  // So operations given it needn't track cancellation.
+  EXPECT_FALSE(token.cancellable());
+  EXPECT_FALSE(MakeCancellableOperation(token));
+  EXPECT_TRUE(CancellationToken::Create().cancellable());
+  EXPECT_TRUE(static_cast<bool>(MakeCancellableOperation(CancellationToken::Create())));
+}
+
+TEST(CancellationTokenTest, BEH_CancelCallsRegisteredFunctors) {
+  auto token(CancellationToken::Create());
+  auto copy(token);
+  int first(0), second(0), late(0);
+  token.Register([&first] { ++first; });
+  auto id(token.Register([&second] { ++second; }));
+  token.Deregister(id);
+  copy.Cancel();
+  copy.Cancel();
+  EXPECT_TRUE(token.cancelled());
+  EXPECT_EQ(1, first);
+  EXPECT_EQ(0, second);
+  // Registering with a cancelled token calls the functor at once.
+  EXPECT_EQ(0U, token.Register([&late] { ++late; }));
+  EXPECT_EQ(1, late);
+}
+
+TEST(CancellationTokenTest, BEH_CompletionOrCancellation) {
+  auto token(CancellationToken::Create());
+  int cancels(0);
+  auto completed(std::make_shared<CancellableOperation>(token));
+  EXPECT_TRUE(completed->Arm([&cancels] { ++cancels; }));
+  EXPECT_TRUE(completed->Complete());
+
+  auto cancelled(std::make_shared<CancellableOperation>(token));
+  EXPECT_TRUE(cancelled->Arm([&cancels] { ++cancels; }));
+  token.Cancel();
+  EXPECT_EQ(1, cancels);
+  EXPECT_FALSE(cancelled->Complete());
+  EXPECT_FALSE(completed->Complete());
+
+  // Operations armed once cancelled are cancelled immediately.
+  auto late(std::make_shared<CancellableOperation>(token));
+  EXPECT_FALSE(late->Arm([&cancels] { ++cancels; }));
+  EXPECT_EQ(2, cancels);
+  EXPECT_FALSE(late->Complete());
+
+  // A destroyed operation isn't cancelled.
+  auto other_token(CancellationToken::Create());
+  std::make_shared<CancellableOperation>(other_token)->Arm([&cancels] { ++cancels; });
+  other_token.Cancel();
+  EXPECT_EQ(2, cancels);
+
+  EXPECT_EQ(std::make_error_code(std::errc::operation_canceled), CancelledError().code());
+}
+
+TEST(CancellationTokenTest, BEH_CompleteWaitsForCancellation) {
+  auto token(CancellationToken::Create());
+  auto operation(std::make_shared<CancellableOperation>(token));
+  bool cancelling(false), cancelled(false);
+  std::mutex mutex;
+  std::condition_variable cond_var;
+  operation->Arm([&] {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      cancelling = true;
+    }
+    cond_var.notify_one();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    cancelled = true;
+  });
+  std::thread canceller([&token] { token.Cancel(); });
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cond_var.wait(lock, [&cancelling] { return cancelling; });
+  }
+  EXPECT_FALSE(operation->Complete());
+  EXPECT_TRUE(cancelled);
+  canceller.join();
+}
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
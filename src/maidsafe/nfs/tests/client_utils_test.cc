@@ -0,0 +1,209 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/client_utils.h"
+
+#include <memory>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/data_types/immutable_data.h"
+
+#include "maidsafe/nfs/utils.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+TEST(ClientUtilsTest, BEH_HandleGetResult) {
+  ImmutableData data(NonEmptyString(RandomString(1024)));
+  {
+    auto promise(std::make_shared<boost::promise<ImmutableData>>());
+    auto future(promise->get_future());
+    HandleGetResult<ImmutableData> handle_get_result(promise);
+    handle_get_result(DataNameAndContentOrReturnCode(data));
+    auto fetched(future.get());
+    EXPECT_EQ(data.name(), fetched.name());
+    EXPECT_EQ(data.data(), fetched.data());
+  }
+  {
+    auto promise(std::make_shared<boost::promise<std::shared_ptr<const ImmutableData>>>());
+    auto future(promise->get_future());
+    HandleGetResult<ImmutableData, std::shared_ptr<const ImmutableData>> handle_get_result(
+        promise);
+    handle_get_result(DataNameAndContentOrReturnCode(data));
+    auto fetched(future.get());
+    ASSERT_TRUE(static_cast<bool>(fetched));
+    EXPECT_EQ(data.name(), fetched->name());
+    EXPECT_EQ(data.data(), fetched->data());
+  }
+  {
+    auto promise(std::make_shared<boost::promise<std::shared_ptr<const ImmutableData>>>());
+    auto future(promise->get_future());
+    HandleGetResult<ImmutableData, std::shared_ptr<const ImmutableData>> handle_get_result(
+        promise);
+    handle_get_result(
+        DataNameAndContentOrReturnCode(data.name(), ReturnCode(CommonErrors::no_such_element)));
+    EXPECT_THROW(future.get(), maidsafe_error);
+  }
+}
+
+TEST(ClientUtilsTest, BEH_CompleteGet) {
+  ImmutableData data(NonEmptyString(RandomString(1024)));
+  std::error_code error;
+  boost::optional<ImmutableData> fetched;
+  int call_count(0);
+  GetCompletionHandler<ImmutableData> handler(
+      [&](std::error_code error_in, boost::optional<ImmutableData> fetched_in) {
+        ++call_count;
+        error = error_in;
+        fetched = std::move(fetched_in);
+      });
+  CompleteGet(DataNameAndContentOrReturnCode(data), nullptr, handler);
+  EXPECT_EQ(1, call_count);
+  EXPECT_FALSE(error);
+  ASSERT_TRUE(static_cast<bool>(fetched));
+  EXPECT_EQ(data.name(), fetched->name());
+  EXPECT_EQ(data.data(), fetched->data());
+
+  CompleteGet(
+      DataNameAndContentOrReturnCode(data.name(), ReturnCode(CommonErrors::no_such_element)),
+      nullptr, handler);
+  EXPECT_EQ(2, call_count);
+  EXPECT_EQ(make_error_code(CommonErrors::no_such_element), error);
+  EXPECT_FALSE(fetched);
+
+  CompleteGet(DataNameAndContentOrReturnCode(), nullptr, handler);
+  EXPECT_EQ(3, call_count);
+  EXPECT_EQ(make_error_code(CommonErrors::uninitialised), error);
+
+  // The future adapter fails with the handler's error.
+  auto promise(std::make_shared<boost::promise<ImmutableData>>());
+  auto future(promise->get_future());
+  GetPromiseHandler<ImmutableData>(promise)(make_error_code(CommonErrors::no_such_element),
+                                            boost::none);
+  EXPECT_THROW(future.get(), maidsafe_error);
+}
+
+TEST(ClientUtilsTest, BEH_IsCompletionHandler) {
+  auto get_handler([](std::error_code, boost::optional<ImmutableData>) {});
+  auto put_handler([](std::error_code) {});
+  auto versions_handler([](std::error_code, std::vector<StructuredDataVersions::VersionName>) {});
+  EXPECT_TRUE((detail::IsCompletionHandler<decltype(get_handler),
+                                           GetCompletionHandler<ImmutableData>>::value));
+  EXPECT_TRUE((detail::IsCompletionHandler<decltype(put_handler), PutCompletionHandler>::value));
+  EXPECT_TRUE((detail::IsCompletionHandler<decltype(versions_handler),
+                                           VersionNamesCompletionHandler>::value));
+  EXPECT_TRUE((detail::IsCompletionHandler<PutCompletionHandler, PutCompletionHandler>::value));
+
+  // A timeout, or a handler for a different operation, isn't accepted.
+  EXPECT_FALSE((detail::IsCompletionHandler<std::chrono::seconds, PutCompletionHandler>::value));
+  EXPECT_FALSE((detail::IsCompletionHandler<decltype(put_handler),
+                                            GetCompletionHandler<ImmutableData>>::value));
+  EXPECT_FALSE((detail::IsCompletionHandler<decltype(get_handler),
+                                            VersionNamesCompletionHandler>::value));
+  EXPECT_FALSE((detail::IsCompletionHandler<decltype(versions_handler),
+                                            PutVersionCompletionHandler>::value));
+}
+
+TEST(ClientUtilsTest, BEH_CompleteGetVersionsOrBranch) {
+  std::error_code error;
+  std::vector<StructuredDataVersions::VersionName> versions;
+  int call_count(0);
+  VersionNamesCompletionHandler handler(
+      [&](std::error_code error_in,
+          std::vector<StructuredDataVersions::VersionName> versions_in) {
+        ++call_count;
+        error = error_in;
+        versions = std::move(versions_in);
+      });
+  CompleteGetVersionsOrBranch(StructuredDataNameAndContentOrReturnCode(), handler);
+  EXPECT_EQ(1, call_count);
+  EXPECT_EQ(make_error_code(CommonErrors::uninitialised), error);
+
+  // A request which expires undecided reports a timeout, not an uninitialised result.
+  ImmutableData::Name name(Identity(RandomString(64)));
+  CompleteGetVersionsOrBranch(VersionsTimedOutResult(name), handler);
+  EXPECT_EQ(2, call_count);
+  EXPECT_EQ(make_error_code(NfsErrors::timed_out), error);
+  EXPECT_TRUE(versions.empty());
+}
+
+TEST(ClientUtilsTest, BEH_OpDataHandsOverChosenResponse) {
+  ImmutableData data(NonEmptyString(RandomString(1024)));
+  DataNameAndContentOrReturnCode received;
+  int call_count(0);
+  nfs::OpData<DataNameAndContentOrReturnCode> op_data(
+      1, [&](DataNameAndContentOrReturnCode response) {
+        ++call_count;
+        received = std::move(response);
+      });
+  op_data.HandleResponseContents(DataNameAndContentOrReturnCode(data));
+  op_data.HandleResponseContents(DataNameAndContentOrReturnCode(data));
+  EXPECT_EQ(1, call_count);
+  EXPECT_EQ(DataNameAndContentOrReturnCode(data), received);
+}
+
+TEST(ClientUtilsTest, BEH_OpDataQuorum) {
+  std::vector<ReturnCode> received;
+  auto callback([&received](ReturnCode response) { received.push_back(response); });
+  {
+    // The operation succeeds as soon as enough successes arrive; later responses are ignored.
+    nfs::OpData<ReturnCode> op_data(2, callback);
+    op_data.HandleResponseContents(ReturnCode());
+    EXPECT_TRUE(received.empty());
+    op_data.HandleResponseContents(ReturnCode());
+    op_data.HandleResponseContents(ReturnCode(CommonErrors::no_such_element));
+    ASSERT_EQ(1U, received.size());
+    EXPECT_TRUE(nfs::IsSuccess(received.front()));
+  }
+  received.clear();
+  {
+    // Once more than half a group has responded without enough successes, the most frequent error
+    // is returned.
+    const int kDecidingResponse(static_cast<int>(routing::Parameters::group_size / 2U) + 1);
+    nfs::OpData<ReturnCode> op_data(kDecidingResponse, callback);
+    op_data.HandleResponseContents(ReturnCode(CommonErrors::invalid_parameter));
+    for (int i(1); i != kDecidingResponse; ++i) {
+      EXPECT_TRUE(received.empty());
+      op_data.HandleResponseContents(ReturnCode(CommonErrors::no_such_element));
+    }
+    ASSERT_EQ(1U, received.size());
+    EXPECT_EQ(make_error_code(CommonErrors::no_such_element), received.front().value);
+  }
+  received.clear();
+  {
+    // An expiry before the outcome is decided reports the given response, and is otherwise ignored.
+    nfs::OpData<ReturnCode> op_data(1, callback);
+    op_data.HandleResponseContents(ReturnCode(CommonErrors::no_such_element));
+    EXPECT_TRUE(op_data.HandleExpiry(ReturnCode(NfsErrors::timed_out)));
+    op_data.HandleResponseContents(ReturnCode());
+    EXPECT_FALSE(op_data.HandleExpiry(ReturnCode(NfsErrors::timed_out)));
+    ASSERT_EQ(1U, received.size());
+    EXPECT_EQ(make_error_code(NfsErrors::timed_out), received.front().value);
+  }
+}
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
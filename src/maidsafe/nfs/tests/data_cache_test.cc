@@ -0,0 +1,155 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/data_cache.h"
+
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/data_types/immutable_data.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+namespace {
+
+const DataTagValue kType(DataTagValue::kImmutableDataValue);
+
+std::vector<Identity> RandomNames(size_t count) {
+  std::vector<Identity> names;
+  for (size_t i(0); i != count; ++i)
+    names.push_back(Identity(RandomString(64)));
+  return names;
+}
+
+}  // unnamed namespace
+
+TEST(DataCacheTest, BEH_ByteBudgetAndStats) {
+  DataCache disabled((DataCacheParameters()));
+  EXPECT_FALSE(disabled.enabled());
+  const Identity kName(RandomString(64));
+  disabled.Put(kType, kName, RandomString(100));
+  EXPECT_FALSE(disabled.Get(kType, kName));
+  EXPECT_EQ(0U, disabled.stats().misses);
+
+  // A budget this small gives a single shard, so eviction order is exact.
+  DataCache cache((DataCacheParameters(1000)));
+  EXPECT_TRUE(cache.enabled());
+  auto names(RandomNames(11));
+  for (size_t i(0); i != 10; ++i)
+    cache.Put(kType, names[i], std::string(100, static_cast<char>(i)));
+  auto stats(cache.stats());
+  EXPECT_EQ(10U, stats.insertions);
+  EXPECT_EQ(10U, stats.entries);
+  EXPECT_EQ(1000U, stats.bytes);
+  EXPECT_EQ(0U, stats.evictions);
+
+  // Re-adding an entry leaves it unchanged; a different type with the same name is distinct.
+  cache.Put(kType, names[0], std::string(100, 'x'));
+  EXPECT_FALSE(cache.Get(DataTagValue::kOwnerDirectoryValue, names[0]));
+  auto content(cache.Get(kType, names[0]));
+  ASSERT_TRUE(static_cast<bool>(content));
+  EXPECT_EQ(std::string(100, 0), *content);
+
+  // The least recently used probationary entry (names[1], as names[0] has been read) is evicted.
+  cache.Put(kType, names[10], std::string(100, 10));
+  EXPECT_FALSE(cache.Get(kType, names[1]));
+  EXPECT_TRUE(static_cast<bool>(cache.Get(kType, names[0])));
+  EXPECT_TRUE(static_cast<bool>(cache.Get(kType, names[10])));
+
+  // Contents larger than the budget aren't cached.
+  const Identity kLargeName(RandomString(64));
+  cache.Put(kType, kLargeName, std::string(1001, 'x'));
+  EXPECT_FALSE(cache.Get(kType, kLargeName));
+
+  stats = cache.stats();
+  EXPECT_EQ(11U, stats.insertions);
+  EXPECT_EQ(1U, stats.evictions);
+  EXPECT_EQ(10U, stats.entries);
+  EXPECT_EQ(1000U, stats.bytes);
+  EXPECT_EQ(3U, stats.hits);
+  EXPECT_EQ(3U, stats.misses);
+}
+
+TEST(DataCacheTest, BEH_ScanResistance) {
+  DataCache cache((DataCacheParameters(1000)));
+  auto hot_names(RandomNames(5));
+  for (const auto& name : hot_names) {
+    cache.Put(kType, name, std::string(100, 'h'));
+    EXPECT_TRUE(static_cast<bool>(cache.Get(kType, name)));
+  }
+
+  // A long scan of entries which are fetched once and never read again doesn't displace the
+  // entries which have been read from the cache.
+  for (const auto& name : RandomNames(50))
+    cache.Put(kType, name, std::string(100, 's'));
+  for (const auto& name : hot_names)
+    EXPECT_TRUE(static_cast<bool>(cache.Get(kType, name)));
+  EXPECT_GE(1000U, cache.stats().bytes);
+}
+
+TEST(DataCacheTest, BEH_DiskTier) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DataCache"));
+  const std::string kContent(RandomString(1000));
+  const Identity kName(crypto::Hash<crypto::SHA512>(kContent).string());
+  {
+    DataCache cache(DataCacheParameters(1000, *test_path, 64 * 1024 * 1024));
+    cache.Put(kType, kName, kContent);
+    // Only ImmutableData is kept on disk.
+    cache.Put(DataTagValue::kOwnerDirectoryValue, kName, kContent);
+    EXPECT_EQ(1U, cache.stats().disk.entries);
+  }
+
+  // After a restart the entry is read from disk, and then from memory.
+  DataCache cache(DataCacheParameters(1000, *test_path, 64 * 1024 * 1024));
+  EXPECT_FALSE(cache.Get(DataTagValue::kOwnerDirectoryValue, kName));
+  for (int i(0); i != 2; ++i) {
+    auto content(cache.Get(kType, kName));
+    ASSERT_TRUE(static_cast<bool>(content));
+    EXPECT_EQ(kContent, *content);
+  }
+  auto stats(cache.stats());
+  EXPECT_EQ(1U, stats.disk_hits);
+  EXPECT_EQ(1U, stats.hits);
+  EXPECT_EQ(1U, stats.misses);
+}
+
+TEST(DataCacheTest, BEH_TypedData) {
+  DataCache cache((DataCacheParameters(1024 * 1024)));
+  ImmutableData data(NonEmptyString(RandomString(1024)));
+  EXPECT_TRUE(cache.Holds<ImmutableData>());
+  EXPECT_FALSE(cache.Get<ImmutableData>(data.name()));
+  cache.Put(data);
+  auto cached(cache.Get<ImmutableData>(data.name()));
+  ASSERT_TRUE(static_cast<bool>(cached));
+  EXPECT_EQ(data.name(), cached->name());
+  EXPECT_EQ(data.data(), cached->data());
+  EXPECT_FALSE(DataCache(DataCacheParameters()).Holds<ImmutableData>());
+}
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
@@ -0,0 +1,157 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/disk_cache.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem/fstream.hpp"
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+namespace {
+
+struct Chunk {
+  explicit Chunk(size_t size)
+      : content(RandomString(size)), name(crypto::Hash<crypto::SHA512>(content).string()) {}
+
+  std::string content;
+  Identity name;
+};
+
+std::vector<Chunk> RandomChunks(size_t count, size_t size) {
+  std::vector<Chunk> chunks;
+  for (size_t i(0); i != count; ++i)
+    chunks.emplace_back(size);
+  return chunks;
+}
+
+void Put(DiskCache& disk_cache, const Identity& name, const std::string& content) {
+  disk_cache.Put(name, std::make_shared<const std::string>(content));
+}
+
+bool Holds(DiskCache& disk_cache, const Chunk& chunk) {
+  auto content(disk_cache.Get(chunk.name));
+  return content && *content == chunk.content;
+}
+
+}  // unnamed namespace
+
+TEST(DiskCacheTest, BEH_PersistsAcrossRestarts) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DiskCache"));
+  const fs::path kDirectory(*test_path / "cache");
+  auto chunks(RandomChunks(10, 1000));
+  {
+    DiskCache disk_cache(kDirectory, 64 * 1024 * 1024);
+    EXPECT_FALSE(disk_cache.Get(chunks[0].name));
+    // Entries are served from the write queue until written, and written before destruction.
+    for (const auto& chunk : chunks)
+      Put(disk_cache, chunk.name, chunk.content);
+    for (const auto& chunk : chunks)
+      EXPECT_TRUE(Holds(disk_cache, chunk));
+    EXPECT_EQ(10U, disk_cache.stats().entries);
+  }
+
+  // A record left incomplete by a crash is discarded when the index is rebuilt.
+  auto segment(kDirectory / "0.segment");
+  auto size(fs::file_size(segment));
+  {
+    fs::ofstream stream(segment, std::ios::binary | std::ios::app);
+    stream << "MSDC" << RandomString(100);
+  }
+  {
+    DiskCache disk_cache(kDirectory, 64 * 1024 * 1024);
+    EXPECT_EQ(10U, disk_cache.stats().entries);
+    EXPECT_EQ(size, fs::file_size(segment));
+    for (const auto& chunk : chunks)
+      EXPECT_TRUE(Holds(disk_cache, chunk));
+    auto chunk(Chunk(1000));
+    Put(disk_cache, chunk.name, chunk.content);
+    EXPECT_TRUE(Holds(disk_cache, chunk));
+    disk_cache.Flush();
+    EXPECT_TRUE(Holds(disk_cache, chunk));
+    EXPECT_EQ(1U, disk_cache.stats().segments);
+  }
+}
+
+TEST(DiskCacheTest, BEH_CorruptEntriesDiscarded) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DiskCache"));
+  DiskCache disk_cache(*test_path, 64 * 1024 * 1024);
+  auto chunk(Chunk(1000));
+  Put(disk_cache, chunk.name, chunk.content);
+  const Identity kWrongName(RandomString(64));
+  Put(disk_cache, kWrongName, chunk.content);
+  disk_cache.Flush();
+  EXPECT_EQ(2U, disk_cache.stats().entries);
+  EXPECT_FALSE(disk_cache.Get(kWrongName));
+  EXPECT_EQ(1U, disk_cache.stats().entries);
+  EXPECT_TRUE(Holds(disk_cache, chunk));
+}
+
+TEST(DiskCacheTest, BEH_Compaction) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DiskCache"));
+  // With this budget, segments hold 4 MiB, so the first seven chunks fill the first segment.
+  const uint64_t kMaxBytes(4 * 1024 * 1024);
+  auto chunks(RandomChunks(8, 512 * 1024));
+  {
+    DiskCache disk_cache(*test_path, kMaxBytes);
+    for (size_t i(0); i != 7; ++i)
+      Put(disk_cache, chunks[i].name, chunks[i].content);
+    disk_cache.Flush();
+    EXPECT_EQ(1U, disk_cache.stats().segments);
+    EXPECT_TRUE(Holds(disk_cache, chunks[0]));
+    EXPECT_TRUE(Holds(disk_cache, chunks[1]));
+
+    // The eighth chunk starts a second segment and takes the total over budget, so the first is
+    // compacted, keeping only the chunks which have been read.
+    Put(disk_cache, chunks[7].name, chunks[7].content);
+    disk_cache.Flush();
+    auto stats(disk_cache.stats());
+    EXPECT_EQ(3U, stats.entries);
+    EXPECT_EQ(1U, stats.segments);
+    EXPECT_GE(kMaxBytes, stats.bytes);
+    EXPECT_EQ(1U, static_cast<size_t>(std::distance(fs::directory_iterator(*test_path),
+                                                    fs::directory_iterator())));
+  }
+  DiskCache disk_cache(*test_path, kMaxBytes);
+  EXPECT_EQ(3U, disk_cache.stats().entries);
+  EXPECT_TRUE(Holds(disk_cache, chunks[0]));
+  EXPECT_TRUE(Holds(disk_cache, chunks[1]));
+  for (size_t i(2); i != 7; ++i)
+    EXPECT_FALSE(disk_cache.Get(chunks[i].name));
+  EXPECT_TRUE(Holds(disk_cache, chunks[7]));
+}
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
@@ -0,0 +1,288 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/get_coalescer.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/thread/future.hpp"
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/nfs/client/cancellation_token.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+namespace {
+
+typedef std::shared_ptr<boost::promise<DataNameAndContentOrReturnCode>> ResultPromise;
+
+// Records the requests sent by a GetCoalescer so that tests can choose when, and with what, each is
+// answered.
+class Sender {
+ public:
+  struct Request {
+    DataNameVariant data_name;
+    std::chrono::steady_clock::duration timeout;
+    GetCoalescer::ResultFunctor result_functor;
+  };
+
+  Sender() : mutex_(), requests_(), cancelled_() {}
+
+  GetCoalescer::SendFunctor functor() {
+    return [this](const DataNameVariant& data_name,
+                  const std::chrono::steady_clock::duration& timeout,
+                  GetCoalescer::ResultFunctor result_functor) -> GetCoalescer::CancelFunctor {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto index(requests_.size());
+      requests_.push_back(Request{data_name, timeout, result_functor});
+      return [this, index] {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_.push_back(index);
+      };
+    };
+  }
+
+  std::vector<Request> requests() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requests_;
+  }
+
+  // The indices into 'requests()' of those which have been cancelled.
+  std::vector<size_t> cancelled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cancelled_;
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::vector<Request> requests_;
+  std::vector<size_t> cancelled_;
+};
+
+GetCoalescer::ResultFunctor ToPromise(ResultPromise promise) {
+  return [promise](DataNameAndContentOrReturnCode result) { promise->set_value(result); };
+}
+
+DataNameAndContentOrReturnCode ContentResponse(const std::string& content) {
+  DataNameAndContentOrReturnCode response;
+  response.content = nfs_vault::Content(content);
+  return response;
+}
+
+bool IsTimedOut(const DataNameAndContentOrReturnCode& result) {
+  return !result.content && result.return_code &&
+         result.return_code->value == make_error_code(NfsErrors::timed_out);
+}
+
+}  // unnamed namespace
+
+TEST(GetCoalescerTest, BEH_ConcurrentGetsShareOneRequest) {
+  AsioService asio_service(2);
+  Sender sender;
+  GetCoalescer coalescer(asio_service, sender.functor());
+  const Identity kName(RandomString(64)), kOtherName(RandomString(64));
+
+  std::vector<ResultPromise> promises;
+  for (int i(0); i != 3; ++i) {
+    promises.push_back(std::make_shared<boost::promise<DataNameAndContentOrReturnCode>>());
+    coalescer.Get(DataTagValue::kImmutableDataValue, kName, std::chrono::seconds(10),
+                  ToPromise(promises.back()));
+  }
+  EXPECT_EQ(1U, sender.requests().size());
+  EXPECT_EQ(1U, coalescer.InFlightCount());
+
+  // The same raw name with a different type, or a different name, gets its own request.
+  auto other_type(std::make_shared<boost::promise<DataNameAndContentOrReturnCode>>());
+  coalescer.Get(DataTagValue::kOwnerDirectoryValue, kName, std::chrono::seconds(10),
+                ToPromise(other_type));
+  auto other_name(std::make_shared<boost::promise<DataNameAndContentOrReturnCode>>());
+  coalescer.Get(DataTagValue::kImmutableDataValue, kOtherName, std::chrono::seconds(10),
+                ToPromise(other_name));
+  auto requests(sender.requests());
+  ASSERT_EQ(3U, requests.size());
+  EXPECT_EQ(3U, coalescer.InFlightCount());
+  EXPECT_TRUE(GetDataNameVariant(DataTagValue::kImmutableDataValue, kName) ==
+              requests[0].data_name);
+
+  // Every caller gets the one response; later responses for the same request are ignored.
+  const std::string kContent(RandomString(100));
+  requests[0].result_functor(ContentResponse(kContent));
+  requests[0].result_functor(ContentResponse(RandomString(100)));
+  for (auto& promise : promises) {
+    auto future(promise->get_future());
+    ASSERT_EQ(boost::future_status::ready, future.wait_for(boost::chrono::seconds(1)));
+    auto result(future.get());
+    ASSERT_TRUE(static_cast<bool>(result.content));
+    EXPECT_EQ(kContent, result.content->data);
+  }
+  EXPECT_EQ(2U, coalescer.InFlightCount());
+
+  // Once complete, a further Get for the name starts a new request.
+  coalescer.Get(DataTagValue::kImmutableDataValue, kName, std::chrono::seconds(10),
+                [](DataNameAndContentOrReturnCode) {});
+  EXPECT_EQ(4U, sender.requests().size());
+  EXPECT_FALSE(other_type->get_future().is_ready());
+  EXPECT_FALSE(other_name->get_future().is_ready());
+}
+
+TEST(GetCoalescerTest, BEH_PerCallerTimeouts) {
+  AsioService asio_service(2);
+  Sender sender;
+  GetCoalescer coalescer(asio_service, sender.functor());
+  const Identity kName(RandomString(64));
+
+  // A caller joining with a shorter timeout than the request's times out alone.
+  auto long_wait(std::make_shared<boost::promise<DataNameAndContentOrReturnCode>>());
+  auto long_wait_future(long_wait->get_future());
+  coalescer.Get(DataTagValue::kImmutableDataValue, kName, std::chrono::seconds(10),
+                ToPromise(long_wait));
+  auto short_wait(std::make_shared<boost::promise<DataNameAndContentOrReturnCode>>());
+  auto short_wait_future(short_wait->get_future());
+  coalescer.Get(DataTagValue::kImmutableDataValue, kName, std::chrono::milliseconds(100),
+                ToPromise(short_wait));
+  ASSERT_EQ(boost::future_status::ready, short_wait_future.wait_for(boost::chrono::seconds(2)));
+  EXPECT_TRUE(IsTimedOut(short_wait_future.get()));
+  EXPECT_FALSE(long_wait_future.is_ready());
+  EXPECT_EQ(1U, coalescer.InFlightCount());
+
+  auto requests(sender.requests());
+  ASSERT_EQ(1U, requests.size());
+  requests[0].result_functor(ContentResponse(RandomString(100)));
+  ASSERT_EQ(boost::future_status::ready, long_wait_future.wait_for(boost::chrono::seconds(1)));
+  EXPECT_TRUE(static_cast<bool>(long_wait_future.get().content));
+  EXPECT_EQ(0U, coalescer.InFlightCount());
+}
+
+TEST(GetCoalescerTest, BEH_TimedOutRequestReissuedForRemainingCallers) {
+  AsioService asio_service(2);
+  Sender sender;
+  GetCoalescer coalescer(asio_service, sender.functor());
+  const Identity kName(RandomString(64));
+
+  auto short_wait(std::make_shared<boost::promise<DataNameAndContentOrReturnCode>>());
+  auto short_wait_future(short_wait->get_future());
+  coalescer.Get(DataTagValue::kImmutableDataValue, kName, std::chrono::milliseconds(100),
+                ToPromise(short_wait));
+  auto long_wait(std::make_shared<boost::promise<DataNameAndContentOrReturnCode>>());
+  auto long_wait_future(long_wait->get_future());
+  coalescer.Get(DataTagValue::kImmutableDataValue, kName, std::chrono::seconds(10),
+                ToPromise(long_wait));
+  ASSERT_EQ(1U, sender.requests().size());
+  EXPECT_GE(std::chrono::milliseconds(100), sender.requests()[0].timeout);
+
+  // The request times out: only the caller whose own timeout has passed is failed, and the request
+  // is sent again for the other.
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  sender.requests()[0].result_functor(DataNameAndContentOrReturnCode());
+  ASSERT_EQ(boost::future_status::ready, short_wait_future.wait_for(boost::chrono::seconds(1)));
+  EXPECT_TRUE(IsTimedOut(short_wait_future.get()));
+  EXPECT_FALSE(long_wait_future.is_ready());
+  auto requests(sender.requests());
+  ASSERT_EQ(2U, requests.size());
+  EXPECT_LT(std::chrono::seconds(9), requests[1].timeout);
+  EXPECT_GE(std::chrono::seconds(10), requests[1].timeout);
+
+  // Responses to the superseded request are ignored.
+  requests[0].result_functor(ContentResponse(RandomString(100)));
+  EXPECT_FALSE(long_wait_future.is_ready());
+  const std::string kContent(RandomString(100));
+  requests[1].result_functor(ContentResponse(kContent));
+  ASSERT_EQ(boost::future_status::ready, long_wait_future.wait_for(boost::chrono::seconds(1)));
+  auto result(long_wait_future.get());
+  ASSERT_TRUE(static_cast<bool>(result.content));
+  EXPECT_EQ(kContent, result.content->data);
+}
+
+TEST(GetCoalescerTest, BEH_SendFailure) {
+  AsioService asio_service(1);
+  GetCoalescer coalescer(asio_service, [](const DataNameVariant&,
+                                          const std::chrono::steady_clock::duration&,
+                                          GetCoalescer::ResultFunctor)
+                                          -> GetCoalescer::CancelFunctor {
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+  });
+  auto promise(std::make_shared<boost::promise<DataNameAndContentOrReturnCode>>());
+  auto future(promise->get_future());
+  coalescer.Get(DataTagValue::kImmutableDataValue, Identity(RandomString(64)),
+                std::chrono::seconds(10), ToPromise(promise));
+  ASSERT_TRUE(future.is_ready());
+  auto result(future.get());
+  ASSERT_TRUE(static_cast<bool>(result.return_code));
+  EXPECT_EQ(make_error_code(CommonErrors::unable_to_handle_request), result.return_code->value);
+  EXPECT_EQ(0U, coalescer.InFlightCount());
+}
+
+TEST(GetCoalescerTest, BEH_Cancel) {
+  AsioService asio_service(2);
+  Sender sender;
+  GetCoalescer coalescer(asio_service, sender.functor());
+  const Identity kName(RandomString(64));
+
+  auto first(std::make_shared<boost::promise<DataNameAndContentOrReturnCode>>());
+  auto first_future(first->get_future());
+  auto first_id(coalescer.Get(DataTagValue::kImmutableDataValue, kName, std::chrono::seconds(10),
+                              ToPromise(first)));
+  auto second(std::make_shared<boost::promise<DataNameAndContentOrReturnCode>>());
+  auto second_future(second->get_future());
+  auto second_id(coalescer.Get(DataTagValue::kImmutableDataValue, kName,
+                               std::chrono::seconds(10), ToPromise(second)));
+  ASSERT_EQ(1U, sender.requests().size());
+
+  // A cancelled caller fails at once, while the request carries on for the other.
+  coalescer.Cancel(DataTagValue::kImmutableDataValue, kName, first_id);
+  ASSERT_TRUE(first_future.is_ready());
+  auto result(first_future.get());
+  ASSERT_TRUE(static_cast<bool>(result.return_code));
+  EXPECT_EQ(CancelledError().code(), result.return_code->value);
+  EXPECT_FALSE(second_future.is_ready());
+  EXPECT_TRUE(sender.cancelled().empty());
+  EXPECT_EQ(1U, coalescer.InFlightCount());
+
+  // Cancelling again, or with an unknown id, does nothing.
+  coalescer.Cancel(DataTagValue::kImmutableDataValue, kName, first_id);
+  coalescer.Cancel(DataTagValue::kImmutableDataValue, kName, second_id + 100);
+  EXPECT_FALSE(second_future.is_ready());
+
+  // Once no callers are left, the request is cancelled and any later response is ignored.
+  coalescer.Cancel(DataTagValue::kImmutableDataValue, kName, second_id);
+  ASSERT_TRUE(second_future.is_ready());
+  EXPECT_EQ(CancelledError().code(), second_future.get().return_code->value);
+  ASSERT_EQ(1U, sender.cancelled().size());
+  EXPECT_EQ(0U, sender.cancelled()[0]);
+  EXPECT_EQ(0U, coalescer.InFlightCount());
+  sender.requests()[0].result_functor(ContentResponse(RandomString(100)));
+  EXPECT_EQ(0U, coalescer.InFlightCount());
+}
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
@@ -0,0 +1,272 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/get_handler.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/data_types/immutable_data.h"
+
+#include "maidsafe/nfs/pending_operations.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+namespace {
+
+const std::chrono::milliseconds kRoundTrip(50);
+const std::chrono::seconds kTimeout(10);
+
+DataNameAndContentOrReturnCode NoSuchElement(const ImmutableData::Name& name) {
+  return DataNameAndContentOrReturnCode(name, ReturnCode(CommonErrors::no_such_element));
+}
+
+}  // unnamed namespace
+
+// Drives a GetHandler directly, recording the requests it sends so that tests can choose when, and
+// with what, each is answered.
+class GetHandlerTest : public testing::Test {
+ protected:
+  struct Request {
+    nfs::TaskId task_id;
+    boost::optional<routing::Cacheable> cacheable;
+  };
+
+  struct Outcome {
+    std::error_code error;
+    boost::optional<ImmutableData> data;
+  };
+
+  GetHandlerTest()
+      : asio_service_(2),
+        latency_estimator_(),
+        data_cache_(DataCacheParameters()),
+        negative_cache_(),
+        pending_operations_(asio_service_),
+        mutex_(),
+        cond_var_(),
+        requests_(),
+        outcomes_(),
+        get_handler_() {}
+
+  // Records 'count' Get round trips of 'kRoundTrip'.
+  void AddGetSamples(size_t count) {
+    for (size_t i(0); i != count; ++i)
+      latency_estimator_.AddSample(LatencyEstimator::Operation::kGet, 1024, kRoundTrip);
+  }
+
+  void CreateHandler(const HedgeParameters& hedge_parameters,
+                     const NegativeCache::TimeToLives& time_to_lives =
+                         NegativeCache::TimeToLives()) {
+    negative_cache_.reset(new NegativeCache(time_to_lives));
+    get_handler_.reset(new GetHandler(
+        asio_service_, pending_operations_,
+        [this](nfs::TaskId task_id, const DataNameVariant&,
+               boost::optional<routing::Cacheable> cacheable) {
+          {
+            std::lock_guard<std::mutex> lock(mutex_);
+            requests_.push_back(Request{task_id, cacheable});
+          }
+          cond_var_.notify_all();
+        },
+        data_cache_, *negative_cache_, latency_estimator_, hedge_parameters));
+  }
+
+  void Get(const ImmutableData::Name& name) {
+    get_handler_->Get(name, [this](std::error_code error, boost::optional<ImmutableData> data) {
+                              {
+                                std::lock_guard<std::mutex> lock(mutex_);
+                                outcomes_.push_back(Outcome{error, std::move(data)});
+                              }
+                              cond_var_.notify_all();
+                            },
+                      kTimeout);
+  }
+
+  void Respond(nfs::TaskId task_id, const DataNameAndContentOrReturnCode& response) {
+    get_handler_->AddResponse(task_id, response);
+  }
+
+  // Waits until at least 'count' requests have been sent, or 'timeout' has passed.
+  std::vector<Request> WaitForRequests(size_t count, const std::chrono::milliseconds& timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_var_.wait_for(lock, timeout, [&] { return requests_.size() >= count; });
+    return requests_;
+  }
+
+  // Waits until at least 'count' Gets have completed, or 'timeout' has passed.
+  std::vector<Outcome> WaitForOutcomes(size_t count, const std::chrono::milliseconds& timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_var_.wait_for(lock, timeout, [&] { return outcomes_.size() >= count; });
+    return outcomes_;
+  }
+
+  AsioService asio_service_;
+  // Declared before 'pending_operations_' and the handler, as they require.
+  LatencyEstimator latency_estimator_;
+  DataCache data_cache_;
+  std::unique_ptr<NegativeCache> negative_cache_;
+  nfs::PendingOperations pending_operations_;
+  std::mutex mutex_;
+  std::condition_variable cond_var_;
+  std::vector<Request> requests_;
+  std::vector<Outcome> outcomes_;
+  std::unique_ptr<GetHandler> get_handler_;
+};
+
+TEST_F(GetHandlerTest, BEH_HedgeSentAfterPercentileDelay) {
+  HedgeParameters hedge_parameters(0.9, routing::Cacheable::kGet);
+  AddGetSamples(hedge_parameters.minimum_samples);
+  CreateHandler(hedge_parameters);
+  ImmutableData data(NonEmptyString(RandomString(1024)));
+  auto start(std::chrono::steady_clock::now());
+  Get(data.name());
+  auto requests(WaitForRequests(2, std::chrono::seconds(5)));
+  ASSERT_EQ(2U, requests.size());
+  EXPECT_GE(std::chrono::steady_clock::now() - start, kRoundTrip);
+  EXPECT_FALSE(requests[0].cacheable);
+  ASSERT_TRUE(static_cast<bool>(requests[1].cacheable));
+  EXPECT_EQ(routing::Cacheable::kGet, *requests[1].cacheable);
+
+  // The first content, here the hedge's, completes the Get and the other request is cancelled.
+  Respond(requests[1].task_id, DataNameAndContentOrReturnCode(data));
+  auto outcomes(WaitForOutcomes(1, std::chrono::seconds(5)));
+  ASSERT_EQ(1U, outcomes.size());
+  EXPECT_FALSE(outcomes[0].error);
+  ASSERT_TRUE(static_cast<bool>(outcomes[0].data));
+  EXPECT_EQ(data.name(), outcomes[0].data->name());
+  EXPECT_FALSE(pending_operations_.HasTask(requests[0].task_id));
+
+  // Later content for the original request is dropped.
+  Respond(requests[0].task_id, DataNameAndContentOrReturnCode(data));
+  EXPECT_EQ(1U, WaitForOutcomes(2, std::chrono::milliseconds(100)).size());
+}
+
+TEST_F(GetHandlerTest, BEH_FailureWaitsForOutstandingHedge) {
+  HedgeParameters hedge_parameters(0.9);
+  AddGetSamples(hedge_parameters.minimum_samples);
+  CreateHandler(hedge_parameters);
+  ImmutableData data(NonEmptyString(RandomString(1024)));
+  Get(data.name());
+  auto requests(WaitForRequests(2, std::chrono::seconds(5)));
+  ASSERT_EQ(2U, requests.size());
+  // Without a cacheability given, the hedge uses the one for the data type.
+  EXPECT_FALSE(requests[1].cacheable);
+
+  // The original request ending without a result (as on expiry) leaves the Get to the hedge.
+  Respond(requests[0].task_id, DataNameAndContentOrReturnCode());
+  EXPECT_FALSE(pending_operations_.HasTask(requests[0].task_id));
+  EXPECT_TRUE(WaitForOutcomes(1, std::chrono::milliseconds(100)).empty());
+
+  Respond(requests[1].task_id, DataNameAndContentOrReturnCode(data));
+  auto outcomes(WaitForOutcomes(1, std::chrono::seconds(5)));
+  ASSERT_EQ(1U, outcomes.size());
+  EXPECT_FALSE(outcomes[0].error);
+  EXPECT_TRUE(static_cast<bool>(outcomes[0].data));
+}
+
+TEST_F(GetHandlerTest, BEH_NoHedgeWhenDisabled) {
+  AddGetSamples(HedgeParameters().minimum_samples);
+  CreateHandler(HedgeParameters());
+  Get(ImmutableData::Name(Identity(RandomString(64))));
+  EXPECT_EQ(1U, WaitForRequests(2, 4 * kRoundTrip).size());
+}
+
+TEST_F(GetHandlerTest, BEH_NoHedgeWithoutEnoughSamples) {
+  HedgeParameters hedge_parameters(0.9);
+  AddGetSamples(hedge_parameters.minimum_samples - 1);
+  CreateHandler(hedge_parameters);
+  Get(ImmutableData::Name(Identity(RandomString(64))));
+  EXPECT_EQ(1U, WaitForRequests(2, 4 * kRoundTrip).size());
+}
+
+TEST_F(GetHandlerTest, BEH_NoHedgeOnceDestroyed) {
+  HedgeParameters hedge_parameters(0.9);
+  AddGetSamples(hedge_parameters.minimum_samples);
+  CreateHandler(hedge_parameters);
+  Get(ImmutableData::Name(Identity(RandomString(64))));
+  ASSERT_EQ(1U, WaitForRequests(1, std::chrono::seconds(5)).size());
+  get_handler_.reset();
+  EXPECT_EQ(1U, WaitForRequests(2, 4 * kRoundTrip).size());
+}
+
+TEST_F(GetHandlerTest, BEH_WholeGroupMissingFailsGet) {
+  NegativeCache::TimeToLives time_to_lives;
+  time_to_lives[DataTagValue::kImmutableDataValue] = std::chrono::minutes(1);
+  CreateHandler(HedgeParameters(), time_to_lives);
+  ImmutableData::Name name(Identity(RandomString(64)));
+  Get(name);
+  auto requests(WaitForRequests(1, std::chrono::seconds(5)));
+  ASSERT_EQ(1U, requests.size());
+  for (int i(0); i != routing::Parameters::group_size; ++i)
+    Respond(requests[0].task_id, NoSuchElement(name));
+
+  // The Get fails rather than being reissued, and the failure is cached.
+  auto outcomes(WaitForOutcomes(1, std::chrono::seconds(5)));
+  ASSERT_EQ(1U, outcomes.size());
+  EXPECT_EQ(make_error_code(CommonErrors::no_such_element), outcomes[0].error);
+  EXPECT_FALSE(outcomes[0].data);
+  EXPECT_EQ(1U, WaitForRequests(2, std::chrono::milliseconds(100)).size());
+  EXPECT_TRUE(static_cast<bool>(
+      negative_cache_->Get(DataTagValue::kImmutableDataValue, name.value)));
+
+  // A repeat Get is answered locally, before it returns.
+  Get(name);
+  outcomes = WaitForOutcomes(2, std::chrono::milliseconds(0));
+  ASSERT_EQ(2U, outcomes.size());
+  EXPECT_EQ(make_error_code(CommonErrors::no_such_element), outcomes[1].error);
+  EXPECT_EQ(1U, WaitForRequests(2, std::chrono::milliseconds(0)).size());
+
+  // Putting the name (as MaidNodeNfs::Put does) removes the cached failure, so the next Get is
+  // sent.
+  negative_cache_->Remove(DataTagValue::kImmutableDataValue, name.value);
+  Get(name);
+  EXPECT_EQ(2U, WaitForRequests(2, std::chrono::seconds(5)).size());
+}
+
+TEST_F(GetHandlerTest, BEH_WholeGroupMissingReissuedIfNotCached) {
+  CreateHandler(HedgeParameters());
+  ImmutableData::Name name(Identity(RandomString(64)));
+  Get(name);
+  auto requests(WaitForRequests(1, std::chrono::seconds(5)));
+  ASSERT_EQ(1U, requests.size());
+  for (int i(0); i != routing::Parameters::group_size; ++i)
+    Respond(requests[0].task_id, NoSuchElement(name));
+  EXPECT_EQ(2U, WaitForRequests(2, std::chrono::seconds(5)).size());
+  EXPECT_TRUE(WaitForOutcomes(1, std::chrono::milliseconds(0)).empty());
+  EXPECT_EQ(0U, negative_cache_->size());
+}
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
@@ -0,0 +1,144 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/latency_estimator.h"
+
+#include <chrono>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+namespace {
+
+typedef LatencyEstimator::Operation Operation;
+typedef std::chrono::milliseconds ms;
+
+}  // unnamed namespace
+
+TEST(LatencyEstimatorTest, BEH_SmoothedMeanAndDeviation) {
+  LatencyEstimator estimator(std::chrono::seconds(10), ms(100), std::chrono::seconds(60));
+  EXPECT_EQ(std::chrono::seconds(10), estimator.Timeout(Operation::kPut, 1000));
+  EXPECT_EQ(std::chrono::seconds(10), estimator.Timeout(Operation::kPut));
+
+  // The first sample R gives a mean of R and deviation of R/2, so a timeout of 3R.
+  estimator.AddSample(Operation::kPut, 1000, ms(200));
+  EXPECT_EQ(ms(600), estimator.Timeout(Operation::kPut, 1000));
+  EXPECT_EQ(ms(600), estimator.Timeout(Operation::kPut));
+  // Other operations and sizes are unaffected.
+  EXPECT_EQ(std::chrono::seconds(10), estimator.Timeout(Operation::kGet));
+  EXPECT_EQ(std::chrono::seconds(10), estimator.Timeout(Operation::kPut, 1024 * 1024));
+
+  // deviation = (3 * 100 + |200 - 600|) / 4 = 175, mean = (7 * 200 + 600) / 8 = 250.
+  estimator.AddSample(Operation::kPut, 1000, ms(600));
+  EXPECT_EQ(ms(250 + 4 * 175), estimator.Timeout(Operation::kPut, 1000));
+
+  // Steady round trips converge on the round trip, but not below the minimum.
+  for (int i(0); i < 200; ++i)
+    estimator.AddSample(Operation::kPut, 1000, ms(50));
+  EXPECT_EQ(ms(100), estimator.Timeout(Operation::kPut, 1000));
+
+  auto estimates(estimator.estimates());
+  ASSERT_EQ(1U, estimates.size());
+  const auto& put_estimates(estimates[Operation::kPut]);
+  EXPECT_EQ(202U, put_estimates.all_sizes.samples);
+  ASSERT_EQ(1U, put_estimates.by_size.size());
+  EXPECT_EQ(0U, put_estimates.by_size.begin()->first);
+  EXPECT_EQ(202U, put_estimates.by_size.begin()->second.samples);
+}
+
+TEST(LatencyEstimatorTest, BEH_BackOff) {
+  LatencyEstimator estimator(std::chrono::seconds(10), ms(100), std::chrono::seconds(20));
+  estimator.AddSample(Operation::kGetVersions, 0, ms(1000));
+  EXPECT_EQ(ms(3000), estimator.Timeout(Operation::kGetVersions, 0));
+  estimator.AddTimeout(Operation::kGetVersions, 0);
+  EXPECT_EQ(ms(6000), estimator.Timeout(Operation::kGetVersions, 0));
+  estimator.AddTimeout(Operation::kGetVersions, 0);
+  estimator.AddTimeout(Operation::kGetVersions, 0);
+  EXPECT_EQ(std::chrono::seconds(20), estimator.Timeout(Operation::kGetVersions, 0));
+  // A measured round trip replaces the backed-off timeout.
+  estimator.AddSample(Operation::kGetVersions, 0, ms(1000));
+  EXPECT_EQ(ms(1000 + 4 * 375), estimator.Timeout(Operation::kGetVersions, 0));
+  EXPECT_EQ(3U, estimator.estimates()[Operation::kGetVersions].all_sizes.timeouts);
+
+  // An operation without samples backs off from the initial timeout.
+  estimator.AddTimeout(Operation::kGet, 0);
+  EXPECT_EQ(std::chrono::seconds(20), estimator.Timeout(Operation::kGet));
+
+  // A response which only arrived once the timeout had passed is the one given on expiry.
+  auto sent(std::chrono::steady_clock::now() - ms(500));
+  estimator.AddResponse(Operation::kPutVersion, 0, sent, ms(400));
+  EXPECT_EQ(std::chrono::seconds(20), estimator.Timeout(Operation::kPutVersion));
+  estimator.AddResponse(Operation::kPutVersion, 0, sent, std::chrono::seconds(5));
+  EXPECT_EQ(1U, estimator.estimates()[Operation::kPutVersion].all_sizes.samples);
+  EXPECT_GT(std::chrono::seconds(20), estimator.Timeout(Operation::kPutVersion));
+}
+
+TEST(LatencyEstimatorTest, BEH_SizeBucketsAndResolve) {
+  EXPECT_EQ(0U, LatencyEstimator::SizeBucket(0));
+  EXPECT_EQ(0U, LatencyEstimator::SizeBucket(4095));
+  EXPECT_EQ(4096U, LatencyEstimator::SizeBucket(4096));
+  EXPECT_EQ(4096U, LatencyEstimator::SizeBucket(16383));
+  EXPECT_EQ(16384U, LatencyEstimator::SizeBucket(16384));
+  EXPECT_EQ(1024U * 1024U, LatencyEstimator::SizeBucket(1024 * 1024 + 1));
+  EXPECT_EQ(16U * 1024U * 1024U, LatencyEstimator::SizeBucket(1ULL << 40));
+
+  LatencyEstimator estimator(std::chrono::seconds(10), ms(100), std::chrono::seconds(60));
+  estimator.AddSample(Operation::kPut, 1024 * 1024, ms(2000));
+  estimator.AddSample(Operation::kPut, 100, ms(200));
+  EXPECT_EQ(ms(6000), estimator.Timeout(Operation::kPut, 1024 * 1024 + 1000));
+  EXPECT_EQ(ms(600), estimator.Timeout(Operation::kPut, 200));
+  EXPECT_EQ(ms(600), estimator.ResolveTimeout(Operation::kPut, kAdaptiveTimeout, 200));
+  EXPECT_EQ(ms(1), estimator.ResolveTimeout(Operation::kPut, ms(1), 200));
+  EXPECT_EQ(estimator.Timeout(Operation::kPut),
+            estimator.ResolveTimeout(Operation::kPut, kAdaptiveTimeout));
+  EXPECT_EQ(2U, estimator.estimates()[Operation::kPut].by_size.size());
+
+  EXPECT_THROW(LatencyEstimator(ms(10), ms(0), ms(100)), maidsafe_error);
+  EXPECT_THROW(LatencyEstimator(ms(10), ms(20), ms(100)), maidsafe_error);
+  EXPECT_THROW(LatencyEstimator(ms(200), ms(20), ms(100)), maidsafe_error);
+}
+
+TEST(LatencyEstimatorTest, BEH_Percentile) {
+  LatencyEstimator estimator;
+  EXPECT_FALSE(estimator.Percentile(Operation::kGet, 0.9, 1));
+  for (int i(1); i <= 100; ++i)
+    estimator.AddSample(Operation::kGet, static_cast<uint64_t>(i) * 1000, ms(i));
+  EXPECT_FALSE(estimator.Percentile(Operation::kGet, 0.9, 101));
+  EXPECT_FALSE(estimator.Percentile(Operation::kPut, 0.9, 1));
+  ASSERT_TRUE(estimator.Percentile(Operation::kGet, 0.9, 100));
+  EXPECT_EQ(ms(90), *estimator.Percentile(Operation::kGet, 0.9, 100));
+  EXPECT_EQ(ms(1), *estimator.Percentile(Operation::kGet, 0.0, 1));
+  EXPECT_EQ(ms(100), *estimator.Percentile(Operation::kGet, 1.0, 1));
+
+  // Only the most recent round trips count.
+  for (int i(0); i < 1000; ++i)
+    estimator.AddSample(Operation::kGet, 0, ms(500));
+  EXPECT_EQ(ms(500), *estimator.Percentile(Operation::kGet, 0.0, 1));
+}
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
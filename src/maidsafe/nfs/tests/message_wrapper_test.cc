@@ -18,7 +18,12 @@
 
 #include "maidsafe/nfs/message_wrapper.h"
 
+#include <algorithm>
+#include <cerrno>
 #include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 #include "boost/variant/static_visitor.hpp"
 #include "boost/variant/variant.hpp"
@@ -28,9 +33,12 @@
 #include "maidsafe/common/utils.h"
 
 #include "maidsafe/nfs/message_types.h"
+#include "maidsafe/nfs/scratch_protobuf.h"
 #include "maidsafe/nfs/client/messages.h"
 #include "maidsafe/nfs/vault/messages.h"
 #include "maidsafe/nfs/types.h"
+#include "maidsafe/nfs/wire_format.h"
+#include "maidsafe/nfs/message_wrapper.pb.h"
 
 namespace maidsafe {
 
@@ -166,6 +174,187 @@ TEST(MessageWrapperTest, BEH_CheckVariant) {
   EXPECT_THROW(data_manager_service.HandleMessage(tuple_del), maidsafe_error);
 }
 
+TEST(MessageWrapperTest, BEH_FlatAndLegacyEncodings) {
+  ImmutableData data(NonEmptyString(RandomString(1024 * 1024)));
+  PutRequest::Contents put_contents;
+  put_contents.data = nfs_vault::DataNameAndContent(data);
+  put_contents.pmid_hint = Identity(RandomString(crypto::SHA512::DIGESTSIZE));
+  PutRequest put(put_contents);
+
+  // The single-pass contents writer must remain readable by the protobuf-based parser.
+  EXPECT_TRUE(put_contents == PutRequest::Contents(put_contents.Serialise()));
+
+  auto parsed(ParseMessageWrapper(put.Serialise()));
+  EXPECT_EQ(MessageAction::kPutRequest, std::get<0>(parsed));
+  EXPECT_EQ(Persona::kMaidNode, std::get<1>(parsed).data);
+  EXPECT_EQ(Persona::kMaidManager, std::get<2>(parsed).data);
+  EXPECT_EQ(put.id, std::get<3>(parsed));
+  EXPECT_TRUE(put == PutRequest(parsed));
+
+  auto legacy_serialised(detail::SerialiseMessageWrapper(std::make_tuple(
+      MessageAction::kPutRequest, detail::SourceTaggedValue(Persona::kMaidNode),
+      detail::DestinationTaggedValue(Persona::kMaidManager), put.id,
+      SharedBuffer(put_contents.Serialise()))));
+  EXPECT_TRUE(put == PutRequest(ParseMessageWrapper(legacy_serialised)));
+
+  EXPECT_THROW(ParseMessageWrapper(std::string(1, 0)), maidsafe_error);
+}
+
+TEST(MessageWrapperTest, BEH_SharedBufferViews) {
+  auto serialised(std::make_shared<const std::string>("0123456789"));
+  SharedBuffer whole(serialised, 0, serialised->size());
+  SharedBuffer middle(whole.Slice(2, 5));
+  EXPECT_EQ("23456", middle.string());
+  EXPECT_EQ(serialised->data() + 2, middle.data());
+  EXPECT_EQ("456", middle.Slice(2, 3).string());
+  EXPECT_TRUE(SharedBuffer(std::string("23456")) == middle);
+  EXPECT_TRUE(middle.Slice(5, 0).empty());
+  EXPECT_THROW(middle.Slice(3, 3), maidsafe_error);
+  EXPECT_THROW(SharedBuffer(serialised, 8, 3), maidsafe_error);
+
+  // Contents of a flat-encoded message are parsed as a view of the received buffer.
+  PutRequest::Contents put_contents;
+  put_contents.data = nfs_vault::DataNameAndContent(ImmutableData(NonEmptyString("data")));
+  put_contents.pmid_hint = Identity(RandomString(crypto::SHA512::DIGESTSIZE));
+  PutRequest put(put_contents);
+  SharedBuffer received(put.Serialise());
+  auto parsed(ParseMessageWrapper(received));
+  EXPECT_EQ(received.data() + received.size() - std::get<4>(parsed).size(),
+            std::get<4>(parsed).data());
+  EXPECT_TRUE(put == PutRequest(parsed));
+}
+
+TEST(MessageWrapperTest, BEH_LazyContents) {
+  PutRequest::Contents put_contents;
+  put_contents.data = nfs_vault::DataNameAndContent(ImmutableData(NonEmptyString("data")));
+  put_contents.pmid_hint = Identity(RandomString(crypto::SHA512::DIGESTSIZE));
+  PutRequest put(put_contents);
+  EXPECT_TRUE(put.contents.decoded());
+
+  auto parsed(ParseMessageWrapper(put.Serialise()));
+  PutRequest received(parsed);
+  EXPECT_EQ(put.id, received.id);
+  EXPECT_TRUE(static_cast<bool>(received.contents));
+  EXPECT_FALSE(received.contents.decoded());
+  EXPECT_EQ(std::get<4>(parsed).size(), received.contents.serialised_size());
+
+  // Copies share decoded state.
+  PutRequest copy(received);
+  EXPECT_EQ(put_contents.pmid_hint, copy.contents->pmid_hint);
+  EXPECT_TRUE(received.contents.decoded());
+  EXPECT_EQ(0U, received.contents.serialised_size());
+  EXPECT_TRUE(put == received);
+
+  // Malformed contents are only detected when accessed.
+  auto malformed(parsed);
+  std::get<4>(malformed) = SharedBuffer(std::string("\xFF"));
+  PutRequest malformed_put(malformed);
+  EXPECT_THROW(*malformed_put.contents, maidsafe_error);
+
+  PutRequest empty;
+  EXPECT_FALSE(static_cast<bool>(empty.contents));
+  EXPECT_THROW(*empty.contents, maidsafe_error);
+}
+
+TEST(MessageWrapperTest, BEH_ScratchProtobuf) {
+  const protobuf::MessageWrapper* outer_address(nullptr);
+  {
+    detail::ScratchProtobuf<protobuf::MessageWrapper> outer;
+    outer_address = &*outer;
+    outer->set_serialised_contents(RandomString(100));
+    // Nested use of the same type must not share the thread's instance.
+    detail::ScratchProtobuf<protobuf::MessageWrapper> inner;
+    EXPECT_NE(outer_address, &*inner);
+    EXPECT_FALSE(inner->has_serialised_contents());
+  }
+  {
+    // The thread's instance is reused, and is cleared before reuse.
+    detail::ScratchProtobuf<protobuf::MessageWrapper> reused;
+    EXPECT_EQ(outer_address, &*reused);
+    EXPECT_FALSE(reused->has_serialised_contents());
+  }
+  {
+    // The same type on another thread gets a different instance.
+    const protobuf::MessageWrapper* other_thread_address(nullptr);
+    std::thread([&] {
+      detail::ScratchProtobuf<protobuf::MessageWrapper> other;
+      other_thread_address = &*other;
+    }).join();
+    EXPECT_NE(outer_address, other_thread_address);
+  }
+}
+
+// See message_id_benchmark.cc for the cost of generating ids.
+TEST(MessageWrapperTest, BEH_MessageIdGeneration) {
+  const int kThreadCount(8);
+  // Enough for each thread to use several blocks of ids.
+  const int kIdsPerThread(1 << 14);
+  std::vector<std::vector<int64_t>> ids(kThreadCount);
+  std::vector<std::thread> threads;
+  for (int i(0); i != kThreadCount; ++i) {
+    threads.push_back(std::thread([&ids, i, kIdsPerThread] {
+      auto& thread_ids(ids[i]);
+      thread_ids.reserve(kIdsPerThread);
+      for (int j(0); j != kIdsPerThread; ++j)
+        thread_ids.push_back(detail::GetNewMessageId().data);
+    }));
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  std::vector<int64_t> all_ids;
+  all_ids.reserve(kThreadCount * kIdsPerThread);
+  for (const auto& thread_ids : ids) {
+    // Each thread sees its own ids in increasing order.
+    EXPECT_TRUE(std::is_sorted(std::begin(thread_ids), std::end(thread_ids)));
+    all_ids.insert(std::end(all_ids), std::begin(thread_ids), std::end(thread_ids));
+  }
+  std::sort(std::begin(all_ids), std::end(all_ids));
+  EXPECT_TRUE(std::adjacent_find(std::begin(all_ids), std::end(all_ids)) == std::end(all_ids));
+  // All ids share this process's prefix.
+  EXPECT_EQ(all_ids.front() >> 40, all_ids.back() >> 40);
+}
+
+TEST(MessageWrapperTest, BEH_CompactReturnCode) {
+  // Success is the default, so serialises to nothing.
+  nfs_client::ReturnCode success;
+  EXPECT_TRUE(success.Serialise().empty());
+  EXPECT_EQ(success, nfs_client::ReturnCode(success.Serialise()));
+  EXPECT_TRUE(IsSuccess(success));
+
+  nfs_client::ReturnCode timed_out(NfsErrors::timed_out);
+  auto serialised(timed_out.Serialise());
+  EXPECT_GT(8U, serialised.size());
+  nfs_client::ReturnCode parsed(serialised);
+  EXPECT_EQ(timed_out, parsed);
+  EXPECT_FALSE(IsSuccess(parsed));
+  EXPECT_EQ(make_error_code(NfsErrors::timed_out), ErrorCode(parsed));
+  try {
+    boost::throw_exception(parsed.error());
+    FAIL() << "error() should be thrown";
+  }
+  catch (const maidsafe_error& error) {
+    EXPECT_EQ(make_error_code(NfsErrors::timed_out), error.code());
+  }
+  EXPECT_EQ(timed_out, nfs_client::ReturnCode(MakeError(NfsErrors::timed_out)));
+
+  // Older peers send the category by name.
+  std::string legacy("\x08");
+  detail::AppendVarint(static_cast<uint64_t>(NfsErrors::timed_out), legacy);
+  detail::AppendLengthDelimitedField(2, GetNfsCategory().name(), legacy);
+  EXPECT_EQ(timed_out, nfs_client::ReturnCode(legacy));
+
+  // Categories which aren't interned, e.g. the generic one CancelledError uses, are sent by name.
+  nfs_client::ReturnCode cancelled(std::make_error_code(std::errc::operation_canceled));
+  EXPECT_EQ(cancelled, nfs_client::ReturnCode(cancelled.Serialise()));
+  nfs_client::ReturnCode system_error(std::error_code(EINVAL, std::system_category()));
+  EXPECT_EQ(system_error, nfs_client::ReturnCode(system_error.Serialise()));
+
+  std::string unknown_category("\x18");
+  detail::AppendVarint(100, unknown_category);
+  EXPECT_THROW(nfs_client::ReturnCode code(unknown_category), maidsafe_error);
+}
+
 /*
  TEST_F(MessageWrapperTest, BEH_SerialiseThenParse) {
   auto serialised_message(message_.Serialise());
@@ -0,0 +1,86 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/negative_cache.h"
+
+#include <chrono>
+#include <thread>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+TEST(NegativeCacheTest, BEH_TimeToLivePerType) {
+  NegativeCache::TimeToLives time_to_lives;
+  time_to_lives[DataTagValue::kImmutableDataValue] = std::chrono::milliseconds(100);
+  time_to_lives[DataTagValue::kOwnerDirectoryValue] = std::chrono::seconds(10);
+  NegativeCache negative_cache(time_to_lives);
+  EXPECT_TRUE(negative_cache.Holds(DataTagValue::kImmutableDataValue));
+  EXPECT_FALSE(negative_cache.Holds(DataTagValue::kPmidValue));
+
+  const Identity kName(RandomString(64));
+  const ReturnCode kFailure(CommonErrors::no_such_element);
+  EXPECT_FALSE(negative_cache.Get(DataTagValue::kImmutableDataValue, kName));
+  negative_cache.Add(DataTagValue::kImmutableDataValue, kName, kFailure);
+  negative_cache.Add(DataTagValue::kOwnerDirectoryValue, kName, kFailure);
+  negative_cache.Add(DataTagValue::kPmidValue, kName, kFailure);
+  EXPECT_EQ(2U, negative_cache.size());
+  auto failure(negative_cache.Get(DataTagValue::kImmutableDataValue, kName));
+  ASSERT_TRUE(static_cast<bool>(failure));
+  EXPECT_EQ(kFailure.value, failure->value);
+  EXPECT_FALSE(negative_cache.Get(DataTagValue::kPmidValue, kName));
+
+  // Each entry expires after its type's time to live.
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  EXPECT_FALSE(negative_cache.Get(DataTagValue::kImmutableDataValue, kName));
+  EXPECT_TRUE(static_cast<bool>(negative_cache.Get(DataTagValue::kOwnerDirectoryValue, kName)));
+
+  // Expired entries are purged as others are added.
+  for (int i(0); i != 10; ++i) {
+    negative_cache.Add(DataTagValue::kImmutableDataValue, Identity(RandomString(64)), kFailure);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  negative_cache.Add(DataTagValue::kImmutableDataValue, kName, kFailure);
+  EXPECT_EQ(2U, negative_cache.size());
+
+  negative_cache.Remove(DataTagValue::kOwnerDirectoryValue, kName);
+  EXPECT_FALSE(negative_cache.Get(DataTagValue::kOwnerDirectoryValue, kName));
+  EXPECT_EQ(1U, negative_cache.size());
+}
+
+TEST(NegativeCacheTest, BEH_Disabled) {
+  NegativeCache negative_cache((NegativeCache::TimeToLives()));
+  const Identity kName(RandomString(64));
+  EXPECT_FALSE(negative_cache.Holds(DataTagValue::kImmutableDataValue));
+  negative_cache.Add(DataTagValue::kImmutableDataValue, kName,
+                     ReturnCode(CommonErrors::no_such_element));
+  EXPECT_EQ(0U, negative_cache.size());
+  EXPECT_FALSE(negative_cache.Get(DataTagValue::kImmutableDataValue, kName));
+}
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
@@ -0,0 +1,161 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/pending_operations.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "boost/thread/future.hpp"
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace test {
+
+TEST(PendingOperationsTest, BEH_ResponsesAndTimeouts) {
+  AsioService asio_service(2);
+  PendingOperations pending_operations(asio_service);
+
+  // A task completes after its expected number of responses, and only accepts responses of the
+  // type it was added with.
+  std::vector<int> responses;
+  auto task_id(pending_operations.NewTaskId());
+  pending_operations.AddTask<int>(std::chrono::seconds(10),
+                                  [&responses](int response) { responses.push_back(response); },
+                                  2, task_id);
+  EXPECT_THROW(pending_operations.AddTask<int>(std::chrono::seconds(10), [](int) {}, 1, task_id),
+               maidsafe_error);
+  EXPECT_TRUE(pending_operations.HasTask(task_id));
+  EXPECT_FALSE(pending_operations.AddResponse(task_id, std::string("wrong type")));
+  EXPECT_TRUE(pending_operations.AddResponse(task_id, 1));
+  EXPECT_TRUE(pending_operations.HasTask(task_id));
+  EXPECT_TRUE(pending_operations.AddResponse(task_id, 2));
+  EXPECT_FALSE(pending_operations.HasTask(task_id));
+  EXPECT_FALSE(pending_operations.AddResponse(task_id, 3));
+  EXPECT_EQ(std::vector<int>({1, 2}), responses);
+
+  // Task ids are the full 64-bit message ids, so ids differing only above the low 32 bits are
+  // distinct tasks.
+  auto low_bits_task_id(pending_operations.NewTaskId());
+  auto high_bits_task_id(low_bits_task_id ^ (TaskId(1) << 40));
+  pending_operations.AddTask<int>(std::chrono::seconds(10), [](int) {}, 1, low_bits_task_id);
+  pending_operations.AddTask<int>(std::chrono::seconds(10), [](int) {}, 1, high_bits_task_id);
+  EXPECT_TRUE(pending_operations.AddResponse(high_bits_task_id, 1));
+  EXPECT_TRUE(pending_operations.HasTask(low_bits_task_id));
+  EXPECT_TRUE(pending_operations.AddResponse(low_bits_task_id, 1));
+
+  // A task which times out or is cancelled gets a default-constructed response.
+  auto timed_out(std::make_shared<boost::promise<std::string>>());
+  auto timed_out_future(timed_out->get_future());
+  pending_operations.AddTask<std::string>(
+      std::chrono::milliseconds(100),
+      [timed_out](std::string response) { timed_out->set_value(response); }, 1,
+      pending_operations.NewTaskId());
+  auto cancelled(std::make_shared<boost::promise<std::string>>());
+  auto cancelled_future(cancelled->get_future());
+  auto cancelled_task_id(pending_operations.NewTaskId());
+  pending_operations.AddTask<std::string>(
+      std::chrono::seconds(10),
+      [cancelled](std::string response) { cancelled->set_value(response); }, 1,
+      cancelled_task_id);
+  EXPECT_EQ(2U, pending_operations.size());
+  pending_operations.CancelTask(cancelled_task_id);
+  ASSERT_EQ(boost::future_status::ready, cancelled_future.wait_for(boost::chrono::seconds(1)));
+  EXPECT_TRUE(cancelled_future.get().empty());
+  ASSERT_EQ(boost::future_status::ready, timed_out_future.wait_for(boost::chrono::seconds(5)));
+  EXPECT_TRUE(timed_out_future.get().empty());
+  EXPECT_EQ(0U, pending_operations.size());
+
+  // A task given an expiry functor has that called instead.
+  int handled_count(0), expired_count(0);
+  auto expiring_task_id(pending_operations.NewTaskId());
+  pending_operations.AddTask<int>(std::chrono::seconds(10), [&handled_count](int) {
+                                    ++handled_count;
+                                  },
+                                  [&expired_count] { ++expired_count; }, 2, expiring_task_id);
+  EXPECT_TRUE(pending_operations.AddResponse(expiring_task_id, 1));
+  pending_operations.CancelTask(expiring_task_id);
+  EXPECT_EQ(1, handled_count);
+  EXPECT_EQ(1, expired_count);
+
+  // Tasks still pending on destruction are expired.
+  std::atomic<int> destroyed_count(0);
+  {
+    PendingOperations short_lived(asio_service);
+    for (int i(0); i != 10; ++i) {
+      short_lived.AddTask<int>(std::chrono::seconds(10),
+                               [&destroyed_count](int response) {
+                                 if (response == 0)
+                                   ++destroyed_count;
+                               },
+                               1, short_lived.NewTaskId());
+    }
+  }
+  EXPECT_EQ(10, destroyed_count);
+}
+
+TEST(PendingOperationsTest, FUNC_ConcurrentTasks) {
+  AsioService asio_service(2);
+  PendingOperations pending_operations(asio_service);
+  const int kThreadCount(8), kTasksPerThread(10000);
+  std::atomic<int> completed(0), expired(0);
+  std::vector<std::thread> threads;
+  for (int i(0); i != kThreadCount; ++i) {
+    threads.emplace_back([&] {
+      for (int j(0); j != kTasksPerThread; ++j) {
+        auto task_id(pending_operations.NewTaskId());
+        // Every other task is left to time out.
+        pending_operations.AddTask<int>(std::chrono::milliseconds(j % 2 ? 200 : 60000),
+                                        [&](int response) {
+                                          if (response)
+                                            ++completed;
+                                          else
+                                            ++expired;
+                                        },
+                                        1, task_id);
+        if (j % 2 == 0)
+          EXPECT_TRUE(pending_operations.AddResponse(task_id, 1));
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  EXPECT_EQ(kThreadCount * kTasksPerThread / 2, completed);
+  auto deadline(std::chrono::steady_clock::now() + std::chrono::seconds(10));
+  while (expired != kThreadCount * kTasksPerThread / 2 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(0U, pending_operations.size());
+  EXPECT_EQ(kThreadCount * kTasksPerThread / 2, expired);
+}
+
+}  // namespace test
+
+}  // namespace nfs
+
+}  // namespace maidsafe
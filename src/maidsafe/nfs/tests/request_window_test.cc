@@ -0,0 +1,283 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/request_window.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/thread/future.hpp"
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+namespace {
+
+struct TestName {
+  typedef std::string data_type;
+  int value;
+};
+
+typedef std::shared_ptr<boost::promise<std::string>> TestPromise;
+
+std::string Content(int value) { return "content " + std::to_string(value); }
+
+// Holds the Gets started by GetMany so that tests can choose when each is answered.  Odd names
+// fail.
+class Getter {
+ public:
+  struct Pending {
+    TestName data_name;
+    TestPromise promise;
+    std::function<void()> on_completion;
+  };
+
+  Getter() : mutex_(), pending_() {}
+
+  std::function<void(const TestName&, TestPromise, std::function<void()>)> functor() {
+    return [this](const TestName& data_name, TestPromise promise,
+                  std::function<void()> on_completion) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_.push_back(Pending{data_name, promise, on_completion});
+    };
+  }
+
+  size_t pending_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+  }
+
+  // Answers the pending Get at 'position'.
+  void Complete(size_t position) {
+    Pending pending;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending = pending_.at(position);
+      pending_.erase(pending_.begin() + position);
+    }
+    if (pending.data_name.value % 2 == 0)
+      pending.promise->set_value(Content(pending.data_name.value));
+    else
+      pending.promise->set_exception(MakeError(CommonErrors::no_such_element));
+    pending.on_completion();
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::deque<Pending> pending_;
+};
+
+std::vector<TestName> Names(int count) {
+  std::vector<TestName> names;
+  for (int i(0); i < count; ++i)
+    names.push_back(TestName{i});
+  return names;
+}
+
+void CheckResult(int value, boost::future<std::string> result) {
+  ASSERT_TRUE(result.is_ready());
+  if (value % 2 == 0) {
+    EXPECT_EQ(Content(value), result.get());
+  } else {
+    EXPECT_THROW(result.get(), maidsafe_error);
+  }
+}
+
+}  // unnamed namespace
+
+TEST(RequestWindowTest, BEH_WindowIsRefilledAsRequestsComplete) {
+  const int kCount(50);
+  const size_t kWindow(4);
+  Getter getter;
+  std::vector<int> delivered(kCount, 0);
+  auto all_done(detail::GetMany(
+      Names(kCount), kWindow, getter.functor(),
+      std::function<void(size_t, boost::future<std::string>)>(
+          [&](size_t index, boost::future<std::string> result) {
+            ++delivered.at(index);
+            CheckResult(static_cast<int>(index), std::move(result));
+          })));
+
+  for (int completed(0); completed < kCount; ++completed) {
+    EXPECT_EQ(std::min(kWindow, static_cast<size_t>(kCount - completed)), getter.pending_count());
+    EXPECT_FALSE(all_done.is_ready());
+    getter.Complete(RandomUint32() % getter.pending_count());
+  }
+  EXPECT_EQ(0, getter.pending_count());
+  ASSERT_TRUE(all_done.is_ready());
+  EXPECT_NO_THROW(all_done.get());
+  for (auto count : delivered)
+    EXPECT_EQ(1, count);
+}
+
+TEST(RequestWindowTest, BEH_SynchronousCompletion) {
+  // Gets answered before returning (e.g. from the cache) mustn't recurse once per item.
+  const int kCount(100000);
+  auto get_functor([](const TestName& data_name, TestPromise promise,
+                      std::function<void()> on_completion) {
+    promise->set_value(Content(data_name.value));
+    on_completion();
+  });
+  auto futures(detail::GetMany(Names(kCount), 8, get_functor));
+  ASSERT_EQ(static_cast<size_t>(kCount), futures.size());
+  for (int i(0); i < kCount; ++i) {
+    ASSERT_TRUE(futures[i].is_ready());
+    EXPECT_EQ(Content(i), futures[i].get());
+  }
+}
+
+TEST(RequestWindowTest, BEH_ConcurrentCompletion) {
+  const int kCount(500);
+  const size_t kWindow(16);
+  std::atomic<size_t> outstanding(0), max_outstanding(0);
+  AsioService asio_service(4);
+  auto get_functor([&](const TestName& data_name, TestPromise promise,
+                       std::function<void()> on_completion) {
+    auto now_outstanding(++outstanding);
+    auto previous_max(max_outstanding.load());
+    while (now_outstanding > previous_max &&
+           !max_outstanding.compare_exchange_weak(previous_max, now_outstanding)) {
+    }
+    asio_service.service().post([&outstanding, data_name, promise, on_completion] {
+      --outstanding;
+      if (data_name.value % 2 == 0)
+        promise->set_value(Content(data_name.value));
+      else
+        promise->set_exception(MakeError(CommonErrors::no_such_element));
+      on_completion();
+    });
+  });
+  auto futures(detail::GetMany(Names(kCount), kWindow, get_functor));
+  for (int i(0); i < kCount; ++i) {
+    futures[i].wait();
+    CheckResult(i, std::move(futures[i]));
+  }
+  EXPECT_LE(max_outstanding.load(), kWindow);
+  EXPECT_GT(max_outstanding.load(), 1U);
+}
+
+TEST(RequestWindowTest, BEH_InvalidWindowAndPullFailure) {
+  Getter getter;
+  EXPECT_THROW(detail::GetMany(Names(1), 0, getter.functor()), maidsafe_error);
+  EXPECT_EQ(0, getter.pending_count());
+
+  // A failure pulling the next item stops further items being started, and is reported once those
+  // already started are done.
+  int pulled(0);
+  std::vector<int> started;
+  std::vector<std::function<void()>> dones;
+  auto request_window(std::make_shared<RequestWindow<int>>(
+      2,
+      [&]() -> boost::optional<int> {
+        if (pulled == 3)
+          BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+        return pulled++;
+      },
+      [&](int item, std::function<void()> done) {
+        started.push_back(item);
+        dones.push_back(done);
+      }));
+  auto all_done(request_window->Run());
+  EXPECT_EQ(std::vector<int>({0, 1}), started);
+  dones[0]();
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), started);
+  dones[1]();
+  EXPECT_FALSE(all_done.is_ready());
+  dones[2]();
+  ASSERT_TRUE(all_done.is_ready());
+  EXPECT_THROW(all_done.get(), maidsafe_error);
+}
+
+TEST(RequestWindowTest, BEH_CostBudget) {
+  // Items are sizes in bytes, pulled lazily from a generator.
+  const uint64_t kBudget(100);
+  const std::vector<uint64_t> kSizes{40, 40, 30, 10, 250, 60, 50, 1};
+  size_t pulled(0);
+  uint64_t outstanding_bytes(0), max_outstanding_bytes(0);
+  std::vector<std::pair<uint64_t, std::function<void()>>> started;
+  auto request_window(std::make_shared<RequestWindow<uint64_t>>(
+      3, kBudget, [](const uint64_t& size) { return size; },
+      [&]() -> boost::optional<uint64_t> {
+        if (pulled == kSizes.size())
+          return boost::none;
+        return kSizes[pulled++];
+      },
+      [&](uint64_t size, std::function<void()> done) {
+        outstanding_bytes += size;
+        max_outstanding_bytes = std::max(max_outstanding_bytes, outstanding_bytes);
+        started.push_back(std::make_pair(size, done));
+      }));
+  auto complete([&](size_t position) {
+    outstanding_bytes -= started.at(position).first;
+    started.at(position).second();
+  });
+
+  auto all_done(request_window->Run());
+  // 40 + 40 fit; 30 doesn't, so it's held (the only item pulled beyond those started).
+  EXPECT_EQ(2U, started.size());
+  EXPECT_EQ(3U, pulled);
+  complete(0);
+  // 40 + 30 + 10 hits the count limit of 3, so nothing more is pulled.
+  EXPECT_EQ(4U, started.size());
+  EXPECT_EQ(4U, pulled);
+  complete(1);
+  EXPECT_EQ(5U, pulled);
+  complete(2);
+  EXPECT_EQ(4U, started.size());
+  complete(3);
+  // 250 exceeds the budget on its own, so it only starts once nothing else is outstanding.
+  EXPECT_EQ(5U, started.size());
+  EXPECT_EQ(250U, started.back().first);
+  complete(4);
+  // 60 + 50 exceeds the budget.
+  EXPECT_EQ(6U, started.size());
+  EXPECT_EQ(7U, pulled);
+  complete(5);
+  EXPECT_EQ(8U, started.size());
+  complete(6);
+  EXPECT_FALSE(all_done.is_ready());
+  complete(7);
+  ASSERT_TRUE(all_done.is_ready());
+  EXPECT_NO_THROW(all_done.get());
+  EXPECT_EQ(250U, max_outstanding_bytes);
+
+  EXPECT_THROW(RequestWindow<uint64_t>(1, 0, [](const uint64_t& size) { return size; },
+                                       [] { return boost::optional<uint64_t>(); },
+                                       [](uint64_t, std::function<void()>) {}),
+               maidsafe_error);
+}
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
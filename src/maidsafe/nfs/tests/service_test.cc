@@ -18,6 +18,14 @@
 
 #include "maidsafe/nfs/service.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
 #include "maidsafe/common/asio_service.h"
 #include "maidsafe/common/test.h"
 #include "maidsafe/common/types.h"
@@ -27,6 +35,7 @@
 #include "maidsafe/routing/timer.h"
 #include "maidsafe/passport/types.h"
 
+#include "maidsafe/nfs/message_batcher.h"
 #include "maidsafe/nfs/message_types.h"
 #include "maidsafe/nfs/message_wrapper.h"
 #include "maidsafe/nfs/client/data_getter_service.h"
@@ -92,6 +101,149 @@ TYPED_TEST(ServiceTest, BEH_All) {
   service.HandleMessage(response_tuple, sender, receiver);
 }
 
+namespace {
+
+// Treats the MaidNode messages as "vault" messages so that every MaidNode message dispatched in the
+// tests below must be found via the vault variant.
+class CountingPersonaService {
+ public:
+  typedef DataGetterServiceMessages PublicMessages;
+  typedef MaidNodeServiceMessages VaultMessages;
+  typedef void HandleMessageReturnType;
+
+  CountingPersonaService() : handled_count(0) {}
+  template <typename Message, typename Sender, typename Receiver>
+  void HandleMessage(const Message& /*message*/, const Sender& /*sender*/,
+                     const Receiver& /*receiver*/) {
+    ++handled_count;
+  }
+  void Stop() {}
+
+  int handled_count;
+};
+
+typedef std::tuple<MessageAction, Persona, Persona> MessageTriple;
+
+class MessageTripleCollector {
+ public:
+  explicit MessageTripleCollector(std::set<MessageTriple>& triples) : triples_(triples) {}
+  template <typename Message>
+  void operator()(Message* /*tag*/) const {
+    triples_.insert(std::make_tuple(Message::kAction, Message::SourcePersona::value,
+                                    Message::DestinationPersona::value));
+  }
+
+ private:
+  std::set<MessageTriple>& triples_;
+};
+
+}  // unnamed namespace
+
+TEST(ServiceDispatchTest, BEH_DispatchTableMatchesVariants) {
+  typedef GetResponseFromDataManagerToMaidNode::Sender Sender;
+  typedef GetResponseFromDataManagerToMaidNode::Receiver Receiver;
+  std::set<MessageTriple> triples;
+  boost::mpl::for_each<DataGetterServiceMessages::types, boost::add_pointer<boost::mpl::_1>>(
+      MessageTripleCollector(triples));
+  boost::mpl::for_each<MaidNodeServiceMessages::types, boost::add_pointer<boost::mpl::_1>>(
+      MessageTripleCollector(triples));
+  ASSERT_FALSE(triples.empty());
+
+  const auto& table(
+      detail::MessageDispatchTable<CountingPersonaService, Sender, Receiver>::Instance());
+  size_t found_count(0);
+  for (int32_t action(0); action <= static_cast<int32_t>(MessageAction::kNoOperation); ++action) {
+    for (int32_t source(0); source <= static_cast<int32_t>(Persona::kNA); ++source) {
+      for (int32_t destination(0); destination <= static_cast<int32_t>(Persona::kNA);
+           ++destination) {
+        auto triple(std::make_tuple(static_cast<MessageAction>(action),
+                                    static_cast<Persona>(source),
+                                    static_cast<Persona>(destination)));
+        auto found(table.Find(std::make_tuple(
+                       std::get<0>(triple), detail::SourceTaggedValue(std::get<1>(triple)),
+                       detail::DestinationTaggedValue(std::get<2>(triple)), MessageId(0),
+                       SharedBuffer())) != nullptr);
+        EXPECT_EQ(triples.count(triple) == 1, found) << std::get<0>(triple) << " from "
+                                                     << std::get<1>(triple) << " to "
+                                                     << std::get<2>(triple);
+        if (found)
+          ++found_count;
+      }
+    }
+  }
+  EXPECT_EQ(triples.size(), found_count);
+}
+
+TEST(ServiceDispatchTest, BEH_HandleBatchedMessages) {
+  typedef GetResponseFromDataManagerToMaidNode GetResponse;
+  ImmutableData immutable_data(NonEmptyString(RandomString(10)));
+  GetResponse::Sender sender((routing::GroupId(NodeId(NodeId::kRandomId))),
+                             (routing::SingleId(NodeId(NodeId::kRandomId))));
+  GetResponse::Receiver receiver((NodeId(NodeId::kRandomId)));
+  auto persona_service(new CountingPersonaService);
+  Service<CountingPersonaService> service(
+      std::move(std::unique_ptr<CountingPersonaService>(persona_service)));
+
+  // An unbatched message is handled as before.
+  GetResponse get_response(MessageId(RandomInt32()), GetResponse::Contents(immutable_data));
+  service.HandleMessages(get_response.Serialise(), sender, receiver);
+  EXPECT_EQ(1, persona_service->handled_count);
+
+  // A message this persona can't handle doesn't stop the rest of the batch being handled.
+  std::string batch;
+  const int kBatchSize(5);
+  for (int i(0); i != kBatchSize; ++i) {
+    GetResponse batched_response(MessageId(i), GetResponse::Contents(immutable_data));
+    AppendToMessageWrapperBatch(batched_response.Serialise(), batch);
+    if (i == 2) {
+      GetRequestFromMaidNodeToDataManager get_request(
+          MessageId(i), GetRequestFromMaidNodeToDataManager::Contents(immutable_data.name()));
+      AppendToMessageWrapperBatch(get_request.Serialise(), batch);
+    }
+  }
+  auto parsed(ParseMessageWrappers(batch));
+  ASSERT_EQ(static_cast<size_t>(kBatchSize + 1), parsed.size());
+  EXPECT_EQ(MessageId(4), std::get<3>(parsed.back()));
+  service.HandleMessages(batch, sender, receiver);
+  EXPECT_EQ(1 + kBatchSize, persona_service->handled_count);
+
+  EXPECT_THROW(ParseMessageWrappers(batch.substr(0, batch.size() - 1)), maidsafe_error);
+}
+
+TEST(ServiceDispatchTest, BEH_MessageBatcher) {
+  typedef GetResponseFromDataManagerToMaidNode GetResponse;
+  ImmutableData immutable_data(NonEmptyString(RandomString(10)));
+  AsioService asio_service(2);
+  std::mutex mutex;
+  std::condition_variable cond_var;
+  std::vector<std::string> sent;
+  {
+    MessageBatcher batcher(asio_service, BatchParameters(std::chrono::milliseconds(100), 1 << 20),
+                           [&](std::string serialised_messages) {
+                             std::lock_guard<std::mutex> lock(mutex);
+                             sent.push_back(std::move(serialised_messages));
+                             cond_var.notify_one();
+                           });
+    const int kBatchSize(10);
+    for (int i(0); i != kBatchSize; ++i) {
+      batcher.Add(
+          GetResponse(MessageId(i), GetResponse::Contents(immutable_data)).Serialise());
+    }
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      ASSERT_TRUE(cond_var.wait_for(lock, std::chrono::seconds(2),
+                                    [&] { return !sent.empty(); }));
+      EXPECT_EQ(static_cast<size_t>(kBatchSize), ParseMessageWrappers(sent.front()).size());
+    }
+    // Pending messages are sent on destruction, and a lone message isn't wrapped in a batch.
+    batcher.Add(GetResponse(MessageId(0), GetResponse::Contents(immutable_data)).Serialise());
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  ASSERT_EQ(2U, sent.size());
+  EXPECT_EQ(1U, ParseMessageWrappers(sent.back()).size());
+  EXPECT_NO_THROW(ParseMessageWrapper(sent.back()));
+}
+
 }  // namespace test
 
 }  // namespace nfs
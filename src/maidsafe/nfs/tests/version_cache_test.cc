@@ -0,0 +1,131 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/version_cache.h"
+
+#include <chrono>
+#include <thread>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/data_types/immutable_data.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+namespace {
+
+typedef VersionCache::VersionName VersionName;
+typedef VersionCache::Versions Versions;
+
+const DataTagValue kType(DataTagValue::kOwnerDirectoryValue);
+const std::chrono::seconds kFresh(60);
+
+VersionName RandomVersionName(uint64_t index) {
+  return VersionName(index, ImmutableData::Name(Identity(RandomString(64))));
+}
+
+}  // unnamed namespace
+
+TEST(VersionCacheTest, BEH_Staleness) {
+  VersionCache disabled(0);
+  const Identity kName(RandomString(64));
+  disabled.SetVersions(kType, kName, Versions(1, RandomVersionName(0)), disabled.write_count());
+  EXPECT_FALSE(disabled.GetVersions(kType, kName, kFresh));
+
+  VersionCache version_cache(10);
+  const Versions kTips(1, RandomVersionName(1));
+  const Versions kBranch({ kTips[0], RandomVersionName(0) });
+  version_cache.SetVersions(kType, kName, kTips, version_cache.write_count());
+  version_cache.SetBranch(kType, kName, kTips[0], kBranch, version_cache.write_count());
+  auto tips(version_cache.GetVersions(kType, kName, kFresh));
+  ASSERT_TRUE(static_cast<bool>(tips));
+  EXPECT_EQ(kTips, *tips);
+  auto branch(version_cache.GetBranch(kType, kName, kTips[0], kFresh));
+  ASSERT_TRUE(static_cast<bool>(branch));
+  EXPECT_EQ(kBranch, *branch);
+  EXPECT_FALSE(version_cache.GetBranch(kType, kName, kBranch[1], kFresh));
+  EXPECT_FALSE(version_cache.GetVersions(DataTagValue::kMutableDataValue, kName, kFresh));
+
+  // A zero staleness never hits, and lists older than the staleness are ignored.
+  EXPECT_FALSE(version_cache.GetVersions(kType, kName, std::chrono::seconds(0)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_FALSE(version_cache.GetVersions(kType, kName, std::chrono::milliseconds(50)));
+  EXPECT_FALSE(version_cache.GetBranch(kType, kName, kTips[0], std::chrono::milliseconds(50)));
+  EXPECT_TRUE(static_cast<bool>(version_cache.GetVersions(kType, kName, kFresh)));
+
+  // A fetch which started before a write isn't stored.
+  auto write_count(version_cache.write_count());
+  version_cache.Invalidate(kType, kName);
+  EXPECT_FALSE(version_cache.GetVersions(kType, kName, kFresh));
+  version_cache.SetVersions(kType, kName, kTips, write_count);
+  EXPECT_FALSE(version_cache.GetVersions(kType, kName, kFresh));
+  EXPECT_EQ(0U, version_cache.size());
+}
+
+TEST(VersionCacheTest, BEH_PutVersion) {
+  VersionCache version_cache(10);
+  const Identity kName(RandomString(64));
+  const Versions kTips({ RandomVersionName(1), RandomVersionName(1) });
+  version_cache.SetVersions(kType, kName, kTips, version_cache.write_count());
+  version_cache.SetBranch(kType, kName, kTips[0], kTips, version_cache.write_count());
+
+  // A new version replaces its parent as a tip; branches are dropped.
+  auto child(RandomVersionName(2));
+  version_cache.PutVersion(kType, kName, kTips[0], child, child);
+  auto tips(version_cache.GetVersions(kType, kName, kFresh));
+  ASSERT_TRUE(static_cast<bool>(tips));
+  EXPECT_EQ(Versions({ child, kTips[1] }), *tips);
+  EXPECT_FALSE(version_cache.GetBranch(kType, kName, kTips[0], kFresh));
+
+  // A version whose parent isn't a tip starts a new branch.
+  auto fork(RandomVersionName(1));
+  version_cache.PutVersion(kType, kName, RandomVersionName(0), fork, boost::none);
+  tips = version_cache.GetVersions(kType, kName, kFresh);
+  ASSERT_TRUE(static_cast<bool>(tips));
+  EXPECT_EQ(Versions({ child, kTips[1], fork }), *tips);
+
+  // An unexpected tip of tree means the tree can't be deduced.
+  version_cache.PutVersion(kType, kName, child, RandomVersionName(3), RandomVersionName(3));
+  EXPECT_FALSE(version_cache.GetVersions(kType, kName, kFresh));
+}
+
+TEST(VersionCacheTest, BEH_LeastRecentlyUsedEvicted) {
+  VersionCache version_cache(2);
+  std::vector<Identity> names;
+  for (int i(0); i != 3; ++i)
+    names.push_back(Identity(RandomString(64)));
+  const Versions kTips(1, RandomVersionName(0));
+  version_cache.SetVersions(kType, names[0], kTips, version_cache.write_count());
+  version_cache.SetVersions(kType, names[1], kTips, version_cache.write_count());
+  EXPECT_TRUE(static_cast<bool>(version_cache.GetVersions(kType, names[0], kFresh)));
+  version_cache.SetVersions(kType, names[2], kTips, version_cache.write_count());
+  EXPECT_EQ(2U, version_cache.size());
+  EXPECT_TRUE(static_cast<bool>(version_cache.GetVersions(kType, names[0], kFresh)));
+  EXPECT_FALSE(version_cache.GetVersions(kType, names[1], kFresh));
+  EXPECT_TRUE(static_cast<bool>(version_cache.GetVersions(kType, names[2], kFresh)));
+}
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
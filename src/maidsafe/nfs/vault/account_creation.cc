@@ -24,6 +24,7 @@
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/utils.h"
 
+#include "maidsafe/nfs/scratch_protobuf.h"
 #include "maidsafe/nfs/vault/account_creation.pb.h"
 
 namespace maidsafe {
@@ -39,19 +40,20 @@ AccountCreation::AccountCreation(const passport::PublicMaid& public_maid,
 
 AccountCreation::AccountCreation(const std::string& serialised_copy)
     : public_maid_ptr(), public_anmaid_ptr() {
-  protobuf::AccountCreation proto_account_creation;
-  if (!proto_account_creation.ParseFromString(serialised_copy)) {
+  nfs::detail::ScratchProtobuf<protobuf::AccountCreation> proto_account_creation;
+  if (!proto_account_creation->ParseFromString(serialised_copy)) {
     LOG(kError) << "Failed to parse account_creation.";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
   }
 
   public_maid_ptr.reset(new passport::PublicMaid(
-      passport::PublicMaid::Name(Identity(proto_account_creation.public_maid_name())),
-      passport::PublicMaid::serialised_type(NonEmptyString(proto_account_creation.public_maid()))));
+      passport::PublicMaid::Name(Identity(proto_account_creation->public_maid_name())),
+      passport::PublicMaid::serialised_type(
+          NonEmptyString(proto_account_creation->public_maid()))));
   public_anmaid_ptr.reset(new passport::PublicAnmaid(
-      passport::PublicAnmaid::Name(Identity(proto_account_creation.public_anmaid_name())),
+      passport::PublicAnmaid::Name(Identity(proto_account_creation->public_anmaid_name())),
       passport::PublicAnmaid::serialised_type(
-          NonEmptyString(proto_account_creation.public_anmaid()))));
+          NonEmptyString(proto_account_creation->public_anmaid()))));
 }
 
 AccountCreation::AccountCreation(const AccountCreation& other)
@@ -68,12 +70,12 @@ AccountCreation& AccountCreation::operator=(AccountCreation other) {
 }
 
 std::string AccountCreation::Serialise() const {
-  protobuf::AccountCreation proto_account_creation;
-  proto_account_creation.set_public_maid_name(public_maid_ptr->name().value.string());
-  proto_account_creation.set_public_maid(public_maid_ptr->Serialise()->string());
-  proto_account_creation.set_public_anmaid_name(public_anmaid_ptr->name().value.string());
-  proto_account_creation.set_public_anmaid(public_anmaid_ptr->Serialise()->string());
-  return proto_account_creation.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::AccountCreation> proto_account_creation;
+  proto_account_creation->set_public_maid_name(public_maid_ptr->name().value.string());
+  proto_account_creation->set_public_maid(public_maid_ptr->Serialise()->string());
+  proto_account_creation->set_public_anmaid_name(public_anmaid_ptr->name().value.string());
+  proto_account_creation->set_public_anmaid(public_anmaid_ptr->Serialise()->string());
+  return proto_account_creation->SerializeAsString();
 }
 
 bool operator==(const AccountCreation& lhs, const AccountCreation& rhs) {
@@ -24,6 +24,7 @@
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/utils.h"
 
+#include "maidsafe/nfs/scratch_protobuf.h"
 #include "maidsafe/nfs/vault/account_removal.pb.h"
 
 namespace maidsafe {
@@ -39,16 +40,16 @@ AccountRemoval::AccountRemoval(const passport::Anmaid& anmaid)
 
 AccountRemoval::AccountRemoval(const std::string& serialised_copy)
     : random_data_(), public_anmaid_name_(), signature_() {
-  protobuf::AccountRemoval proto_account_removal;
-  if (!proto_account_removal.ParseFromString(serialised_copy)) {
+  nfs::detail::ScratchProtobuf<protobuf::AccountRemoval> proto_account_removal;
+  if (!proto_account_removal->ParseFromString(serialised_copy)) {
     LOG(kError) << "Failed to parse account_removal.";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
   }
 
-  random_data_ = NonEmptyString(proto_account_removal.random_data());
+  random_data_ = NonEmptyString(proto_account_removal->random_data());
   public_anmaid_name_ =
-      passport::PublicAnmaid::Name(Identity(proto_account_removal.public_anmaid_name()));
-  signature_ = asymm::Signature(proto_account_removal.signature());
+      passport::PublicAnmaid::Name(Identity(proto_account_removal->public_anmaid_name()));
+  signature_ = asymm::Signature(proto_account_removal->signature());
 }
 
 AccountRemoval::AccountRemoval(const AccountRemoval& other)
@@ -67,11 +68,11 @@ AccountRemoval& AccountRemoval::operator=(AccountRemoval other) {
 }
 
 std::string AccountRemoval::Serialise() const {
-  protobuf::AccountRemoval proto_account_removal;
-  proto_account_removal.set_random_data(random_data_.string());
-  proto_account_removal.set_public_anmaid_name(public_anmaid_name_->string());
-  proto_account_removal.set_signature(signature_.string());
-  return proto_account_removal.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::AccountRemoval> proto_account_removal;
+  proto_account_removal->set_random_data(random_data_.string());
+  proto_account_removal->set_public_anmaid_name(public_anmaid_name_->string());
+  proto_account_removal->set_signature(signature_.string());
+  return proto_account_removal->SerializeAsString();
 }
 
 bool AccountRemoval::Validate(const passport::PublicAnmaid& public_anmaid) const {
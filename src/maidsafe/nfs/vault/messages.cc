@@ -20,13 +20,44 @@
 
 #include <cstdint>
 
+#include "maidsafe/nfs/scratch_protobuf.h"
 #include "maidsafe/nfs/utils.h"
+#include "maidsafe/nfs/wire_format.h"
 #include "maidsafe/nfs/vault/messages.pb.h"
 
 namespace maidsafe {
 
 namespace nfs_vault {
 
+namespace {
+
+// Field numbers from protobuf::DataNameAndContent and protobuf::DataAndPmidHint respectively.
+const uint32_t kSerialisedNameField(1), kContentField(2);
+const uint32_t kSerialisedDataNameAndContentField(1), kPmidHintField(2);
+
+size_t DataNameAndContentSize(const std::string& serialised_name, const NonEmptyString& content) {
+  return nfs::detail::LengthDelimitedFieldSize(kSerialisedNameField, serialised_name.size()) +
+         nfs::detail::LengthDelimitedFieldSize(kContentField, content.string().size());
+}
+
+void AppendDataNameAndContent(const std::string& serialised_name, const NonEmptyString& content,
+                              std::string& output) {
+  nfs::detail::AppendLengthDelimitedField(kSerialisedNameField, serialised_name, output);
+  nfs::detail::AppendLengthDelimitedField(kContentField, content.string(), output);
+}
+
+DataNameAndContent ParseDataNameAndContent(const char* data, size_t size) {
+  nfs::detail::FieldView fields[kContentField + 1];
+  nfs::detail::ParseLengthDelimitedFields(data, size, fields, kContentField + 1);
+  if (!fields[kSerialisedNameField].present() || !fields[kContentField].present())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  DataName name(fields[kSerialisedNameField].string());
+  return DataNameAndContent(name.type, name.raw_name,
+                            NonEmptyString(fields[kContentField].string()));
+}
+
+}  // unnamed namespace
+
 // ========================== Empty ================================================================
 
 bool operator==(const Empty& /*lhs*/, const Empty& /*rhs*/) { return true; }
@@ -49,16 +80,16 @@ AvailableSize& AvailableSize::operator=(AvailableSize other) {
 
 AvailableSize::AvailableSize(const std::string& serialised_copy)
     : available_size([&serialised_copy]() {
-                       protobuf::AvailableSize proto_size;
-                       if (!proto_size.ParseFromString(serialised_copy))
+                       nfs::detail::ScratchProtobuf<protobuf::AvailableSize> proto_size;
+                       if (!proto_size->ParseFromString(serialised_copy))
                          BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-                       return proto_size.size();
+                       return proto_size->size();
                      }()) {}
 
 std::string AvailableSize::Serialise() const {
-  protobuf::AvailableSize proto_size;
-  proto_size.set_size(available_size);
-  return proto_size.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::AvailableSize> proto_size;
+  proto_size->set_size(available_size);
+  return proto_size->SerializeAsString();
 }
 
 bool operator==(const AvailableSize& lhs, const AvailableSize& rhs) {
@@ -88,18 +119,18 @@ DataName& DataName::operator=(DataName other) {
 
 DataName::DataName(const std::string& serialised_copy)
     : type(DataTagValue::kAnmaidValue), raw_name() {
-  protobuf::DataName proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataName> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  type = static_cast<DataTagValue>(proto_copy.type());
-  raw_name = Identity(proto_copy.raw_name());
+  type = static_cast<DataTagValue>(proto_copy->type());
+  raw_name = Identity(proto_copy->raw_name());
 }
 
 std::string DataName::Serialise() const {
-  protobuf::DataName proto_data_name;
-  proto_data_name.set_type(static_cast<uint32_t>(type));
-  proto_data_name.set_raw_name(raw_name.string());
-  return proto_data_name.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::DataName> proto_data_name;
+  proto_data_name->set_type(static_cast<uint32_t>(type));
+  proto_data_name->set_raw_name(raw_name.string());
+  return proto_data_name->SerializeAsString();
 }
 
 bool operator==(const DataName& lhs, const DataName& rhs) {
@@ -134,25 +165,23 @@ DataNames& DataNames::operator=(DataNames other) {
 
 DataNames::DataNames(const std::string& serialised_copy)
     : data_names_() {
-  protobuf::DataNames proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataNames> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  for (int index(0); index < proto_copy.data_names_size(); ++index) {
-    data_names_.push_back(DataName(static_cast<DataTagValue>(proto_copy.data_names(index).type()),
-                                   Identity(proto_copy.data_names(index).raw_name())));
+  for (int index(0); index < proto_copy->data_names_size(); ++index) {
+    data_names_.push_back(DataName(static_cast<DataTagValue>(proto_copy->data_names(index).type()),
+                                   Identity(proto_copy->data_names(index).raw_name())));
   }
 }
 
 std::string DataNames::Serialise() const {
-  protobuf::DataNames proto_data_names;
+  nfs::detail::ScratchProtobuf<protobuf::DataNames> proto_data_names;
   for (const auto& data_name : data_names_) {
-    protobuf::DataName proto_data_name;
-    proto_data_name.set_type(static_cast<uint32_t>(data_name.type));
-    proto_data_name.set_raw_name(data_name.raw_name.string());
-    auto value(proto_data_names.add_data_names());
-    *value = proto_data_name;
+    auto proto_data_name(proto_data_names->add_data_names());
+    proto_data_name->set_type(static_cast<uint32_t>(data_name.type));
+    proto_data_name->set_raw_name(data_name.raw_name.string());
   }
-  return proto_data_names.SerializeAsString();
+  return proto_data_names->SerializeAsString();
 }
 
 bool operator==(const DataNames& lhs, const DataNames& rhs) {
@@ -192,18 +221,18 @@ DataNameAndVersion& DataNameAndVersion::operator=(DataNameAndVersion other) {
 
 DataNameAndVersion::DataNameAndVersion(const std::string& serialised_copy)
     : data_name(), version_name() {
-  protobuf::DataNameAndVersion proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataNameAndVersion> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  data_name = DataName(proto_copy.serialised_data_name());
-  version_name = StructuredDataVersions::VersionName(proto_copy.serialised_version_name());
+  data_name = DataName(proto_copy->serialised_data_name());
+  version_name = StructuredDataVersions::VersionName(proto_copy->serialised_version_name());
 }
 
 std::string DataNameAndVersion::Serialise() const {
-  protobuf::DataNameAndVersion proto_copy;
-  proto_copy.set_serialised_data_name(data_name.Serialise());
-  proto_copy.set_serialised_version_name(version_name.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::DataNameAndVersion> proto_copy;
+  proto_copy->set_serialised_data_name(data_name.Serialise());
+  proto_copy->set_serialised_version_name(version_name.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataNameAndVersion& lhs, const DataNameAndVersion& rhs) {
@@ -244,23 +273,23 @@ DataNameOldNewVersion& DataNameOldNewVersion::operator=(DataNameOldNewVersion ot
 
 DataNameOldNewVersion::DataNameOldNewVersion(const std::string& serialised_copy)
     : data_name(), old_version_name(), new_version_name() {
-  protobuf::DataNameOldNewVersion proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataNameOldNewVersion> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  data_name = DataName(proto_copy.serialised_data_name());
-  if (proto_copy.has_serialised_old_version_name())
+  data_name = DataName(proto_copy->serialised_data_name());
+  if (proto_copy->has_serialised_old_version_name())
     old_version_name = StructuredDataVersions::VersionName(
-                           proto_copy.serialised_old_version_name());
-  new_version_name = StructuredDataVersions::VersionName(proto_copy.serialised_new_version_name());
+                           proto_copy->serialised_old_version_name());
+  new_version_name = StructuredDataVersions::VersionName(proto_copy->serialised_new_version_name());
 }
 
 std::string DataNameOldNewVersion::Serialise() const {
-  protobuf::DataNameOldNewVersion proto_copy;
-  proto_copy.set_serialised_data_name(data_name.Serialise());
+  nfs::detail::ScratchProtobuf<protobuf::DataNameOldNewVersion> proto_copy;
+  proto_copy->set_serialised_data_name(data_name.Serialise());
   if (old_version_name.id->IsInitialised())
-    proto_copy.set_serialised_old_version_name(old_version_name.Serialise());
-  proto_copy.set_serialised_new_version_name(new_version_name.Serialise());
-  return proto_copy.SerializeAsString();
+    proto_copy->set_serialised_old_version_name(old_version_name.Serialise());
+  proto_copy->set_serialised_new_version_name(new_version_name.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataNameOldNewVersion& lhs, const DataNameOldNewVersion& rhs) {
@@ -298,22 +327,22 @@ VersionTreeCreation& VersionTreeCreation::operator=(VersionTreeCreation other) {
 
 VersionTreeCreation::VersionTreeCreation(const std::string& serialised_copy)
     : data_name(), version_name(), max_versions(0), max_branches(0) {
-  protobuf::VersionTreeCreation proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::VersionTreeCreation> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  data_name = DataName(proto_copy.serialised_data_name());
-  version_name = StructuredDataVersions::VersionName(proto_copy.serialised_version_name());
-  max_versions = proto_copy.max_versions();
-  max_branches = proto_copy.max_branches();
+  data_name = DataName(proto_copy->serialised_data_name());
+  version_name = StructuredDataVersions::VersionName(proto_copy->serialised_version_name());
+  max_versions = proto_copy->max_versions();
+  max_branches = proto_copy->max_branches();
 }
 
 std::string VersionTreeCreation::Serialise() const {
-  protobuf::VersionTreeCreation proto_copy;
-  proto_copy.set_serialised_data_name(data_name.Serialise());
-  proto_copy.set_serialised_version_name(version_name.Serialise());
-  proto_copy.set_max_versions(max_versions);
-  proto_copy.set_max_branches(max_branches);
-  return proto_copy.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::VersionTreeCreation> proto_copy;
+  proto_copy->set_serialised_data_name(data_name.Serialise());
+  proto_copy->set_serialised_version_name(version_name.Serialise());
+  proto_copy->set_max_versions(max_versions);
+  proto_copy->set_max_branches(max_branches);
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const VersionTreeCreation& lhs, const VersionTreeCreation& rhs) {
@@ -350,18 +379,17 @@ DataNameAndContent& DataNameAndContent::operator=(DataNameAndContent other) {
 }
 
 DataNameAndContent::DataNameAndContent(const std::string& serialised_copy) : name(), content() {
-  protobuf::DataNameAndContent proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataNameAndContent> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  name = DataName(proto_copy.serialised_name());
-  content = NonEmptyString(proto_copy.content());
+  name = DataName(proto_copy->serialised_name());
+  content = NonEmptyString(proto_copy->content());
 }
 
 std::string DataNameAndContent::Serialise() const {
-  protobuf::DataNameAndContent proto_copy;
-  proto_copy.set_serialised_name(name.Serialise());
-  proto_copy.set_content(content.string());
-  return proto_copy.SerializeAsString();
+  std::string serialised;
+  AppendSerialised(*this, serialised);
+  return serialised;
 }
 
 bool operator==(const DataNameAndContent& lhs, const DataNameAndContent& rhs) {
@@ -378,6 +406,19 @@ void swap(DataNameAndContent& lhs, DataNameAndContent& rhs) MAIDSAFE_NOEXCEPT {
   swap(lhs.name, rhs.name);
   swap(lhs.content, rhs.content);
 }
+
+// Produces exactly the same bytes as protobuf::DataNameAndContent::SerializeAsString.
+void AppendSerialised(const DataNameAndContent& data_name_and_content, std::string& output) {
+  auto serialised_name(data_name_and_content.name.Serialise());
+  output.reserve(output.size() +
+                 DataNameAndContentSize(serialised_name, data_name_and_content.content));
+  AppendDataNameAndContent(serialised_name, data_name_and_content.content, output);
+}
+
+DataNameAndContent ParseContents(const nfs::SharedBuffer& serialised_contents,
+                                 DataNameAndContent* /*tag*/) {
+  return ParseDataNameAndContent(serialised_contents.data(), serialised_contents.size());
+}
 // ========================== Content ==============================================================
 
 Content::Content(const std::string &data_in) : data(data_in) {}
@@ -427,18 +468,18 @@ DataNameAndRandomString& DataNameAndRandomString::operator=(DataNameAndRandomStr
 
 DataNameAndRandomString::DataNameAndRandomString(const std::string& serialised_copy)
     : name(), random_string() {
-  protobuf::DataNameAndRandomString proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataNameAndRandomString> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  name = DataName(proto_copy.serialised_name());
-  random_string = NonEmptyString(proto_copy.random_string());
+  name = DataName(proto_copy->serialised_name());
+  random_string = NonEmptyString(proto_copy->random_string());
 }
 
 std::string DataNameAndRandomString::Serialise() const {
-  protobuf::DataNameAndRandomString proto_copy;
-  proto_copy.set_serialised_name(name.Serialise());
-  proto_copy.set_random_string(random_string.string());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::DataNameAndRandomString> proto_copy;
+  proto_copy->set_serialised_name(name.Serialise());
+  proto_copy->set_random_string(random_string.string());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataNameAndRandomString& lhs, const DataNameAndRandomString& rhs) {
@@ -470,18 +511,18 @@ DataNameAndCost& DataNameAndCost::operator=(DataNameAndCost other) {
 }
 
 DataNameAndCost::DataNameAndCost(const std::string& serialised_copy) : name(), cost(0) {
-  protobuf::DataNameAndCost proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataNameAndCost> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  name = DataName(proto_copy.serialised_name());
-  cost = proto_copy.cost();
+  name = DataName(proto_copy->serialised_name());
+  cost = proto_copy->cost();
 }
 
 std::string DataNameAndCost::Serialise() const {
-  protobuf::DataNameAndCost proto_copy;
-  proto_copy.set_serialised_name(name.Serialise());
-  proto_copy.set_cost(cost);
-  return proto_copy.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::DataNameAndCost> proto_copy;
+  proto_copy->set_serialised_name(name.Serialise());
+  proto_copy->set_cost(cost);
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataNameAndCost& lhs, const DataNameAndCost& rhs) {
@@ -513,18 +554,18 @@ DataNameAndSize& DataNameAndSize::operator=(DataNameAndSize other) {
 }
 
 DataNameAndSize::DataNameAndSize(const std::string& serialised_copy) : name(), size(0) {
-  protobuf::DataNameAndSize proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataNameAndSize> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  name = DataName(proto_copy.serialised_name());
-  size = proto_copy.size();
+  name = DataName(proto_copy->serialised_name());
+  size = proto_copy->size();
 }
 
 std::string DataNameAndSize::Serialise() const {
-  protobuf::DataNameAndSize proto_copy;
-  proto_copy.set_serialised_name(name.Serialise());
-  proto_copy.set_size(size);
-  return proto_copy.SerializeAsString();
+  nfs::detail::ScratchProtobuf<protobuf::DataNameAndSize> proto_copy;
+  proto_copy->set_serialised_name(name.Serialise());
+  proto_copy->set_size(size);
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataNameAndSize& lhs, const DataNameAndSize& rhs) {
@@ -557,18 +598,17 @@ DataAndPmidHint& DataAndPmidHint::operator=(DataAndPmidHint other) {
 }
 
 DataAndPmidHint::DataAndPmidHint(const std::string& serialised_copy) : data(), pmid_hint() {
-  protobuf::DataAndPmidHint proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataAndPmidHint> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  data = DataNameAndContent(proto_copy.serialised_data_name_and_content());
-  pmid_hint = Identity(proto_copy.pmid_hint());
+  data = DataNameAndContent(proto_copy->serialised_data_name_and_content());
+  pmid_hint = Identity(proto_copy->pmid_hint());
 }
 
 std::string DataAndPmidHint::Serialise() const {
-  protobuf::DataAndPmidHint proto_copy;
-  proto_copy.set_serialised_data_name_and_content(data.Serialise());
-  proto_copy.set_pmid_hint(pmid_hint.string());
-  return proto_copy.SerializeAsString();
+  std::string serialised;
+  AppendSerialised(*this, serialised);
+  return serialised;
 }
 
 bool operator==(const DataAndPmidHint& lhs, const DataAndPmidHint& rhs) {
@@ -581,6 +621,37 @@ void swap(DataAndPmidHint& lhs, DataAndPmidHint& rhs) MAIDSAFE_NOEXCEPT {
   swap(lhs.pmid_hint, rhs.pmid_hint);
 }
 
+// Produces exactly the same bytes as protobuf::DataAndPmidHint::SerializeAsString, but writes the
+// chunk content once instead of once per level of nesting.
+void AppendSerialised(const DataAndPmidHint& data_and_pmid_hint, std::string& output) {
+  auto serialised_name(data_and_pmid_hint.data.name.Serialise());
+  auto data_size(DataNameAndContentSize(serialised_name, data_and_pmid_hint.data.content));
+  output.reserve(
+      output.size() +
+      nfs::detail::LengthDelimitedFieldSize(kSerialisedDataNameAndContentField, data_size) +
+      nfs::detail::LengthDelimitedFieldSize(kPmidHintField,
+                                            data_and_pmid_hint.pmid_hint.string().size()));
+  nfs::detail::AppendLengthDelimitedFieldHeader(kSerialisedDataNameAndContentField, data_size,
+                                                output);
+  AppendDataNameAndContent(serialised_name, data_and_pmid_hint.data.content, output);
+  nfs::detail::AppendLengthDelimitedField(kPmidHintField, data_and_pmid_hint.pmid_hint.string(),
+                                          output);
+}
+
+DataAndPmidHint ParseContents(const nfs::SharedBuffer& serialised_contents,
+                              DataAndPmidHint* /*tag*/) {
+  nfs::detail::FieldView fields[kPmidHintField + 1];
+  nfs::detail::ParseLengthDelimitedFields(serialised_contents.data(), serialised_contents.size(),
+                                          fields, kPmidHintField + 1);
+  const auto& data(fields[kSerialisedDataNameAndContentField]);
+  if (!data.present() || !fields[kPmidHintField].present())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  DataAndPmidHint data_and_pmid_hint;
+  data_and_pmid_hint.data = ParseDataNameAndContent(data.data, data.size);
+  data_and_pmid_hint.pmid_hint = Identity(fields[kPmidHintField].string());
+  return data_and_pmid_hint;
+}
+
 // ========================== DataNameAndContentOrCheckResult ======================================
 
 DataNameAndContentOrCheckResult::DataNameAndContentOrCheckResult(
@@ -614,15 +685,15 @@ DataNameAndContentOrCheckResult& DataNameAndContentOrCheckResult::operator=(
 
 DataNameAndContentOrCheckResult::DataNameAndContentOrCheckResult(
     const std::string& serialised_copy) {
-  protobuf::DataNameAndContentOrCheckResult proto;
-  if (!proto.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::DataNameAndContentOrCheckResult> proto;
+  if (!proto->ParseFromString(serialised_copy))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
 
-  name = DataName(proto.serialised_name());
-  if (proto.has_content())
-    content.reset(NonEmptyString(proto.content()));
-  if (proto.has_check_result())
-    check_result.reset(CheckResult(proto.check_result()));
+  name = DataName(proto->serialised_name());
+  if (proto->has_content())
+    content.reset(NonEmptyString(proto->content()));
+  if (proto->has_check_result())
+    check_result.reset(CheckResult(proto->check_result()));
 
   if (!nfs::CheckMutuallyExclusive(content, check_result)) {
     assert(false);
@@ -631,19 +702,19 @@ DataNameAndContentOrCheckResult::DataNameAndContentOrCheckResult(
 }
 
 std::string DataNameAndContentOrCheckResult::Serialise() const {
-  protobuf::DataNameAndContentOrCheckResult proto;
-  proto.set_serialised_name(name.Serialise());
+  nfs::detail::ScratchProtobuf<protobuf::DataNameAndContentOrCheckResult> proto;
+  proto->set_serialised_name(name.Serialise());
   if (content)
-    proto.set_content(content->string());
+    proto->set_content(content->string());
   if (check_result)
-    proto.set_check_result(check_result->string());
+    proto->set_check_result(check_result->string());
 
   if (!nfs::CheckMutuallyExclusive(content, check_result)) {
     assert(false);
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::serialisation_error));
   }
 
-  return proto.SerializeAsString();
+  return proto->SerializeAsString();
 }
 
 void swap(DataNameAndContentOrCheckResult& lhs,
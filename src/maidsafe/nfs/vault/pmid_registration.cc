@@ -21,6 +21,7 @@
 #include "maidsafe/common/rsa.h"
 #include "maidsafe/common/utils.h"
 
+#include "maidsafe/nfs/scratch_protobuf.h"
 #include "maidsafe/nfs/vault/pmid_registration.pb.h"
 
 namespace maidsafe {
@@ -32,19 +33,19 @@ namespace {
 asymm::PlainText GetSerialisedDetails(const passport::PublicMaid::Name& maid_name,
                                       const passport::PublicPmid::Name& pmid_name,
                                       bool unregister) {
-  protobuf::PmidRegistration::SignedDetails::Details details;
-  details.set_maid_name(maid_name->string());
-  details.set_pmid_name(pmid_name->string());
-  details.set_unregister(unregister);
-  return asymm::PlainText(details.SerializeAsString());
+  nfs::detail::ScratchProtobuf<protobuf::PmidRegistration::SignedDetails::Details> details;
+  details->set_maid_name(maid_name->string());
+  details->set_pmid_name(pmid_name->string());
+  details->set_unregister(unregister);
+  return asymm::PlainText(details->SerializeAsString());
 }
 
 asymm::PlainText GetSerialisedSignedDetails(const asymm::PlainText& serialised_details,
                                             const asymm::Signature& pmid_signature) {
-  protobuf::PmidRegistration::SignedDetails signed_details;
-  signed_details.set_serialised_details(serialised_details.string());
-  signed_details.set_pmid_signature(pmid_signature.string());
-  return asymm::PlainText(signed_details.SerializeAsString());
+  nfs::detail::ScratchProtobuf<protobuf::PmidRegistration::SignedDetails> signed_details;
+  signed_details->set_serialised_details(serialised_details.string());
+  signed_details->set_pmid_signature(pmid_signature.string());
+  return asymm::PlainText(signed_details->SerializeAsString());
 }
 
 }  //  unnamed namespace
@@ -72,21 +73,21 @@ PmidRegistration::PmidRegistration(const std::string& serialised_copy)
     LOG(kError) << "Failed to parse pmid_registration.";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
   });
-  protobuf::PmidRegistration proto_pmid_registration;
-  if (!proto_pmid_registration.ParseFromString(serialised_copy))
+  nfs::detail::ScratchProtobuf<protobuf::PmidRegistration> proto_pmid_registration;
+  if (!proto_pmid_registration->ParseFromString(serialised_copy))
     fail();
-  protobuf::PmidRegistration::SignedDetails signed_details;
-  if (!signed_details.ParseFromString(proto_pmid_registration.serialised_signed_details()))
+  nfs::detail::ScratchProtobuf<protobuf::PmidRegistration::SignedDetails> signed_details;
+  if (!signed_details->ParseFromString(proto_pmid_registration->serialised_signed_details()))
     fail();
-  protobuf::PmidRegistration::SignedDetails::Details details;
-  if (!details.ParseFromString(signed_details.serialised_details()))
+  nfs::detail::ScratchProtobuf<protobuf::PmidRegistration::SignedDetails::Details> details;
+  if (!details->ParseFromString(signed_details->serialised_details()))
     fail();
 
-  maid_name_ = passport::PublicMaid::Name(Identity(details.maid_name()));
-  pmid_name_ = passport::PublicPmid::Name(Identity(details.pmid_name()));
-  unregister_ = details.unregister();
-  maid_signature_ = asymm::Signature(proto_pmid_registration.maid_signature());
-  pmid_signature_ = asymm::Signature(signed_details.pmid_signature());
+  maid_name_ = passport::PublicMaid::Name(Identity(details->maid_name()));
+  pmid_name_ = passport::PublicPmid::Name(Identity(details->pmid_name()));
+  unregister_ = details->unregister();
+  maid_signature_ = asymm::Signature(proto_pmid_registration->maid_signature());
+  pmid_signature_ = asymm::Signature(signed_details->pmid_signature());
 }
 
 PmidRegistration::PmidRegistration(const PmidRegistration& other)
@@ -125,11 +126,11 @@ bool PmidRegistration::Validate(const passport::PublicMaid& public_maid,
 }
 
 std::string PmidRegistration::Serialise() const {
-  protobuf::PmidRegistration proto_pmid_registration;
-  proto_pmid_registration.set_serialised_signed_details(GetSerialisedSignedDetails(
+  nfs::detail::ScratchProtobuf<protobuf::PmidRegistration> proto_pmid_registration;
+  proto_pmid_registration->set_serialised_signed_details(GetSerialisedSignedDetails(
       GetSerialisedDetails(maid_name_, pmid_name_, unregister_), pmid_signature_).string());
-  proto_pmid_registration.set_maid_signature(maid_signature_.string());
-  return proto_pmid_registration.SerializeAsString();
+  proto_pmid_registration->set_maid_signature(maid_signature_.string());
+  return proto_pmid_registration->SerializeAsString();
 }
 
 bool operator==(const PmidRegistration& lhs, const PmidRegistration& rhs) {
@@ -0,0 +1,130 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/wire_format.h"
+
+#include "maidsafe/common/error.h"
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace detail {
+
+namespace {
+
+const uint32_t kVarintWireType(0), kFixed64WireType(1), kLengthDelimitedWireType(2),
+               kFixed32WireType(5);
+
+void Skip(size_t count, size_t size, size_t& offset) {
+  if (count > size - offset)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  offset += count;
+}
+
+uint32_t MakeTag(uint32_t field_number, uint32_t wire_type) {
+  return (field_number << 3) | wire_type;
+}
+
+}  // unnamed namespace
+
+size_t VarintSize(uint64_t value) {
+  size_t size(1);
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+void AppendVarint(uint64_t value, std::string& output) {
+  while (value >= 0x80) {
+    output.push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  output.push_back(static_cast<char>(value));
+}
+
+uint64_t ReadVarint(const char* data, size_t size, size_t& offset) {
+  uint64_t value(0);
+  for (int shift(0); shift < 64; shift += 7) {
+    if (offset >= size)
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+    auto byte(static_cast<uint8_t>(data[offset++]));
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0)
+      return value;
+  }
+  BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+}
+
+size_t LengthDelimitedFieldSize(uint32_t field_number, size_t length) {
+  return VarintSize(MakeTag(field_number, kLengthDelimitedWireType)) + VarintSize(length) + length;
+}
+
+void AppendLengthDelimitedFieldHeader(uint32_t field_number, size_t length, std::string& output) {
+  AppendVarint(MakeTag(field_number, kLengthDelimitedWireType), output);
+  AppendVarint(length, output);
+}
+
+void AppendLengthDelimitedField(uint32_t field_number, const std::string& value,
+                                std::string& output) {
+  AppendLengthDelimitedFieldHeader(field_number, value.size(), output);
+  output.append(value);
+}
+
+void ParseLengthDelimitedFields(const char* data, size_t size, FieldView* fields,
+                                uint32_t field_count) {
+  size_t offset(0);
+  while (offset < size) {
+    auto tag(ReadVarint(data, size, offset));
+    auto field_number(tag >> 3);
+    if (field_number == 0)
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+    switch (static_cast<uint32_t>(tag & 0x07)) {
+      case kVarintWireType:
+        ReadVarint(data, size, offset);
+        break;
+      case kFixed64WireType:
+        Skip(8, size, offset);
+        break;
+      case kLengthDelimitedWireType: {
+        auto length(ReadVarint(data, size, offset));
+        if (length > size - offset)
+          BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+        if (field_number < field_count) {
+          fields[field_number].data = data + offset;
+          fields[field_number].size = static_cast<size_t>(length);
+        }
+        offset += static_cast<size_t>(length);
+        break;
+      }
+      case kFixed32WireType:
+        Skip(4, size, offset);
+        break;
+      default:
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+    }
+  }
+}
+
+}  // namespace detail
+
+}  // namespace nfs
+
+}  // namespace maidsafe